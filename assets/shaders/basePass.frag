@@ -10,10 +10,51 @@ in block {
 
 layout(location=0) out vec4 fragColor;
 
+#ifdef OVERDRAW_COUNT
+// Overdraw view (see OverdrawView): every invocation adds one, including the ones discarded below
+layout(r32ui, binding=2) uniform uimage2D overdrawCounts;
+#endif
+
+#ifdef OCTAGON_SPRITE
+// exp(-9 x) at FALLOFF_SIZE evenly spaced x = squared distance from the centre (in quad half-sizes),
+// from the centre to the octagon's corners, already zero below the 0.01 cutoff
+// (see ComputeParticles::createFalloffTexture)
+uniform sampler1D falloffTexture;
+#define FALLOFF_SIZE 64.0
+#define FALLOFF_RANGE 0.5995
+#endif
+
+#ifdef OVER_BLEND
+#define DUST_OPACITY 0.35
+#define DUST_BRIGHTNESS 1.5
+#endif
+
 void main() {
+#ifdef OVERDRAW_COUNT
+    imageAtomicAdd(overdrawCounts, ivec2(gl_FragCoord.xy), 1u);
+#endif
+
+#ifdef POINT_SPRITE
+    fragColor = In.color;
+#else
+#ifdef OCTAGON_SPRITE
+    // No discard: outside the cutoff the table is zero and the blend adds nothing
+    vec2 d = In.texCoord*2.0-1.0;
+    float x = min(dot(d, d) / FALLOFF_RANGE, 1.0);
+    float i = texture(falloffTexture, (x * (FALLOFF_SIZE - 1.0) + 0.5) / FALLOFF_SIZE).r;
+#else
     float r = length(In.texCoord*2.0-1.0)*3.0;
     float i = exp(-r*r);
     if (i < 0.01) discard;
+#endif
 
-    fragColor = vec4(In.color.rgb, i);
+#ifdef OVER_BLEND
+    // Premultiplied "over": sprites are drawn back-to-front and occlude each other like dust
+    float alpha = i * DUST_OPACITY;
+    fragColor = vec4(In.color.rgb * DUST_BRIGHTNESS * alpha, alpha);
+#else
+    // Alpha is 1 except for stochastically subsampled sprites (see cullPass.cs), which carry their weight
+    fragColor = vec4(In.color.rgb, i * In.color.a);
+#endif
+#endif
 }
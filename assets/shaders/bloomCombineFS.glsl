@@ -7,8 +7,13 @@ uniform sampler2D sceneTexture;
 uniform sampler2D bloomTexture;
 uniform float bloomIntensity;
 
+// Scene exposure, as in bloomExtractFS.glsl
+layout(std430, binding=27) readonly buffer Exposure {
+    float exposure;
+};
+
 void main() {
-    vec3 sceneColor = texture(sceneTexture, TexCoord).rgb;
+    vec3 sceneColor = texture(sceneTexture, TexCoord).rgb * exposure;
     vec3 bloom = texture(bloomTexture, TexCoord).rgb;
     
     // Combine original scene with bloom
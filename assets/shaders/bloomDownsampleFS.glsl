@@ -5,23 +5,66 @@ out vec4 FragColor;
 
 uniform sampler2D inputTexture;
 
+#ifdef BLOOM_FUSED_EXTRACT
+// First level of the fused chain: inputTexture is the HDR scene itself, thresholded here instead of
+// in a separate full-resolution extract pass (bloomExtractFS.glsl).
+uniform float threshold;
+
+const vec3 LUMA = vec3(0.2126, 0.7152, 0.0722);
+
+// Scene exposure, as in bloomExtractFS.glsl
+layout(std430, binding=27) readonly buffer Exposure {
+    float exposure;
+};
+
+vec3 brightPart(ivec2 p) {
+    p = clamp(p, ivec2(0), textureSize(inputTexture, 0) - 1);
+    vec3 color = texelFetch(inputTexture, p, 0).rgb * exposure;
+    float brightness = dot(color, LUMA);
+    float excess = max(0.0, brightness - threshold);
+    return excess > 0.0 ? color * (excess / brightness) : vec3(0.0);
+}
+
+// Mean of the thresholded 2x2 block at (x, y) in the 4x4 neighbourhood
+vec3 quad(vec3 t[16], int x, int y) {
+    return (t[y * 4 + x] + t[y * 4 + x + 1] + t[y * 4 + x + 4] + t[y * 4 + x + 5]) * 0.25;
+}
+#endif
+
 void main() {
+#ifdef BLOOM_FUSED_EXTRACT
+    // The five bilinear taps below land on texel corners of this 4x4 block (four corner quads plus
+    // the centre quad). Thresholding each texel before averaging gives the same result as
+    // extracting into a full-resolution target first.
+    ivec2 base = ivec2(gl_FragCoord.xy) * 2 - 1;
+    vec3 t[16];
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            t[y * 4 + x] = brightPart(base + ivec2(x, y));
+        }
+    }
+    vec3 a = quad(t, 0, 0);
+    vec3 b = quad(t, 2, 0);
+    vec3 c = quad(t, 0, 2);
+    vec3 d = quad(t, 2, 2);
+    vec3 e = quad(t, 1, 1);
+#else
     vec2 texelSize = 1.0 / textureSize(inputTexture, 0);
-    
+
     // Sample 4 corners and center
     vec3 a = texture(inputTexture, TexCoord + vec2(-texelSize.x, -texelSize.y)).rgb;
     vec3 b = texture(inputTexture, TexCoord + vec2(texelSize.x, -texelSize.y)).rgb;
     vec3 c = texture(inputTexture, TexCoord + vec2(-texelSize.x, texelSize.y)).rgb;
     vec3 d = texture(inputTexture, TexCoord + vec2(texelSize.x, texelSize.y)).rgb;
     vec3 e = texture(inputTexture, TexCoord).rgb;
-    
+#endif
+
     // Downsample with weighted average (center has more weight)
     vec3 color = (a + b + c + d) * 0.125 + e * 0.5;
-    
+
     // Tone mapping to prevent excessive brightness accumulation
     // Simple reinhard tone mapping: color / (1.0 + color)
     color = color / (1.0 + color * 0.5);
-    
+
     FragColor = vec4(color, 1.0);
 }
-
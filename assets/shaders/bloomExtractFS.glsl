@@ -6,8 +6,13 @@ out vec4 FragColor;
 uniform sampler2D sceneTexture;
 uniform float threshold;
 
+// Scene exposure, written on the GPU by exposurePass.cs (1.0 when auto-exposure is off)
+layout(std430, binding=27) readonly buffer Exposure {
+    float exposure;
+};
+
 void main() {
-    vec3 color = texture(sceneTexture, TexCoord).rgb;
+    vec3 color = texture(sceneTexture, TexCoord).rgb * exposure;
     
     float brightness = dot(color, vec3(0.2126, 0.7152, 0.0722));
     
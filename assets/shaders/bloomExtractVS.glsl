@@ -5,8 +5,29 @@ layout(location = 1) in vec2 aTexCoord;
 
 out vec2 TexCoord;
 
+// Sparse bloom (see BloomTiles): one instance per active tile instead of the full-screen quad
+uniform bool tiled;
+uniform vec2 tileSize;      // tile extent in texture coordinates
+
+layout(std430, binding = 24) readonly buffer BloomTileList {
+    uint tileList[];        // x | (y << 16)
+};
+
+const vec2 kTileCorners[6] = vec2[](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+    vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0)
+);
+
 void main() {
+    if (tiled) {
+        uint tile = tileList[gl_InstanceID];
+        vec2 origin = vec2(float(tile & 0xFFFFu), float(tile >> 16));
+        vec2 uv = min((origin + kTileCorners[gl_VertexID]) * tileSize, vec2(1.0));
+        gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+        TexCoord = uv;
+        return;
+    }
+
     gl_Position = vec4(aPos, 0.0, 1.0);
     TexCoord = aTexCoord;
 }
-
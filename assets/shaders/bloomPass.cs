@@ -0,0 +1,167 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// Compute bloom (see ComputeBloom). The mip chain is one RGBA16F texture whose level 0 is half the
+// scene resolution. Compiled once per kernel with one of these defined:
+//   BLOOM_DOWNSAMPLE  one dispatch builds the whole chain: every group thresholds a 64x64 scene tile
+//                     and reduces it to levels 0..5 in registers and shared memory; the last group
+//                     to finish (global atomic counter) reduces level 5 to level 6
+//   BLOOM_UPSAMPLE    adds a 3x3 tent-filtered copy of level srcLevel onto level srcLevel-1,
+//                     one small dispatch per level from the bottom of the chain up
+
+#define BLOOM_GROUP_SIZE 16
+
+// Same luminance weights as bloomExtractFS.glsl
+const vec3 LUMA = vec3(0.2126, 0.7152, 0.0722);
+
+uniform sampler2D sceneTexture;     // BLOOM_DOWNSAMPLE: HDR scene
+uniform float threshold;
+uniform sampler2D chainTexture;     // BLOOM_UPSAMPLE: the mip chain, sampled at srcLevel
+uniform int srcLevel;
+
+// Scene exposure, as in bloomExtractFS.glsl
+layout(std430, binding=27) readonly buffer Exposure {
+    float exposure;
+};
+
+layout(local_size_x = BLOOM_GROUP_SIZE, local_size_y = BLOOM_GROUP_SIZE, local_size_z = 1) in;
+
+#ifdef BLOOM_DOWNSAMPLE
+
+layout(rgba16f, binding=0) writeonly uniform image2D level0;
+layout(rgba16f, binding=1) writeonly uniform image2D level1;
+layout(rgba16f, binding=2) writeonly uniform image2D level2;
+layout(rgba16f, binding=3) writeonly uniform image2D level3;
+layout(rgba16f, binding=4) writeonly uniform image2D level4;
+layout(rgba16f, binding=5) coherent uniform image2D level5;    // read back by the last group
+layout(rgba16f, binding=6) writeonly uniform image2D level6;
+
+// Groups that have finished levels 0..5; the last one resets it for the next frame
+layout(std430, binding=22) coherent buffer BloomCounter {
+    uint groupsDone;
+};
+
+shared vec3 sTile[BLOOM_GROUP_SIZE * BLOOM_GROUP_SIZE];
+shared bool sLastGroup;
+
+// Soft compression applied at every level, as in bloomDownsampleFS.glsl
+vec3 compress(vec3 c) {
+    return c / (1.0 + c * 0.5);
+}
+
+// Part of the scene pixel above the threshold, as in bloomExtractFS.glsl
+vec3 brightPart(ivec2 p) {
+    p = clamp(p, ivec2(0), textureSize(sceneTexture, 0) - 1);
+    vec3 color = texelFetch(sceneTexture, p, 0).rgb * exposure;
+    float brightness = dot(color, LUMA);
+    float excess = max(0.0, brightness - threshold);
+    return excess > 0.0 ? color * (excess / brightness) : vec3(0.0);
+}
+
+// 2x2 average of the width x width values in sTile, for output texel t of the next level
+vec3 reduceShared(uint t, uint width) {
+    uint half_ = width / 2u;
+    uint i = (t / half_) * 2u * width + (t % half_) * 2u;
+    return compress((sTile[i] + sTile[i + 1u] + sTile[i + width] + sTile[i + width + 1u]) * 0.25);
+}
+
+void main() {
+    uint t = gl_LocalInvocationIndex;
+    ivec2 local = ivec2(gl_LocalInvocationID.xy);
+    ivec2 group = ivec2(gl_WorkGroupID.xy);
+
+    // Level 0 (32x32 per group): each invocation owns a 2x2 block, i.e. 4x4 scene pixels,
+    // so level 1 needs no shared memory
+    vec3 sum = vec3(0.0);
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 2; i++) {
+            ivec2 p = group * 32 + local * 2 + ivec2(i, j);
+            ivec2 s = p * 2;
+            vec3 c = compress((brightPart(s) + brightPart(s + ivec2(1, 0)) +
+                               brightPart(s + ivec2(0, 1)) + brightPart(s + ivec2(1, 1))) * 0.25);
+            imageStore(level0, p, vec4(c, 1.0));
+            sum += c;
+        }
+    }
+    vec3 c = compress(sum * 0.25);
+    imageStore(level1, group * 16 + local, vec4(c, 1.0));
+    sTile[t] = c;
+    barrier();
+
+    // Levels 2..5 (8x8 .. 1x1 per group) through shared memory
+    if (t < 64u) {
+        c = reduceShared(t, 16u);
+        imageStore(level2, group * 8 + ivec2(t % 8u, t / 8u), vec4(c, 1.0));
+    }
+    barrier();
+    if (t < 64u) sTile[t] = c;
+    barrier();
+
+    if (t < 16u) {
+        c = reduceShared(t, 8u);
+        imageStore(level3, group * 4 + ivec2(t % 4u, t / 4u), vec4(c, 1.0));
+    }
+    barrier();
+    if (t < 16u) sTile[t] = c;
+    barrier();
+
+    if (t < 4u) {
+        c = reduceShared(t, 4u);
+        imageStore(level4, group * 2 + ivec2(t % 2u, t / 2u), vec4(c, 1.0));
+    }
+    barrier();
+    if (t < 4u) sTile[t] = c;
+    barrier();
+
+    if (t == 0u) {
+        c = reduceShared(0u, 2u);
+        imageStore(level5, group, vec4(c, 1.0));
+        memoryBarrierImage();
+        uint done = atomicAdd(groupsDone, 1u);
+        sLastGroup = done == gl_NumWorkGroups.x * gl_NumWorkGroups.y - 1u;
+    }
+    barrier();
+    if (!sLastGroup) return;
+
+    // Only the last group gets here; every other group's level-5 texel is visible by now
+    ivec2 size = imageSize(level6);
+    for (int k = int(t); k < size.x * size.y; k += BLOOM_GROUP_SIZE * BLOOM_GROUP_SIZE) {
+        ivec2 p = ivec2(k % size.x, k / size.x);
+        ivec2 s = p * 2;
+        vec3 tail = (imageLoad(level5, s).rgb + imageLoad(level5, s + ivec2(1, 0)).rgb +
+                     imageLoad(level5, s + ivec2(0, 1)).rgb + imageLoad(level5, s + ivec2(1, 1)).rgb) * 0.25;
+        imageStore(level6, p, vec4(compress(tail), 1.0));
+    }
+    if (t == 0u) groupsDone = 0u;
+}
+
+#endif
+
+#ifdef BLOOM_UPSAMPLE
+
+layout(rgba16f, binding=0) uniform image2D dstLevel;     // level srcLevel-1, accumulated in place
+
+void main() {
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(dstLevel);
+    if (any(greaterThanEqual(p, size))) return;
+
+    // 3x3 tent over the coarser level with bilinear taps, weights 1-2-1
+    vec2 uv = (vec2(p) + 0.5) / vec2(size);
+    vec2 texel = 1.0 / vec2(textureSize(chainTexture, srcLevel));
+    float lod = float(srcLevel);
+    vec3 up = textureLod(chainTexture, uv, lod).rgb * 4.0;
+    up += (textureLod(chainTexture, uv + vec2(-texel.x, 0.0), lod).rgb +
+           textureLod(chainTexture, uv + vec2( texel.x, 0.0), lod).rgb +
+           textureLod(chainTexture, uv + vec2(0.0, -texel.y), lod).rgb +
+           textureLod(chainTexture, uv + vec2(0.0,  texel.y), lod).rgb) * 2.0;
+    up += textureLod(chainTexture, uv - texel, lod).rgb +
+          textureLod(chainTexture, uv + texel, lod).rgb +
+          textureLod(chainTexture, uv + vec2(texel.x, -texel.y), lod).rgb +
+          textureLod(chainTexture, uv + vec2(-texel.x, texel.y), lod).rgb;
+
+    imageStore(dstLevel, p, vec4(imageLoad(dstLevel, p).rgb + up * (1.0 / 16.0), 1.0));
+}
+
+#endif
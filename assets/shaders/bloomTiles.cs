@@ -0,0 +1,122 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// Tile classification for the sparse bloom path (see BloomTiles). The scene is split into
+// 64x64 pixel tiles. Compiled once per kernel with one of these defined:
+//   BLOOM_TILE_CLASSIFY  one 16x16 group per tile, each thread tests 4x4 pixels; flags the tile if
+//                        any pixel is above the extract threshold. Group (0,0) also resets the
+//                        indirect draw command for the compact kernel
+//   BLOOM_TILE_COMPACT   one thread per tile; a tile is active if a flagged tile lies within
+//                        `dilation` tiles of it (the reach of the downsample and upsample kernels).
+//                        Active tiles are appended to the tile list and counted as instances of
+//                        the indirect draw used by the extract, downsample and upsample passes
+
+#define TILE_SIZE 64
+#define GROUP_SIZE 16
+
+// Same luminance weights as bloomExtractFS.glsl
+const vec3 LUMA = vec3(0.2126, 0.7152, 0.0722);
+
+uniform ivec2 tileCount;
+
+// Scene exposure, as in bloomExtractFS.glsl
+layout(std430, binding=27) readonly buffer Exposure {
+    float exposure;
+};
+
+// One flag per tile, row-major
+layout(std430, binding=23) buffer BloomTileMask {
+    uint tileMask[];
+};
+
+// Active tiles packed as x | (y << 16)
+layout(std430, binding=24) writeonly buffer BloomTileList {
+    uint tileList[];
+};
+
+// DrawArraysIndirectCommand: 6 vertices per tile quad, one instance per active tile
+layout(std430, binding=25) buffer BloomTileCommand {
+    uint vertexCount;
+    uint instanceCount;
+    uint firstVertex;
+    uint baseInstance;
+};
+
+#ifdef BLOOM_TILE_CLASSIFY
+
+uniform sampler2D sceneTexture;
+uniform float threshold;
+
+layout(local_size_x = GROUP_SIZE, local_size_y = GROUP_SIZE, local_size_z = 1) in;
+
+shared uint sBright;
+
+void main() {
+    if (gl_LocalInvocationIndex == 0u) {
+        sBright = 0u;
+        if (gl_WorkGroupID.x == 0u && gl_WorkGroupID.y == 0u) {
+            vertexCount = 6u;
+            instanceCount = 0u;
+            firstVertex = 0u;
+            baseInstance = 0u;
+        }
+    }
+    barrier();
+
+    const int perThread = TILE_SIZE / GROUP_SIZE;
+    ivec2 size = textureSize(sceneTexture, 0);
+    ivec2 base = ivec2(gl_WorkGroupID.xy) * TILE_SIZE + ivec2(gl_LocalInvocationID.xy) * perThread;
+    bool bright = false;
+    for (int y = 0; y < perThread; y++) {
+        for (int x = 0; x < perThread; x++) {
+            ivec2 p = base + ivec2(x, y);
+            if (p.x < size.x && p.y < size.y) {
+                bright = bright || dot(texelFetch(sceneTexture, p, 0).rgb, LUMA) * exposure > threshold;
+            }
+        }
+    }
+    if (bright) {
+        atomicOr(sBright, 1u);
+    }
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0u) {
+        tileMask[gl_WorkGroupID.y * uint(tileCount.x) + gl_WorkGroupID.x] = sBright;
+    }
+}
+
+#endif
+
+#ifdef BLOOM_TILE_COMPACT
+
+uniform int dilation;
+
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+void main() {
+    int index = int(gl_GlobalInvocationID.x);
+    if (index >= tileCount.x * tileCount.y) {
+        return;
+    }
+    ivec2 tile = ivec2(index % tileCount.x, index / tileCount.x);
+    ivec2 lo = max(tile - dilation, ivec2(0));
+    ivec2 hi = min(tile + dilation, tileCount - 1);
+
+    bool isActive = false;
+    for (int y = lo.y; y <= hi.y && !isActive; y++) {
+        for (int x = lo.x; x <= hi.x; x++) {
+            if (tileMask[y * tileCount.x + x] != 0u) {
+                isActive = true;
+                break;
+            }
+        }
+    }
+
+    if (isActive) {
+        uint slot = atomicAdd(instanceCount, 1u);
+        tileList[slot] = uint(tile.x) | (uint(tile.y) << 16);
+    }
+}
+
+#endif
@@ -7,6 +7,29 @@ uniform sampler2D lowResTexture;
 uniform sampler2D highResTexture;
 uniform vec2 texelSize;
 
+#ifdef BLOOM_FUSED_COMBINE
+// Last level of the fused chain: highResTexture is the HDR scene. The detail taps threshold it on
+// the fly (there is no full-resolution extract target) and the result is combined with the scene
+// here, writing the final image instead of a full-resolution bloom target (bloomCombineFS.glsl).
+uniform float threshold;
+uniform float bloomIntensity;
+
+const vec3 LUMA = vec3(0.2126, 0.7152, 0.0722);
+
+// Scene exposure, as in bloomExtractFS.glsl
+layout(std430, binding=27) readonly buffer Exposure {
+    float exposure;
+};
+
+vec3 brightPart(ivec2 p) {
+    p = clamp(p, ivec2(0), textureSize(highResTexture, 0) - 1);
+    vec3 color = texelFetch(highResTexture, p, 0).rgb * exposure;
+    float brightness = dot(color, LUMA);
+    float excess = max(0.0, brightness - threshold);
+    return excess > 0.0 ? color * (excess / brightness) : vec3(0.0);
+}
+#endif
+
 // Bilateral filter parameters
 const float sigmaSpace = 1.5;
 const float sigmaColor = 0.15;
@@ -17,44 +40,71 @@ float gaussian(float x, float sigma) {
 
 void main() {
     vec2 uv = TexCoord;
-    
+
     // Sample low-res (upsampled from previous level) and high-res (current level detail)
     vec3 lowResSample = texture(lowResTexture, uv).rgb;
+
+    const int kernelSize = 5;
+    const float offset = 1.5;
+
+#ifdef BLOOM_FUSED_COMBINE
+    // Taps at 1.5-texel steps fall on texel centres (0, +-3) or midway between two texels (+-1.5):
+    // threshold the 7x7 texels once and average the ones each tap would have filtered
+    ivec2 center = ivec2(uv * vec2(textureSize(highResTexture, 0)));
+    vec3 bright[49];
+    for (int y = 0; y < 7; y++) {
+        for (int x = 0; x < 7; x++) {
+            bright[y * 7 + x] = brightPart(center + ivec2(x - 3, y - 3));
+        }
+    }
+    // Per axis, tap k covers texels [first, last] of the 7 (offset -3..3)
+    const int tapFirst[5] = int[](0, 1, 3, 4, 6);
+    const int tapLast[5] = int[](0, 2, 3, 5, 6);
+    vec3 highResSample = bright[3 * 7 + 3];
+#else
     vec3 highResSample = texture(highResTexture, uv).rgb;
+#endif
     vec3 centerColor = highResSample;
-    
+
     vec3 result = vec3(0.0);
     float weightSum = 0.0;
-    
+
     // Bilateral filtering on high-res texture to preserve edges
-    const int kernelSize = 5;
-    const float offset = 1.5;
-    
     for (int y = -kernelSize/2; y <= kernelSize/2; y++) {
         for (int x = -kernelSize/2; x <= kernelSize/2; x++) {
+#ifdef BLOOM_FUSED_COMBINE
+            int tx = x + kernelSize/2, ty = y + kernelSize/2;
+            vec3 sampleHighRes = (bright[tapFirst[ty] * 7 + tapFirst[tx]] + bright[tapFirst[ty] * 7 + tapLast[tx]] +
+                                  bright[tapLast[ty] * 7 + tapFirst[tx]] + bright[tapLast[ty] * 7 + tapLast[tx]]) * 0.25;
+#else
             vec2 sampleCoord = uv + vec2(float(x), float(y)) * texelSize * offset;
             vec3 sampleHighRes = texture(highResTexture, sampleCoord).rgb;
-            
+#endif
+
             // Spatial weight
             float dist = length(vec2(x, y));
             float spatialWeight = gaussian(dist, sigmaSpace);
-            
+
             // Color weight
             float colorDiff = length(sampleHighRes - centerColor);
             float colorWeight = gaussian(colorDiff, sigmaColor);
-            
+
             float weight = spatialWeight * colorWeight;
             result += sampleHighRes * weight;
             weightSum += weight;
         }
     }
-    
+
     if (weightSum > 0.0) {
         result /= weightSum;
     } else {
         result = highResSample;
     }
-    
+
+#ifdef BLOOM_FUSED_COMBINE
+    vec3 sceneColor = texture(highResTexture, uv).rgb * exposure;
+    FragColor = vec4(sceneColor + (lowResSample + result) * bloomIntensity, 1.0);
+#else
     FragColor = vec4(lowResSample + result, 1.0);
+#endif
 }
-
@@ -0,0 +1,168 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+layout(std140, binding=1) uniform ShaderParams {
+    mat4 ModelView;
+    mat4 ModelViewProjection;
+    mat4 ProjectionMatrix;
+
+    vec4 attractor;
+
+    uint numParticles;
+    float spriteSize;
+    float damping;
+    float particleScale;
+
+    float noiseFreq;
+    float noiseStrength;
+};
+
+#define WORK_GROUP_SIZE 128
+
+// Integral of exp(-r*r) over the sprite quad divided by the quad area (see basePass.frag)
+#define SPRITE_ENERGY 0.0872665
+// Octagon sprite area relative to the quad (see basePass.verrt)
+#define OCTAGON_AREA 0.4239
+// Screen tiles of the stochastic LOD density estimate, in pixels
+#define LOD_TILE_SIZE 16
+
+uniform vec2 viewportSize;
+uniform float lodPointRadius;   // sprites smaller than this (in pixels) collapse to a single point
+uniform float lodMinEnergy;     // points dimmer than this are skipped entirely
+uniform int octagonSprites;     // visible sprites are counted as octagon instances instead of quad indices
+
+// Stochastic LOD (see ParticleCuller): in tiles whose estimated overdraw exceeds lodTargetOverdraw only a
+// fraction of the particles is kept, chosen by hashing the particle's id so the same ones stay selected
+// from frame to frame; kept particles carry 1/fraction as their weight so the expected energy is unchanged.
+// The estimate is last frame's footprint sum per tile, while this frame's is accumulated for the next.
+uniform int stochasticLod;
+uniform float lodTargetOverdraw;
+uniform float lodMinFraction;   // lower bound of the kept fraction (upper bound of the weight)
+uniform float lodMaxRadius;     // sprites this large (in pixels) are always kept, half as large start fading in
+uniform ivec2 lodTiles;
+
+layout( std140, binding=2 ) readonly buffer Pos {
+    vec4 pos[];
+};
+
+// Original particle ids (slots are permuted by the Morton reorder)
+layout( std430, binding=7 ) readonly buffer ParticleIds {
+    uint ids[];
+};
+
+layout( std430, binding=4 ) writeonly buffer QuadList {
+    uint quadList[];
+};
+
+layout( std430, binding=5 ) writeonly buffer PointList {
+    uint pointList[];
+};
+
+// DrawElementsIndirectCommand followed by two DrawArraysIndirectCommands
+layout( std430, binding=6 ) buffer DrawCommands {
+    uint quadCount;
+    uint quadInstanceCount;
+    uint quadFirstIndex;
+    int  quadBaseVertex;
+    uint quadBaseInstance;
+
+    uint pointCount;
+    uint pointInstanceCount;
+    uint pointFirst;
+    uint pointBaseInstance;
+
+    uint octagonCount;
+    uint octagonInstanceCount;
+    uint octagonFirst;
+    uint octagonBaseInstance;
+};
+
+layout( std430, binding=29 ) writeonly buffer QuadWeights {
+    float quadWeights[];
+};
+
+layout( std430, binding=30 ) writeonly buffer PointWeights {
+    float pointWeights[];
+};
+
+// Footprint sums in 1/16 pixel units: last frame's (read) and this frame's (accumulated)
+layout( std430, binding=31 ) readonly buffer LodDensity {
+    uint lodDensity[];
+};
+
+layout( std430, binding=32 ) buffer LodDensityNext {
+    uint lodDensityNext[];
+};
+
+layout(local_size_x = WORK_GROUP_SIZE,  local_size_y = 1, local_size_z = 1) in;
+
+uint hashId(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Adds the particle's footprint (covered pixels) to its tile and returns the fraction to keep, from 0 to 1
+float lodFraction(vec4 clip, float radiusPx, bool sprite) {
+    vec2 pixel = (clip.xy / clip.w * 0.5 + 0.5) * viewportSize;
+    ivec2 tile = clamp(ivec2(pixel) / LOD_TILE_SIZE, ivec2(0), lodTiles - 1);
+    int t = tile.y * lodTiles.x + tile.x;
+
+    float area = sprite ? 4.0 * radiusPx * radiusPx * (octagonSprites != 0 ? OCTAGON_AREA : 1.0) : 1.0;
+    atomicAdd(lodDensityNext[t], uint(min(area * 16.0, 65536.0)));
+
+    float overdraw = float(lodDensity[t]) / (16.0 * LOD_TILE_SIZE * LOD_TILE_SIZE);
+    float fraction = overdraw > lodTargetOverdraw ? max(lodTargetOverdraw / overdraw, lodMinFraction) : 1.0;
+    // Dropping a large sprite would show as a hole rather than as noise
+    return mix(fraction, 1.0, smoothstep(0.5 * lodMaxRadius, lodMaxRadius, radiusPx));
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+
+    if (i >= numParticles) return;
+
+    vec4 particlePos = vec4(pos[i].xyz * particleScale, 1.0);
+    vec4 eye = ModelView * particlePos;
+    vec4 clip = ProjectionMatrix * eye;
+
+    // The sprite is a view-aligned quad, so its bounding sphere is the quad's circumcircle
+    float radius = spriteSize * 1.41421356;
+    float zNear = ProjectionMatrix[3][2] / (ProjectionMatrix[2][2] - 1.0);
+    float zFar = ProjectionMatrix[3][2] / (ProjectionMatrix[2][2] + 1.0);
+
+    if (-eye.z < zNear - radius || -eye.z > zFar + radius) return;
+    if (abs(clip.x) > clip.w + radius * ProjectionMatrix[0][0]) return;
+    if (abs(clip.y) > clip.w + radius * ProjectionMatrix[1][1]) return;
+
+    float radiusPx = spriteSize * ProjectionMatrix[1][1] / clip.w * 0.5 * viewportSize.y;
+    bool sprite = radiusPx >= lodPointRadius;
+
+    if (!sprite) {
+        float energy = 4.0 * radiusPx * radiusPx * SPRITE_ENERGY;
+        if (energy < lodMinEnergy) return;
+    }
+
+    float weight = 1.0;
+    if (stochasticLod != 0) {
+        float fraction = lodFraction(clip, radiusPx, sprite);
+        // Uniform in [0, 1) per particle: keeps the selection stable as the fraction changes smoothly
+        float u = float(hashId(ids[i]) >> 8) * (1.0 / 16777216.0);
+        if (u >= fraction) return;
+        weight = 1.0 / fraction;
+    }
+
+    if (sprite) {
+        uint slot = octagonSprites != 0 ? atomicAdd(octagonInstanceCount, 1u) : atomicAdd(quadCount, 6u) / 6u;
+        quadList[slot] = i;
+        if (stochasticLod != 0) quadWeights[slot] = weight;
+    } else {
+        uint slot = atomicAdd(pointCount, 1u);
+        pointList[slot] = i;
+        if (stochasticLod != 0) pointWeights[slot] = weight;
+    }
+}
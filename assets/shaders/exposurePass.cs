@@ -0,0 +1,130 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// GPU auto-exposure (see AutoExposure). Compiled once per kernel with one of these defined:
+//   EXPOSURE_HISTOGRAM  one thread per 2x2 scene pixels (one bilinear fetch); every 16x16 group builds
+//                       a 256-bin log-luminance histogram in shared memory and adds its non-empty
+//                       bins to the global one
+//   EXPOSURE_AVERAGE    a single group of 256 threads: clears the global histogram for the next
+//                       frame, averages log luminance between the low and high percentiles, and
+//                       moves the exposure towards key / average with exponential smoothing
+// Nothing is read back by the CPU; the bloom extract and combine shaders read `exposure` directly.
+
+#define NUM_BINS 256
+#define GROUP_SIZE 16
+
+// Same luminance weights as bloomExtractFS.glsl
+const vec3 LUMA = vec3(0.2126, 0.7152, 0.0722);
+
+// Bin 0 holds (near) black pixels, bins 1..255 span [minLogLuminance, minLogLuminance + logLuminanceRange]
+uniform float minLogLuminance;
+uniform float logLuminanceRange;
+
+layout(std430, binding=26) buffer ExposureHistogram {
+    uint histogram[NUM_BINS];
+};
+
+layout(std430, binding=27) buffer Exposure {
+    float exposure;
+    float averageLuminance;
+};
+
+#ifdef EXPOSURE_HISTOGRAM
+
+uniform sampler2D sceneTexture;
+
+layout(local_size_x = GROUP_SIZE, local_size_y = GROUP_SIZE, local_size_z = 1) in;
+
+shared uint sHistogram[NUM_BINS];
+
+uint luminanceBin(vec3 color) {
+    float luminance = dot(color, LUMA);
+    if (luminance < exp2(minLogLuminance)) {
+        return 0u;
+    }
+    float t = clamp((log2(luminance) - minLogLuminance) / logLuminanceRange, 0.0, 1.0);
+    return uint(t * 254.0 + 1.0);
+}
+
+void main() {
+    sHistogram[gl_LocalInvocationIndex] = 0u;
+    barrier();
+
+    // Metering does not need every pixel: the bilinear fetch at the shared corner averages 2x2 of them
+    ivec2 size = textureSize(sceneTexture, 0);
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy) * 2;
+    if (all(lessThan(p, size))) {
+        vec2 uv = (vec2(p) + 1.0) / vec2(size);
+        atomicAdd(sHistogram[luminanceBin(textureLod(sceneTexture, uv, 0.0).rgb)], 1u);
+    }
+    barrier();
+
+    uint count = sHistogram[gl_LocalInvocationIndex];
+    if (count > 0u) {
+        atomicAdd(histogram[gl_LocalInvocationIndex], count);
+    }
+}
+
+#endif
+
+#ifdef EXPOSURE_AVERAGE
+
+uniform float lowPercent;       // fraction of the darkest non-black pixels ignored
+uniform float highPercent;      // fraction of the brightest pixels ignored
+uniform float key;              // average luminance the exposure aims for
+uniform float minExposure;
+uniform float maxExposure;
+uniform float adaptation;       // 1 - exp(-deltaTime * rate), computed on the CPU
+
+layout(local_size_x = NUM_BINS, local_size_y = 1, local_size_z = 1) in;
+
+shared uint sHistogram[NUM_BINS];
+
+void main() {
+    uint bin = gl_LocalInvocationIndex;
+    sHistogram[bin] = histogram[bin];
+    histogram[bin] = 0u;
+    barrier();
+
+    if (bin != 0u) {
+        return;
+    }
+
+    uint total = 0u;
+    for (int i = 1; i < NUM_BINS; i++) {
+        total += sHistogram[i];
+    }
+    if (total == 0u) {
+        return;
+    }
+
+    // Walk the bins, keeping only the part of each bin between the two percentiles
+    float low = float(total) * lowPercent;
+    float high = float(total) * (1.0 - highPercent);
+    float seen = 0.0;
+    float weighted = 0.0;
+    float kept = 0.0;
+    for (int i = 1; i < NUM_BINS; i++) {
+        float count = float(sHistogram[i]);
+        float lo = max(seen, low);
+        float hi = min(seen + count, high);
+        if (hi > lo) {
+            float logLuminance = minLogLuminance + (float(i) - 0.5) / 254.0 * logLuminanceRange;
+            weighted += logLuminance * (hi - lo);
+            kept += hi - lo;
+        }
+        seen += count;
+    }
+    if (kept <= 0.0) {
+        return;
+    }
+
+    float average = exp2(weighted / kept);
+    float target = clamp(key / average, minExposure, maxExposure);
+    // Adapt in log space so brightening and darkening take the same time
+    exposure = exp2(mix(log2(exposure), log2(target), adaptation));
+    averageLuminance = average;
+}
+
+#endif
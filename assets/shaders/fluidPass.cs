@@ -0,0 +1,177 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// Stable-fluids solver on a cubic velocity grid covering [-domainExtent, domainExtent]^3.
+// Velocity is stored in world units per frame, one frame per solver step.
+// Compiled once per stage with FLUID_ADVECT, FLUID_CURL, FLUID_CONFINE, FLUID_DIVERGENCE,
+// FLUID_JACOBI or FLUID_PROJECT defined (see FluidSolver).
+
+precision highp sampler3D;
+
+#define NUM_JETS 3
+
+uniform int gridSize;
+uniform float cellSize;         // world units
+uniform float dissipation;
+uniform float vorticityStrength;
+
+// Orbiting jets that keep the flow alive: xyz position, w radius / xyz velocity, w unused
+uniform vec4 jetPos[NUM_JETS];
+uniform vec4 jetVel[NUM_JETS];
+
+uniform sampler3D velocitySrc;
+
+layout(rgba16f, binding=0) uniform image3D velocityImage;
+layout(rgba16f, binding=1) uniform image3D vorticityImage;
+layout(r32f, binding=2) uniform image3D pressureSrc;
+layout(r32f, binding=3) uniform image3D pressureDst;
+layout(r32f, binding=4) uniform image3D divergenceImage;
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 4) in;
+
+ivec3 clampCell(ivec3 c) {
+    return clamp(c, ivec3(0), ivec3(gridSize - 1));
+}
+
+vec3 cellCenter(ivec3 c) {
+    return (vec3(c) + 0.5) * cellSize - vec3(gridSize) * cellSize * 0.5;
+}
+
+#ifdef FLUID_ADVECT
+
+// Semi-Lagrangian advection: trace back along the velocity and sample the previous field
+void main() {
+    ivec3 c = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(c, ivec3(gridSize)))) return;
+
+    vec3 uvw = (vec3(c) + 0.5) / float(gridSize);
+    vec3 v = texelFetch(velocitySrc, c, 0).xyz;
+    vec3 back = uvw - v / (cellSize * float(gridSize));
+    v = texture(velocitySrc, back).xyz * dissipation;
+
+    vec3 x = cellCenter(c);
+    for (int j = 0; j < NUM_JETS; j++) {
+        vec3 d = x - jetPos[j].xyz;
+        float falloff = exp(-dot(d, d) / (jetPos[j].w * jetPos[j].w));
+        v += jetVel[j].xyz * falloff;
+    }
+
+    imageStore(velocityImage, c, vec4(v, 0.0));
+}
+
+#endif
+
+#ifdef FLUID_CURL
+
+void main() {
+    ivec3 c = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(c, ivec3(gridSize)))) return;
+
+    vec3 l = imageLoad(velocityImage, clampCell(c - ivec3(1, 0, 0))).xyz;
+    vec3 r = imageLoad(velocityImage, clampCell(c + ivec3(1, 0, 0))).xyz;
+    vec3 b = imageLoad(velocityImage, clampCell(c - ivec3(0, 1, 0))).xyz;
+    vec3 t = imageLoad(velocityImage, clampCell(c + ivec3(0, 1, 0))).xyz;
+    vec3 n = imageLoad(velocityImage, clampCell(c - ivec3(0, 0, 1))).xyz;
+    vec3 f = imageLoad(velocityImage, clampCell(c + ivec3(0, 0, 1))).xyz;
+
+    float inv2h = 0.5 / cellSize;
+    vec3 curl = vec3((t.z - b.z) - (f.y - n.y),
+                     (f.x - n.x) - (r.z - l.z),
+                     (r.y - l.y) - (t.x - b.x)) * inv2h;
+    imageStore(vorticityImage, c, vec4(curl, length(curl)));
+}
+
+#endif
+
+#ifdef FLUID_CONFINE
+
+// Vorticity confinement: push along N x omega, N pointing towards stronger vorticity
+void main() {
+    ivec3 c = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(c, ivec3(gridSize)))) return;
+
+    float l = imageLoad(vorticityImage, clampCell(c - ivec3(1, 0, 0))).w;
+    float r = imageLoad(vorticityImage, clampCell(c + ivec3(1, 0, 0))).w;
+    float b = imageLoad(vorticityImage, clampCell(c - ivec3(0, 1, 0))).w;
+    float t = imageLoad(vorticityImage, clampCell(c + ivec3(0, 1, 0))).w;
+    float n = imageLoad(vorticityImage, clampCell(c - ivec3(0, 0, 1))).w;
+    float f = imageLoad(vorticityImage, clampCell(c + ivec3(0, 0, 1))).w;
+
+    vec3 eta = vec3(r - l, t - b, f - n);
+    float len = length(eta);
+    if (len < 1e-8) return;
+
+    vec3 omega = imageLoad(vorticityImage, c).xyz;
+    vec3 force = cross(eta / len, omega) * (vorticityStrength * cellSize);
+    vec4 v = imageLoad(velocityImage, c);
+    imageStore(velocityImage, c, vec4(v.xyz + force, 0.0));
+}
+
+#endif
+
+#ifdef FLUID_DIVERGENCE
+
+void main() {
+    ivec3 c = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(c, ivec3(gridSize)))) return;
+
+    // Solid walls: the neighbour outside the grid mirrors the normal component
+    vec3 v = imageLoad(velocityImage, c).xyz;
+    float l = c.x > 0 ? imageLoad(velocityImage, c - ivec3(1, 0, 0)).x : -v.x;
+    float r = c.x < gridSize - 1 ? imageLoad(velocityImage, c + ivec3(1, 0, 0)).x : -v.x;
+    float b = c.y > 0 ? imageLoad(velocityImage, c - ivec3(0, 1, 0)).y : -v.y;
+    float t = c.y < gridSize - 1 ? imageLoad(velocityImage, c + ivec3(0, 1, 0)).y : -v.y;
+    float n = c.z > 0 ? imageLoad(velocityImage, c - ivec3(0, 0, 1)).z : -v.z;
+    float f = c.z < gridSize - 1 ? imageLoad(velocityImage, c + ivec3(0, 0, 1)).z : -v.z;
+
+    float div = ((r - l) + (t - b) + (f - n)) * (0.5 / cellSize);
+    imageStore(divergenceImage, c, vec4(div));
+}
+
+#endif
+
+#ifdef FLUID_JACOBI
+
+// One Jacobi iteration of lap(p) = div, pure Neumann boundary (clamped neighbours)
+void main() {
+    ivec3 c = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(c, ivec3(gridSize)))) return;
+
+    float sum = imageLoad(pressureSrc, clampCell(c - ivec3(1, 0, 0))).x
+              + imageLoad(pressureSrc, clampCell(c + ivec3(1, 0, 0))).x
+              + imageLoad(pressureSrc, clampCell(c - ivec3(0, 1, 0))).x
+              + imageLoad(pressureSrc, clampCell(c + ivec3(0, 1, 0))).x
+              + imageLoad(pressureSrc, clampCell(c - ivec3(0, 0, 1))).x
+              + imageLoad(pressureSrc, clampCell(c + ivec3(0, 0, 1))).x;
+    float div = imageLoad(divergenceImage, c).x;
+    imageStore(pressureDst, c, vec4((sum - cellSize * cellSize * div) / 6.0));
+}
+
+#endif
+
+#ifdef FLUID_PROJECT
+
+void main() {
+    ivec3 c = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(c, ivec3(gridSize)))) return;
+
+    float l = imageLoad(pressureSrc, clampCell(c - ivec3(1, 0, 0))).x;
+    float r = imageLoad(pressureSrc, clampCell(c + ivec3(1, 0, 0))).x;
+    float b = imageLoad(pressureSrc, clampCell(c - ivec3(0, 1, 0))).x;
+    float t = imageLoad(pressureSrc, clampCell(c + ivec3(0, 1, 0))).x;
+    float n = imageLoad(pressureSrc, clampCell(c - ivec3(0, 0, 1))).x;
+    float f = imageLoad(pressureSrc, clampCell(c + ivec3(0, 0, 1))).x;
+
+    vec3 v = imageLoad(velocityImage, c).xyz;
+    v -= vec3(r - l, t - b, f - n) * (0.5 / cellSize);
+
+    // No flow through the walls
+    bvec3 lo = equal(c, ivec3(0));
+    bvec3 hi = equal(c, ivec3(gridSize - 1));
+    v = mix(v, vec3(0.0), bvec3(lo.x || hi.x, lo.y || hi.y, lo.z || hi.z));
+
+    imageStore(velocityImage, c, vec4(v, 0.0));
+}
+
+#endif
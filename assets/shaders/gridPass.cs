@@ -0,0 +1,180 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// Spatial hash grid for neighbour queries, rebuilt every step by a counting sort:
+// count particles per cell -> exclusive scan of the counts -> scatter particles into cell order.
+// Compiled once per kernel with GRID_COUNT, GRID_SCAN_BLOCKS, GRID_SCAN_TOTALS, GRID_ADD_TOTALS
+// or GRID_SCATTER defined (see NeighborGrid). cellHash() must match particlePass.cs.
+
+#define GRID_GROUP_SIZE 512
+#define GRID_BLOCK 1024u        // cells scanned per work group, GRID_GROUP_SIZE * 2
+
+uniform uint count;
+uniform uint numCells;          // power of two
+uniform float cellSize;
+
+layout( std140, binding=2 ) readonly buffer Pos {
+    vec4 pos[];
+};
+
+layout( std140, binding=3 ) readonly buffer Vel {
+    vec4 vel[];
+};
+
+// Particles in cell order: position, then velocity
+layout( std430, binding=13 ) writeonly buffer SortedParticles {
+    vec4 sortedParticles[];
+};
+
+// x: first sorted index of the cell, y: particle count
+layout( std430, binding=14 ) buffer CellRanges {
+    uvec2 cellRanges[];
+};
+
+layout( std430, binding=15 ) buffer CellCounts {
+    uint cellCounts[];
+};
+
+// x: cell, y: rank of the particle within its cell
+layout( std430, binding=16 ) buffer ParticleCells {
+    uvec2 particleCells[];
+};
+
+layout( std430, binding=17 ) buffer BlockTotals {
+    uint blockTotals[];
+};
+
+layout(local_size_x = GRID_GROUP_SIZE,  local_size_y = 1, local_size_z = 1) in;
+
+uint cellHash(vec3 p) {
+    ivec3 c = ivec3(floor(p / cellSize));
+    uint h = (uint(c.x) * 73856093u) ^ (uint(c.y) * 19349663u) ^ (uint(c.z) * 83492791u);
+    return h & (numCells - 1u);
+}
+
+#ifdef GRID_COUNT
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= count) return;
+
+    uint cell = cellHash(pos[i].xyz);
+    uint rank = atomicAdd(cellCounts[cell], 1u);
+    particleCells[i] = uvec2(cell, rank);
+}
+
+#endif
+
+#ifdef GRID_SCAN_BLOCKS
+
+// Exclusive scan of GRID_BLOCK cell counts per group; the block sum goes to blockTotals
+shared uint scratch[GRID_BLOCK];
+
+void main() {
+    uint t = gl_LocalInvocationID.x;
+    uint base = gl_WorkGroupID.x * GRID_BLOCK;
+
+    uint c0 = cellCounts[base + 2u * t];
+    uint c1 = cellCounts[base + 2u * t + 1u];
+    scratch[2u * t] = c0;
+    scratch[2u * t + 1u] = c1;
+
+    // Blelloch up-sweep
+    uint offset = 1u;
+    for (uint d = GRID_BLOCK >> 1; d > 0u; d >>= 1) {
+        barrier();
+        if (t < d) {
+            uint a = offset * (2u * t + 1u) - 1u;
+            uint b = offset * (2u * t + 2u) - 1u;
+            scratch[b] += scratch[a];
+        }
+        offset <<= 1;
+    }
+
+    barrier();
+    if (t == 0u) {
+        blockTotals[gl_WorkGroupID.x] = scratch[GRID_BLOCK - 1u];
+        scratch[GRID_BLOCK - 1u] = 0u;
+    }
+
+    // Down-sweep
+    for (uint d = 1u; d < GRID_BLOCK; d <<= 1) {
+        offset >>= 1;
+        barrier();
+        if (t < d) {
+            uint a = offset * (2u * t + 1u) - 1u;
+            uint b = offset * (2u * t + 2u) - 1u;
+            uint v = scratch[a];
+            scratch[a] = scratch[b];
+            scratch[b] += v;
+        }
+    }
+    barrier();
+
+    cellRanges[base + 2u * t] = uvec2(scratch[2u * t], c0);
+    cellRanges[base + 2u * t + 1u] = uvec2(scratch[2u * t + 1u], c1);
+}
+
+#endif
+
+#ifdef GRID_SCAN_TOTALS
+
+// Dispatched as a single work group: exclusive scan of the block totals in place
+shared uint partial[GRID_GROUP_SIZE];
+
+void main() {
+    uint t = gl_LocalInvocationID.x;
+    uint total = numCells / GRID_BLOCK;
+    uint chunk = (total + GRID_GROUP_SIZE - 1u) / GRID_GROUP_SIZE;
+    uint begin = min(t * chunk, total);
+    uint end = min(begin + chunk, total);
+
+    uint sum = 0u;
+    for (uint n = begin; n < end; n++) {
+        sum += blockTotals[n];
+    }
+    partial[t] = sum;
+    barrier();
+
+    for (uint offset = 1u; offset < GRID_GROUP_SIZE; offset <<= 1) {
+        uint v = t >= offset ? partial[t - offset] : 0u;
+        barrier();
+        partial[t] += v;
+        barrier();
+    }
+
+    uint running = partial[t] - sum;
+    for (uint n = begin; n < end; n++) {
+        uint c = blockTotals[n];
+        blockTotals[n] = running;
+        running += c;
+    }
+}
+
+#endif
+
+#ifdef GRID_ADD_TOTALS
+
+void main() {
+    uint cell = gl_GlobalInvocationID.x;
+    if (cell >= numCells) return;
+
+    cellRanges[cell].x += blockTotals[cell / GRID_BLOCK];
+}
+
+#endif
+
+#ifdef GRID_SCATTER
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= count) return;
+
+    uvec2 pc = particleCells[i];
+    uint dst = cellRanges[pc.x].x + pc.y;
+    sortedParticles[dst * 2u] = pos[i];
+    sortedParticles[dst * 2u + 1u] = vel[i];
+}
+
+#endif
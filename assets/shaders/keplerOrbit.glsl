@@ -0,0 +1,75 @@
+// Closed Kepler orbits around the origin, shared by orbitPass.cs and basePass.verrt (KEPLER_ORBITS).
+// Inserted in place of the "// @KEPLER_ORBIT" line by KeplerOrbits::insertOrbitCode.
+//
+// Each particle owns 3 words of packed orbital elements, indexed by particle id (see KeplerOrbits):
+//   word 0: unorm16 semi-major axis / KEPLER_MAX_AXIS, unorm16 eccentricity
+//   word 1: unorm16 inclination / pi, unorm16 longitude of the ascending node / 2pi
+//   word 2: unorm16 argument of periapsis / 2pi, unorm16 mean anomaly at t = 0 / 2pi
+// Nothing is integrated: the position at any time t is a pure function of the elements.
+
+layout( std430, binding=19 ) readonly buffer OrbitElementWords {
+    uint orbitElements[];
+};
+
+#define KEPLER_MAX_AXIS 2.0
+#define KEPLER_PI 3.14159265359
+#define KEPLER_TWO_PI 6.28318530718
+// Newton on E - e sin E = M from E0 = M + e sin M: the starter error is O(e^2) and every
+// iteration squares it, so 4 iterations reach float precision for e <= 0.3
+#define KEPLER_ITERATIONS 4
+
+// keplerOrbit(T) is instantiated for float (one particle) and vec4 (four particles per
+// invocation, structure-of-arrays), so the solver and the frame rotation run as vector ops.
+// m0 is the mean anomaly at t = 0 in revolutions; gm is the central body's gravitational
+// parameter, giving the mean motion n = sqrt(gm / a^3) in radians per second.
+// Velocity is per second.
+#define KEPLER_ORBIT(T) \
+T solveKepler(T M, T e) { \
+    T E = M + e * sin(M); \
+    for (int k = 0; k < KEPLER_ITERATIONS; k++) { \
+        E -= (E - e * sin(E) - M) / (1.0 - e * cos(E)); \
+    } \
+    return E; \
+} \
+void keplerOrbit(T a, T e, T incl, T node, T peri, T m0, float t, float gm, \
+                 out T px, out T py, out T pz, out T vx, out T vy, out T vz) { \
+    T n = sqrt(gm / (a * a * a)); \
+    T M = KEPLER_TWO_PI * fract(m0 + n * (t / KEPLER_TWO_PI)); \
+    T E = solveKepler(M, e); \
+    T cosE = cos(E), sinE = sin(E); \
+    T b = a * sqrt(1.0 - e * e); \
+    T x = a * (cosE - e), y = b * sinE; \
+    T dE = n / (1.0 - e * cosE); \
+    T dx = -a * sinE * dE, dy = b * cosE * dE; \
+    T cosO = cos(node), sinO = sin(node); \
+    T cosW = cos(peri), sinW = sin(peri); \
+    T cosI = cos(incl), sinI = sin(incl); \
+    T Px = cosO * cosW - sinO * sinW * cosI, Py = sinW * sinI, Pz = sinO * cosW + cosO * sinW * cosI; \
+    T Qx = -cosO * sinW - sinO * cosW * cosI, Qy = cosW * sinI, Qz = -sinO * sinW + cosO * cosW * cosI; \
+    px = x * Px + y * Qx; py = x * Py + y * Qy; pz = x * Pz + y * Qz; \
+    vx = dx * Px + dy * Qx; vy = dx * Py + dy * Qy; vz = dx * Pz + dy * Qz; \
+}
+
+KEPLER_ORBIT(float)
+KEPLER_ORBIT(vec4)
+
+// The 6 elements of particle id, decoded
+void orbitElementsOf(uint id, out float a, out float e, out float incl, out float node, out float peri, out float m0) {
+    vec2 w0 = unpackUnorm2x16(orbitElements[3u * id]);
+    vec2 w1 = unpackUnorm2x16(orbitElements[3u * id + 1u]);
+    vec2 w2 = unpackUnorm2x16(orbitElements[3u * id + 2u]);
+    a = w0.x * KEPLER_MAX_AXIS;
+    e = w0.y;
+    incl = w1.x * KEPLER_PI;
+    node = w1.y * KEPLER_TWO_PI;
+    peri = w2.x * KEPLER_TWO_PI;
+    m0 = w2.y;
+}
+
+vec3 orbitPosition(uint id, float t, float gm) {
+    float a, e, incl, node, peri, m0;
+    orbitElementsOf(id, a, e, incl, node, peri, m0);
+    vec3 p, v;
+    keplerOrbit(a, e, incl, node, peri, m0, t, gm, p.x, p.y, p.z, v.x, v.y, v.z);
+    return p;
+}
@@ -0,0 +1,82 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// Morton-order reordering of the particle buffers.
+// MORTON_CODES writes (30-bit code, slot) pairs; after GpuRadixSort, MORTON_PERMUTE gathers
+// pos/vel/id into scratch buffers in sorted order (see ParticleReorder).
+
+#define WORK_GROUP_SIZE 128
+
+uniform uint count;
+
+layout( std140, binding=2 ) readonly buffer Pos {
+    vec4 pos[];
+};
+
+layout( std430, binding=4 ) buffer Pairs {
+    uvec2 pairs[];
+};
+
+layout(local_size_x = WORK_GROUP_SIZE,  local_size_y = 1, local_size_z = 1) in;
+
+#ifdef MORTON_CODES
+
+uniform float boundsExtent;     // codes cover the cube [-boundsExtent, boundsExtent]^3, outliers are clamped
+
+// Spreads the low 10 bits of v so there are two zero bits between each
+uint expandBits(uint v) {
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+uint morton3D(vec3 p) {
+    vec3 q = clamp(p / boundsExtent * 0.5 + 0.5, 0.0, 1.0) * 1023.0;
+    return (expandBits(uint(q.x)) << 2) | (expandBits(uint(q.y)) << 1) | expandBits(uint(q.z));
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= count) return;
+
+    pairs[i] = uvec2(morton3D(pos[i].xyz), i);
+}
+
+#endif
+
+#ifdef MORTON_PERMUTE
+
+layout( std140, binding=3 ) readonly buffer Vel {
+    vec4 vel[];
+};
+
+layout( std430, binding=7 ) readonly buffer ParticleIds {
+    uint particleIds[];
+};
+
+layout( std140, binding=8 ) writeonly buffer SortedPos {
+    vec4 sortedPos[];
+};
+
+layout( std140, binding=9 ) writeonly buffer SortedVel {
+    vec4 sortedVel[];
+};
+
+layout( std430, binding=10 ) writeonly buffer SortedIds {
+    uint sortedIds[];
+};
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= count) return;
+
+    uint slot = pairs[i].y;
+    sortedPos[i] = pos[slot];
+    sortedVel[i] = vel[slot];
+    sortedIds[i] = particleIds[slot];
+}
+
+#endif
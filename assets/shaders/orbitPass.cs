@@ -0,0 +1,58 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// Orbit mode: writes the position of every particle at orbitTime from its Kepler elements
+// (see keplerOrbit.glsl). Each invocation evaluates 4 particles with vec4 math.
+// Only pos is written per frame; vel is written once when leaving orbit mode (writeVelocity)
+// so the integrated states continue from the orbital motion.
+
+#define WORK_GROUP_SIZE 128
+
+uniform uint numParticles;
+uniform float orbitTime;
+uniform float orbitGM;
+uniform bool writeVelocity;
+uniform float velocityScale;    // seconds per integration step
+
+layout( std140, binding=2 ) writeonly buffer Pos {
+    vec4 pos[];
+};
+
+layout( std140, binding=3 ) writeonly buffer Vel {
+    vec4 vel[];
+};
+
+// Particle id of each slot, elements are indexed by id so Morton reordering needs no extra copy
+layout( std430, binding=7 ) readonly buffer ParticleIds {
+    uint ids[];
+};
+
+// @KEPLER_ORBIT
+
+layout(local_size_x = WORK_GROUP_SIZE,  local_size_y = 1, local_size_z = 1) in;
+
+void main() {
+    uint base = gl_GlobalInvocationID.x * 4u;
+    if (base >= numParticles) return;
+
+    // The tail lanes of the last invocation repeat the last particle and are not stored
+    uvec4 slot = min(uvec4(base) + uvec4(0u, 1u, 2u, 3u), uvec4(numParticles - 1u));
+
+    vec4 a, e, incl, node, peri, m0;
+    for (int k = 0; k < 4; k++) {
+        orbitElementsOf(ids[slot[k]], a[k], e[k], incl[k], node[k], peri[k], m0[k]);
+    }
+
+    vec4 px, py, pz, vx, vy, vz;
+    keplerOrbit(a, e, incl, node, peri, m0, orbitTime, orbitGM, px, py, pz, vx, vy, vz);
+
+    for (int k = 0; k < 4; k++) {
+        if (base + uint(k) < numParticles) {
+            pos[base + uint(k)] = vec4(px[k], py[k], pz[k], 1.0);
+            if (writeVelocity) {
+                vel[base + uint(k)] = vec4(vx[k], vy[k], vz[k], 0.0) * velocityScale;
+            }
+        }
+    }
+}
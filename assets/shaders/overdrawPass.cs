@@ -0,0 +1,78 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_image_load_store : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// Overdraw view (see OverdrawView). basePass.frag added one to overdrawCounts for every fragment shader
+// invocation of the particle pass. One thread per pixel maps its count to a heatmap colour, clears it for
+// the next frame, and every 16x16 group reduces its counts in shared memory before adding them to the
+// global statistics with atomics. The CPU reads the statistics a few frames later without waiting.
+
+#define GROUP_SIZE 16
+#define GROUP_THREADS (GROUP_SIZE * GROUP_SIZE)
+
+layout(r32ui, binding=0) coherent uniform uimage2D overdrawCounts;
+layout(rgba8, binding=1) writeonly uniform image2D heatmap;
+
+layout(std430, binding=28) buffer OverdrawStats {
+    uint fragments;     // sum of all counts
+    uint peak;          // largest count
+    uint coveredPixels; // pixels with at least one fragment
+};
+
+uniform float rampMax;  // overdraw shown as the last colour of the ramp (log scale)
+
+layout(local_size_x = GROUP_SIZE, local_size_y = GROUP_SIZE, local_size_z = 1) in;
+
+shared uint sFragments[GROUP_THREADS];
+shared uint sPeak[GROUP_THREADS];
+shared uint sCovered[GROUP_THREADS];
+
+// Black -> blue -> cyan -> green -> yellow -> red, then white above rampMax
+vec3 ramp(uint count) {
+    if (count == 0u) {
+        return vec3(0.0);
+    }
+    const vec3 stops[6] = vec3[6](vec3(0.0, 0.0, 0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 1.0),
+                                  vec3(0.0, 1.0, 0.0), vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0));
+    float t = log2(float(count) + 1.0) / log2(rampMax + 1.0);
+    if (t > 1.0) {
+        return vec3(1.0);
+    }
+    float x = t * 5.0;
+    int i = min(int(x), 4);
+    return mix(stops[i], stops[i + 1], x - float(i));
+}
+
+void main() {
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(overdrawCounts);
+    uint local = gl_LocalInvocationIndex;
+
+    uint count = 0u;
+    if (all(lessThan(p, size))) {
+        count = imageLoad(overdrawCounts, p).r;
+        imageStore(overdrawCounts, p, uvec4(0u));
+        imageStore(heatmap, p, vec4(ramp(count), 1.0));
+    }
+
+    sFragments[local] = count;
+    sPeak[local] = count;
+    sCovered[local] = count > 0u ? 1u : 0u;
+    barrier();
+
+    for (uint stride = GROUP_THREADS / 2u; stride > 0u; stride >>= 1) {
+        if (local < stride) {
+            sFragments[local] += sFragments[local + stride];
+            sPeak[local] = max(sPeak[local], sPeak[local + stride]);
+            sCovered[local] += sCovered[local + stride];
+        }
+        barrier();
+    }
+
+    if (local == 0u && sCovered[0] > 0u) {
+        atomicAdd(fragments, sFragments[0]);
+        atomicMax(peak, sPeak[0]);
+        atomicAdd(coveredPixels, sCovered[0]);
+    }
+}
@@ -23,13 +23,66 @@ layout(std140, binding=1) uniform ShaderParams {
     float particleState; 
     float stateTime;  
     float heartScale; 
+
+    uint numAttractors;
+    uint numSwarmBodies;
+
+    float gridCellSize;
+    uint numGridCells;
+    uint maxNeighbors;
+
+    float fluidExtent;
+
+    uint targetOffsetA;
+    uint targetOffsetB;
+    float targetMorph;
+
+    uint noiseOctaves;
+    uint integrator;
+    float dt;
+    float dampingPerSecond;
 };
 
 #define WORK_GROUP_SIZE 128
 
+// Shader variants (ParticleSystem::variantDefines): PARTICLE_STATE compiles a single state, and
+// USE_ATTRACTOR / USE_CLUSTER / NOISE_OCTAVES fix the feature toggles at compile time.
+// Without PARTICLE_STATE this is the uber-kernel that branches on particleState at run time.
+#define STATE_NORMAL 0
+#define STATE_ABSORB 1
+#define STATE_SHAPE 2
+#define STATE_SWARM 3
+#define STATE_FLOCK 4
+#define STATE_FLUID 5
+
+#ifndef PARTICLE_STATE
+#define USE_ATTRACTOR 1
+#define USE_CLUSTER 1
+#endif
+
+// Integrators (ParticleSystem::Integrator). LEGACY is the original per-frame step and ignores dt;
+// the others advance the force-driven states by dt seconds. INTEGRATOR fixes the choice in variants.
+#define INTEGRATOR_LEGACY 0
+#define INTEGRATOR_EULER 1      // semi-implicit (symplectic) Euler, 1 force evaluation
+#define INTEGRATOR_VERLET 2     // velocity Verlet, 2 force evaluations
+#define INTEGRATOR_RK4 3        // classic Runge-Kutta, 4 force evaluations
+
+#ifdef INTEGRATOR
+#define ACTIVE_INTEGRATOR INTEGRATOR
+#else
+#define ACTIVE_INTEGRATOR int(integrator)
+#endif
+
+// Time unit of the integrated states: velocities stay in world units per reference frame, so
+// switching integrators keeps their meaning and the legacy step is the h = 1 case
+#define REFERENCE_FPS 60.0
+
 uniform float invNoiseSize;
 uniform sampler3D noiseTex3D;
 
+// Fluid state: velocity grid of FluidSolver (world units per frame) covering [-fluidExtent, fluidExtent]^3
+uniform sampler3D fluidVelocity;
+
 // SSBO binding points: use 2 and 3 to avoid conflict with UBO at binding=1
 layout( std140, binding=2 ) buffer Pos {
     vec4 pos[];
@@ -39,8 +92,65 @@ layout( std140, binding=3 ) buffer Vel {
     vec4 vel[];
 };
 
+// Original particle index of each slot; slots are permuted by Morton reordering (mortonPass.cs)
+layout( std430, binding=7 ) readonly buffer ParticleIds {
+    uint particleIds[];
+};
+
+// Attractor cluster: xyz position, w strength (AttractorCluster)
+layout( std430, binding=11 ) readonly buffer Attractors {
+    vec4 attractors[];
+};
+
+// Self-gravity of the swarm state: per-frame acceleration of the first numSwarmBodies slots,
+// solved asynchronously on the CPU (SwarmGravity / BarnesHut)
+layout( std430, binding=12 ) readonly buffer SwarmAccel {
+    vec4 swarmAccel[];
+};
+
+#define SWARM_DAMPING 0.998             // per reference frame
+
+// Flock state: neighbours come from the spatial hash grid rebuilt before this pass (gridPass.cs).
+// Position/velocity are read from the cell-sorted copy, so every invocation sees the previous step.
+layout( std430, binding=13 ) readonly buffer SortedParticles {
+    vec4 sortedParticles[];
+};
+
+layout( std430, binding=14 ) readonly buffer CellRanges {
+    uvec2 cellRanges[];
+};
+
+#define FLOCK_SEPARATION_RADIUS 0.4     // fraction of the neighbour radius
+#define FLOCK_ALIGNMENT 0.05
+#define FLOCK_COHESION 0.02
+#define FLOCK_SEPARATION 0.00002
+#define FLOCK_CONTAINMENT 0.002
+#define FLOCK_MIN_SPEED 0.002
+#define FLOCK_MAX_SPEED 0.006
+
+// Shape states: one precomputed target per particle id and shape, shapes stored back to back (ShapeTargets).
+// The target is mix(shape A, shape B, targetMorph).
+layout( std430, binding=18 ) readonly buffer ShapeTargetPoints {
+    vec4 shapeTargets[];
+};
+
+#define FLUID_DRAG 0.5                  // how fast particles relax to the local flow velocity
+#define FLUID_CONTAINMENT 0.01
+
+// Absorbing and shape states: acceleration, velocity-to-position gain and damping per reference frame
+#define ABSORB_STRENGTH 5.0
+#define ABSORB_GAIN 0.5
+#define ABSORB_DAMPING 0.8
+#define SHAPE_SPRING 2.0
+#define SHAPE_GAIN 0.3
+#define SHAPE_DAMPING 0.85
+#define SETTLE_DISTANCE 0.001           // closer than this the particle snaps to its target
+
 layout(local_size_x = WORK_GROUP_SIZE,  local_size_y = 1, local_size_z = 1) in;
 
+#if USE_CLUSTER
+shared vec4 attractorTile[WORK_GROUP_SIZE];
+#endif
 
 vec3 noise3f(vec3 p) {
     return texture(noiseTex3D, p * invNoiseSize).xyz;
@@ -68,6 +178,91 @@ vec3 attract(vec3 p, vec3 p2) {
     return v * invDistCubed;
 }
 
+#if USE_CLUSTER
+// N-body style tiling: the work group loads WORK_GROUP_SIZE attractors into shared memory
+// at a time, so each attractor is fetched from global memory once per group, not per particle.
+// Must be reached by every invocation of the group because of the barriers.
+vec3 attractCluster(vec3 p) {
+    vec3 sum = vec3(0.0);
+    uint local = gl_LocalInvocationID.x;
+
+    for (uint tile = 0u; tile < numAttractors; tile += uint(WORK_GROUP_SIZE)) {
+        uint a = tile + local;
+        attractorTile[local] = a < numAttractors ? attractors[a] : vec4(0.0);
+        barrier();
+
+        uint count = min(uint(WORK_GROUP_SIZE), numAttractors - tile);
+        for (uint j = 0u; j < count; j++) {
+            sum += attract(p, attractorTile[j].xyz) * attractorTile[j].w;
+        }
+        barrier();
+    }
+    return sum;
+}
+#endif
+
+// Cluster attraction at p. Must be reached by every invocation of the group because of the barriers
+vec3 clusterAt(vec3 p) {
+#if USE_CLUSTER
+    if (particleState < 0.5 && numAttractors > 0u) {
+        return attractCluster(p);
+    }
+#endif
+    return vec3(0.0);
+}
+
+// Must match gridPass.cs
+uint cellHash(ivec3 c) {
+    uint h = (uint(c.x) * 73856093u) ^ (uint(c.y) * 19349663u) ^ (uint(c.z) * 83492791u);
+    return h & (numGridCells - 1u);
+}
+
+// Boids: alignment and cohesion over neighbours within gridCellSize, separation inside a smaller radius.
+// Scans the 27 cells around p and stops after maxNeighbors accepted neighbours.
+vec3 flockSteer(vec3 p, vec3 v) {
+    float radius2 = gridCellSize * gridCellSize;
+    float separation2 = radius2 * FLOCK_SEPARATION_RADIUS * FLOCK_SEPARATION_RADIUS;
+    ivec3 c = ivec3(floor(p / gridCellSize));
+
+    vec3 sumPos = vec3(0.0);
+    vec3 sumVel = vec3(0.0);
+    vec3 separation = vec3(0.0);
+    uint n = 0u;
+
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                uvec2 range = cellRanges[cellHash(c + ivec3(dx, dy, dz))];
+                for (uint k = range.x; k < range.x + range.y && n < maxNeighbors; k++) {
+                    vec3 q = sortedParticles[k * 2u].xyz;
+                    vec3 d = q - p;
+                    float r2 = dot(d, d);
+                    if (r2 < radius2 && r2 > 1e-12) {
+                        sumPos += q;
+                        sumVel += sortedParticles[k * 2u + 1u].xyz;
+                        if (r2 < separation2) {
+                            separation -= d / r2;
+                        }
+                        n++;
+                    }
+                }
+            }
+        }
+    }
+
+    vec3 steer = vec3(0.0);
+    if (n > 0u) {
+        float invN = 1.0 / float(n);
+        steer += (sumVel * invN - v) * FLOCK_ALIGNMENT;
+        steer += (sumPos * invN - p) * FLOCK_COHESION;
+        steer += separation * FLOCK_SEPARATION;
+    }
+    steer -= p * max(length(p) - 1.0, 0.0) * FLOCK_CONTAINMENT;
+    return steer;
+}
+
+#ifdef ANALYTIC_SHAPE_TARGETS
+// Previous per-frame evaluation of the heart/star curves, kept only for the shapes benchmark
 vec3 getHeartPosition(uint particleIndex) {
     float t = float(particleIndex) / float(numParticles);
     
@@ -119,67 +314,278 @@ vec3 getStarPosition(uint particleIndex) {
     
     return vec3(x, y, z);
 }
+#endif
 
-void main() {
-    uint i = gl_GlobalInvocationID.x;
+vec3 getTargetPosition(uint particleId) {
+#ifdef ANALYTIC_SHAPE_TARGETS
+    return particleState < 2.5 ? getHeartPosition(particleId) : getStarPosition(particleId);
+#else
+    vec3 target = shapeTargets[targetOffsetA + particleId].xyz;
+    if (targetMorph > 0.0) {
+        target = mix(target, shapeTargets[targetOffsetB + particleId].xyz, targetMorph);
+    }
+    return target;
+#endif
+}
 
-    if (i >= numParticles) return;
+// Noise field, point attractor and attractor cluster
+void stepNormal(inout vec3 p, inout vec3 v, vec3 cluster) {
+#ifdef NOISE_OCTAVES
+    v += fBm3f(p*noiseFreq,NOISE_OCTAVES,2.0,0.5)*noiseStrength;
+#else
+    v += fBm3f(p*noiseFreq,int(noiseOctaves),2.0,0.5)*noiseStrength;
+#endif
+#if USE_ATTRACTOR
+    v += attract(p, attractor.xyz)*attractor.w;
+#endif
+    v += cluster;
+    
+    p += v;
+    v *= damping;
+}
 
-    vec3 p = pos[i].xyz;
-    vec3 v = vel[i].xyz;
+void stepAbsorb(inout vec3 p, inout vec3 v) {
+    vec3 center = vec3(0.0, 0.0, 0.0);
+    vec3 toCenter = center - p;
+    float dist = length(toCenter);
     
-    if (particleState < 0.5) {
-        v += fBm3f(p*noiseFreq,4,2.0,0.5)*noiseStrength;
-        v += attract(p, attractor.xyz)*attractor.w;
+    if (dist > SETTLE_DISTANCE) {
+        v += normalize(toCenter) * ABSORB_STRENGTH * (1.0 / (dist + 0.01));
+    } else {
+        v = vec3(0.0);
+        p = center;
+    }
+    
+    p += v * ABSORB_GAIN;
+    v *= ABSORB_DAMPING;
+}
+
+void stepShape(inout vec3 p, inout vec3 v, uint i) {
+    vec3 targetPos = getTargetPosition(particleIds[i]);
+    
+    vec3 toTarget = targetPos - p;
+    float dist = length(toTarget);
+    
+    if (dist > SETTLE_DISTANCE) {
+        v += normalize(toTarget) * SHAPE_SPRING * dist;
         
-        p += v;
-        v *= damping;
+        p += v * SHAPE_GAIN;
+        v *= SHAPE_DAMPING;
+    } else {
+        p = targetPos;
+        v = vec3(0.0);
+    }
+}
+
+void stepSwarm(inout vec3 p, inout vec3 v, uint i) {
+    v += swarmAccel[i].xyz;
+
+    p += v;
+    v *= SWARM_DAMPING;
+}
+
+// Flock and fluid are steering rules rather than forces: every integrator applies them as a
+// semi-implicit Euler step of h reference frames (h = 1 is the legacy step)
+void stepFlock(inout vec3 p, inout vec3 v, uint i, float h) {
+    v += flockSteer(p, v) * h;
+
+    float speed = length(v);
+    if (speed < 1e-7) {
+        // At rest (e.g. right after a shape state): pick a direction from the particle id
+        float a = float(particleIds[i]) * 2.39996323;
+        v = vec3(cos(a), sin(a * 0.5), sin(a)) * FLOCK_MIN_SPEED;
+    } else {
+        v *= clamp(speed, FLOCK_MIN_SPEED, FLOCK_MAX_SPEED) / speed;
+    }
+
+    p += v * h;
+}
+
+void stepFluid(inout vec3 p, inout vec3 v, float h) {
+    vec3 flow = texture(fluidVelocity, p / (2.0 * fluidExtent) + 0.5).xyz;
+    v = mix(v, flow, 1.0 - pow(1.0 - FLUID_DRAG, h));
+    // The grid is closed; keep particles from drifting out through the walls
+    v -= p * max(length(p) - fluidExtent * 0.9, 0.0) * FLUID_CONTAINMENT * h;
+
+    p += v * h;
+}
+
+int currentState() {
+#ifdef PARTICLE_STATE
+    return PARTICLE_STATE;
+#else
+    if (particleState > 5.5) return STATE_FLUID;
+    if (particleState > 4.5) return STATE_FLOCK;
+    if (particleState > 3.5) return STATE_SWARM;
+    if (particleState < 0.5) return STATE_NORMAL;
+    if (particleState < 1.5) return STATE_ABSORB;
+    return STATE_SHAPE;
+#endif
+}
+
+// The force-driven states in continuous time (reference frames as the time unit):
+//   dp/dt = gain * v,    dv/dt = accel(p) - drag * v
+// With h = 1 and semi-implicit Euler this reproduces the legacy steps above.
+#define FORCE_FIELD 0       // noise field, point attractor and cluster
+#define FORCE_ABSORB 1
+#define FORCE_SPRING 2      // towards the shape target
+#define FORCE_CONSTANT 3    // swarm self-gravity, solved on the CPU once per frame
+
+struct Dynamics {
+    int force;
+    float gain;
+    float drag;
+    vec3 anchor;            // spring target or constant acceleration
+};
+
+Dynamics dynamicsOf(vec3 p, uint i, bool inRange, out bool settled) {
+    Dynamics d;
+    d.force = FORCE_FIELD;
+    d.gain = 1.0;
+    d.drag = -log(dampingPerSecond) / REFERENCE_FPS;
+    d.anchor = vec3(0.0);
+    settled = false;
+
+    int state = currentState();
+    if (state == STATE_SWARM && i < numSwarmBodies) {
+        d.force = FORCE_CONSTANT;
+        d.drag = -log(SWARM_DAMPING);
+        d.anchor = swarmAccel[i].xyz;
+    } else if (state == STATE_ABSORB) {
+        d.force = FORCE_ABSORB;
+        d.gain = ABSORB_GAIN;
+        d.drag = -log(ABSORB_DAMPING);
+        settled = !(length(p) > SETTLE_DISTANCE);
+    } else if (state == STATE_SHAPE) {
+        d.force = FORCE_SPRING;
+        d.gain = SHAPE_GAIN;
+        d.drag = -log(SHAPE_DAMPING);
+        d.anchor = inRange ? getTargetPosition(particleIds[i]) : p;
+        settled = !(length(d.anchor - p) > SETTLE_DISTANCE);
+    }
+    return d;
+}
+
+// Every invocation of the group must make the same calls (cluster barriers)
+vec3 accelAt(Dynamics d, vec3 p) {
+    vec3 cluster = clusterAt(p);
+    if (d.force == FORCE_FIELD) {
+        vec3 a;
+#ifdef NOISE_OCTAVES
+        a = fBm3f(p*noiseFreq,NOISE_OCTAVES,2.0,0.5)*noiseStrength;
+#else
+        a = fBm3f(p*noiseFreq,int(noiseOctaves),2.0,0.5)*noiseStrength;
+#endif
+#if USE_ATTRACTOR
+        a += attract(p, attractor.xyz)*attractor.w;
+#endif
+        return a + cluster;
+    }
+    if (d.force == FORCE_ABSORB) {
+        float dist = length(p);
+        return dist > 0.0 ? -p / dist * (ABSORB_STRENGTH / (dist + 0.01)) : vec3(0.0);
+    }
+    if (d.force == FORCE_SPRING) {
+        return (d.anchor - p) * SHAPE_SPRING;
+    }
+    return d.anchor;
+}
+
+// Advances p, v by h reference frames; drag is applied exactly as exp(-drag * h)
+void integrate(Dynamics d, inout vec3 p, inout vec3 v, float h) {
+    if (ACTIVE_INTEGRATOR == INTEGRATOR_EULER) {
+        v += accelAt(d, p) * h;
+        p += v * (d.gain * h);
+        v *= exp(-d.drag * h);
+    } else if (ACTIVE_INTEGRATOR == INTEGRATOR_VERLET) {
+        // Drag split symmetrically around the kick-drift-kick step
+        float halfDecay = exp(-d.drag * h * 0.5);
+        v = v * halfDecay + accelAt(d, p) * (0.5 * h);
+        p += v * (d.gain * h);
+        v = (v + accelAt(d, p) * (0.5 * h)) * halfDecay;
+    } else {
+        vec3 k1p = v * d.gain;
+        vec3 k1v = accelAt(d, p) - v * d.drag;
+        vec3 v2 = v + k1v * (0.5 * h);
+        vec3 k2p = v2 * d.gain;
+        vec3 k2v = accelAt(d, p + k1p * (0.5 * h)) - v2 * d.drag;
+        vec3 v3 = v + k2v * (0.5 * h);
+        vec3 k3p = v3 * d.gain;
+        vec3 k3v = accelAt(d, p + k2p * (0.5 * h)) - v3 * d.drag;
+        vec3 v4 = v + k3v * h;
+        vec3 k4p = v4 * d.gain;
+        vec3 k4v = accelAt(d, p + k3p * h) - v4 * d.drag;
+        p += (k1p + 2.0 * (k2p + k3p) + k4p) * (h / 6.0);
+        v += (k1v + 2.0 * (k2v + k3v) + k4v) * (h / 6.0);
+    }
+}
+
+void stepLegacy(inout vec3 p, inout vec3 v, uint i, vec3 cluster) {
+#if !defined(PARTICLE_STATE)
+    if (particleState > 5.5) {
+        stepFluid(p, v, 1.0);
+    } else if (particleState > 4.5) {
+        stepFlock(p, v, i, 1.0);
+    } else if (particleState > 3.5 && i < numSwarmBodies) {
+        stepSwarm(p, v, i);
+    } else if (particleState < 0.5 || particleState > 3.5) {
+        stepNormal(p, v, cluster);
     } else if (particleState < 1.5) {
-        vec3 center = vec3(0.0, 0.0, 0.0);
-        vec3 toCenter = center - p;
-        float dist = length(toCenter);
-        
-        float absorbStrength = 5.0;
-        if (dist > 0.001) {
-            v += normalize(toCenter) * absorbStrength * (1.0 / (dist + 0.01));
-        } else {
-            v = vec3(0.0);
-            p = center;
-        }
-        
-        p += v * 0.5;
-        v *= 0.8;
-    } else if (particleState < 2.5) {
-        vec3 targetPos = getHeartPosition(i);
-        
-        vec3 toTarget = targetPos - p;
-        float dist = length(toTarget);
-        
-        if (dist > 0.001) {
-            float springStrength = 2.0;
-            v += normalize(toTarget) * springStrength * dist;
-            
-            p += v * 0.3;
-            v *= 0.85; // Damping
-        } else {
-            p = targetPos;
-            v = vec3(0.0);
-        }
+        stepAbsorb(p, v);
     } else {
-        vec3 targetPos = getStarPosition(i);
-        
-        vec3 toTarget = targetPos - p;
-        float dist = length(toTarget);
-        
-        if (dist > 0.001) {
-            float springStrength = 2.0;
-            v += normalize(toTarget) * springStrength * dist;
-            
-            p += v * 0.3;
-            v *= 0.85; // Damping
+        stepShape(p, v, i);
+    }
+#elif PARTICLE_STATE == STATE_NORMAL
+    stepNormal(p, v, cluster);
+#elif PARTICLE_STATE == STATE_ABSORB
+    stepAbsorb(p, v);
+#elif PARTICLE_STATE == STATE_SHAPE
+    stepShape(p, v, i);
+#elif PARTICLE_STATE == STATE_SWARM
+    // Bodies beyond the solved set keep following the noise field
+    if (i < numSwarmBodies) {
+        stepSwarm(p, v, i);
+    } else {
+        stepNormal(p, v, cluster);
+    }
+#elif PARTICLE_STATE == STATE_FLOCK
+    stepFlock(p, v, i, 1.0);
+#elif PARTICLE_STATE == STATE_FLUID
+    stepFluid(p, v, 1.0);
+#endif
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    bool inRange = i < numParticles;
+
+    vec3 p = inRange ? pos[i].xyz : vec3(0.0);
+    vec3 v = inRange ? vel[i].xyz : vec3(0.0);
+
+    if (ACTIVE_INTEGRATOR == INTEGRATOR_LEGACY) {
+        // Evaluated before the early return so the whole group reaches the barriers
+        vec3 cluster = clusterAt(p);
+        if (!inRange) return;
+        stepLegacy(p, v, i, cluster);
+    } else {
+        float h = dt * REFERENCE_FPS;
+        int state = currentState();
+        if (state == STATE_FLUID) {
+            if (!inRange) return;
+            stepFluid(p, v, h);
+        } else if (state == STATE_FLOCK) {
+            if (!inRange) return;
+            stepFlock(p, v, i, h);
         } else {
-            p = targetPos;
-            v = vec3(0.0);
+            // Out-of-range invocations integrate too, for the cluster barriers
+            bool settled;
+            Dynamics d = dynamicsOf(p, i, inRange, settled);
+            integrate(d, p, v, h);
+            if (!inRange) return;
+            if (settled) {
+                p = d.anchor;
+                v = vec3(0.0);
+            }
         }
     }
 
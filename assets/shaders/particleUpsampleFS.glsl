@@ -0,0 +1,46 @@
+#version 430
+
+in vec2 TexCoord;
+out vec4 FragColor;
+
+uniform sampler2D lowResTexture;
+
+// Range sigma, relative to the guide luminance: smaller keeps sprite edges crisper
+const float sigmaRange = 0.25;
+
+float luminance(vec3 c) {
+    return dot(c, vec3(0.2126, 0.7152, 0.0722));
+}
+
+void main() {
+    vec2 lowSize = vec2(textureSize(lowResTexture, 0));
+    ivec2 maxCoord = ivec2(lowSize) - 1;
+
+    vec2 st = TexCoord * lowSize - 0.5;
+    ivec2 base = ivec2(floor(st));
+    vec2 f = st - vec2(base);
+
+    // There is no full-res depth or colour to guide the filter, so the low-res texel
+    // covering this pixel acts as the guide: bilinear taps that differ strongly from
+    // it lie across an edge and are down-weighted instead of being smeared in.
+    vec3 guide = texelFetch(lowResTexture, clamp(ivec2(TexCoord * lowSize), ivec2(0), maxCoord), 0).rgb;
+    float guideLum = luminance(guide);
+
+    vec3 result = vec3(0.0);
+    float weightSum = 0.0;
+
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            vec3 c = texelFetch(lowResTexture, clamp(base + ivec2(x, y), ivec2(0), maxCoord), 0).rgb;
+
+            float spatialWeight = (x == 0 ? 1.0 - f.x : f.x) * (y == 0 ? 1.0 - f.y : f.y);
+            float d = (luminance(c) - guideLum) / (sigmaRange * guideLum + 1e-3);
+            float weight = spatialWeight * exp(-0.5 * d * d) + 1e-5;
+
+            result += c * weight;
+            weightSum += weight;
+        }
+    }
+
+    FragColor = vec4(result / weightSum, 1.0);
+}
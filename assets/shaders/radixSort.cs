@@ -0,0 +1,141 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// Stable LSD radix sort of (key, value) pairs, 4 bits per pass.
+// Compiled once per kernel with RADIX_COUNT, RADIX_SCAN or RADIX_SCATTER defined (see GpuRadixSort).
+
+#define RADIX_GROUP_SIZE 256
+#define RADIX_ITEMS 4
+#define RADIX_TILE 1024u        // RADIX_GROUP_SIZE * RADIX_ITEMS elements per work group
+#define RADIX_DIGITS 16u
+
+uniform uint count;
+uniform uint shift;
+uniform uint numTiles;
+
+layout( std430, binding=4 ) readonly buffer Src {
+    uvec2 src[];
+};
+
+layout( std430, binding=5 ) writeonly buffer Dst {
+    uvec2 dst[];
+};
+
+// Digit-major: histogram[digit * numTiles + tile], so one exclusive scan yields every scatter base
+layout( std430, binding=6 ) buffer Histogram {
+    uint histogram[];
+};
+
+layout(local_size_x = RADIX_GROUP_SIZE,  local_size_y = 1, local_size_z = 1) in;
+
+uint digitOf(uint key) {
+    return (key >> shift) & (RADIX_DIGITS - 1u);
+}
+
+#ifdef RADIX_COUNT
+
+shared uint tileCounts[RADIX_DIGITS];
+
+void main() {
+    uint t = gl_LocalInvocationID.x;
+    if (t < RADIX_DIGITS) tileCounts[t] = 0u;
+    barrier();
+
+    uint base = gl_WorkGroupID.x * RADIX_TILE;
+    for (uint n = 0u; n < RADIX_ITEMS; n++) {
+        uint e = base + n * RADIX_GROUP_SIZE + t;
+        if (e < count) {
+            atomicAdd(tileCounts[digitOf(src[e].x)], 1u);
+        }
+    }
+    barrier();
+
+    if (t < RADIX_DIGITS) {
+        histogram[t * numTiles + gl_WorkGroupID.x] = tileCounts[t];
+    }
+}
+
+#endif
+
+#ifdef RADIX_SCAN
+
+// Dispatched as a single work group: each thread scans a contiguous chunk,
+// chunk totals are combined with a shared-memory scan
+shared uint partial[RADIX_GROUP_SIZE];
+
+void main() {
+    uint t = gl_LocalInvocationID.x;
+    uint total = numTiles * RADIX_DIGITS;
+    uint chunk = (total + RADIX_GROUP_SIZE - 1u) / RADIX_GROUP_SIZE;
+    uint begin = min(t * chunk, total);
+    uint end = min(begin + chunk, total);
+
+    uint sum = 0u;
+    for (uint n = begin; n < end; n++) {
+        sum += histogram[n];
+    }
+    partial[t] = sum;
+    barrier();
+
+    for (uint offset = 1u; offset < RADIX_GROUP_SIZE; offset <<= 1) {
+        uint v = t >= offset ? partial[t - offset] : 0u;
+        barrier();
+        partial[t] += v;
+        barrier();
+    }
+
+    uint running = partial[t] - sum;
+    for (uint n = begin; n < end; n++) {
+        uint c = histogram[n];
+        histogram[n] = running;
+        running += c;
+    }
+}
+
+#endif
+
+#ifdef RADIX_SCATTER
+
+// Each thread owns RADIX_ITEMS consecutive elements, so ranking by (thread, item) keeps the sort stable
+shared uint threadOffsets[RADIX_DIGITS][RADIX_GROUP_SIZE];
+
+void main() {
+    uint t = gl_LocalInvocationID.x;
+    uint tile = gl_WorkGroupID.x;
+    uint first = tile * RADIX_TILE + t * RADIX_ITEMS;
+
+    for (uint d = 0u; d < RADIX_DIGITS; d++) {
+        threadOffsets[d][t] = 0u;
+    }
+
+    uvec2 items[RADIX_ITEMS];
+    for (uint n = 0u; n < RADIX_ITEMS; n++) {
+        if (first + n < count) {
+            items[n] = src[first + n];
+            threadOffsets[digitOf(items[n].x)][t]++;
+        }
+    }
+    barrier();
+
+    // Per digit, turn the per-thread counts into global output offsets
+    if (t < RADIX_DIGITS) {
+        uint running = histogram[t * numTiles + tile];
+        for (uint n = 0u; n < RADIX_GROUP_SIZE; n++) {
+            uint c = threadOffsets[t][n];
+            threadOffsets[t][n] = running;
+            running += c;
+        }
+    }
+    barrier();
+
+    for (uint n = 0u; n < RADIX_ITEMS; n++) {
+        if (first + n < count) {
+            uint d = digitOf(items[n].x);
+            dst[threadOffsets[d][t]] = items[n];
+            threadOffsets[d][t]++;
+        }
+    }
+}
+
+#endif
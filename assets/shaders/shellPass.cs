@@ -0,0 +1,69 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// Position-based dynamics for the geodesic shell (see ShellConstraints). The shell occupies the
+// first particle slots; particlePass.cs predicts their positions, then:
+//   SHELL_SOLVE     projects the distance constraints of one colour. Constraints of a colour share
+//                   no particle, so every invocation owns both of its endpoints and needs no atomics.
+//   SHELL_FINALIZE  derives the velocity from the corrected position change. Like particlePass.cs the
+//                   velocity is per reference frame (1/60 s), and a step spans h of them.
+// Compiled once per kernel with one of the two defined.
+
+#define SHELL_GROUP_SIZE 256
+
+uniform uint first;             // SHELL_SOLVE: first constraint of the colour
+uniform uint count;             // constraints in the colour, or shell particles for SHELL_FINALIZE
+uniform vec2 stiffness;         // per pass, stretch and bend, already corrected for the iteration count
+uniform float damping;          // velocity kept per reference frame
+uniform float h;                // step length in reference frames, 1 for the legacy integrator
+
+layout( std140, binding=2 ) buffer Pos {
+    vec4 pos[];
+};
+
+layout( std140, binding=3 ) buffer Vel {
+    vec4 vel[];
+};
+
+// Particle slots a and b are kept restLength apart; kind 0 is a shell edge, 1 spans two triangles (bending)
+struct Constraint {
+    uint a;
+    uint b;
+    float restLength;
+    uint kind;
+};
+
+layout( std430, binding=20 ) readonly buffer Constraints {
+    Constraint constraints[];
+};
+
+// Shell positions before the prediction step
+layout( std430, binding=21 ) readonly buffer PrevPos {
+    vec4 prevPos[];
+};
+
+layout(local_size_x = SHELL_GROUP_SIZE,  local_size_y = 1, local_size_z = 1) in;
+
+void main() {
+    uint k = gl_GlobalInvocationID.x;
+    if (k >= count) return;
+
+#ifdef SHELL_SOLVE
+    Constraint c = constraints[first + k];
+    vec3 pa = pos[c.a].xyz;
+    vec3 pb = pos[c.b].xyz;
+    vec3 d = pb - pa;
+    float len = length(d);
+    if (len < 1e-9) return;
+
+    // Equal masses: each endpoint moves half of the error
+    vec3 correction = d * ((len - c.restLength) / len * 0.5 * stiffness[c.kind]);
+    pos[c.a] = vec4(pa + correction, 1.0);
+    pos[c.b] = vec4(pb - correction, 1.0);
+#endif
+
+#ifdef SHELL_FINALIZE
+    vel[k] = vec4((pos[k].xyz - prevPos[k].xyz) * (pow(damping, h) / h), 0.0);
+#endif
+}
@@ -0,0 +1,139 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// Bitonic sort of (view depth key, particle index) pairs, farthest first.
+// Compiled once per kernel with SORT_KEYS, SORT_LOCAL or SORT_GLOBAL defined (see ParticleSorter).
+
+layout(std140, binding=1) uniform ShaderParams {
+    mat4 ModelView;
+    mat4 ModelViewProjection;
+    mat4 ProjectionMatrix;
+
+    vec4 attractor;
+
+    uint numParticles;
+    float spriteSize;
+    float damping;
+    float particleScale;
+
+    float noiseFreq;
+    float noiseStrength;
+};
+
+#define SORT_GROUP_SIZE 512
+#define SORT_BLOCK_SIZE 1024u  // elements sorted in shared memory by one work group
+
+layout( std140, binding=2 ) readonly buffer Pos {
+    vec4 pos[];
+};
+
+// x = order-preserving depth key, y = particle index (0xffffffff for padding)
+layout( std430, binding=4 ) buffer SortList {
+    uvec2 entries[];
+};
+
+uniform uint entryCount;        // padded to a power of two
+
+layout(local_size_x = SORT_GROUP_SIZE,  local_size_y = 1, local_size_z = 1) in;
+
+// Index of the lower element handled by thread t in a compare step of distance j
+uint lowerIndex(uint t, uint j) {
+    return ((t & ~(j - 1u)) << 1) | (t & (j - 1u));
+}
+
+#ifdef SORT_KEYS
+
+// Maps a float to a uint with the same ordering, so keys compare as integers
+uint floatToSortKey(float f) {
+    uint bits = floatBitsToUint(f);
+    return (bits & 0x80000000u) != 0u ? ~bits : bits | 0x80000000u;
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= entryCount) return;
+
+    uint index = entries[i].y;
+    uint key = 0xffffffffu;
+    if (index < numParticles) {
+        // Eye-space z is negative in front of the camera: ascending z is back-to-front
+        vec4 eye = ModelView * vec4(pos[index].xyz * particleScale, 1.0);
+        key = floatToSortKey(eye.z);
+    }
+    entries[i].x = key;
+}
+
+#endif
+
+#ifdef SORT_LOCAL
+
+uniform uint blockOffset;       // SORT_BLOCK_SIZE/2 on odd incremental passes
+uniform uint mergeStage;        // 0: sort each block from scratch, otherwise finish global stage k
+uniform bool alternateBlocks;   // full sort: even blocks ascending, odd descending (bitonic input)
+
+shared uvec2 block[SORT_BLOCK_SIZE];
+
+void compareExchange(uint i, uint j, bool ascending) {
+    uvec2 a = block[i];
+    uvec2 b = block[i + j];
+    if ((a.x > b.x) == ascending) {
+        block[i] = b;
+        block[i + j] = a;
+    }
+}
+
+void main() {
+    uint t = gl_LocalInvocationID.x;
+    uint base = blockOffset + gl_WorkGroupID.x * SORT_BLOCK_SIZE;
+
+    for (uint n = t; n < SORT_BLOCK_SIZE; n += SORT_GROUP_SIZE) {
+        block[n] = base + n < entryCount ? entries[base + n] : uvec2(0xffffffffu);
+    }
+    barrier();
+
+    if (mergeStage == 0u) {
+        bool blockAscending = !alternateBlocks || (base & SORT_BLOCK_SIZE) == 0u;
+        for (uint k = 2u; k <= SORT_BLOCK_SIZE; k <<= 1) {
+            for (uint j = k >> 1; j > 0u; j >>= 1) {
+                uint i = lowerIndex(t, j);
+                compareExchange(i, j, k == SORT_BLOCK_SIZE ? blockAscending : (i & k) == 0u);
+                barrier();
+            }
+        }
+    } else {
+        for (uint j = SORT_BLOCK_SIZE >> 1; j > 0u; j >>= 1) {
+            uint i = lowerIndex(t, j);
+            compareExchange(i, j, ((base + i) & mergeStage) == 0u);
+            barrier();
+        }
+    }
+
+    for (uint n = t; n < SORT_BLOCK_SIZE; n += SORT_GROUP_SIZE) {
+        if (base + n < entryCount) {
+            entries[base + n] = block[n];
+        }
+    }
+}
+
+#endif
+
+#ifdef SORT_GLOBAL
+
+uniform uint stage;             // k: size of the bitonic sequences being merged
+uniform uint stepSize;          // j: compare distance, >= SORT_BLOCK_SIZE
+
+void main() {
+    uint t = gl_GlobalInvocationID.x;
+    if (t >= entryCount / 2u) return;
+
+    uint i = lowerIndex(t, stepSize);
+    uvec2 a = entries[i];
+    uvec2 b = entries[i + stepSize];
+    if ((a.x > b.x) == ((i & stage) == 0u)) {
+        entries[i] = b;
+        entries[i + stepSize] = a;
+    }
+}
+
+#endif
@@ -0,0 +1,111 @@
+#version 430
+#extension GL_ARB_compute_shader : enable
+#extension GL_ARB_shader_image_load_store : enable
+
+// Temporal reconstruction of the reduced-resolution particle pass (see TemporalUpsample).
+// The low-res particles were drawn with a sub-pixel jitter: the sample of low-res texel i lies at
+// i + 0.5 - jitter in low-res pixel units. One thread per full-resolution pixel blends the
+// reprojected history with the nearest jittered sample, weighted by how close that sample is to
+// the pixel centre, and writes both the new history and the scene.
+
+#define GROUP_SIZE 16
+
+uniform sampler2D lowResTexture;
+uniform sampler2D historyTexture;
+
+layout(rgba16f, binding=0) writeonly uniform image2D historyOut;
+layout(rgba16f, binding=1) writeonly uniform image2D sceneOut;
+
+uniform vec2 jitter;            // low-res pixels, in [-0.5, 0.5)
+uniform mat4 reprojection;      // current NDC -> previous clip space, including the particle scale change
+uniform float focusDepth;       // NDC depth assumed for every pixel (particles have no depth)
+uniform vec2 parallaxDepths;    // NDC depths in front of and behind the focus point bounding the particles
+uniform int historyValid;
+uniform float sampleBlend;      // weight of a sample landing exactly on the pixel centre
+uniform float parallaxRejection; // history discarded per pixel of parallax between parallaxDepths
+
+// Range sigma of the spatial estimate, as in particleUpsampleFS.glsl
+const float sigmaRange = 0.25;
+
+layout(local_size_x = GROUP_SIZE, local_size_y = GROUP_SIZE, local_size_z = 1) in;
+
+float luminance(vec3 c) {
+    return dot(c, vec3(0.2126, 0.7152, 0.0722));
+}
+
+void main() {
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(sceneOut);
+    if (any(greaterThanEqual(p, size))) {
+        return;
+    }
+
+    vec2 lowSize = vec2(textureSize(lowResTexture, 0));
+    ivec2 maxCoord = ivec2(lowSize) - 1;
+    vec2 uv = (vec2(p) + 0.5) / vec2(size);
+    vec2 s = uv * lowSize;
+
+    // Nearest jittered sample and its distance to this pixel in full-resolution pixels
+    ivec2 nearest = clamp(ivec2(floor(s + jitter)), ivec2(0), maxCoord);
+    vec2 offset = (vec2(nearest) + 0.5 - jitter - s) * (vec2(size) / lowSize);
+    float sampleWeight = exp(-2.29 * dot(offset, offset));
+
+    vec3 nearestColor = texelFetch(lowResTexture, nearest, 0).rgb;
+
+    // The 2x2 samples around the pixel (with the jitter undone) bound what the history may
+    // contribute. A wider window would span 3x3 low-res texels, i.e. up to 12 pixels at 1/4
+    // resolution, and keep thin shapes' ghosts. Weighted like particleUpsampleFS.glsl, with the
+    // nearest sample as the guide, they also give the spatial estimate used where there is no history
+    vec2 st = s + jitter - 0.5;
+    ivec2 base = ivec2(floor(st));
+    vec2 f = st - vec2(base);
+    float guideLum = luminance(nearestColor);
+    vec3 neighbourMin = vec3(1e9);
+    vec3 neighbourMax = vec3(-1e9);
+    vec3 spatial = vec3(0.0);
+    float weightSum = 0.0;
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            vec3 c = texelFetch(lowResTexture, clamp(base + ivec2(x, y), ivec2(0), maxCoord), 0).rgb;
+            neighbourMin = min(neighbourMin, c);
+            neighbourMax = max(neighbourMax, c);
+
+            float spatialWeight = (x == 0 ? 1.0 - f.x : f.x) * (y == 0 ? 1.0 - f.y : f.y);
+            float d = (luminance(c) - guideLum) / (sigmaRange * guideLum + 1e-3);
+            float weight = spatialWeight * exp(-0.5 * d * d) + 1e-5;
+            spatial += c * weight;
+            weightSum += weight;
+        }
+    }
+    spatial /= weightSum;
+
+    vec3 result = spatial;
+    if (historyValid != 0) {
+        vec2 ndc = uv * 2.0 - 1.0;
+        vec4 previousClip = reprojection * vec4(ndc, focusDepth, 1.0);
+        vec2 previousUV = previousClip.xy / previousClip.w * 0.5 + 0.5;
+        bool onScreen = previousClip.w > 0.0 && all(greaterThanEqual(previousUV, vec2(0.0))) &&
+                        all(lessThanEqual(previousUV, vec2(1.0)));
+        if (onScreen) {
+            vec3 history = texture(historyTexture, previousUV).rgb;
+            vec3 clamped = clamp(history, neighbourMin, neighbourMax);
+
+            // Only a sample near the pixel centre adds to the history; blending in the spatial
+            // estimate every frame would pull it back to the blurrier single-frame result
+            vec3 accumulated = mix(clamped, nearestColor, sampleBlend * sampleWeight);
+
+            // History outside the neighbourhood belongs to a particle that moved away (or arrived),
+            // and when the camera moves the assumed depth misplaces particles in front of or behind
+            // the focus point by up to the parallax between the two bounding depths: either way
+            // the spatial estimate takes over
+            float rejection = abs(luminance(history) - luminance(clamped)) / max(luminance(clamped), 0.05);
+            vec4 nearClip = reprojection * vec4(ndc, parallaxDepths.x, 1.0);
+            vec4 farClip = reprojection * vec4(ndc, parallaxDepths.y, 1.0);
+            float parallax = length((nearClip.xy / nearClip.w - farClip.xy / farClip.w) * 0.5 * vec2(size));
+            result = mix(accumulated, spatial, clamp(max(rejection, parallax * parallaxRejection), 0.0, 1.0));
+        }
+    }
+
+    imageStore(historyOut, p, vec4(result, 1.0));
+    imageStore(sceneOut, p, vec4(result, 1.0));
+}
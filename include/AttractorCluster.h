@@ -0,0 +1,57 @@
+#ifndef ATTRACTOR_CLUSTER_H
+#define ATTRACTOR_CLUSTER_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// 环绕球体运动的引力源星团，每帧在CPU上按圆轨道推进后上传到SSBO
+// 上传不阻塞: 缓冲分为kRegions段轮流写入，每段用fence确认GPU读完后再以
+// GL_MAP_UNSYNCHRONIZED_BIT映射，驱动无需等待正在使用的缓冲
+class AttractorCluster
+{
+public:
+    static const int kMaxAttractors = 4096;
+
+    AttractorCluster(int maxCount = kMaxAttractors);
+    ~AttractorCluster();
+
+    // 重新生成count个引力源的轨道(固定种子，结果可复现)
+    void setCount(int count);
+    int getCount() const { return m_count; }
+
+    // 推进到time并写入下一段缓冲
+    void update(float time);
+
+    GLuint getBuffer() const { return m_buffer; }
+    GLintptr getOffset() const { return (GLintptr)(m_region * m_regionStride); }
+    GLsizeiptr getRangeSize() const { return (GLsizeiptr)(m_maxCount * sizeof(glm::vec4)); }
+
+    const std::vector<glm::vec4>& getAttractors() const { return m_attractors; }
+
+    float totalStrength;    // 所有引力源强度之和，按数量平均分配
+
+private:
+    static const int kRegions = 3;
+
+    struct Orbit
+    {
+        float radius;
+        float inclination;
+        float node;
+        float phase;
+        float angularSpeed;
+    };
+
+    int m_maxCount;
+    int m_count;
+    std::vector<Orbit> m_orbits;
+    std::vector<glm::vec4> m_attractors;
+
+    GLuint m_buffer;
+    size_t m_regionStride;
+    int m_region;
+    GLsync m_fences[kRegions];
+};
+
+#endif // ATTRACTOR_CLUSTER_H
@@ -0,0 +1,52 @@
+#ifndef AUTO_EXPOSURE_H
+#define AUTO_EXPOSURE_H
+
+#include <GL/gl3w.h>
+#include <cstdint>
+#include "ShaderBuffer.h"
+
+// GPU自动曝光(exposurePass.cs)，全程无CPU回读、不阻塞管线:
+// 1. 直方图: 每个线程取2x2像素的平均亮度，每个16x16工作组在共享内存中原子累计256档对数亮度直方图，
+//    再把非空档加到全局直方图
+// 2. 归约: 单个工作组去掉最暗lowPercent与最亮highPercent的像素，求其余像素对数亮度的平均，
+//    目标曝光 = key / 平均亮度，在对数空间按adaptationRate指数趋近，并清空直方图供下一帧使用
+// 曝光写在绑定点27的缓冲中，Bloom提取/分类与合成着色器直接读取；关闭时reset()写回1.0，画面与未曝光时相同
+class AutoExposure
+{
+public:
+    static const int kNumBins = 256;
+
+    explicit AutoExposure(const char* shaderPrefix);
+    ~AutoExposure();
+
+    void loadShaders();
+
+    // 由场景构建直方图并更新曝光
+    void update(GLuint sceneTexture, int width, int height, float deltaTime);
+
+    // 把曝光设为固定值，不等待GPU
+    void reset(float exposure = 1.0f);
+
+    // 绑定曝光缓冲到绑定点27
+    void bind();
+
+    // 回读当前曝光与上次归约的平均亮度，会等待GPU，仅用于统计
+    float readExposure(float* averageLuminance = nullptr);
+
+    float key;                  // 目标平均亮度
+    float lowPercent;           // 忽略最暗的比例: 大部分画面是背景，只按最亮的几个百分点(粒子)测光
+    float highPercent;          // 忽略最亮的比例(个别饱和的粒子核心)
+    float minExposure;
+    float maxExposure;
+    float adaptationRate;       // 每秒趋近目标的速率
+
+private:
+    ShaderBuffer<uint32_t>* m_histogram;
+    ShaderBuffer<float>* m_exposure;        // exposure, averageLuminance
+
+    GLuint m_histogramProg;
+    GLuint m_averageProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // AUTO_EXPOSURE_H
@@ -0,0 +1,86 @@
+#ifndef BARNES_HUT_H
+#define BARNES_HUT_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+struct BarnesHutStats
+{
+    double buildMs;
+    double traverseMs;
+    size_t numNodes;
+    double interactionsPerBody;   // 平均每个粒子求和的节点+粒子数量
+};
+
+// CPU Barnes-Hut八叉树引力求解器
+// 构建: 63位Morton码(每轴21位)并行排序后，按码的前缀自顶向下划分，
+//       顶部几层串行展开，其下的子树分给多个线程并行构建后拼接
+// 遍历: 以叶子(最多kLeafSize个空间相邻的粒子)为组，整组共享一次遍历生成的交互列表，
+//       求和时内层循环遍历组内粒子，各粒子独立累加，便于编译器向量化；
+//       Morton码相同的粒子在最深一层无法再分，这样的叶子按kLeafSize分块求和
+class BarnesHut
+{
+public:
+    static const int kLeafSize = 16;
+
+    explicit BarnesHut(int numThreads = 0);
+
+    // 计算每个粒子受到的加速度(xyz)，accel与pos下标一一对应
+    void solve(const glm::vec4* pos, size_t count, glm::vec4* accel);
+
+    void build(const glm::vec4* pos, size_t count);
+    void computeAccelerations(glm::vec4* accel);
+
+    // 直接求和，用于评估误差
+    glm::vec3 computeDirect(const glm::vec4* pos, size_t count, size_t body) const;
+
+    const BarnesHutStats& getStats() const { return m_stats; }
+    int getNumThreads() const { return m_numThreads; }
+
+    float theta;        // 张角阈值: 节点宽度/距离 < theta 时用质心近似
+    float gravity;      // G * 总质量，每个粒子质量为 1/N
+    float softening;    // 软化长度，避免近距离奇点
+
+private:
+    struct Node
+    {
+        glm::vec3 com;
+        float mass;
+        glm::vec3 center;
+        float halfSize;
+        int firstChild;     // 子节点连续存放
+        int childCount;     // 0表示叶子
+        uint32_t bodyBegin;
+        uint32_t bodyEnd;
+    };
+
+    struct SubtreeTask
+    {
+        int node;
+        uint32_t begin;
+        uint32_t end;
+        int level;
+    };
+
+    void buildNode(std::vector<Node>& nodes, int index, uint32_t begin, uint32_t end, int level,
+                   std::vector<SubtreeTask>* tasks);
+    void finalizeNode(std::vector<Node>& nodes, int index);
+    void computeLeafGroup(const Node& leaf, glm::vec4* accel, std::vector<float>& list, size_t& interactions) const;
+
+    int m_numThreads;
+    size_t m_count;
+    float m_bodyMass;
+
+    // 按Morton序排列的粒子(SoA)
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_order;
+    std::vector<float> m_x, m_y, m_z;
+
+    std::vector<Node> m_nodes;
+    std::vector<int> m_leaves;
+
+    BarnesHutStats m_stats;
+};
+
+#endif // BARNES_HUT_H
@@ -0,0 +1,31 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+
+// 命令行 --bench <name> 运行的离屏GPU基准测试，结果打印到标准输出
+//   sort    - 视深排序: 键值更新 / 全排序 / 增量排序的耗时与残余逆序，1M与4M粒子
+//   reorder - Morton序重排前后的计算与绘制耗时，以及重排本身的开销，1M与4M粒子
+//   attractors - 1~4096个引力源对1M粒子的计算耗时与吞吐量
+//   barnes-hut - CPU八叉树引力在32K~512K粒子、不同张角下的构建/遍历耗时与力误差，以及大量粒子重合时的力误差
+//   grid    - 邻域网格各重建阶段与鸟群查询步进的耗时，256K与1M粒子
+//   fluid   - 网格流体在64^3~128^3、10~40次压力迭代下各阶段的耗时，以及粒子平流的耗时
+//   shapes  - 网格面积加权采样在不同线程数下的吞吐量，形状状态步进查表与逐帧求值曲线的耗时对比
+//   variants - 各状态下uber-kernel与按状态特化的着色器变体的步进耗时与程序大小，1M粒子
+//   orbits  - 开普勒轨道模式(计算着色器/顶点着色器求值)与积分模式的耗时、每粒子读写字节数，以及逐帧积分的漂移
+//   integrators - 各积分器每步的耗时(1M粒子)，以及CPU参考实现上各受力状态可用的最大步长与每秒受力计算次数
+//   shell   - PBD壳体在6万~98万个约束时每次约束投影的耗时与颜色数，以及不同迭代次数下的残余拉伸误差
+//   bloom   - 1080p/1440p/4K下片元着色器Bloom链与计算着色器mip链的整帧耗时，以及计算路径各阶段的耗时
+//   resize  - 模拟拖动缩放窗口，每次按实际尺寸重新分配与渲染目标池分桶复用、停止后再分配的耗时与分配次数
+//   framegraph - 4K下帧图之前常驻的后处理目标与帧图别名、格式选择后实际分配的显存，以及各配置裁剪的pass
+//   sparsebloom - 1080p/4K下不同相机距离与阈值(高亮覆盖面积)时逐像素片元链与分块稀疏链的整帧耗时与活动块比例
+//   fusedbloom - 1080p/1440p/4K下普通片元链与融合链(提取并入降采样、合成并入上采样)的pass数、估算显存流量与整帧耗时
+//   exposure - 自动曝光直方图与归约的耗时，以及爱心/散开/五角星状态序列中场景平均亮度与曝光随时间的变化
+//   temporal - 相机环绕与形状切换时，1/2、1/4分辨率粒子的空间上采样与时间重建相对全分辨率的整帧耗时与PSNR
+//   sprites - 剔除与未剔除路径下八边形精灵与四边形的整帧耗时、管线统计查询的顶点/片段着色器调用数与PSNR
+//   stochastic - 相机距离3/6/10时随机LOD关闭与开启的整帧耗时、保留的精灵与单像素点数、片段着色器调用数与PSNR
+// 返回0表示成功，可直接作为进程退出码
+int runBenchmark(GLFWwindow* window, const char* name);
+
+#endif // BENCHMARKS_H
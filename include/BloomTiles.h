@@ -0,0 +1,61 @@
+#ifndef BLOOM_TILES_H
+#define BLOOM_TILES_H
+
+#include <GL/gl3w.h>
+#include <cstdint>
+#include "ShaderBuffer.h"
+
+// 稀疏Bloom的屏幕分块分类(bloomTiles.cs): 大部分画面低于Bloom阈值，提取/降采样/上采样却逐像素执行。
+// 1. 分类: 场景按64x64像素分块，每块一个工作组，标记含有超过阈值像素的块
+// 2. 压缩: 每块一个线程，dilation块之内有被标记块的即为活动块，追加到块列表，
+//    并由GPU累加间接绘制命令的实例数
+// 之后各Bloom片元pass以draw()对每个活动块绘制一个四边形(glDrawArraysIndirect)，
+// 块坐标归一化，各级分辨率共用一份列表；非活动块由清屏置零。全程无CPU回读
+class BloomTiles
+{
+public:
+    static const int kTileSize = 64;
+
+    explicit BloomTiles(const char* shaderPrefix);
+    ~BloomTiles();
+
+    void loadShaders();
+
+    // 按场景分辨率重新分配块缓冲
+    void resize(int width, int height);
+
+    // 分类 + 压缩，之后的draw()只覆盖活动块
+    void classify(GLuint sceneTexture, float threshold);
+
+    // 以当前程序间接绘制活动块，顶点着色器从绑定点24读取块坐标(见bloomExtractVS.glsl)
+    void draw();
+
+    int getTileCountX() const { return m_tilesX; }
+    int getTileCountY() const { return m_tilesY; }
+    // 块在纹理坐标中的尺寸，传给顶点着色器的tileSize
+    float getTileSizeU() const { return m_width > 0 ? (float)kTileSize / m_width : 0.0f; }
+    float getTileSizeV() const { return m_height > 0 ? (float)kTileSize / m_height : 0.0f; }
+
+    // 回读上一次分类的活动块数，会等待GPU，仅用于统计
+    int readActiveTileCount();
+
+    // 膨胀的块数。降采样与双边上采样在最低一级(1/8)的覆盖范围约为全分辨率的60像素，一块即可
+    int dilation;
+
+private:
+    void destroyBuffers();
+
+    int m_width;            // 场景分辨率
+    int m_height;
+    int m_tilesX;
+    int m_tilesY;
+    ShaderBuffer<uint32_t>* m_mask;         // 每块一个标记
+    ShaderBuffer<uint32_t>* m_list;         // 活动块 x | (y << 16)
+    ShaderBuffer<uint32_t>* m_command;      // DrawArraysIndirectCommand
+
+    GLuint m_classifyProg;
+    GLuint m_compactProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // BLOOM_TILES_H
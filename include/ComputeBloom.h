@@ -0,0 +1,52 @@
+#ifndef COMPUTE_BLOOM_H
+#define COMPUTE_BLOOM_H
+
+#include <GL/gl3w.h>
+#include <cstdint>
+#include "ShaderBuffer.h"
+
+// 计算着色器Bloom(bloomPass.cs)，替代逐级全屏绘制的片元着色器链:
+// 1. 单次调度的降采样: 每个工作组读取64x64场景像素做阈值提取，在寄存器与共享内存中逐级平均，
+//    写出mip链第0~5级(1/2~1/64分辨率)；最后完成的工作组(全局原子计数)再由第5级生成第6级
+// 2. 由最小级向上，每级一次小调度，把3x3帐篷滤波的下一级加到本级上(9次双线性采样)
+// 结果在mip链第0级(1/2分辨率)，由bloomCombineFS.glsl双线性放大后与场景合成。
+// 无需逐级绑定FBO、清屏，也省去了全分辨率的提取与双边上采样
+class ComputeBloom
+{
+public:
+    static const int kNumLevels = 7;
+
+    explicit ComputeBloom(const char* shaderPrefix);
+    ~ComputeBloom();
+
+    void loadShaders();
+
+    // 按场景分辨率重新分配mip链
+    void resize(int width, int height);
+
+    // downsample + upsample
+    void render(GLuint sceneTexture);
+
+    // 两个阶段，分开调用便于基准测试分别计时
+    void downsample(GLuint sceneTexture);
+    void upsample();
+
+    // mip链，第0级为最终的Bloom
+    GLuint getBloomTexture() const { return m_chain; }
+
+    float threshold;        // 与片元着色器链相同的亮度阈值
+
+private:
+    void destroyTextures();
+
+    int m_width;            // 场景分辨率
+    int m_height;
+    GLuint m_chain;
+    ShaderBuffer<uint32_t>* m_counter;      // 已完成的工作组数，由最后一个工作组清零
+
+    GLuint m_downsampleProg;
+    GLuint m_upsampleProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // COMPUTE_BLOOM_H
@@ -8,14 +8,64 @@
 #include "ShaderUtils.h" 
 #include "noise.h"
 #include "uniforms.h"
+#include <string>
+#include <vector>
 
 class ParticleSystem;
+class ParticleCuller;
+class ParticleSorter;
+class ParticleReorder;
+class AttractorCluster;
+class SwarmGravity;
+class NeighborGrid;
+class FluidSolver;
+class ShapeTargets;
+class KeplerOrbits;
+class ShellConstraints;
+class ComputeBloom;
+class BloomTiles;
+class AutoExposure;
+class TemporalUpsample;
+class OverdrawView;
+class RenderTargetPool;
+class FrameGraph;
+struct RenderTarget;
+class GpuTimer;
 
 enum ParticleState {
     Normal,   
     Absorbing, 
     HeartShape,
-    StarShape 
+    StarShape,
+    Swarm,      // 粒子群自引力(CPU Barnes-Hut)，手动切换进入/退出
+    Flock,      // 鸟群(邻域查询网格)，手动切换进入/退出
+    Fluid,      // 随欧拉网格流体平流，手动切换进入/退出
+    ShapeMorph, // 在两个形状目标之间渐变，着色器中与爱心/五角星同一分支，手动切换
+    Orbit,      // 开普勒轨道(KeplerOrbits)，位置由轨道根数直接求值，不积分，手动切换
+    Shell       // PBD测地壳体(ShellConstraints)，前几个槽位为壳体顶点，其余粒子按普通状态运动，手动切换
+};
+
+// 粒子绘制分辨率
+enum ParticleResolution {
+    FullResolution,
+    HalfResolution,
+    QuarterResolution,
+    AutoResolution     // 根据实测填充耗时每帧自动选择
+};
+
+// 粒子混合方式
+enum ParticleBlendMode {
+    AdditiveBlend,         // 加性混合，无需排序
+    SortedOverBlend,       // 按视深全排序后由远及近"over"混合
+    IncrementalOverBlend   // 同上，但利用帧间相关性每帧只做几轮增量排序
+};
+
+// Bloom实现
+enum BloomPath {
+    FragmentChainBloom,    // 全分辨率提取 + 逐级降采样/双边上采样的全屏绘制
+    ComputeMipBloom,       // 单次调度生成整条mip链，再逐级帐篷滤波上采样(ComputeBloom)
+    SparseTileBloom,       // 同片元着色器链，但只间接绘制含高亮像素的屏幕块及其邻域(BloomTiles)
+    FusedChainBloom        // 同片元着色器链，提取并入第一次降采样、合成并入最后一次上采样，省去两个全分辨率pass
 };
 
 class ComputeParticles
@@ -26,17 +76,73 @@ public:
     
     bool init(GLFWwindow* window);
     void draw(float deltaTime);
-    void reshape(int width, int height);
+    // interactive为true时来自窗口缩放事件: 连续缩放期间渲染目标按分桶尺寸复用，停止后再按实际尺寸分配
+    void reshape(int width, int height, bool interactive = false);
     void handleKey(int key, int action);
     void handleMouseButton(int button, int action, int mods);
     void handleMouseMove(double xpos, double ypos);
     void handleScroll(double xoffset, double yoffset);
     
     void reset();
+    
+    // 需在init之前调用
+    void setParticleCount(int32_t count) { mParticleCount = count; }
+    // 追加一个OBJ/PLY网格作为形状目标，需在init之前调用
+    void addShapeFile(const char* path) { mShapeFiles.push_back(path); }
+    void setBloomPath(BloomPath path) { mBloomPath = path; }
+    // Bloom提取的亮度阈值，各实现共用
+    void setBloomThreshold(float threshold);
+    // 回读稀疏Bloom上一帧的活动块数与总块数，会等待GPU，仅用于统计
+    void getBloomTileCoverage(int& activeTiles, int& totalTiles);
+    // 关闭时曝光固定为1.0
+    void setAutoExposure(bool enabled);
+    // 回读当前曝光，会等待GPU，仅用于统计
+    float readExposure(float* averageLuminance = nullptr);
+    void setParticleResolution(ParticleResolution resolution) { mParticleResolution = resolution; }
+    // 降分辨率时以抖动采样累加到全分辨率历史，代替单帧的空间上采样；全分辨率时无效果
+    void setTemporalUpsample(bool enabled);
+    // 以全分辨率、无抖动重新绘制本帧粒子，返回帧图中场景相对它的PSNR(dB)，会等待GPU，仅用于统计。
+    // 参考帧不做随机LOD；quadReference为true时以四边形精灵绘制
+    float measureParticlePSNR(bool quadReference = false);
+    void setCulling(bool enabled) { mEnableCulling = enabled; }
+    // 剔除路径下按每块估计的overdraw随机保留一部分粒子并按比例加权(见ParticleCuller)
+    void setStochasticLod(bool enabled) { mStochasticLod = enabled; }
+    // 上一次剔除保留的精灵与单像素点数，会等待GPU，仅用于统计；未剔除时返回false
+    bool readCullCounts(unsigned int& sprites, unsigned int& points);
+    // 加性混合(剔除与未剔除)路径的精灵以八边形实例代替四边形绘制
+    void setOctagonSprites(bool enabled) { mOctagonSprites = enabled; }
+    // 帧图每个pass的管线统计查询，overdraw视图打开时自动开启
+    void setPipelineStatistics(bool enabled);
+    // 帧图粒子pass最近一次的顶点/图元/片段着色器调用数，会等待GPU，仅用于统计；
+    // 未开启管线统计或不支持查询时返回false
+    bool readParticleStatistics(GLuint64& vertices, GLuint64& primitives, GLuint64& fragments);
+    // 以粒子pass的overdraw热力图代替合成后的画面
+    void setOverdrawView(bool enabled);
+    // overdraw视图最近一次完成的统计: 被覆盖像素的平均、全部像素的平均与峰值。wait为true时等待GPU；
+    // 视图关闭或还没有结果时返回false
+    bool readOverdraw(float& coveredAverage, float& screenAverage, unsigned int& peak, bool wait = false);
+    // 渲染目标池累计创建的目标数
+    int getRenderTargetAllocations() const;
+    // 场景与后处理的帧图，用于统计显存与裁剪情况
+    const FrameGraph* getFrameGraph() const { return mFrameGraph; }
 
 private:
     ShaderParams mShaderParams;
-    ShaderProgram* mRenderProg;
+    // 粒子精灵程序，共用basePass.verrt/basePass.frag，按宏各编译一个变体
+    struct SpritePrograms
+    {
+        ShaderProgram* quad;
+        ShaderProgram* list;           // 从剔除后的压缩索引列表取粒子(USE_DRAW_LIST)
+        ShaderProgram* point;          // 亚像素粒子画成单像素点(POINT_SPRITE)
+        ShaderProgram* sorted;         // 按排序列表由远及近"over"混合(SORTED_DRAW_LIST)
+        ShaderProgram* orbit;          // 顶点着色器中直接求轨道位置(KEPLER_ORBITS)
+        ShaderProgram* octagon;        // 八边形精灵(OCTAGON_SPRITE)，衰减查表，无discard
+        ShaderProgram* octagonList;    // 同上，从剔除后的压缩索引列表取粒子
+    };
+    SpritePrograms mSprites;
+    SpritePrograms mOverdrawSprites;   // 同上并定义OVERDRAW_COUNT，第一次打开overdraw视图时编译
+    GLuint mFalloffTexture;            // 八边形精灵的衰减表
+    bool mOctagonSprites;
     
     const static int mNumParticles = 1<<20;
     ParticleSystem* mParticles;
@@ -45,9 +151,61 @@ private:
     GLuint mVBO;
     GLuint mVAO;
     
+    // 视锥剔除与LOD
+    ParticleCuller* mCuller;
+    bool mEnableCulling;
+    bool mStochasticLod;
+    
+    // 降分辨率粒子绘制
+    ParticleResolution mParticleResolution;
+    int mAutoDivisor;                  // 自动模式当前的分辨率除数(1/2/4)
+    int mAutoCooldown;                 // 切换后等待计时稳定的帧数
+    float mParticleBudgetMs;           // 粒子填充的GPU时间预算
+    bool mReportParticleResolution;
+    GpuTimer* mParticleTimer;
+    TemporalUpsample* mTemporal;
+    bool mTemporalUpsample;
+    
+    // 按视深排序的"over"混合
+    ParticleBlendMode mBlendMode;
+    ParticleSorter* mSorter;
+    
+    // Morton序重排
+    ParticleReorder* mReorder;
+    
+    // 多引力源星团
+    AttractorCluster* mAttractors;
+    
+    // 粒子群自引力
+    SwarmGravity* mSwarm;
+    
+    // 鸟群邻域查询
+    NeighborGrid* mGrid;
+    
+    // 网格流体
+    FluidSolver* mFluid;
+    
+    // 形状目标点云
+    ShapeTargets* mShapes;
+    std::vector<std::string> mShapeFiles;
+    int mHeartShape;
+    int mStarShape;
+    int mMorphFrom;                    // 渐变的起止形状
+    int mMorphTo;
+    float mMorphDuration;
+    
+    // 开普勒轨道模式
+    KeplerOrbits* mOrbits;
+    float mOrbitTime;                  // 轨道时间(秒)，可任意跳转
+    bool mOrbitActive;                 // 上一帧是否处于轨道模式，离开时写回位置与速度
+    
+    // PBD壳体
+    ShellConstraints* mShell;
+    
     bool mEnableAttractor;
     bool mAnimate;
     float mTime;
+    int mSubsteps;                     // 本帧粒子更新的子步数(按dt积分时)
     
     // 形状效果状态
     ParticleState mParticleState;      // 当前粒子状态
@@ -71,25 +229,70 @@ private:
     float mCameraAzimuth;      
     float mCameraElevation;  
     
-    // Bloom后处理效果
-    GLuint mSceneFBO;          
-    GLuint mSceneTexture;  
-    GLuint mBloomFBO[4];      
-    GLuint mBloomTexture[4];   
-    GLuint mBloomUpsampleFBO[3];   
-    GLuint mBloomUpsampleTexture[3];
+    // 场景与Bloom后处理由帧图组织，渲染目标由帧图从mTargetPool中分配
+    RenderTargetPool* mTargetPool;
+    FrameGraph* mFrameGraph;
+    int mSceneHandle;                  // 帧图中的场景纹理
+    int mFrameGraphDivisor;            // 帧图按此粒子分辨率与Bloom实现构建，变化时重建
+    BloomPath mFrameGraphBloomPath;
+    int mRenderWidth;                  // 渲染目标尺寸，缩放过程中可能与窗口不同，合成时拉伸到窗口
+    int mRenderHeight;
+    bool mResizePending;               // 渲染目标尚未按最终窗口尺寸分配
+    float mResizeIdleTime;             // 距上次缩放事件的时间
+    BloomPath mBloomPath;
+    float mBloomThreshold;
+    ComputeBloom* mComputeBloom;
+    BloomTiles* mBloomTiles;
+    AutoExposure* mAutoExposure;
+    bool mAutoExposureEnabled;
+    float mFrameDeltaTime;             // 本帧的时间步，帧图中随时间平滑的pass(自动曝光)使用
+    
+    // overdraw热力图与每个pass的管线统计
+    OverdrawView* mOverdraw;
+    bool mOverdrawView;
+    float mOverdrawReportTime;         // 距上次打印统计的时间
     
     ShaderProgram* mBloomExtractProg;
     ShaderProgram* mBloomDownsampleProg;
     ShaderProgram* mBloomUpsampleProg;
     ShaderProgram* mBloomCombineProg;
+    ShaderProgram* mBloomFusedDownsampleProg;  // 直接读取场景并逐纹素提取的第一次降采样
+    ShaderProgram* mBloomFusedUpsampleProg;    // 读取场景作细节并与之合成、写默认帧缓冲的最后一次上采样
+    ShaderProgram* mParticleUpsampleProg;
     
     GLuint mScreenQuadVAO;
     GLuint mScreenQuadVBO;
     
-    void initBloomResources();
-    void destroyBloomResources();
-    void renderBloom();
+    void updateShaderParams(float deltaTime);
+    void renderFrame();
+    void renderParticlesAt(int divisor, RenderTarget* scene);
+    // countOverdraw为true时每次片段着色器调用在overdraw计数图像上加一
+    void drawParticles(GLuint fbo, int width, int height, bool countOverdraw = false);
+    void reportOverdraw();
+    // 编译一组精灵程序，defines加在各变体自身的宏之前；八边形与轨道变体失败时置空
+    bool loadSpritePrograms(SpritePrograms& progs, const std::string& defines);
+    void destroySpritePrograms(SpritePrograms& progs);
+    void createFalloffTexture();
+    // 轨道模式下没有剔除/排序读取位置缓冲时，跳过orbitPass.cs，由顶点着色器求位置
+    bool evaluateOrbitsInVertexShader() const;
+    void upsampleParticles(GLuint lowResTexture, RenderTarget* scene);
+    int chooseParticleDivisor();
+    bool useTemporalUpsample(int divisor) const;
+    void jitterParticleProjection(int divisor);
+    void reportParticleResolution();
+    
+    void loadPostProcessShaders();
+    void destroyPostProcessShaders();
+    void setRenderSize(int width, int height);
+    void buildFrameGraph(int divisor);
+    void drawScreenQuad();
+    void drawBloomGeometry(ShaderProgram* prog, bool sparse);
+    void bloomExtractPass(GLuint sceneTexture, RenderTarget* dst, bool sparse);
+    void bloomDownsamplePass(GLuint srcTexture, RenderTarget* dst, bool sparse);
+    void bloomUpsamplePass(GLuint lowResTexture, GLuint highResTexture, RenderTarget* dst, bool sparse);
+    void bloomCombinePass(GLuint sceneTexture, GLuint bloomTexture);
+    void bloomFusedDownsamplePass(GLuint sceneTexture, RenderTarget* dst);
+    void bloomFusedUpsamplePass(GLuint lowResTexture, GLuint sceneTexture);
     void createScreenQuad();
 };
 
@@ -0,0 +1,68 @@
+#ifndef FLUID_SOLVER_H
+#define FLUID_SOLVER_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+
+// 欧拉网格流体(stable fluids)，覆盖 [-domainExtent, domainExtent]^3 的立方体(fluidPass.cs)
+// 每步: 半拉格朗日平流(含喷流外力) -> 涡度 -> 涡度约束 -> 散度 -> Jacobi压力迭代 -> 投影
+// 速度以 世界单位/帧 存储在RGBA16F三维纹理中，粒子在particlePass.cs中三线性采样后随之平流，
+// 因此开销只与网格分辨率和迭代次数有关，与粒子数量无关
+class FluidSolver
+{
+public:
+    static const int kNumJets = 3;
+
+    FluidSolver(int gridSize, const char* shaderPrefix);
+    ~FluidSolver();
+
+    void loadShaders();
+
+    // 重新分配网格纹理，速度场清零
+    void setResolution(int gridSize);
+    int getResolution() const { return m_gridSize; }
+
+    // 完整的一步，time用于推进喷流位置
+    void step(float time);
+
+    // 各阶段，按顺序调用等价于step()，分开调用便于基准测试分别计时
+    void advect(float time);
+    void confineVorticity();
+    void computeDivergence();
+    void solvePressure();
+    void project();
+
+    // 当前速度场，可直接作为sampler3D采样(线性过滤、边缘钳制)
+    GLuint getVelocityTexture() const { return m_velocity[m_current]; }
+
+    float domainExtent;     // 立方体半边长
+    int jacobiIterations;
+    float dissipation;      // 每步速度衰减
+    float vorticity;        // 涡度约束强度
+    float jetStrength;      // 喷流每步注入的速度
+
+private:
+    void createTextures();
+    void destroyTextures();
+    void dispatch(GLuint prog);
+    float getCellSize() const { return 2.0f * domainExtent / m_gridSize; }
+
+    int m_gridSize;
+    int m_current;
+    int m_pressureCurrent;
+
+    GLuint m_velocity[2];
+    GLuint m_vorticity;
+    GLuint m_pressure[2];
+    GLuint m_divergence;
+
+    GLuint m_advectProg;
+    GLuint m_curlProg;
+    GLuint m_confineProg;
+    GLuint m_divergenceProg;
+    GLuint m_jacobiProg;
+    GLuint m_projectProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // FLUID_SOLVER_H
@@ -0,0 +1,112 @@
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <GL/gl3w.h>
+#include "PipelineStatistics.h"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class RenderTargetPool;
+struct RenderTarget;
+
+// 场景与后处理的帧图: 每个pass声明读写哪些纹理，compile()据此
+//  1. 从输出资源(如默认帧缓冲)反向追溯，裁剪输出无人读取的pass
+//  2. 计算每个临时纹理的生存期: 首个写入它的pass到最后一个读取它的pass
+//  3. 按(尺寸, 格式)把生存期不重叠的临时纹理分配到同一个物理目标。核心GL没有显存别名，
+//     以整张纹理为粒度复用，效果相同
+//  4. 不需要alpha且不做混合累加的纹理使用R11F_G11F_B10F(每像素4字节，RGBA16F的一半)
+// 物理目标取自RenderTargetPool，在下次reset()之前保持不变；execute()按声明顺序执行未裁剪的pass，
+// 开启管线统计时每个pass各自包在一组异步的PipelineStatistics查询中
+class FrameGraph
+{
+public:
+    typedef int Handle;
+    static const Handle kInvalid = -1;
+
+    struct TextureDesc
+    {
+        int width;
+        int height;
+        bool alpha;         // 需要alpha通道
+        bool blended;       // 作为混合目标反复累加，R11G11B10的6位尾数会吞掉微弱的增量
+
+        TextureDesc(int w, int h, bool needsAlpha = false, bool blendTarget = false) :
+            width(w), height(h), alpha(needsAlpha), blended(blendTarget) {}
+    };
+
+    explicit FrameGraph(RenderTargetPool* pool);
+    ~FrameGraph();
+
+    // 清空声明并把物理目标归还给池，之后重新声明并compile
+    void reset();
+
+    Handle createTexture(const char* name, const TextureDesc& desc);
+    // 图外管理的资源(默认帧缓冲、计算着色器的mip链等)，不分配；output为true时视为帧的最终输出
+    Handle importResource(const char* name, bool output);
+
+    // reads/writes中的kInvalid会被忽略
+    void addPass(const char* name, const std::vector<Handle>& reads, const std::vector<Handle>& writes,
+                 const std::function<void()>& execute);
+
+    void compile();
+    void execute();
+    bool isCompiled() const { return m_compiled; }
+
+    // 临时纹理对应的物理目标，compile之后有效
+    RenderTarget* getTarget(Handle handle) const;
+
+    // 统计: 物理目标总字节数，以及每个临时纹理各自一张RGBA16F时的字节数
+    size_t getAllocatedBytes() const;
+    size_t getUnaliasedBytes() const;
+    // 估算每帧显存流量: 每个未裁剪的pass完整读取一次输入、写入一次输出，只计临时纹理(导入资源尺寸未知)
+    size_t getTrafficBytes() const;
+    int getPassCount() const { return (int)m_passes.size(); }
+    int getCulledPassCount() const;
+    int getPhysicalTargetCount() const { return (int)m_physical.size(); }
+    // 打印每个pass是否被裁剪、每个纹理的生存期/格式/物理目标
+    void dump() const;
+
+    // 每个未裁剪的pass统计顶点/图元/片段着色器调用数，结果几帧后非阻塞回读；reset()后从头开始
+    void setPipelineStatistics(bool enabled);
+    bool getPipelineStatistics() const { return m_statisticsEnabled; }
+    // 同名pass(如各级降采样)的最近一次结果之和；wait为true时先等待所有未完成的查询。没有结果时返回false
+    bool getPassStatistics(const char* name, PipelineStatistics::Counts& counts, bool wait = false);
+    // 打印每个pass最近一次的统计
+    void dumpPipelineStatistics();
+
+private:
+    struct Resource
+    {
+        const char* name;
+        TextureDesc desc;
+        bool imported;
+        bool output;
+        GLenum format;
+        int firstPass;      // 生存期，compile之后有效
+        int lastPass;
+        int physical;       // m_physical的下标，-1表示未分配(导入或未使用)
+    };
+
+    struct Pass
+    {
+        const char* name;
+        std::vector<Handle> reads;
+        std::vector<Handle> writes;
+        std::function<void()> execute;
+        bool culled;
+        PipelineStatistics* statistics;     // 开启统计后的第一次execute()创建
+    };
+
+    static GLenum chooseFormat(const TextureDesc& desc);
+    void destroyStatistics();
+
+    RenderTargetPool* m_pool;
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<RenderTarget*> m_physical;
+    bool m_compiled;
+    bool m_statisticsEnabled;
+};
+
+#endif // FRAME_GRAPH_H
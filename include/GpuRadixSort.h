@@ -0,0 +1,33 @@
+#ifndef GPU_RADIX_SORT_H
+#define GPU_RADIX_SORT_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+#include "ShaderBuffer.h"
+
+// GPU稳定LSD基数排序，每轮4位: 分块计数 -> 全局前缀和 -> 分块稳定散射
+// 对 (key, value) 对按key的低numBits位排序，结果写回 getPairBuffer()
+class GpuRadixSort
+{
+public:
+    GpuRadixSort(size_t capacity, const char* shaderPrefix);
+    ~GpuRadixSort();
+
+    void loadShaders();
+    void sort(size_t count, int numBits);
+
+    GLuint getPairBuffer() { return m_pairs[0]->getBuffer(); }
+    size_t getCapacity() { return m_capacity; }
+
+private:
+    size_t m_capacity;
+    ShaderBuffer<glm::uvec2> *m_pairs[2];
+    ShaderBuffer<uint32_t> *m_histogram;
+
+    GLuint m_countProg;
+    GLuint m_scanProg;
+    GLuint m_scatterProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // GPU_RADIX_SORT_H
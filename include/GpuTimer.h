@@ -0,0 +1,91 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <GL/gl3w.h>
+
+// 异步GPU计时器: GL_TIMESTAMP查询对组成环形缓冲，结果在几帧后非阻塞回读
+// 使用时间戳而非GL_TIME_ELAPSED，因此多个计时器可以相互嵌套
+class GpuTimer
+{
+public:
+    GpuTimer() : m_index(0), m_lastMs(0.0f), m_averageMs(0.0f), m_samples(0) {
+        glGenQueries(kLatency * 2, &m_queries[0][0]);
+        for (int i = 0; i < kLatency; i++) {
+            m_pending[i] = false;
+        }
+    }
+
+    ~GpuTimer() {
+        glDeleteQueries(kLatency * 2, &m_queries[0][0]);
+    }
+
+    void begin() {
+        collect(false);
+        if (m_pending[m_index]) {
+            read(m_index);
+        }
+        glQueryCounter(m_queries[m_index][0], GL_TIMESTAMP);
+    }
+
+    void end() {
+        glQueryCounter(m_queries[m_index][1], GL_TIMESTAMP);
+        m_pending[m_index] = true;
+        m_index = (m_index + 1) % kLatency;
+    }
+
+    // 阻塞等待所有未完成的查询，用于一次性的测量报告
+    void finish() {
+        collect(true);
+    }
+
+    void reset() {
+        collect(true);
+        m_samples = 0;
+        m_averageMs = 0.0f;
+    }
+
+    bool hasResult() const { return m_samples > 0; }
+    int getSampleCount() const { return m_samples; }
+    float getLastMs() const { return m_lastMs; }
+    float getAverageMs() const { return m_averageMs; }
+
+private:
+    static const int kLatency = 4;
+
+    void collect(bool wait) {
+        for (int i = 1; i <= kLatency; i++) {
+            int slot = (m_index + i) % kLatency;
+            if (!m_pending[slot]) continue;
+
+            GLint available = GL_TRUE;
+            if (!wait) {
+                glGetQueryObjectiv(m_queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+            }
+            if (available) {
+                read(slot);
+            }
+        }
+    }
+
+    void read(int slot) {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(m_queries[slot][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(m_queries[slot][1], GL_QUERY_RESULT, &end);
+        m_pending[slot] = false;
+
+        m_lastMs = (float)((double)(end - begin) / 1.0e6);
+        m_samples++;
+        // 指数滑动平均，前几个样本直接取算术平均
+        float alpha = m_samples < 10 ? 1.0f / m_samples : 0.1f;
+        m_averageMs += (m_lastMs - m_averageMs) * alpha;
+    }
+
+    GLuint m_queries[kLatency][2];
+    bool m_pending[kLatency];
+    int m_index;
+    float m_lastMs;
+    float m_averageMs;
+    int m_samples;
+};
+
+#endif // GPU_TIMER_H
@@ -0,0 +1,72 @@
+#ifndef KEPLER_ORBITS_H
+#define KEPLER_ORBITS_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ShaderBuffer.h"
+
+class ParticleSystem;
+
+// 无状态的开普勒轨道(戴森云集热器): 每个粒子只保存12字节的压缩轨道根数(SSBO binding 19，按粒子编号索引)，
+// 任意时刻的位置由 orbitPass.cs 或顶点着色器(basePass.verrt 的 KEPLER_ORBITS)直接解开普勒方程得到，
+// 不积分、不写回逐帧状态，没有积分漂移，时间可以任意跳转
+class KeplerOrbits
+{
+public:
+    // 轨道根数，角度为弧度，meanAnomaly为 t=0 时的平近点角(单位为圈)
+    struct Elements
+    {
+        float a;            // 半长轴
+        float e;            // 偏心率
+        float inclination;
+        float node;         // 升交点经度
+        float periapsis;    // 近心点幅角
+        float meanAnomaly;
+    };
+
+    static const int kWordsPerParticle = 3;
+    static constexpr float kMaxAxis = 2.0f;     // 半长轴的编码范围 [0, kMaxAxis]
+    static const int kIterations = 4;           // 牛顿迭代次数，与keplerOrbit.glsl一致
+
+    KeplerOrbits(size_t count, const char* shaderPrefix);
+    ~KeplerOrbits();
+
+    void loadShaders();
+
+    // 生成numRings个轨道环，粒子按编号轮流分到各环，沿环的平近点角随机分布(固定种子，结果可复现)
+    void generate(int numRings, uint32_t seed);
+    // 直接设置每个粒子的轨道根数
+    void setElements(const std::vector<Elements>& elements);
+
+    // 把time(秒)时刻的位置写入粒子缓冲；writeVelocity时同时写入速度(每步位移)，用于退出轨道模式后继续积分
+    void evaluate(ParticleSystem* particles, float time, bool writeVelocity = false);
+
+    GLuint getElementBuffer() { return m_buffer->getBuffer(); }
+    // 与GPU缓冲内容相同的压缩根数，每个粒子kWordsPerParticle个字
+    const std::vector<uint32_t>& getPackedElements() const { return m_packed; }
+    size_t getCount() const { return m_count; }
+
+    // 16位定点压缩，与keplerOrbit.glsl的解码一致
+    static void packElements(const Elements& el, uint32_t* words);
+    static Elements unpackElements(const uint32_t* words);
+    // CPU参考实现，迭代次数与运算顺序同着色器；velocity单位为每秒
+    static glm::vec3 position(const Elements& el, float time, float gm, glm::vec3* velocity = nullptr);
+    // 把源码中"// @KEPLER_ORBIT"一行替换为keplerOrbit.glsl，读取失败返回空串
+    static std::string insertOrbitCode(const std::string& src);
+
+    float gm;               // 中心天体引力参数，半长轴为1的轨道周期为 2π/sqrt(gm) 秒
+    float stepSeconds;      // 积分状态每步对应的秒数，写入速度时换算为每步位移
+
+private:
+    size_t m_count;
+    std::vector<uint32_t> m_packed;
+    ShaderBuffer<uint32_t>* m_buffer;
+
+    GLuint m_evaluateProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // KEPLER_ORBITS_H
@@ -0,0 +1,57 @@
+#ifndef NEIGHBOR_GRID_H
+#define NEIGHBOR_GRID_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+#include "ShaderBuffer.h"
+
+class ParticleSystem;
+
+// GPU空间哈希网格，每步重建，用于粒子间的邻域查询(gridPass.cs)
+// 计数排序: 每个粒子原子累加所在格子的计数并记下自己的名次 -> 格子计数做前缀和 ->
+// 按 格子起点+名次 把位置/速度散射成按格子排列的副本(binding 13)，格子区间在binding 14
+// 格子坐标经哈希映射到固定大小的表，不限制模拟范围；不同格子撞到同一项时由距离判断过滤
+class NeighborGrid
+{
+public:
+    static const GLuint kNumCells = 1 << 20;
+
+    NeighborGrid(size_t capacity, const char* shaderPrefix);
+    ~NeighborGrid();
+
+    void loadShaders();
+
+    // 三个阶段依次执行即为一次完整重建，分开调用便于基准测试分别计时
+    void build(ParticleSystem* particles);
+    void countCells(ParticleSystem* particles);
+    void scanCells();
+    void scatter(ParticleSystem* particles);
+
+    GLuint getSortedBuffer() { return m_sorted->getBuffer(); }
+    GLuint getCellRangeBuffer() { return m_cellRanges->getBuffer(); }
+
+    float cellSize;     // 格子边长，应不小于邻域查询半径
+
+private:
+    void bindBuffers(ParticleSystem* particles);
+    void unbindBuffers();
+    void dispatch(GLuint prog, GLuint numGroups);
+
+    size_t m_capacity;
+    size_t m_count;
+
+    ShaderBuffer<glm::vec4> *m_sorted;
+    ShaderBuffer<glm::uvec2> *m_cellRanges;
+    ShaderBuffer<uint32_t> *m_cellCounts;
+    ShaderBuffer<glm::uvec2> *m_particleCells;
+    ShaderBuffer<uint32_t> *m_blockTotals;
+
+    GLuint m_countProg;
+    GLuint m_scanBlocksProg;
+    GLuint m_scanTotalsProg;
+    GLuint m_addTotalsProg;
+    GLuint m_scatterProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // NEIGHBOR_GRID_H
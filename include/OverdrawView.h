@@ -0,0 +1,69 @@
+#ifndef OVERDRAW_VIEW_H
+#define OVERDRAW_VIEW_H
+
+#include <GL/gl3w.h>
+#include <cstdint>
+#include "ShaderBuffer.h"
+
+// 粒子pass的overdraw热力图(overdrawPass.cs):
+// 1. 计数: 粒子绘制期间basePass.frag的OVERDRAW_COUNT变体对每次片段着色器调用(包括之后被discard的)在R32UI图像上原子加一
+// 2. 解析: 每像素一个线程把计数按对数色带映射成热力图颜色并清零计数，
+//    每个16x16工作组在共享内存中归约总片段数、峰值与被覆盖的像素数，再原子累加到统计缓冲(绑定点28)
+// 3. 显示: 热力图拉伸blit到默认帧缓冲，替换合成后的画面
+// 统计缓冲组成环形缓冲，用栅栏判断完成，几帧后非阻塞回读，与GpuTimer一样不等待GPU
+class OverdrawView
+{
+public:
+    struct Stats {
+        uint32_t fragments;         // 片段着色器调用总数
+        uint32_t peak;              // 单个像素的最大overdraw
+        uint32_t coveredPixels;     // 至少有一个片段的像素数
+        uint32_t pixels;            // 计数图像的像素数
+    };
+
+    explicit OverdrawView(const char* shaderPrefix);
+    ~OverdrawView();
+
+    void loadShaders();
+
+    // 按粒子绘制的分辨率分配计数与热力图，计数从零开始
+    void resize(int width, int height);
+
+    // 绑定计数图像到图像单元2，之后用OVERDRAW_COUNT变体的粒子绘制累加计数
+    void bindCounts();
+
+    // 生成热力图、清零计数并归约统计，再拉伸到默认帧缓冲的(0, 0, width, height)
+    void resolve(int width, int height);
+
+    // 最近一次完成回读的统计，没有结果时返回false
+    bool getStats(Stats& stats) const;
+    // 等待所有未完成的统计，用于一次性的测量报告
+    void finish();
+
+    GLuint getCountTexture() const { return m_counts; }
+
+    float rampMax;              // 对应色带最后一种颜色(红)的overdraw，更高的显示为白色
+
+private:
+    static const int kLatency = 4;
+
+    void destroyTargets();
+    void collect(bool wait);
+
+    int m_width;
+    int m_height;
+    GLuint m_counts;            // R32UI
+    GLuint m_heatmap;           // RGBA8
+    GLuint m_heatmapFBO;
+
+    ShaderBuffer<uint32_t>* m_stats[kLatency];
+    GLsync m_fences[kLatency];
+    int m_index;
+    Stats m_last;
+    bool m_hasResult;
+
+    GLuint m_resolveProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // OVERDRAW_VIEW_H
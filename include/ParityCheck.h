@@ -0,0 +1,56 @@
+#ifndef PARITY_CHECK_H
+#define PARITY_CHECK_H
+
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+
+// CPU/GPU一致性检查: 对particlePass.cs的任何优化都应先通过此检查
+// 1. 同一随机种子下，逐步比较计算着色器与ParticleReference的位置/速度
+// 2. 固定时间步渲染若干帧，与金标准图像做感知差异(CIELAB ΔE)比较
+struct ParityOptions
+{
+    unsigned int seed;
+    int numParticles;
+    int stepsPerPhase;
+    // false时模拟检查只用uber-kernel，用于对比特化变体
+    bool specializeShaders;
+
+    // 误差 |gpu - cpu| 超过 absTolerance + relTolerance*|cpu| 的粒子记为离群
+    float absTolerance;
+    float relTolerance;
+    float maxOutlierFraction;
+
+    int imageWidth;
+    int imageHeight;
+    int imageFrames;
+    const char* goldenPath;
+    bool updateGolden;
+
+    // ΔE超过pixelDeltaE的像素记为不同，平均ΔE与不同像素比例均需低于阈值
+    float pixelDeltaE;
+    float maxMeanDeltaE;
+    float maxBadPixelFraction;
+
+    ParityOptions() :
+        seed(1234),
+        numParticles(1<<16),
+        stepsPerPhase(8),
+        specializeShaders(true),
+        absTolerance(1e-4f),
+        relTolerance(1e-3f),
+        maxOutlierFraction(1e-4f),
+        imageWidth(256),
+        imageHeight(256),
+        imageFrames(90),
+        goldenPath("assets/golden/parity_256x256.ppm"),
+        updateGolden(false),
+        pixelDeltaE(5.0f),
+        maxMeanDeltaE(1.0f),
+        maxBadPixelFraction(0.01f)
+        {}
+};
+
+// 返回0表示全部通过，可直接作为进程退出码
+int runParityCheck(GLFWwindow* window, const ParityOptions& options);
+
+#endif // PARITY_CHECK_H
@@ -0,0 +1,95 @@
+#ifndef PARTICLE_CULLER_H
+#define PARTICLE_CULLER_H
+
+#include <GL/gl3w.h>
+#include <cstddef>
+#include "ShaderBuffer.h"
+
+class ParticleSystem;
+
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+struct DrawArraysIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+};
+
+// 与cullPass.cs中的DrawCommands布局一致
+struct CullDrawCommands
+{
+    DrawElementsIndirectCommand quads;
+    DrawArraysIndirectCommand points;
+    DrawArraysIndirectCommand octagons;     // 8顶点三角扇，每个可见精灵一个实例
+};
+
+// GPU视锥剔除 + LOD分级
+// 按投影尺寸将可见粒子分为: 完整精灵(四边形或八边形) / 单像素点 / (亚像素且暗淡)跳过
+// 结果直接写入压缩索引列表和间接绘制参数，CPU无需回读
+//
+// 随机LOD(stochasticLod): 屏幕按16x16像素分块，每块累加可见粒子的覆盖面积(像素数)估计overdraw，
+// 超过lodTargetOverdraw的块只保留其中一部分粒子，保留比例逐帧由上一帧的估计自动得出(只差一帧，
+// 不需要单独的统计pass)。取舍按粒子原始id的哈希决定，比例平滑变化时只有阈值附近的粒子进出，不闪烁；
+// 保留的粒子以1/比例的权重写入与索引列表对应的权重缓冲，期望能量不变。大精灵逐渐退出随机取舍
+class ParticleCuller
+{
+public:
+    ParticleCuller(size_t capacity, const char* shaderPrefix);
+    ~ParticleCuller();
+
+    void loadShaders();
+    void cull(ParticleSystem* particles, int viewportWidth, int viewportHeight);
+
+    GLuint getQuadListBuffer() { return m_quadList->getBuffer(); }
+    GLuint getPointListBuffer() { return m_pointList->getBuffer(); }
+    GLuint getIndirectBuffer() { return m_indirectBuffer; }
+    // 随机LOD时与两个索引列表逐项对应的权重
+    GLuint getQuadWeightBuffer() { return m_quadWeights->getBuffer(); }
+    GLuint getPointWeightBuffer() { return m_pointWeights->getBuffer(); }
+
+    // 回读上一次剔除的绘制参数，会等待GPU，仅用于统计
+    CullDrawCommands readCommands();
+
+    static const GLintptr quadCommandOffset = offsetof(CullDrawCommands, quads);
+    static const GLintptr pointCommandOffset = offsetof(CullDrawCommands, points);
+    static const GLintptr octagonCommandOffset = offsetof(CullDrawCommands, octagons);
+
+    float lodPointRadius;   // 像素半径低于此值时画成单像素点
+    float lodMinEnergy;     // 单像素点能量低于此值时直接跳过
+    bool octagonSprites;    // 可见精灵计入八边形实例数(octagons)而不是四边形索引数(quads)
+
+    bool stochasticLod;
+    float lodTargetOverdraw;    // 每块估计的overdraw超过此值时按比例随机保留粒子
+    float lodMinFraction;       // 保留比例的下限，即权重的上限
+    float lodMaxRadius;         // 像素半径达到此值的精灵总是保留，从一半开始逐渐退出取舍
+
+private:
+    void resizeDensity(int tilesX, int tilesY);
+
+    size_t m_capacity;
+    ShaderBuffer<uint32_t> *m_quadList;
+    ShaderBuffer<uint32_t> *m_pointList;
+    ShaderBuffer<float> *m_quadWeights;
+    ShaderBuffer<float> *m_pointWeights;
+    GLuint m_indirectBuffer;
+
+    // 每块的覆盖面积(1/16像素)，上一帧的读取、本帧的累加，逐帧交换
+    ShaderBuffer<uint32_t> *m_density[2];
+    int m_densityCurrent;
+    int m_tilesX;
+    int m_tilesY;
+
+    GLuint m_cullProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // PARTICLE_CULLER_H
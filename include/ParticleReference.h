@@ -0,0 +1,74 @@
+#ifndef PARTICLE_REFERENCE_H
+#define PARTICLE_REFERENCE_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "uniforms.h"
+
+// particlePass.cs 的CPU参考实现，逐行对应着色器中的数学
+// 噪声纹理按GL_LINEAR + GL_REPEAT + RGBA8_SNORM 的规则在CPU上采样
+class ParticleReference
+{
+public:
+    ParticleReference(const std::vector<int8_t>& noiseTexels, int noiseSize);
+
+    void step(const ShaderParams& params, std::vector<glm::vec4>& pos, std::vector<glm::vec4>& vel) const;
+
+    // 引力源星团(对应SSBO binding 11)，使用前 params.numAttractors 个
+    void setAttractors(const std::vector<glm::vec4>& attractors) { m_attractors = attractors; }
+    // 粒子群自引力加速度(对应SSBO binding 12)，使用前 params.numSwarmBodies 个
+    void setSwarmAccelerations(const std::vector<glm::vec4>& accel) { m_swarmAccel = accel; }
+    // 流体速度场(对应纹理单元1)，gridSize^3 个纹素，x变化最快
+    void setFluidVelocity(const std::vector<glm::vec4>& texels, int gridSize)
+    {
+        m_fluid = texels;
+        m_fluidSize = gridSize;
+    }
+
+    // 形状目标点(对应SSBO binding 18)，按 params.targetOffsetA/B + 粒子编号 读取
+    void setShapeTargets(const std::vector<glm::vec4>& targets) { m_shapeTargets = targets; }
+
+    glm::vec3 getTargetPosition(uint32_t particleId, const ShaderParams& params) const;
+
+private:
+    glm::vec4 texel(int x, int y, int z) const;
+    glm::vec3 noise3f(glm::vec3 p) const;
+    glm::vec3 fBm3f(glm::vec3 p, int octaves, float lacunarity, float gain) const;
+    glm::vec3 attract(glm::vec3 p, glm::vec3 p2) const;
+    // texture(fluidVelocity, uvw)，GL_LINEAR + GL_CLAMP_TO_EDGE
+    glm::vec3 sampleFluid(glm::vec3 uvw) const;
+
+    // 鸟群状态: 按gridPass.cs的哈希把步进前的位置/速度按格子排列，查询顺序与着色器一致
+    struct NeighborGrid
+    {
+        std::vector<uint32_t> cellStart;    // numGridCells+1 项
+        std::vector<glm::vec4> pos;
+        std::vector<glm::vec4> vel;
+    };
+    uint32_t cellHash(glm::ivec3 c, const ShaderParams& params) const;
+    void buildGrid(const ShaderParams& params, const std::vector<glm::vec4>& pos, const std::vector<glm::vec4>& vel,
+                   NeighborGrid& grid) const;
+    glm::vec3 flockSteer(glm::vec3 p, glm::vec3 v, const ShaderParams& params, const NeighborGrid& grid) const;
+
+    // 按dt积分的受力状态(integrator不为0)，对应着色器中的Dynamics/accelAt/integrate
+    struct Dynamics
+    {
+        int force;
+        float gain;
+        float drag;
+        glm::vec3 anchor;
+    };
+    glm::vec3 accelAt(const Dynamics& d, glm::vec3 p, const ShaderParams& params) const;
+    void integrate(const Dynamics& d, glm::vec3& p, glm::vec3& v, float h, const ShaderParams& params) const;
+
+    std::vector<int8_t> m_noise;
+    std::vector<glm::vec4> m_attractors;
+    std::vector<glm::vec4> m_swarmAccel;
+    std::vector<glm::vec4> m_fluid;
+    std::vector<glm::vec4> m_shapeTargets;
+    int m_fluidSize = 0;
+    int m_noiseSize;
+};
+
+#endif // PARTICLE_REFERENCE_H
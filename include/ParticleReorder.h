@@ -0,0 +1,49 @@
+#ifndef PARTICLE_REORDER_H
+#define PARTICLE_REORDER_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+#include "ShaderBuffer.h"
+
+class ParticleSystem;
+class GpuRadixSort;
+
+// 按Morton(Z序)曲线重排粒子缓冲，使空间相邻的粒子在内存中也相邻，
+// 提高计算时噪声纹理采样和光栅化时纹理/ROP的缓存命中率
+// 重排后槽位与粒子编号不再一致，编号保存在 ParticleSystem 的编号表中(心形/星形目标查找使用)
+class ParticleReorder
+{
+public:
+    ParticleReorder(size_t capacity, const char* shaderPrefix);
+    ~ParticleReorder();
+
+    void loadShaders();
+
+    // 每帧调用: 按策略决定是否重排，返回true表示本帧重排过(依赖槽位顺序的缓存需失效)
+    bool update(ParticleSystem* particles);
+
+    // 立即重排
+    void reorder(ParticleSystem* particles);
+
+    // 粒子被随机重置等空间相关性完全失效时调用，下一帧立即重排
+    void invalidate() { m_framesSinceReorder = interval; }
+
+    bool enabled;
+    int interval;           // 重排间隔(帧): 粒子随噪声场缓慢漂移，相关性逐渐退化
+    float boundsExtent;     // Morton编码覆盖的立方体半边长，超出的粒子钳制到边界
+
+private:
+    size_t m_capacity;
+    int m_framesSinceReorder;
+
+    GpuRadixSort *m_sort;
+    ShaderBuffer<glm::vec4> *m_sortedPos;
+    ShaderBuffer<glm::vec4> *m_sortedVel;
+    ShaderBuffer<uint32_t> *m_sortedIds;
+
+    GLuint m_codesProg;
+    GLuint m_permuteProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // PARTICLE_REORDER_H
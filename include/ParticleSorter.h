@@ -0,0 +1,59 @@
+#ifndef PARTICLE_SORTER_H
+#define PARTICLE_SORTER_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+#include "ShaderBuffer.h"
+
+class ParticleSystem;
+
+// 按视深对粒子索引做GPU双调排序(由远及近)，供"over"混合按序绘制
+// 全排序: 先在共享内存中排好每个块，再逐级做全局比较交换 + 块内归并
+// 增量排序: 利用帧间相关性，每帧只做几轮块内排序，奇偶轮错开半个块，
+// 让元素可以跨块移动(块级奇偶换位排序)，画面稳定时几轮即可收敛
+class ParticleSorter
+{
+public:
+    ParticleSorter(size_t capacity, const char* shaderPrefix);
+    ~ParticleSorter();
+
+    void loadShaders();
+
+    // 每帧调用: 更新键值后按策略选择全排序或增量排序
+    void sort(ParticleSystem* particles);
+
+    void updateKeys(ParticleSystem* particles);
+    void sortFull();
+    void sortIncremental(int passes);
+
+    // 粒子被重置等顺序完全失效时调用，下一帧强制全排序
+    void invalidate() { m_framesSinceFullSort = -1; }
+
+    // 回读统计相邻逆序对数量，用于衡量增量排序的误差(会阻塞)
+    size_t countInversions();
+
+    GLuint getSortListBuffer() { return m_entries->getBuffer(); }
+    size_t getEntryCount() { return m_entryCount; }
+
+    bool incremental;
+    int incrementalPasses;   // 增量模式每帧的块内排序轮数
+    int fullSortInterval;    // 增量模式下每隔多少帧做一次全排序兜底，0表示从不
+
+private:
+    void dispatchLocal(GLuint blockOffset, GLuint mergeStage, bool alternateBlocks);
+    void bindBuffers(ParticleSystem* particles);
+
+    size_t m_capacity;
+    size_t m_entryCount;
+    ShaderBuffer<glm::uvec2> *m_entries;
+
+    int m_framesSinceFullSort;
+    int m_passParity;
+
+    GLuint m_keysProg;
+    GLuint m_localProg;
+    GLuint m_globalProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // PARTICLE_SORTER_H
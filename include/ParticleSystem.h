@@ -1,10 +1,14 @@
 #ifndef PARTICLE_SYSTEM_H
 #define PARTICLE_SYSTEM_H
 #include <iostream>
+#include <string>
+#include <unordered_map>
 #include <GL/gl3w.h>
 #include <glm/glm.hpp>
 #include "ShaderBuffer.h"
 
+struct ShaderParams;
+
 class ParticleSystem
 {
 public:
@@ -12,28 +16,88 @@ public:
     ~ParticleSystem();
 
     void loadShaders();
+    // 追加到particlePass.cs的宏定义(如基准测试对比的着色器变体)，重新编译
+    void setShaderDefines(const std::string& defines)
+    {
+        m_shaderDefines = defines;
+        loadShaders();
+    }
     void reset(float size=1.0f);
     void resetToHeartShape(float scale=0.3f);
-    void update();
+    // params须与已上传到UBO(binding 1)的内容一致，用于选择着色器变体
+    void update(const ShaderParams& params);
+
+    // 着色器变体: 每个状态与特性开关(单个吸引子、引力源星团、噪声层数)的组合各编译一个程序，
+    // 只保留该状态用到的代码；首次用到时编译并按键缓存。键为0表示按particleState分支的uber-kernel
+    static const uint32_t kUberKernel = 0;
+    enum VariantState { kStateNormal, kStateAbsorb, kStateShape, kStateSwarm, kStateFlock, kStateFluid };
+    static uint32_t variantKey(const ShaderParams& params);
+    static std::string variantDefines(uint32_t key);
+    GLuint getProgram(uint32_t key);
+    size_t getVariantCount() const { return m_variants.size(); }
+    bool specializeShaders;     // 关闭时所有状态都使用uber-kernel，用于对比
+
+    // 积分器，写入ShaderParams::integrator。Legacy为原来的逐帧步进(帧率决定模拟速度)；
+    // 其余对受力状态(普通、吸收、形状、粒子群)按真实dt积分，鸟群与流体为转向规则，按dt缩放步长
+    enum Integrator { kIntegratorLegacy, kIntegratorEuler, kIntegratorVerlet, kIntegratorRK4, kNumIntegrators };
+    static const char* integratorName(uint32_t integrator);
+    // 每步的受力计算次数
+    static int integratorEvaluations(uint32_t integrator);
+
+    // 引力源星团SSBO区间，numAttractors为0时不会读取
+    void setAttractors(GLuint buffer, GLintptr offset, GLsizeiptr size);
+    // 粒子群自引力加速度SSBO，numSwarmBodies为0时不会读取
+    void setSwarmAccelerations(GLuint buffer) { m_swarmAccelBuffer = buffer; }
+    // 邻域查询网格(NeighborGrid)，仅鸟群状态读取
+    void setNeighborGrid(GLuint sortedBuffer, GLuint cellRangeBuffer)
+    {
+        m_gridSortedBuffer = sortedBuffer;
+        m_gridCellRangeBuffer = cellRangeBuffer;
+    }
+    // 流体速度场(FluidSolver)，仅流体状态采样
+    void setFluidVelocity(GLuint texture) { m_fluidVelocityTex = texture; }
+    // 形状目标点(ShapeTargets)，仅形状状态读取
+    void setShapeTargets(GLuint buffer) { m_shapeTargetBuffer = buffer; }
 
     size_t getSize() { return m_size; }
 
     ShaderBuffer<glm::vec4> *getPosBuffer() { return m_pos; }
     ShaderBuffer<glm::vec4> *getVelBuffer() { return m_vel; }
     ShaderBuffer<uint32_t> *getIndexBuffer() { return m_indices; }
+    // 每个槽位对应的粒子编号，缓冲被重排后用于查找与编号相关的目标位置
+    ShaderBuffer<uint32_t> *getIdBuffer() { return m_ids; }
+
+    GLuint getNoiseTexture() { return m_noiseTex; }
+    int getNoiseSize() { return m_noiseSize; }
 
 private:
     GLuint createComputeProgram(const char* src);
+    void setupProgram(GLuint prog, bool warnMissing);
+    void destroyVariants();
+    void resetIds();
 
     size_t m_size;
     ShaderBuffer<glm::vec4> *m_pos;
     ShaderBuffer<glm::vec4> *m_vel;
     ShaderBuffer<uint32_t> *m_indices;
+    ShaderBuffer<uint32_t> *m_ids;
 
     GLuint m_updateProg;
+    std::string m_shaderSource;     // 已注入m_shaderDefines，变体在此基础上再注入各自的宏
+    std::unordered_map<uint32_t, GLuint> m_variants;
+
+    GLuint m_attractorBuffer;
+    GLintptr m_attractorOffset;
+    GLsizeiptr m_attractorSize;
+    GLuint m_swarmAccelBuffer;
+    GLuint m_gridSortedBuffer;
+    GLuint m_fluidVelocityTex;
+    GLuint m_gridCellRangeBuffer;
+    GLuint m_shapeTargetBuffer;
 
     GLuint m_noiseTex;
     int m_noiseSize;
     const char* m_shaderPrefix;
+    std::string m_shaderDefines;
 };
 #endif // PARTICLE_SYSTEM_H
\ No newline at end of file
@@ -0,0 +1,122 @@
+#ifndef PIPELINE_STATISTICS_H
+#define PIPELINE_STATISTICS_H
+
+#include <GL/gl3w.h>
+#include <cstring>
+
+// GL_ARB_pipeline_statistics_query (GL 4.6核心)，gl3w的头文件中没有
+#ifndef GL_VERTEX_SHADER_INVOCATIONS_ARB
+#define GL_VERTEX_SHADER_INVOCATIONS_ARB    0x82F0
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB  0x82F4
+#define GL_CLIPPING_INPUT_PRIMITIVES_ARB    0x82F6
+#endif
+
+// 异步管线统计: 顶点着色器调用、进入裁剪的图元与片段着色器调用三种查询，
+// 与GpuTimer一样组成环形缓冲，结果在几帧后非阻塞回读。
+// 同一种查询不能嵌套，一个begin()/end()区间内不能再开始另一个PipelineStatistics
+class PipelineStatistics
+{
+public:
+    struct Counts {
+        GLuint64 vertices;
+        GLuint64 primitives;
+        GLuint64 fragments;
+    };
+
+    PipelineStatistics() : m_index(0), m_last(), m_samples(0) {
+        m_supported = gl3wIsSupported(4, 6) || hasExtension("GL_ARB_pipeline_statistics_query");
+        if (m_supported) {
+            glGenQueries(kLatency * kNumTargets, &m_queries[0][0]);
+        }
+        for (int i = 0; i < kLatency; i++) {
+            m_pending[i] = false;
+        }
+    }
+
+    ~PipelineStatistics() {
+        if (m_supported) {
+            glDeleteQueries(kLatency * kNumTargets, &m_queries[0][0]);
+        }
+    }
+
+    bool isSupported() const { return m_supported; }
+
+    void begin() {
+        if (!m_supported) return;
+        collect(false);
+        if (m_pending[m_index]) {
+            read(m_index);
+        }
+        for (int t = 0; t < kNumTargets; t++) {
+            glBeginQuery(kTargets[t], m_queries[m_index][t]);
+        }
+    }
+
+    void end() {
+        if (!m_supported) return;
+        for (int t = 0; t < kNumTargets; t++) {
+            glEndQuery(kTargets[t]);
+        }
+        m_pending[m_index] = true;
+        m_index = (m_index + 1) % kLatency;
+    }
+
+    // 阻塞等待所有未完成的查询，用于一次性的测量报告
+    void finish() {
+        if (m_supported) collect(true);
+    }
+
+    bool hasResult() const { return m_samples > 0; }
+    const Counts& getLast() const { return m_last; }
+
+private:
+    static const int kLatency = 4;
+    static const int kNumTargets = 3;
+    static constexpr GLenum kTargets[kNumTargets] = {
+        GL_VERTEX_SHADER_INVOCATIONS_ARB, GL_CLIPPING_INPUT_PRIMITIVES_ARB, GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+    };
+
+    static bool hasExtension(const char* name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (extension && std::strcmp(extension, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void collect(bool wait) {
+        for (int i = 1; i <= kLatency; i++) {
+            int slot = (m_index + i) % kLatency;
+            if (!m_pending[slot]) continue;
+
+            GLint available = GL_TRUE;
+            if (!wait) {
+                glGetQueryObjectiv(m_queries[slot][kNumTargets - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            }
+            if (available) {
+                read(slot);
+            }
+        }
+    }
+
+    void read(int slot) {
+        glGetQueryObjectui64v(m_queries[slot][0], GL_QUERY_RESULT, &m_last.vertices);
+        glGetQueryObjectui64v(m_queries[slot][1], GL_QUERY_RESULT, &m_last.primitives);
+        glGetQueryObjectui64v(m_queries[slot][2], GL_QUERY_RESULT, &m_last.fragments);
+        m_pending[slot] = false;
+        m_samples++;
+    }
+
+    bool m_supported;
+    GLuint m_queries[kLatency][kNumTargets];
+    bool m_pending[kLatency];
+    int m_index;
+    Counts m_last;
+    int m_samples;
+};
+
+#endif // PIPELINE_STATISTICS_H
@@ -0,0 +1,82 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <GL/gl3w.h>
+#include <atomic>
+#include <cstdint>
+
+// CPU/GPU时间线采样
+// CPU区间写入线程局部环形缓冲区，GPU区间使用GL_TIMESTAMP查询异步回读，
+// 最终合并输出为Chrome trace_event JSON (chrome://tracing 或 ui.perfetto.dev)
+class Profiler
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+    // 每帧开始时调用：回收已完成的GPU查询并校准CPU/GPU时钟
+    static void beginFrame();
+
+    static void setThreadName(const char* name);
+    static bool dumpChromeTrace(const char* path);
+    static void clear();
+
+    static uint64_t nowNs();
+    static void recordCpu(const char* name, uint64_t beginNs, uint64_t endNs);
+    static int beginGpuZone(const char* name);
+    static void endGpuZone(int zone);
+
+private:
+    static std::atomic<bool> sEnabled;
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name) : mName(nullptr), mBegin(0) {
+        if (Profiler::isEnabled()) {
+            mName = name;
+            mBegin = Profiler::nowNs();
+        }
+    }
+    ~ProfileScope() {
+        if (mName) {
+            Profiler::recordCpu(mName, mBegin, Profiler::nowNs());
+        }
+    }
+
+private:
+    const char* mName;
+    uint64_t mBegin;
+};
+
+class GpuProfileScope
+{
+public:
+    explicit GpuProfileScope(const char* name) : mZone(-1) {
+        if (Profiler::isEnabled()) {
+            mZone = Profiler::beginGpuZone(name);
+        }
+    }
+    ~GpuProfileScope() {
+        if (mZone >= 0) {
+            Profiler::endGpuZone(mZone);
+        }
+    }
+
+private:
+    int mZone;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifndef DYSON_DISABLE_PROFILER
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) do {} while(0)
+#define PROFILE_GPU_SCOPE(name) do {} while(0)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,64 @@
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include <GL/gl3w.h>
+#include <cstddef>
+#include <vector>
+
+// 离屏渲染目标: 一张纹理及以它为颜色附着的FBO
+struct RenderTarget
+{
+    GLuint texture;
+    GLuint fbo;
+    int width;
+    int height;
+    GLenum format;
+    int lastUsedFrame;      // 归还时的帧号，空闲目标按此淘汰
+};
+
+// 渲染目标池，按(尺寸, 格式)复用纹理与FBO:
+// 归还的目标进入空闲列表，之后申请相同尺寸与格式时直接取用，不再分配显存；
+// 空闲超过kMaxIdleFrames帧或空闲总量超过kMaxIdleBytes时按最久未用淘汰。
+// 尺寸的选择(分桶与滞回)由调用方通过bucketSize/chooseSize决定，池只做精确匹配
+class RenderTargetPool
+{
+public:
+    static const int kMaxIdleFrames = 300;
+    static const size_t kMaxIdleBytes = 256u << 20;
+
+    RenderTargetPool();
+    ~RenderTargetPool();
+
+    // 取一个给定尺寸与格式的目标，优先复用空闲的，否则新建；线性过滤、边缘钳制
+    RenderTarget* acquire(int width, int height, GLenum format);
+    // 归还，不立即释放；传入nullptr无操作
+    void release(RenderTarget* target);
+    // 每帧调用一次，淘汰过期的空闲目标
+    void endFrame();
+    // 释放所有空闲目标
+    void trim();
+
+    // 向上取到 2^k 或 1.5*2^k，相邻两档相差不超过1.5倍
+    static int bucketSize(int size);
+    // 滞回: requested在(current/2, current]之内时保持current，否则取requested所在的档，
+    // 避免拖动窗口时在两档之间来回切换
+    static int chooseSize(int current, int requested);
+
+    // 累计创建的目标数，用于统计复用效果
+    int getAllocationCount() const { return m_allocations; }
+    size_t getIdleBytes() const;
+    size_t getLiveBytes() const;
+
+    static size_t bytesPerPixel(GLenum format);
+
+private:
+    RenderTarget* create(int width, int height, GLenum format);
+    void destroy(RenderTarget* target);
+
+    std::vector<RenderTarget*> m_idle;
+    std::vector<RenderTarget*> m_live;
+    int m_frame;
+    int m_allocations;
+};
+
+#endif // RENDER_TARGET_POOL_H
@@ -110,6 +110,9 @@ private:
 };
 
 std::string loadShaderSourceWithUniformTag(const char* uniformsFile, const char* srcFile);
+std::string readShaderFile(const char* path);
+std::string injectShaderDefines(const std::string& src, const std::string& defines);
+GLuint createComputeProgram(const char* src, const char* shaderPrefix);
 
 #endif // SHADER_UTILS_H
 
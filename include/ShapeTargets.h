@@ -0,0 +1,70 @@
+#ifndef SHAPE_TARGETS_H
+#define SHAPE_TARGETS_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 三角网格，顶点按三角形索引
+struct TriangleMesh
+{
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::uvec3> triangles;
+};
+
+// 形状目标点云: 每个形状为每个粒子编号预先给出一个目标位置，所有形状首尾相接存放在一个SSBO中(binding 18)，
+// 形状状态下particlePass.cs直接按 偏移+粒子编号 读取，不再逐帧求值参数曲线
+// 网格形状按三角形面积加权(alias表)在表面均匀采样，多线程分块进行
+class ShapeTargets
+{
+public:
+    // pointsPerShape一般等于粒子数量，numThreads为0时使用全部硬件线程
+    ShapeTargets(size_t pointsPerShape, int numThreads = 0);
+    ~ShapeTargets();
+
+    // 内置形状，与原particlePass.cs中的参数曲线相同；返回形状编号
+    int addHeart(float scale);
+    int addStar(float scale);
+    // 读取OBJ/PLY网格并采样，缩放到包围盒半边长最大为radius；失败返回-1
+    int addMesh(const char* path, float radius);
+    int addMesh(const TriangleMesh& mesh, const std::string& name, float radius);
+    // 直接添加pointsPerShape个点
+    int addPoints(const glm::vec4* points, const std::string& name);
+
+    int getShapeCount() const { return (int)m_names.size(); }
+    const std::string& getName(int shape) const { return m_names[shape]; }
+    size_t getPointsPerShape() const { return m_pointsPerShape; }
+
+    // 形状在缓冲中的起始下标，写入ShaderParams::targetOffsetA/B
+    GLuint getOffset(int shape) const { return (GLuint)(shape * m_pointsPerShape); }
+    // 添加形状会重新分配缓冲，应在全部形状添加完后再获取
+    GLuint getBuffer() const { return m_buffer; }
+
+    // 按面积加权在网格表面均匀采样count个点(w为1)；结果只取决于seed，与线程数无关
+    // 网格没有面积非零的三角形时返回false
+    bool samplePoints(const TriangleMesh& mesh, size_t count, glm::vec4* out, uint32_t seed) const;
+
+    // 按扩展名选择格式
+    static bool loadMesh(const char* path, TriangleMesh& mesh);
+    // v/f行，多边形按扇形三角化，支持 v/vt/vn 形式的索引与负索引
+    static bool loadOBJ(const char* path, TriangleMesh& mesh);
+    // ascii与binary_little_endian，读取vertex的x/y/z与face的顶点索引列表
+    static bool loadPLY(const char* path, TriangleMesh& mesh);
+    // 平移到包围盒中心并缩放到最大半边长为radius
+    static void normalize(TriangleMesh& mesh, float radius);
+
+    // 第i个(共count个)粒子在爱心/五角星曲线上的位置
+    static glm::vec3 heartPosition(size_t i, size_t count, float scale);
+    static glm::vec3 starPosition(size_t i, size_t count, float scale);
+
+    int numThreads;
+
+private:
+    size_t m_pointsPerShape;
+    std::vector<std::string> m_names;
+    GLuint m_buffer;
+};
+
+#endif // SHAPE_TARGETS_H
@@ -0,0 +1,83 @@
+#ifndef SHELL_CONSTRAINTS_H
+#define SHELL_CONSTRAINTS_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "ShaderBuffer.h"
+
+class ParticleSystem;
+struct ShaderParams;
+
+// 基于位置的动力学(PBD)戴森壳: 测地球面(二十面体细分)的顶点占用前几个粒子槽位，
+// 每条边一个拉伸约束，每条边两侧三角形的对顶点之间一个弯曲约束，使壳体能保持形状而不只是不被拉长。
+// 约束按图着色分组，同色约束不共享粒子，每种颜色一次无冲突的调度(shellPass.cs)，不需要原子操作。
+// 每步: storePositions -> particlePass.cs 预测位置 -> solve(迭代投影约束，再由位置变化求速度)
+// 速度与particlePass.cs一样以参考帧(1/60秒)为单位，按dt积分时一步为 h = dt*60 个参考帧
+class ShellConstraints
+{
+public:
+    // 与shellPass.cs中的结构一致(std430，16字节)
+    struct Constraint
+    {
+        uint32_t a;
+        uint32_t b;
+        float restLength;
+        uint32_t kind;      // kStretch / kBend
+    };
+    enum { kStretch, kBend };
+
+    // level为二十面体细分次数，顶点数 10*4^level+2，约束数 60*4^level
+    ShellConstraints(int level, float radius, const char* shaderPrefix);
+    ~ShellConstraints();
+
+    void loadShaders();
+
+    // 把壳体顶点写入前getVertexCount()个槽位(速度清零)，粒子数不足时不做任何事并返回false
+    bool deploy(ParticleSystem* particles);
+    // 记录预测前的位置，之后的solve由位置变化求速度
+    void storePositions(ParticleSystem* particles);
+    // iterations次约束投影 + 速度更新，params为本步预测使用的参数(积分器与dt决定步长)
+    void solve(ParticleSystem* particles, const ShaderParams& params);
+    // 单次投影(所有颜色各一次调度)与速度更新，分开调用便于基准测试分别计时
+    void iterate(ParticleSystem* particles);
+    void finalize(ParticleSystem* particles, const ShaderParams& params);
+
+    // CPU参考实现，按颜色顺序投影，运算顺序同着色器
+    void solveReference(std::vector<glm::vec4>& pos, std::vector<glm::vec4>& vel,
+                        const std::vector<glm::vec4>& prevPos, const ShaderParams& params) const;
+
+    size_t getVertexCount() const { return m_vertices.size(); }
+    size_t getConstraintCount() const { return m_constraints.size(); }
+    size_t getColorCount() const { return m_colorOffsets.size() - 1; }
+    // 按颜色排列，与GPU缓冲内容相同
+    const std::vector<Constraint>& getConstraints() const { return m_constraints; }
+
+    int iterations;             // 每步的投影次数
+    float stretchStiffness;     // 边长约束的刚度[0,1]，按迭代次数换算为每次投影的刚度，结果与次数无关
+    float bendStiffness;        // 对顶点约束的刚度，越小越容易弯曲
+    float damping;              // 每个参考帧保留的速度比例，默认与普通状态的damping相同
+
+private:
+    void generate(int level, float radius);
+    void colorConstraints();
+    void dispatch(GLuint prog, GLuint first, GLuint count);
+    // 每次投影的刚度 1-(1-k)^(1/iterations)
+    glm::vec2 passStiffness() const;
+    // 一步的参考帧数: 按帧步进为1，其余为dt*60
+    static float stepFrames(const ShaderParams& params);
+
+    std::vector<glm::vec3> m_vertices;
+    std::vector<Constraint> m_constraints;      // 按颜色排列
+    std::vector<uint32_t> m_colorOffsets;       // 每种颜色在m_constraints中的起点，末尾为总数
+
+    ShaderBuffer<Constraint>* m_constraintBuffer;
+    ShaderBuffer<glm::vec4>* m_prevPos;
+
+    GLuint m_solveProg;
+    GLuint m_finalizeProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // SHELL_CONSTRAINTS_H
@@ -0,0 +1,55 @@
+#ifndef SWARM_GRAVITY_H
+#define SWARM_GRAVITY_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+#include <future>
+#include <vector>
+#include "BarnesHut.h"
+
+class ParticleSystem;
+
+// 粒子群自引力: 前numBodies个槽位的粒子互相吸引，由CPU上的BarnesHut求解
+// 流水线全程不阻塞渲染:
+//   1. 把位置拷贝到回读缓冲并插入fence
+//   2. fence完成后映射读出，交给后台线程求解
+//   3. 求解完成后把加速度上传到SSBO(binding 12)，计算着色器每帧累加到速度上
+// 因此加速度相对位置滞后若干帧，对缓慢演化的引力场影响很小
+class SwarmGravity
+{
+public:
+    SwarmGravity(size_t maxBodies);
+    ~SwarmGravity();
+
+    // 每帧调用一次，推进上面的流水线
+    void update(ParticleSystem* particles);
+
+    // 丢弃进行中的回读与求解结果(槽位被重排或粒子被重置后不再对应)
+    void invalidate();
+
+    GLuint getAccelBuffer() const { return m_accelBuffer; }
+    // 已有有效加速度的粒子数量，在第一次求解完成前为0
+    unsigned int getActiveBodies() const { return m_activeBodies; }
+
+    BarnesHut& getSolver() { return m_solver; }
+
+private:
+    void waitForJob();
+
+    BarnesHut m_solver;
+    size_t m_maxBodies;
+    size_t m_numBodies;     // 当前回读的数量
+    size_t m_jobBodies;     // 后台求解的数量
+    unsigned int m_activeBodies;
+
+    GLuint m_readbackBuffer;
+    GLuint m_accelBuffer;
+    GLsync m_readbackFence;
+
+    std::vector<glm::vec4> m_positions;
+    std::vector<glm::vec4> m_accel;
+    std::future<void> m_job;
+    bool m_discardJob;
+};
+
+#endif // SWARM_GRAVITY_H
@@ -0,0 +1,67 @@
+#ifndef TEMPORAL_UPSAMPLE_H
+#define TEMPORAL_UPSAMPLE_H
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+
+// 降分辨率粒子的时间重建(temporalPass.cs):
+// 粒子以1/2或1/4分辨率绘制，投影矩阵每帧加一个低分辨率像素内的Halton(2,3)子像素偏移，
+// 各帧的采样点落在不同的全分辨率像素上，累加到全分辨率的历史缓冲中。
+// 历史按相机矩阵与粒子的呼吸缩放(particleScale)重投影: 粒子没有深度，像素统一取相机注视点所在的深度。
+// 历史颜色钳制到当前帧覆盖该像素的2x2个低分辨率采样的范围内，被钳制得越多(粒子运动、状态切换)、
+// 或相机运动使注视点前后depthRange处的视差越大，越多地退回当前帧的边缘保持空间插值
+class TemporalUpsample
+{
+public:
+    static const int kJitterCount = 16;
+
+    explicit TemporalUpsample(const char* shaderPrefix);
+    ~TemporalUpsample();
+
+    void loadShaders();
+
+    // 按场景分辨率重新分配历史缓冲，历史随之失效
+    void resize(int width, int height);
+
+    // 每帧绘制粒子之前调用: 前进到下一个抖动位置，记录本帧(未抖动的)视图投影矩阵与粒子缩放用于重投影。
+    // focusPoint为重投影假定的深度所在的世界坐标点
+    void beginFrame(const glm::mat4& viewProjection, float particleScale, const glm::vec3& focusPoint,
+                    int lowResWidth, int lowResHeight);
+
+    // 左乘到投影矩阵上的抖动平移(NDC)
+    glm::mat4 getJitterMatrix() const;
+
+    // 由抖动的低分辨率粒子与历史重建全分辨率场景，同时写入新的历史
+    void resolve(GLuint lowResTexture, GLuint sceneTexture);
+
+    // 丢弃历史，下一帧只用当前帧的空间插值
+    void reset() { m_historyValid = false; }
+
+    float sampleBlend;          // 当前帧采样点正落在像素中心时的混合权重，随距离按高斯衰减
+    float depthRange;           // 粒子在注视点前后的深度范围(世界单位)
+    float parallaxRejection;    // 相机运动时范围两端的视差每像素舍弃的历史比例: 假定的深度对它们不准
+
+private:
+    void destroyTextures();
+
+    int m_width;            // 场景分辨率
+    int m_height;
+    GLuint m_history[2];    // 交替读写
+    int m_current;          // 本帧写入的历史
+    bool m_historyValid;
+
+    int m_frame;
+    glm::vec2 m_jitter;     // 低分辨率像素单位
+    glm::vec2 m_lowResSize;
+    glm::mat4 m_viewProjection;     // 上一帧的，beginFrame后为本帧
+    float m_particleScale;
+    glm::mat4 m_reprojection;       // 本帧NDC -> 上一帧裁剪空间
+    float m_focusDepth;             // 注视点在本帧的NDC深度
+    glm::vec2 m_parallaxDepths;     // 注视点前后depthRange处的NDC深度
+    bool m_hasPreviousFrame;
+
+    GLuint m_resolveProg;
+    const char* m_shaderPrefix;
+};
+
+#endif // TEMPORAL_UPSAMPLE_H
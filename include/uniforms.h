@@ -25,6 +25,30 @@ struct ShaderParams
     float stateTime;  
     float heartScale;
 
+    unsigned int numAttractors;   // 引力源星团中的数量，数据在SSBO binding 11
+    unsigned int numSwarmBodies;  // 粒子群状态下受自引力的粒子数量，加速度在SSBO binding 12
+
+    // 鸟群状态的邻域查询，网格数据在SSBO binding 13/14(NeighborGrid)
+    float gridCellSize;           // 格子边长即邻域半径
+    unsigned int numGridCells;    // 哈希表大小，2的幂
+    unsigned int maxNeighbors;    // 每个粒子最多统计的邻居数，限制密集处的开销
+
+    float fluidExtent;            // 流体网格覆盖的立方体半边长(FluidSolver)
+
+    // 形状状态的目标点，数据在SSBO binding 18(ShapeTargets)，目标为两个形状按targetMorph插值
+    unsigned int targetOffsetA;   // 形状A在缓冲中的起始下标
+    unsigned int targetOffsetB;
+    float targetMorph;            // 0为形状A，1为形状B
+
+    unsigned int noiseOctaves;    // 噪声场fBm的层数，特化的着色器变体中为编译期常量
+
+    // 积分器(ParticleSystem::Integrator)。0为原来按帧步进的写法，不使用dt；
+    // 其余按dt秒积分，速度仍以参考帧(1/60秒)为单位，帧率变化时轨迹不变
+    unsigned int integrator;
+    float dt;                     // 本次更新的步长(秒)
+    float dampingPerSecond;       // 普通状态每秒保留的速度比例，对应按帧步进时的damping
+    unsigned int padding[2];      // 补齐到std140块大小(16字节的倍数)
+
     ShaderParams() :
         spriteSize(0.015f),
         attractor(0.0f, 0.0f, 0.0f, 0.0f),
@@ -34,7 +58,21 @@ struct ShaderParams
         noiseStrength(0.001f),
         particleState(0.0f),
         stateTime(0.0f),
-        heartScale(0.3f)
+        heartScale(0.3f),
+        numAttractors(0),
+        numSwarmBodies(0),
+        gridCellSize(0.03f),
+        numGridCells(0),
+        maxNeighbors(32),
+        fluidExtent(1.5f),
+        targetOffsetA(0),
+        targetOffsetB(0),
+        targetMorph(0.0f),
+        noiseOctaves(4),
+        integrator(0),
+        dt(1.0f / 60.0f),
+        dampingPerSecond(0.0461f),  // 0.95^60
+        padding{0, 0}
         {}
 };
 
@@ -0,0 +1,107 @@
+#include "AttractorCluster.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+
+AttractorCluster::AttractorCluster(int maxCount) :
+    totalStrength(0.0005f),
+    m_maxCount(maxCount),
+    m_count(0),
+    m_buffer(0),
+    m_regionStride(0),
+    m_region(0)
+{
+    // 每段起点需满足SSBO偏移对齐
+    GLint alignment = 256;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    size_t regionSize = maxCount * sizeof(glm::vec4);
+    m_regionStride = (regionSize + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, m_regionStride * kRegions, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    CHECK_GL_ERROR();
+
+    for (int i = 0; i < kRegions; i++) {
+        m_fences[i] = 0;
+    }
+}
+
+AttractorCluster::~AttractorCluster()
+{
+    for (int i = 0; i < kRegions; i++) {
+        if (m_fences[i]) {
+            glDeleteSync(m_fences[i]);
+        }
+    }
+    if (m_buffer) {
+        glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+void AttractorCluster::setCount(int count)
+{
+    m_count = count < 0 ? 0 : (count > m_maxCount ? m_maxCount : count);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    const float twoPi = 6.28318530718f;
+
+    m_orbits.resize(m_count);
+    for (Orbit& orbit : m_orbits) {
+        orbit.radius = 0.6f + 0.5f * uniform(rng);
+        orbit.inclination = (uniform(rng) - 0.5f) * 1.2f;
+        orbit.node = uniform(rng) * twoPi;
+        orbit.phase = uniform(rng) * twoPi;
+        // 近似开普勒: 角速度 ∝ r^-1.5
+        orbit.angularSpeed = 0.3f / (orbit.radius * sqrtf(orbit.radius));
+    }
+    m_attractors.assign(m_count, glm::vec4(0.0f));
+}
+
+void AttractorCluster::update(float time)
+{
+    PROFILE_SCOPE("AttractorCluster::update");
+
+    float strength = m_count > 0 ? totalStrength / m_count : 0.0f;
+    for (int i = 0; i < m_count; i++) {
+        const Orbit& orbit = m_orbits[i];
+        float angle = orbit.phase + orbit.angularSpeed * time;
+        // 轨道平面内的圆周运动，先绕X轴倾斜，再绕Y轴旋转到升交点
+        glm::vec3 p(orbit.radius * cosf(angle), 0.0f, orbit.radius * sinf(angle));
+        p = glm::vec3(p.x, p.z * sinf(orbit.inclination), p.z * cosf(orbit.inclination));
+        float cn = cosf(orbit.node), sn = sinf(orbit.node);
+        m_attractors[i] = glm::vec4(cn * p.x + sn * p.z, p.y, -sn * p.x + cn * p.z, strength);
+    }
+
+    // 上一帧使用的段在此之前的命令都已提交，插入fence标记其读取完成点
+    if (m_fences[m_region]) {
+        glDeleteSync(m_fences[m_region]);
+    }
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_region = (m_region + 1) % kRegions;
+    if (m_fences[m_region]) {
+        // 通常早已完成；只有GPU落后kRegions帧以上才会真正等待
+        glClientWaitSync(m_fences[m_region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        glDeleteSync(m_fences[m_region]);
+        m_fences[m_region] = 0;
+    }
+
+    if (m_count == 0) {
+        return;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+    void* dst = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, getOffset(), m_count * sizeof(glm::vec4),
+                                 GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (dst) {
+        memcpy(dst, m_attractors.data(), m_count * sizeof(glm::vec4));
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    CHECK_GL_ERROR();
+}
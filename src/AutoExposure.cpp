@@ -0,0 +1,134 @@
+#include "AutoExposure.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 与exposurePass.cs一致
+static const int kGroupSize = 16;
+// 直方图覆盖的对数亮度范围: 1/256 ~ 16，更暗的像素计入第0档(黑)并被忽略
+static const float kMinLogLuminance = -8.0f;
+static const float kLogLuminanceRange = 12.0f;
+
+AutoExposure::AutoExposure(const char* shaderPrefix) :
+    key(1.0f),
+    lowPercent(0.95f),
+    highPercent(0.005f),
+    minExposure(0.25f),
+    maxExposure(4.0f),
+    adaptationRate(1.5f),
+    m_histogram(nullptr),
+    m_exposure(nullptr),
+    m_histogramProg(0),
+    m_averageProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    std::vector<uint32_t> zeros(kNumBins, 0);
+    m_histogram = new ShaderBuffer<uint32_t>(kNumBins);
+    m_histogram->bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, kNumBins * sizeof(uint32_t), zeros.data());
+    m_histogram->unbind();
+
+    m_exposure = new ShaderBuffer<float>(2);
+    reset(1.0f);
+
+    loadShaders();
+}
+
+AutoExposure::~AutoExposure()
+{
+    delete m_histogram;
+    delete m_exposure;
+
+    if (m_histogramProg) glDeleteProgram(m_histogramProg);
+    if (m_averageProg) glDeleteProgram(m_averageProg);
+}
+
+void AutoExposure::loadShaders()
+{
+    PROFILE_SCOPE("AutoExposure::loadShaders");
+
+    GLuint* programs[] = { &m_histogramProg, &m_averageProg };
+    for (GLuint* prog : programs) {
+        if (*prog) {
+            glDeleteProgram(*prog);
+            *prog = 0;
+        }
+    }
+
+    std::string src = readShaderFile("assets/shaders/exposurePass.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_histogramProg = createComputeProgram(injectShaderDefines(src, "#define EXPOSURE_HISTOGRAM\n").c_str(), m_shaderPrefix);
+    m_averageProg = createComputeProgram(injectShaderDefines(src, "#define EXPOSURE_AVERAGE\n").c_str(), m_shaderPrefix);
+    if (m_histogramProg == 0 || m_averageProg == 0) {
+        std::cerr << "Failed to create auto exposure shader programs" << std::endl;
+    }
+}
+
+void AutoExposure::update(GLuint sceneTexture, int width, int height, float deltaTime)
+{
+    PROFILE_GPU_SCOPE("AutoExposure::update");
+    if (m_histogramProg == 0 || m_averageProg == 0 || width <= 0 || height <= 0) return;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 26, m_histogram->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 27, m_exposure->getBuffer());
+
+    glUseProgram(m_histogramProg);
+    glUniform1i(glGetUniformLocation(m_histogramProg, "sceneTexture"), 0);
+    glUniform1f(glGetUniformLocation(m_histogramProg, "minLogLuminance"), kMinLogLuminance);
+    glUniform1f(glGetUniformLocation(m_histogramProg, "logLuminanceRange"), kLogLuminanceRange);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sceneTexture);
+    // 每个线程取2x2像素的平均
+    int samplesX = (width + 1) / 2;
+    int samplesY = (height + 1) / 2;
+    glDispatchCompute((samplesX + kGroupSize - 1) / kGroupSize, (samplesY + kGroupSize - 1) / kGroupSize, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(m_averageProg);
+    glUniform1f(glGetUniformLocation(m_averageProg, "minLogLuminance"), kMinLogLuminance);
+    glUniform1f(glGetUniformLocation(m_averageProg, "logLuminanceRange"), kLogLuminanceRange);
+    glUniform1f(glGetUniformLocation(m_averageProg, "lowPercent"), lowPercent);
+    glUniform1f(glGetUniformLocation(m_averageProg, "highPercent"), highPercent);
+    glUniform1f(glGetUniformLocation(m_averageProg, "key"), key);
+    glUniform1f(glGetUniformLocation(m_averageProg, "minExposure"), minExposure);
+    glUniform1f(glGetUniformLocation(m_averageProg, "maxExposure"), maxExposure);
+    glUniform1f(glGetUniformLocation(m_averageProg, "adaptation"), 1.0f - expf(-deltaTime * adaptationRate));
+    glDispatchCompute(1, 1, 1);
+    // 之后的片元与计算着色器都从缓冲读取曝光
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(0);
+    CHECK_GL_ERROR();
+}
+
+void AutoExposure::reset(float exposure)
+{
+    float values[2] = { exposure, 0.0f };
+    m_exposure->bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(values), values);
+    m_exposure->unbind();
+}
+
+void AutoExposure::bind()
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 27, m_exposure->getBuffer());
+}
+
+float AutoExposure::readExposure(float* averageLuminance)
+{
+    float values[2] = {};
+    m_exposure->bind();
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(values), values);
+    m_exposure->unbind();
+    if (averageLuminance) {
+        *averageLuminance = values[1];
+    }
+    return values[0];
+}
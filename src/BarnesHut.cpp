@@ -0,0 +1,436 @@
+#include "BarnesHut.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+const int kMortonBits = 21;
+// 顶部串行展开的层数，其下最多 8^2 = 64 棵子树并行构建
+const int kSplitLevel = 2;
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 把[0, count)分成numThreads段并行执行，fn(begin, end, thread)
+template <class F>
+void parallelFor(int numThreads, size_t count, F fn)
+{
+    if (numThreads <= 1 || count < 1024) {
+        fn((size_t)0, count, 0);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    size_t chunk = (count + numThreads - 1) / numThreads;
+    for (int t = 0; t < numThreads; t++) {
+        size_t begin = std::min(count, t * chunk);
+        size_t end = std::min(count, begin + chunk);
+        threads.emplace_back([=]() { fn(begin, end, t); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+uint64_t expandBits21(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x001f00000000ffffull;
+    v = (v | v << 16) & 0x001f0000ff0000ffull;
+    v = (v | v << 8)  & 0x100f00f00f00f00full;
+    v = (v | v << 4)  & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2)  & 0x1249249249249249ull;
+    return v;
+}
+
+inline int digitAt(uint64_t key, int level)
+{
+    return (int)((key >> (3 * (kMortonBits - 1 - level))) & 7);
+}
+
+} // namespace
+
+BarnesHut::BarnesHut(int numThreads) :
+    theta(0.5f),
+    gravity(4.0e-6f),
+    softening(0.02f),
+    m_numThreads(numThreads),
+    m_count(0),
+    m_bodyMass(0.0f),
+    m_stats()
+{
+    if (m_numThreads <= 0) {
+        m_numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+void BarnesHut::solve(const glm::vec4* pos, size_t count, glm::vec4* accel)
+{
+    PROFILE_SCOPE("BarnesHut::solve");
+
+    build(pos, count);
+    computeAccelerations(accel);
+}
+
+void BarnesHut::build(const glm::vec4* pos, size_t count)
+{
+    PROFILE_SCOPE("BarnesHut::build");
+    auto start = std::chrono::steady_clock::now();
+
+    m_count = count;
+    m_bodyMass = count > 0 ? 1.0f / count : 0.0f;
+    m_nodes.clear();
+    m_leaves.clear();
+    if (count == 0) {
+        m_stats.buildMs = elapsedMs(start);
+        m_stats.numNodes = 0;
+        return;
+    }
+
+    // 包围立方体
+    std::vector<glm::vec3> threadMin(m_numThreads, glm::vec3(1e30f));
+    std::vector<glm::vec3> threadMax(m_numThreads, glm::vec3(-1e30f));
+    parallelFor(m_numThreads, count, [&](size_t begin, size_t end, int t) {
+        for (size_t i = begin; i < end; i++) {
+            threadMin[t] = glm::min(threadMin[t], glm::vec3(pos[i]));
+            threadMax[t] = glm::max(threadMax[t], glm::vec3(pos[i]));
+        }
+    });
+    glm::vec3 lo(1e30f), hi(-1e30f);
+    for (int t = 0; t < m_numThreads; t++) {
+        lo = glm::min(lo, threadMin[t]);
+        hi = glm::max(hi, threadMax[t]);
+    }
+    glm::vec3 center = (lo + hi) * 0.5f;
+    float halfSize = std::max(std::max(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z) * 0.5f * 1.001f + 1e-6f;
+
+    // Morton码: 高位为x，低位为z
+    std::vector<std::pair<uint64_t, uint32_t>> keyed(count);
+    const float scale = (float)((1 << kMortonBits) - 1) / (2.0f * halfSize);
+    const glm::vec3 origin = center - glm::vec3(halfSize);
+    parallelFor(m_numThreads, count, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            glm::vec3 q = (glm::vec3(pos[i]) - origin) * scale;
+            uint64_t key = (expandBits21((uint64_t)q.x) << 2) | (expandBits21((uint64_t)q.y) << 1) |
+                           expandBits21((uint64_t)q.z);
+            keyed[i] = std::make_pair(key, (uint32_t)i);
+        }
+    });
+
+    // 分段并行排序后逐轮两两归并
+    size_t chunk = (count + m_numThreads - 1) / m_numThreads;
+    parallelFor(m_numThreads, count, [&](size_t begin, size_t end, int) {
+        std::sort(keyed.begin() + begin, keyed.begin() + end);
+    });
+    for (size_t width = chunk; width < count; width *= 2) {
+        std::vector<std::thread> merges;
+        for (size_t begin = 0; begin + width < count; begin += 2 * width) {
+            size_t mid = begin + width;
+            size_t end = std::min(count, begin + 2 * width);
+            merges.emplace_back([&keyed, begin, mid, end]() {
+                std::inplace_merge(keyed.begin() + begin, keyed.begin() + mid, keyed.begin() + end);
+            });
+        }
+        for (std::thread& merge : merges) {
+            merge.join();
+        }
+    }
+
+    m_keys.resize(count);
+    m_order.resize(count);
+    m_x.resize(count);
+    m_y.resize(count);
+    m_z.resize(count);
+    parallelFor(m_numThreads, count, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            uint32_t body = keyed[i].second;
+            m_keys[i] = keyed[i].first;
+            m_order[i] = body;
+            m_x[i] = pos[body].x;
+            m_y[i] = pos[body].y;
+            m_z[i] = pos[body].z;
+        }
+    });
+
+    // 顶部几层串行展开，记录待并行构建的子树
+    std::vector<SubtreeTask> tasks;
+    m_nodes.push_back(Node());
+    m_nodes[0].center = center;
+    m_nodes[0].halfSize = halfSize;
+    buildNode(m_nodes, 0, 0, (uint32_t)count, 0, &tasks);
+    int topCount = (int)m_nodes.size();
+
+    std::vector<std::vector<Node>> subtrees(tasks.size());
+    std::atomic<size_t> nextTask(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < std::min<int>(m_numThreads, (int)tasks.size()); t++) {
+        workers.emplace_back([&]() {
+            for (size_t k = nextTask++; k < tasks.size(); k = nextTask++) {
+                const SubtreeTask& task = tasks[k];
+                std::vector<Node>& local = subtrees[k];
+                local.push_back(m_nodes[task.node]);
+                buildNode(local, 0, task.begin, task.end, task.level, nullptr);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // 拼接: 子树根写回占位节点，其余节点追加并修正子节点下标
+    for (size_t k = 0; k < tasks.size(); k++) {
+        std::vector<Node>& local = subtrees[k];
+        int offset = (int)m_nodes.size() - 1;
+        for (Node& node : local) {
+            if (node.childCount > 0) node.firstChild += offset;
+        }
+        m_nodes[tasks[k].node] = local[0];
+        m_nodes.insert(m_nodes.end(), local.begin() + 1, local.end());
+    }
+
+    // 顶部节点的子节点下标总是更大，逆序即可自底向上汇总质量
+    for (int i = topCount - 1; i >= 0; i--) {
+        if (m_nodes[i].childCount > 0 && m_nodes[i].mass == 0.0f) {
+            finalizeNode(m_nodes, i);
+        }
+    }
+
+    for (int i = 0; i < (int)m_nodes.size(); i++) {
+        if (m_nodes[i].childCount == 0) {
+            m_leaves.push_back(i);
+        }
+    }
+
+    m_stats.numNodes = m_nodes.size();
+    m_stats.buildMs = elapsedMs(start);
+}
+
+void BarnesHut::buildNode(std::vector<Node>& nodes, int index, uint32_t begin, uint32_t end, int level,
+                          std::vector<SubtreeTask>* tasks)
+{
+    {
+        Node& node = nodes[index];
+        node.bodyBegin = begin;
+        node.bodyEnd = end;
+        node.firstChild = 0;
+        node.childCount = 0;
+        node.mass = 0.0f;
+        node.com = glm::vec3(0.0f);
+    }
+
+    if (tasks && level >= kSplitLevel && end - begin > (uint32_t)kLeafSize) {
+        tasks->push_back({ index, begin, end, level });
+        return;
+    }
+
+    if (end - begin <= (uint32_t)kLeafSize || level >= kMortonBits) {
+        finalizeNode(nodes, index);
+        return;
+    }
+
+    // 码已排序，同一前缀下第level位数字单调不减，二分即可找到各子区间
+    uint32_t ranges[9];
+    ranges[0] = begin;
+    for (int d = 1; d < 8; d++) {
+        ranges[d] = (uint32_t)(std::partition_point(m_keys.begin() + ranges[d - 1], m_keys.begin() + end,
+                                                    [&](uint64_t key) { return digitAt(key, level) < d; }) -
+                               m_keys.begin());
+    }
+    ranges[8] = end;
+
+    int firstChild = (int)nodes.size();
+    int childCount = 0;
+    for (int d = 0; d < 8; d++) {
+        if (ranges[d + 1] > ranges[d]) childCount++;
+    }
+    nodes.resize(nodes.size() + childCount);
+    nodes[index].firstChild = firstChild;
+    nodes[index].childCount = childCount;
+
+    glm::vec3 center = nodes[index].center;
+    float quarter = nodes[index].halfSize * 0.5f;
+    int child = firstChild;
+    for (int d = 0; d < 8; d++) {
+        if (ranges[d + 1] == ranges[d]) continue;
+        nodes[child].center = center + glm::vec3((d & 4) ? quarter : -quarter,
+                                                 (d & 2) ? quarter : -quarter,
+                                                 (d & 1) ? quarter : -quarter);
+        nodes[child].halfSize = quarter;
+        buildNode(nodes, child, ranges[d], ranges[d + 1], level + 1, tasks);
+        child++;
+    }
+
+    if (!tasks) {
+        finalizeNode(nodes, index);
+    }
+}
+
+void BarnesHut::finalizeNode(std::vector<Node>& nodes, int index)
+{
+    Node& node = nodes[index];
+    // 相对节点中心累加: 最深一层的叶子可能有上千个粒子，按绝对坐标累加的舍入误差
+    // 会让质心偏出节点，遍历时整组被当作远处的质点
+    glm::vec3 weighted(0.0f);
+    float mass = 0.0f;
+
+    if (node.childCount == 0) {
+        for (uint32_t i = node.bodyBegin; i < node.bodyEnd; i++) {
+            weighted += glm::vec3(m_x[i], m_y[i], m_z[i]) - node.center;
+        }
+        mass = (node.bodyEnd - node.bodyBegin) * m_bodyMass;
+        weighted *= m_bodyMass;
+    } else {
+        for (int c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+            weighted += (nodes[c].com - node.center) * nodes[c].mass;
+            mass += nodes[c].mass;
+        }
+    }
+
+    node.mass = mass;
+    node.com = mass > 0.0f ? node.center + weighted / mass : node.center;
+}
+
+void BarnesHut::computeAccelerations(glm::vec4* accel)
+{
+    PROFILE_SCOPE("BarnesHut::traverse");
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<size_t> threadInteractions(m_numThreads, 0);
+    std::atomic<size_t> nextLeaf(0);
+    std::vector<std::thread> workers;
+
+    // 叶子按Morton序排列，动态领取小批量以平衡负载
+    const size_t batch = 64;
+    auto work = [&](int t) {
+        std::vector<float> list;
+        for (size_t first = nextLeaf.fetch_add(batch); first < m_leaves.size(); first = nextLeaf.fetch_add(batch)) {
+            size_t last = std::min(first + batch, m_leaves.size());
+            for (size_t k = first; k < last; k++) {
+                computeLeafGroup(m_nodes[m_leaves[k]], accel, list, threadInteractions[t]);
+            }
+        }
+    };
+    for (int t = 1; t < m_numThreads; t++) {
+        workers.emplace_back(work, t);
+    }
+    work(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    size_t interactions = 0;
+    for (size_t n : threadInteractions) {
+        interactions += n;
+    }
+    m_stats.interactionsPerBody = m_count > 0 ? (double)interactions / m_count : 0.0;
+    m_stats.traverseMs = elapsedMs(start);
+}
+
+void BarnesHut::computeLeafGroup(const Node& leaf, glm::vec4* accel, std::vector<float>& list,
+                                 size_t& interactions) const
+{
+    const uint32_t begin = leaf.bodyBegin;
+    const int groupSize = (int)(leaf.bodyEnd - leaf.bodyBegin);
+
+    // 组包围盒: 对整组都满足张角条件的节点才能整体近似
+    glm::vec3 lo(1e30f), hi(-1e30f);
+    for (int j = 0; j < groupSize; j++) {
+        glm::vec3 p(m_x[begin + j], m_y[begin + j], m_z[begin + j]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+
+    // 交互列表按 x,y,z,m 交错存放
+    list.clear();
+    const float theta2 = theta * theta;
+    int stack[64 * 8];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = m_nodes[stack[--top]];
+        glm::vec3 nearest = glm::clamp(node.com, lo, hi);
+        glm::vec3 d = node.com - nearest;
+        float dist2 = glm::dot(d, d);
+        float width = node.halfSize * 2.0f;
+
+        if (width * width < theta2 * dist2) {
+            list.push_back(node.com.x);
+            list.push_back(node.com.y);
+            list.push_back(node.com.z);
+            list.push_back(node.mass);
+        } else if (node.childCount == 0) {
+            for (uint32_t i = node.bodyBegin; i < node.bodyEnd; i++) {
+                list.push_back(m_x[i]);
+                list.push_back(m_y[i]);
+                list.push_back(m_z[i]);
+                list.push_back(m_bodyMass);
+            }
+        } else {
+            for (int c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+                stack[top++] = c;
+            }
+        }
+    }
+
+    // 外层遍历交互列表，内层遍历组内粒子: 各粒子独立累加，内层循环可直接向量化
+    // Morton码相同的粒子无法再细分，到最深一层的叶子可能超过kLeafSize个，
+    // 按kLeafSize分块，各块共享同一个交互列表
+    const float eps2 = softening * softening;
+    const size_t count = list.size() / 4;
+    for (int chunk = 0; chunk < groupSize; chunk += kLeafSize) {
+        const int chunkSize = std::min(groupSize - chunk, kLeafSize);
+        float bx[kLeafSize], by[kLeafSize], bz[kLeafSize];
+        float ax[kLeafSize], ay[kLeafSize], az[kLeafSize];
+        for (int j = 0; j < kLeafSize; j++) {
+            uint32_t src = begin + chunk + (j < chunkSize ? j : 0);
+            bx[j] = m_x[src];
+            by[j] = m_y[src];
+            bz[j] = m_z[src];
+            ax[j] = ay[j] = az[j] = 0.0f;
+        }
+
+        for (size_t k = 0; k < count; k++) {
+            const float lx = list[k * 4 + 0];
+            const float ly = list[k * 4 + 1];
+            const float lz = list[k * 4 + 2];
+            const float lm = list[k * 4 + 3];
+            for (int j = 0; j < kLeafSize; j++) {
+                float dx = lx - bx[j];
+                float dy = ly - by[j];
+                float dz = lz - bz[j];
+                float r2 = dx * dx + dy * dy + dz * dz + eps2;
+                float invDist = 1.0f / std::sqrt(r2);
+                float s = lm * invDist * invDist * invDist;
+                ax[j] += dx * s;
+                ay[j] += dy * s;
+                az[j] += dz * s;
+            }
+        }
+
+        for (int j = 0; j < chunkSize; j++) {
+            accel[m_order[begin + chunk + j]] = glm::vec4(ax[j] * gravity, ay[j] * gravity, az[j] * gravity, 0.0f);
+        }
+    }
+    interactions += count * groupSize;
+}
+
+glm::vec3 BarnesHut::computeDirect(const glm::vec4* pos, size_t count, size_t body) const
+{
+    const float eps2 = softening * softening;
+    const float mass = count > 0 ? 1.0f / count : 0.0f;
+    glm::vec3 p(pos[body]);
+    glm::vec3 a(0.0f);
+    for (size_t i = 0; i < count; i++) {
+        glm::vec3 d = glm::vec3(pos[i]) - p;
+        float r2 = glm::dot(d, d) + eps2;
+        float invDist = 1.0f / std::sqrt(r2);
+        a += d * (mass * invDist * invDist * invDist);
+    }
+    return a * gravity;
+}
@@ -0,0 +1,1934 @@
+#include "Benchmarks.h"
+#include "ParticleSystem.h"
+#include "ParticleSorter.h"
+#include "ParticleReorder.h"
+#include "AttractorCluster.h"
+#include "BarnesHut.h"
+#include "NeighborGrid.h"
+#include "FluidSolver.h"
+#include "ShapeTargets.h"
+#include "KeplerOrbits.h"
+#include "ParticleReference.h"
+#include "ShellConstraints.h"
+#include "ComputeBloom.h"
+#include "BloomTiles.h"
+#include "AutoExposure.h"
+#include "ComputeParticles.h"
+#include "FrameGraph.h"
+#include "RenderTargetPool.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "uniforms.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* kShaderPrefix = "#version 430\n";
+
+// 用glFinish包围的墙钟计时: 软件光栅器(llvmpipe)的GL_TIMESTAMP不反映计算着色器的实际执行时间，
+// 基准测试统一用此计时以便在不同驱动间比较。接口与GpuTimer相同
+class FinishTimer
+{
+public:
+    FinishTimer() : m_totalMs(0.0), m_samples(0) {}
+
+    void begin() {
+        glFinish();
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    void end() {
+        glFinish();
+        m_totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+        m_samples++;
+    }
+
+    void finish() {}
+
+    void reset() {
+        m_totalMs = 0.0;
+        m_samples = 0;
+    }
+
+    float getAverageMs() const { return m_samples > 0 ? (float)(m_totalMs / m_samples) : 0.0f; }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+    double m_totalMs;
+    int m_samples;
+};
+
+// 与ComputeParticles相同的相机: 绕Y轴旋转、距原点3个单位
+struct BenchScene
+{
+    GLuint ubo;
+    ShaderParams params;
+
+    explicit BenchScene(size_t numParticles) : ubo(0) {
+        params.numParticles = (unsigned int)numParticles;
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(ShaderParams), nullptr, GL_STREAM_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, 1, ubo);
+        setCamera(0.0f);
+    }
+
+    ~BenchScene() {
+        glBindBufferBase(GL_UNIFORM_BUFFER, 1, 0);
+        glDeleteBuffers(1, &ubo);
+    }
+
+    void setCamera(float azimuthDegrees) {
+        float a = glm::radians(azimuthDegrees);
+        glm::vec3 eye(3.0f * sinf(a), 0.0f, -3.0f * cosf(a));
+        glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 10.0f);
+        params.ModelView = view;
+        params.ModelViewProjection = projection * view;
+        params.ProjectionMatrix = projection;
+
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShaderParams), &params);
+    }
+};
+
+// 离屏1080p加性混合绘制，与ComputeParticles的未剔除路径相同
+// 给出orbits时与轨道模式的顶点着色器路径相同，位置在顶点着色器中按orbitTime求值
+struct BenchRenderer
+{
+    static const int width = 1920;
+    static const int height = 1080;
+
+    GLuint fbo;
+    GLuint texture;
+    GLuint vao;
+    ShaderProgram program;
+    bool valid;
+    KeplerOrbits* orbits;
+    float orbitTime;
+
+    explicit BenchRenderer(KeplerOrbits* keplerOrbits = nullptr) :
+        fbo(0), texture(0), vao(0), valid(false), orbits(keplerOrbits), orbitTime(0.0f) {
+        std::string vs = readShaderFile("assets/shaders/basePass.verrt");
+        std::string fs = readShaderFile("assets/shaders/basePass.frag");
+        if (orbits) {
+            vs = injectShaderDefines(KeplerOrbits::insertOrbitCode(vs), "#define KEPLER_ORBITS\n");
+        }
+        valid = !vs.empty() && !fs.empty() && program.loadFromStrings(vs.c_str(), fs.c_str());
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        glGenVertexArrays(1, &vao);
+    }
+
+    ~BenchRenderer() {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &texture);
+    }
+
+    void draw(ParticleSystem* particles) {
+        if (!valid) return;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+        glClearColor(0.25f, 0.25f, 0.25f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+        program.enable();
+        glBindVertexArray(vao);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, particles->getPosBuffer()->getBuffer());
+        if (orbits) {
+            glUniform1f(program.getUniformLocation("orbitTime"), orbitTime);
+            glUniform1f(program.getUniformLocation("orbitGM"), orbits->gm);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, particles->getIdBuffer()->getBuffer());
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 19, orbits->getElementBuffer());
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, particles->getIndexBuffer()->getBuffer());
+        glDrawElements(GL_TRIANGLES, GLsizei(particles->getSize() * 6), GL_UNSIGNED_INT, 0);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 19, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+        glBindVertexArray(0);
+        program.disable();
+        glDisable(GL_BLEND);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+};
+
+void benchmarkSort()
+{
+    const size_t counts[] = { 1u << 20, 1u << 22 };
+    const int runs = 5;
+    const int coherentFrames = 30;
+    const float degreesPerFrame = 0.5f;
+
+    printf("== Depth sort (bitonic, %d frames of %.1f deg/frame camera motion for incremental)\n",
+           coherentFrames, degreesPerFrame);
+
+    for (size_t count : counts) {
+        srand(1234);
+        ParticleSystem particles(count, kShaderPrefix);
+        ParticleSorter sorter(count, kShaderPrefix);
+        BenchScene scene(count);
+        FinishTimer timer;
+
+        for (int run = 0; run < runs; run++) {
+            timer.begin();
+            sorter.updateKeys(&particles);
+            timer.end();
+        }
+        timer.finish();
+        float keysMs = timer.getAverageMs();
+
+        timer.reset();
+        for (int run = 0; run < runs; run++) {
+            timer.begin();
+            sorter.updateKeys(&particles);
+            sorter.sortFull();
+            timer.end();
+        }
+        timer.finish();
+        float fullMs = timer.getAverageMs();
+        size_t fullInversions = sorter.countInversions();
+
+        printf("  %zuK particles (%zu entries)\n", count >> 10, sorter.getEntryCount());
+        printf("    keys only        %8.3f ms\n", keysMs);
+        printf("    full sort        %8.3f ms  inversions %zu\n", fullMs, fullInversions);
+
+        // 从完全有序出发，模拟相机转动和粒子运动，每帧只做少量增量轮次
+        const int passCounts[] = { 1, 2, 4 };
+        for (int passes : passCounts) {
+            scene.setCamera(0.0f);
+            sorter.updateKeys(&particles);
+            sorter.sortFull();
+
+            timer.reset();
+            for (int frame = 1; frame <= coherentFrames; frame++) {
+                scene.setCamera(frame * degreesPerFrame);
+                particles.update(scene.params);
+                timer.begin();
+                sorter.updateKeys(&particles);
+                sorter.sortIncremental(passes);
+                timer.end();
+            }
+            timer.finish();
+            size_t inversions = sorter.countInversions();
+            printf("    incremental x%d   %8.3f ms  inversions %zu (%.4f%%)  %.1fx faster than full\n",
+                   passes, timer.getAverageMs(), inversions, 100.0 * inversions / count,
+                   timer.getAverageMs() > 0.0f ? fullMs / timer.getAverageMs() : 0.0f);
+        }
+        CHECK_GL_ERROR();
+    }
+}
+
+// 粒子随机初始化(创建顺序与空间位置无关)，比较Morton重排前后的计算与绘制耗时
+void benchmarkReorder()
+{
+    const size_t counts[] = { 1u << 20, 1u << 22 };
+    const int warmupFrames = 10;
+    const int runs = 10;
+
+    printf("== Morton reorder (noise state, %dx%d additive draw)\n", BenchRenderer::width, BenchRenderer::height);
+
+    BenchRenderer renderer;
+    for (size_t count : counts) {
+        srand(1234);
+        ParticleSystem particles(count, kShaderPrefix);
+        ParticleReorder reorder(count, kShaderPrefix);
+        BenchScene scene(count);
+        FinishTimer computeTimer, drawTimer, reorderTimer;
+
+        for (int frame = 0; frame < warmupFrames; frame++) {
+            particles.update(scene.params);
+        }
+
+        float computeMs[2], drawMs[2];
+        for (int order = 0; order < 2; order++) {
+            if (order == 1) {
+                for (int run = 0; run < runs; run++) {
+                    reorderTimer.begin();
+                    reorder.reorder(&particles);
+                    reorderTimer.end();
+                }
+                reorderTimer.finish();
+            }
+
+            computeTimer.reset();
+            drawTimer.reset();
+            for (int run = 0; run < runs; run++) {
+                computeTimer.begin();
+                particles.update(scene.params);
+                computeTimer.end();
+
+                drawTimer.begin();
+                renderer.draw(&particles);
+                drawTimer.end();
+            }
+            computeTimer.finish();
+            drawTimer.finish();
+            computeMs[order] = computeTimer.getAverageMs();
+            drawMs[order] = drawTimer.getAverageMs();
+        }
+
+        printf("  %zuK particles\n", count >> 10);
+        printf("    reorder cost     %8.3f ms\n", reorderTimer.getAverageMs());
+        printf("    compute          %8.3f ms -> %8.3f ms  (%.2fx)\n", computeMs[0], computeMs[1],
+               computeMs[1] > 0.0f ? computeMs[0] / computeMs[1] : 0.0f);
+        printf("    draw             %8.3f ms -> %8.3f ms  (%.2fx)\n", drawMs[0], drawMs[1],
+               drawMs[1] > 0.0f ? drawMs[0] / drawMs[1] : 0.0f);
+        CHECK_GL_ERROR();
+    }
+}
+
+// 引力源数量从1到4096，1M粒子处于噪声状态，统计计算耗时、相互作用吞吐量和上传的CPU耗时
+void benchmarkAttractors()
+{
+    const size_t count = 1u << 20;
+    const int attractorCounts[] = { 1, 16, 64, 256, 1024, 4096 };
+    const int runs = 5;
+
+    printf("== Attractor cluster (%zuK particles, tiled shared-memory evaluation)\n", count >> 10);
+
+    srand(1234);
+    ParticleSystem particles(count, kShaderPrefix);
+    AttractorCluster cluster;
+    BenchScene scene(count);
+    FinishTimer timer;
+
+    for (int numAttractors : attractorCounts) {
+        cluster.setCount(numAttractors);
+        scene.params.numAttractors = (unsigned int)numAttractors;
+        scene.setCamera(0.0f);
+
+        double uploadMs = 0.0;
+        timer.reset();
+        for (int run = 0; run < runs; run++) {
+            auto t0 = std::chrono::steady_clock::now();
+            cluster.update(run / 60.0f);
+            uploadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+            particles.setAttractors(cluster.getBuffer(), cluster.getOffset(), cluster.getRangeSize());
+            timer.begin();
+            particles.update(scene.params);
+            timer.end();
+        }
+        timer.finish();
+
+        float ms = timer.getAverageMs();
+        double interactions = (double)count * numAttractors;
+        printf("  %4d attractors  %9.3f ms  %8.2f G interactions/s  upload %.3f ms (CPU)\n",
+               numAttractors, ms, ms > 0.0f ? interactions / (ms * 1.0e6) : 0.0, uploadMs / runs);
+    }
+    CHECK_GL_ERROR();
+}
+
+// CPU Barnes-Hut: 不同粒子数与张角下的构建/遍历耗时，以及相对直接求和的力误差
+void benchmarkBarnesHut()
+{
+    const size_t counts[] = { 1u << 15, 1u << 17, 1u << 19 };
+    const float thetas[] = { 0.3f, 0.5f, 0.7f, 1.0f };
+    const int runs = 3;
+    const size_t samples = 256;
+
+    BarnesHut solver;
+    printf("== Barnes-Hut self-gravity (CPU, %d threads, leaf size %d)\n",
+           solver.getNumThreads(), BarnesHut::kLeafSize);
+
+    for (size_t count : counts) {
+        // Plummer球: 中心密集、外围稀疏，比均匀分布更接近实际的树深度
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        std::vector<glm::vec4> pos(count), accel(count);
+        for (glm::vec4& p : pos) {
+            float m = std::min(uniform(rng), 0.99f);
+            float r = 0.2f / sqrtf(powf(m, -2.0f / 3.0f) - 1.0f);
+            float z = uniform(rng) * 2.0f - 1.0f;
+            float phi = uniform(rng) * 6.28318530718f;
+            float s = sqrtf(1.0f - z * z);
+            p = glm::vec4(r * s * cosf(phi), r * s * sinf(phi), r * z, 1.0f);
+        }
+
+        std::vector<glm::vec3> direct(samples);
+        for (size_t k = 0; k < samples; k++) {
+            direct[k] = solver.computeDirect(pos.data(), count, k * (count / samples));
+        }
+
+        for (float theta : thetas) {
+            solver.theta = theta;
+            double buildMs = 0.0, traverseMs = 0.0;
+            for (int run = 0; run < runs; run++) {
+                solver.solve(pos.data(), count, accel.data());
+                buildMs += solver.getStats().buildMs;
+                traverseMs += solver.getStats().traverseMs;
+            }
+
+            double errSq = 0.0;
+            for (size_t k = 0; k < samples; k++) {
+                glm::vec3 diff = glm::vec3(accel[k * (count / samples)]) - direct[k];
+                errSq += glm::dot(diff, diff) / std::max(glm::dot(direct[k], direct[k]), 1e-30f);
+            }
+
+            printf("  %4zuK  theta %.1f  build %8.2f ms  traverse %9.2f ms  %7.0f interactions/body  "
+                   "%zu nodes  rms force error %.2e\n",
+                   count >> 10, theta, buildMs / runs, traverseMs / runs,
+                   solver.getStats().interactionsPerBody, solver.getStats().numNodes, sqrt(errSq / samples));
+        }
+    }
+
+    // 重合的粒子(如吸收状态之后进入粒子群): Morton码相同，最深一层的叶子远超kLeafSize个，
+    // 叶子内每个粒子都要与直接求和一致
+    const size_t count = 1u << 15;
+    const size_t coincident = 4096;
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> uniform(-0.5f, 0.5f);
+    std::vector<glm::vec4> pos(count), accel(count);
+    for (size_t i = 0; i < count; i++) {
+        pos[i] = i < coincident ? glm::vec4(0.8f, 0.2f, 0.0f, 1.0f)
+                                : glm::vec4(uniform(rng), uniform(rng), uniform(rng), 1.0f);
+    }
+    solver.theta = 0.5f;
+    solver.solve(pos.data(), count, accel.data());
+
+    double errSq = 0.0;
+    double maxErr = 0.0;
+    for (size_t k = 0; k < coincident; k++) {
+        glm::vec3 direct = solver.computeDirect(pos.data(), count, k);
+        glm::vec3 diff = glm::vec3(accel[k]) - direct;
+        double err = sqrt(glm::dot(diff, diff) / std::max(glm::dot(direct, direct), 1e-30f));
+        errSq += err * err;
+        maxErr = std::max(maxErr, err);
+    }
+    printf("  %4zuK  %zu coincident bodies  theta %.1f  %zu nodes  rms force error %.2e  max %.2e\n",
+           count >> 10, coincident, solver.theta, solver.getStats().numNodes, sqrt(errSq / coincident), maxErr);
+}
+
+// 邻域网格: 各重建阶段(计数/前缀和/散射)与鸟群查询步进的耗时，以普通噪声步进作对照
+void benchmarkNeighborGrid()
+{
+    const size_t counts[] = { 1u << 18, 1u << 20 };
+    const int runs = 10;
+
+    printf("== Neighbor grid (spatial hash, %u cells)\n", NeighborGrid::kNumCells);
+
+    for (size_t count : counts) {
+        srand(1234);
+        ParticleSystem particles(count, kShaderPrefix);
+        NeighborGrid grid(count, kShaderPrefix);
+        particles.setNeighborGrid(grid.getSortedBuffer(), grid.getCellRangeBuffer());
+
+        BenchScene scene(count);
+        scene.params.numGridCells = NeighborGrid::kNumCells;
+        scene.params.gridCellSize = grid.cellSize;
+
+        FinishTimer countTimer, scanTimer, scatterTimer, flockTimer, normalTimer;
+
+        scene.params.particleState = 0.0f;
+        scene.setCamera(0.0f);
+        for (int run = 0; run < runs; run++) {
+            normalTimer.begin();
+            particles.update(scene.params);
+            normalTimer.end();
+        }
+
+        // 先步进几次让速度进入鸟群的速度区间
+        scene.params.particleState = 5.0f;
+        scene.setCamera(0.0f);
+        for (int run = 0; run < 3; run++) {
+            grid.build(&particles);
+            particles.update(scene.params);
+        }
+
+        for (int run = 0; run < runs; run++) {
+            countTimer.begin();
+            grid.countCells(&particles);
+            countTimer.end();
+            scanTimer.begin();
+            grid.scanCells();
+            scanTimer.end();
+            scatterTimer.begin();
+            grid.scatter(&particles);
+            scatterTimer.end();
+            flockTimer.begin();
+            particles.update(scene.params);
+            flockTimer.end();
+        }
+
+        float buildMs = countTimer.getAverageMs() + scanTimer.getAverageMs() + scatterTimer.getAverageMs();
+        printf("  %4zuK  count %7.3f  scan %7.3f  scatter %7.3f  build %7.3f ms  |  flock step %8.3f ms"
+               "  (noise step %7.3f ms)  %.1f ns/particle total\n",
+               count >> 10, countTimer.getAverageMs(), scanTimer.getAverageMs(), scatterTimer.getAverageMs(),
+               buildMs, flockTimer.getAverageMs(), normalTimer.getAverageMs(),
+               (buildMs + flockTimer.getAverageMs()) * 1.0e6 / count);
+    }
+    CHECK_GL_ERROR();
+}
+
+// 网格流体: 各分辨率与压力迭代次数下每个阶段的耗时，以及粒子采样平流的耗时(与网格无关)
+void benchmarkFluid()
+{
+    const int sizes[] = { 64, 96, 128 };
+    const int iterationCounts[] = { 10, 20, 40 };
+    const int runs = 5;
+
+    printf("== Grid fluid (stable fluids, Jacobi pressure projection)\n");
+
+    FluidSolver fluid(sizes[0], kShaderPrefix);
+    for (int size : sizes) {
+        fluid.setResolution(size);
+        for (int iterations : iterationCounts) {
+            fluid.jacobiIterations = iterations;
+            FinishTimer advectTimer, vorticityTimer, divergenceTimer, pressureTimer, projectTimer;
+            for (int run = 0; run < runs; run++) {
+                float time = run / 60.0f;
+                advectTimer.begin();
+                fluid.advect(time);
+                advectTimer.end();
+                vorticityTimer.begin();
+                fluid.confineVorticity();
+                vorticityTimer.end();
+                divergenceTimer.begin();
+                fluid.computeDivergence();
+                divergenceTimer.end();
+                pressureTimer.begin();
+                fluid.solvePressure();
+                pressureTimer.end();
+                projectTimer.begin();
+                fluid.project();
+                projectTimer.end();
+            }
+
+            float total = advectTimer.getAverageMs() + vorticityTimer.getAverageMs() + divergenceTimer.getAverageMs() +
+                          pressureTimer.getAverageMs() + projectTimer.getAverageMs();
+            printf("  %3d^3  %2d iterations  advect %7.3f  vorticity %7.3f  divergence %7.3f  pressure %8.3f"
+                   "  project %7.3f  total %8.3f ms\n",
+                   size, iterations, advectTimer.getAverageMs(), vorticityTimer.getAverageMs(),
+                   divergenceTimer.getAverageMs(), pressureTimer.getAverageMs(), projectTimer.getAverageMs(), total);
+        }
+    }
+
+    const size_t counts[] = { 1u << 18, 1u << 20 };
+    for (size_t count : counts) {
+        srand(1234);
+        ParticleSystem particles(count, kShaderPrefix);
+        particles.setFluidVelocity(fluid.getVelocityTexture());
+        BenchScene scene(count);
+        scene.params.particleState = 6.0f;
+        scene.params.fluidExtent = fluid.domainExtent;
+        scene.setCamera(0.0f);
+
+        FinishTimer timer;
+        for (int run = 0; run < runs; run++) {
+            timer.begin();
+            particles.update(scene.params);
+            timer.end();
+        }
+        printf("  particle advection %4zuK  %8.3f ms\n", count >> 10, timer.getAverageMs());
+    }
+    CHECK_GL_ERROR();
+}
+
+// 形状目标: 网格面积加权采样的吞吐量与线程数的关系，以及形状状态步进中查表与逐帧求值三角函数的对比
+void benchmarkShapes()
+{
+    const size_t numPoints = 1u << 20;
+    const int runs = 5;
+
+    printf("== Shape targets (area-weighted mesh sampling, %zuK points)\n", numPoints >> 10);
+
+    // 细分的环面，三角形面积不均匀，alias表的作用可以体现出来
+    TriangleMesh mesh;
+    const int rings = 512, sides = 256;
+    for (int r = 0; r < rings; r++) {
+        for (int k = 0; k < sides; k++) {
+            float u = r * 6.28318530718f / rings, v = k * 6.28318530718f / sides;
+            mesh.vertices.push_back(glm::vec3((1.0f + 0.4f * cosf(v)) * cosf(u), 0.4f * sinf(v),
+                                              (1.0f + 0.4f * cosf(v)) * sinf(u)));
+            uint32_t a = r * sides + k, b = ((r + 1) % rings) * sides + k;
+            uint32_t c = ((r + 1) % rings) * sides + (k + 1) % sides, d = r * sides + (k + 1) % sides;
+            mesh.triangles.push_back(glm::uvec3(a, b, c));
+            mesh.triangles.push_back(glm::uvec3(a, c, d));
+        }
+    }
+
+    std::vector<glm::vec4> points(numPoints);
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (int threads = 1; ; threads *= 2) {
+        threads = std::min(threads, maxThreads);
+        ShapeTargets shapes(numPoints, threads);
+        double totalMs = 0.0;
+        for (int run = 0; run < runs; run++) {
+            auto start = std::chrono::steady_clock::now();
+            shapes.samplePoints(mesh, numPoints, points.data(), 1);
+            totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        double ms = totalMs / runs;
+        printf("  %2d threads  %zuK triangles  %8.3f ms  %7.1f Mpoints/s\n",
+               threads, mesh.triangles.size() >> 10, ms, numPoints / (ms * 1000.0));
+        if (threads == maxThreads) break;
+    }
+
+    // 形状状态步进: 查表(默认)与逐帧求值爱心曲线(ANALYTIC_SHAPE_TARGETS)
+    const size_t counts[] = { 1u << 18, 1u << 20 };
+    for (size_t count : counts) {
+        srand(1234);
+        ParticleSystem particles(count, kShaderPrefix);
+        ShapeTargets shapes(count);
+        int heart = shapes.addHeart(0.3f);
+        particles.setShapeTargets(shapes.getBuffer());
+
+        BenchScene scene(count);
+        scene.params.particleState = 2.0f;
+        scene.params.targetOffsetA = scene.params.targetOffsetB = shapes.getOffset(heart);
+        scene.setCamera(0.0f);
+
+        // 每种变体先步进一次，排除首次访问缓冲与编译的开销
+        FinishTimer tableTimer, analyticTimer;
+        particles.update(scene.params);
+        for (int run = 0; run < runs; run++) {
+            tableTimer.begin();
+            particles.update(scene.params);
+            tableTimer.end();
+        }
+
+        particles.setShaderDefines("#define ANALYTIC_SHAPE_TARGETS\n");
+        particles.update(scene.params);
+        for (int run = 0; run < runs; run++) {
+            analyticTimer.begin();
+            particles.update(scene.params);
+            analyticTimer.end();
+        }
+
+        printf("  shape step %4zuK  table %8.3f ms  analytic %8.3f ms  speedup %.2fx\n",
+               count >> 10, tableTimer.getAverageMs(), analyticTimer.getAverageMs(),
+               analyticTimer.getAverageMs() / std::max(tableTimer.getAverageMs(), 1e-6f));
+    }
+    CHECK_GL_ERROR();
+}
+
+// 着色器变体: 每个状态分别用uber-kernel与特化变体步进1M粒子，比较耗时与程序大小
+void benchmarkVariants()
+{
+    const size_t count = 1u << 20;
+    const int runs = 5;
+
+    printf("== Particle shader variants (%zuK particles, uber-kernel vs per-state specialisation)\n", count >> 10);
+
+    srand(1234);
+    ParticleSystem particles(count, kShaderPrefix);
+    BenchScene scene(count);
+
+    AttractorCluster cluster;
+    cluster.setCount(256);
+    cluster.update(0.0f);
+    particles.setAttractors(cluster.getBuffer(), cluster.getOffset(), cluster.getRangeSize());
+
+    ShapeTargets shapes(count);
+    int heart = shapes.addHeart(0.3f);
+    particles.setShapeTargets(shapes.getBuffer());
+
+    // 粒子群的加速度只影响数值，不影响耗时，这里用常量
+    std::vector<glm::vec4> accel(count, glm::vec4(0.0f, -1.0e-6f, 0.0f, 0.0f));
+    GLuint accelBuffer;
+    glGenBuffers(1, &accelBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, accelBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(glm::vec4), accel.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    particles.setSwarmAccelerations(accelBuffer);
+
+    NeighborGrid grid(count, kShaderPrefix);
+    particles.setNeighborGrid(grid.getSortedBuffer(), grid.getCellRangeBuffer());
+
+    FluidSolver fluid(64, kShaderPrefix);
+    for (int step = 0; step < 10; step++) {
+        fluid.step(step / 60.0f);
+    }
+    particles.setFluidVelocity(fluid.getVelocityTexture());
+
+    struct Case
+    {
+        const char* name;
+        float particleState;
+        float attractor;
+        unsigned int numAttractors;
+        unsigned int noiseOctaves;
+        unsigned int numSwarmBodies;
+    };
+    const Case cases[] = {
+        { "normal",               0.0f, 0.0f,    0,   4, 0 },
+        { "normal 2 octaves",     0.0f, 0.0f,    0,   2, 0 },
+        { "normal+attractor",     0.0f, 0.0002f, 0,   4, 0 },
+        { "normal+cluster(256)",  0.0f, 0.0f,    256, 4, 0 },
+        { "absorbing",            1.0f, 0.0f,    0,   4, 0 },
+        { "shape",                2.0f, 0.0f,    0,   4, 0 },
+        { "swarm",                4.0f, 0.0f,    0,   4, (unsigned int)(count / 8) },
+        { "flock",                5.0f, 0.0f,    0,   4, 0 },
+        { "fluid",                6.0f, 0.0f,    0,   4, 0 },
+    };
+
+    scene.params.numGridCells = NeighborGrid::kNumCells;
+    scene.params.gridCellSize = grid.cellSize;
+    scene.params.fluidExtent = fluid.domainExtent;
+    scene.params.targetOffsetA = scene.params.targetOffsetB = shapes.getOffset(heart);
+
+    for (const Case& c : cases) {
+        scene.params.particleState = c.particleState;
+        scene.params.attractor = glm::vec4(0.3f, -0.2f, 0.1f, c.attractor);
+        scene.params.numAttractors = c.numAttractors;
+        scene.params.noiseOctaves = c.noiseOctaves;
+        scene.params.numSwarmBodies = c.numSwarmBodies;
+        scene.setCamera(0.0f);
+
+        float ms[2];
+        for (int specialized = 0; specialized < 2; specialized++) {
+            particles.specializeShaders = specialized != 0;
+            FinishTimer timer;
+            // 先步进一次，排除变体首次编译的开销
+            if (c.particleState > 4.5f && c.particleState < 5.5f) grid.build(&particles);
+            particles.update(scene.params);
+            for (int run = 0; run < runs; run++) {
+                if (c.particleState > 4.5f && c.particleState < 5.5f) grid.build(&particles);
+                timer.begin();
+                particles.update(scene.params);
+                timer.end();
+            }
+            ms[specialized] = timer.getAverageMs();
+        }
+
+        // 核心GL无法查询寄存器数与占用率，以驱动生成的程序二进制大小近似代码量
+        GLint uberSize = 0, variantSize = 0;
+        glGetProgramiv(particles.getProgram(ParticleSystem::kUberKernel), GL_PROGRAM_BINARY_LENGTH, &uberSize);
+        glGetProgramiv(particles.getProgram(ParticleSystem::variantKey(scene.params)), GL_PROGRAM_BINARY_LENGTH, &variantSize);
+
+        printf("  %-20s uber %8.3f ms  variant %8.3f ms  speedup %.2fx  |  binary %7d -> %7d bytes\n",
+               c.name, ms[0], ms[1], ms[0] / std::max(ms[1], 1e-6f), uberSize, variantSize);
+    }
+    printf("  %zu variants compiled\n", particles.getVariantCount());
+
+    glDeleteBuffers(1, &accelBuffer);
+    CHECK_GL_ERROR();
+}
+
+// 开普勒轨道模式与积分模式对比: 1M粒子的每帧计算/绘制耗时、每帧读写的粒子状态字节数，
+// 以及用逐帧积分(半隐式欧拉，60Hz)跟踪同样轨道时的漂移
+void benchmarkOrbits()
+{
+    const size_t count = 1u << 20;
+    const int runs = 5;
+
+    printf("== Kepler orbits vs integrated mode (%zuK particles, %dx%d additive draw)\n",
+           count >> 10, BenchRenderer::width, BenchRenderer::height);
+
+    srand(1234);
+    ParticleSystem particles(count, kShaderPrefix);
+    BenchScene scene(count);
+    KeplerOrbits orbits(count, kShaderPrefix);
+    orbits.generate(64, 7);
+    BenchRenderer renderer;
+    BenchRenderer orbitRenderer(&orbits);
+
+    FinishTimer integrateTimer, evaluateTimer, evaluateVelTimer, scrubTimer, drawTimer, vertexDrawTimer;
+    particles.update(scene.params);
+    orbits.evaluate(&particles, 0.0f);
+    for (int run = 0; run < runs; run++) {
+        float time = run / 60.0f;
+
+        integrateTimer.begin();
+        particles.update(scene.params);
+        integrateTimer.end();
+
+        evaluateVelTimer.begin();
+        orbits.evaluate(&particles, time, true);
+        evaluateVelTimer.end();
+
+        // 跳转到一小时后与逐帧推进的开销相同
+        scrubTimer.begin();
+        orbits.evaluate(&particles, 3600.0f + time);
+        scrubTimer.end();
+
+        evaluateTimer.begin();
+        orbits.evaluate(&particles, time);
+        evaluateTimer.end();
+
+        drawTimer.begin();
+        renderer.draw(&particles);
+        drawTimer.end();
+
+        orbitRenderer.orbitTime = time;
+        vertexDrawTimer.begin();
+        orbitRenderer.draw(&particles);
+        vertexDrawTimer.end();
+    }
+
+    // 每帧读写的粒子状态: 积分读写pos/vel；轨道读编号与12字节根数，只写pos；顶点着色器求值不写
+    const size_t elementBytes = KeplerOrbits::kWordsPerParticle * sizeof(uint32_t);
+    printf("  %-30s %8s %8s %10s %10s\n", "", "compute", "draw", "read B/p", "write B/p");
+    printf("  %-30s %8.3f %8.3f %10zu %10zu\n", "integrated (noise state)",
+           integrateTimer.getAverageMs(), drawTimer.getAverageMs(), 2 * sizeof(glm::vec4) + sizeof(uint32_t), 2 * sizeof(glm::vec4));
+    printf("  %-30s %8.3f %8.3f %10zu %10zu\n", "orbits, orbitPass.cs",
+           evaluateTimer.getAverageMs(), drawTimer.getAverageMs(), elementBytes + sizeof(uint32_t), sizeof(glm::vec4));
+    printf("  %-30s %8.3f %8s %10zu %10zu\n", "orbits, orbitPass.cs + velocity",
+           evaluateVelTimer.getAverageMs(), "-", elementBytes + sizeof(uint32_t), 2 * sizeof(glm::vec4));
+    printf("  %-30s %8.3f %8s\n", "orbits, scrub to t+3600s", scrubTimer.getAverageMs(), "-");
+    printf("  %-30s %8.3f %8.3f %10zu %10d\n", "orbits, vertex shader",
+           0.0f, vertexDrawTimer.getAverageMs(), elementBytes + sizeof(uint32_t), 0);
+
+    // 逐帧积分同样的轨道(中心引力，半隐式欧拉)，与解析解比较位置误差
+    const int samples = 1024;
+    const float dt = 1.0f / 60.0f;
+    const float durations[] = { 60.0f, 600.0f };
+    const std::vector<uint32_t>& packed = orbits.getPackedElements();
+    size_t stride = count / samples;
+    printf("  drift of per-frame integration (semi-implicit Euler, 60 Hz) vs closed-form orbit, %d orbits:\n", samples);
+    for (float duration : durations) {
+        int steps = (int)(duration / dt + 0.5f);
+        double sumError = 0.0, maxError = 0.0;
+        for (int s = 0; s < samples; s++) {
+            KeplerOrbits::Elements el = KeplerOrbits::unpackElements(&packed[s * stride * KeplerOrbits::kWordsPerParticle]);
+            glm::vec3 v;
+            glm::vec3 p = KeplerOrbits::position(el, 0.0f, orbits.gm, &v);
+            for (int step = 0; step < steps; step++) {
+                float r = glm::length(p);
+                v -= p * (orbits.gm / (r * r * r)) * dt;
+                p += v * dt;
+            }
+            double error = glm::length(p - KeplerOrbits::position(el, steps * dt, orbits.gm));
+            sumError += error;
+            maxError = std::max(maxError, error);
+        }
+        printf("    after %5.0f s: mean %.2e  max %.2e  (closed form: 0)\n", duration, sumError / samples, maxError);
+    }
+    CHECK_GL_ERROR();
+}
+
+// 积分器对比: 1M粒子每步的GPU耗时，以及在CPU参考实现上搜索各积分器仍然可用的最大步长。
+// 可用的标准是各检查时刻的位置RMS误差(相对极小步长RK4的解)低于粒子尺寸的量级
+void benchmarkIntegrators()
+{
+    const size_t count = 1u << 20;
+    const int runs = 5;
+
+    printf("== Particle integrators (%zuK particles, GPU cost per step; CPU search for the largest usable step)\n",
+           count >> 10);
+
+    srand(1234);
+    ParticleSystem particles(count, kShaderPrefix);
+    BenchScene scene(count);
+
+    AttractorCluster cluster;
+    cluster.setCount(256);
+    cluster.update(0.0f);
+    particles.setAttractors(cluster.getBuffer(), cluster.getOffset(), cluster.getRangeSize());
+
+    ShapeTargets shapes(count);
+    int heart = shapes.addHeart(0.3f);
+    particles.setShapeTargets(shapes.getBuffer());
+    scene.params.targetOffsetA = scene.params.targetOffsetB = shapes.getOffset(heart);
+
+    struct GpuCase
+    {
+        const char* name;
+        float particleState;
+        float attractor;
+        unsigned int numAttractors;
+    };
+    const GpuCase gpuCases[] = {
+        { "normal+attractor",    0.0f, 0.0002f, 0 },
+        { "normal+cluster(256)", 0.0f, 0.0f,    256 },
+        { "absorbing",           1.0f, 0.0f,    0 },
+        { "shape",               2.0f, 0.0f,    0 },
+    };
+
+    printf("  %-20s", "ms/step");
+    for (uint32_t integrator = 0; integrator < ParticleSystem::kNumIntegrators; integrator++) {
+        printf(" %9s", ParticleSystem::integratorName(integrator));
+    }
+    printf("\n");
+    for (const GpuCase& c : gpuCases) {
+        scene.params.particleState = c.particleState;
+        scene.params.attractor = glm::vec4(0.3f, -0.2f, 0.1f, c.attractor);
+        scene.params.numAttractors = c.numAttractors;
+
+        float ms[ParticleSystem::kNumIntegrators];
+        for (uint32_t integrator = 0; integrator < ParticleSystem::kNumIntegrators; integrator++) {
+            scene.params.integrator = integrator;
+            scene.setCamera(0.0f);
+            particles.reset();
+            // 先步进一次，排除变体首次编译的开销
+            particles.update(scene.params);
+
+            FinishTimer timer;
+            for (int run = 0; run < runs; run++) {
+                timer.begin();
+                particles.update(scene.params);
+                timer.end();
+            }
+            ms[integrator] = timer.getAverageMs();
+        }
+        printf("  %-20s", c.name);
+        for (float t : ms) {
+            printf(" %9.3f", t);
+        }
+        printf("\n");
+    }
+
+    // CPU参考实现上的步长搜索。噪声关闭，只保留确定的受力，误差只来自积分器
+    const int samples = 2048;
+    const int noiseSize = 16;
+    ParticleReference reference(std::vector<int8_t>(noiseSize * noiseSize * noiseSize * 4, 0), noiseSize);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::vector<glm::vec4> start(samples), targets(samples);
+    for (int i = 0; i < samples; i++) {
+        start[i] = glm::vec4(uniform(rng), uniform(rng), uniform(rng), 1.0f);
+        glm::vec3 dir(uniform(rng), uniform(rng), uniform(rng));
+        targets[i] = glm::vec4(glm::normalize(dir + glm::vec3(1e-4f)) * 0.3f, 1.0f);
+    }
+    reference.setShapeTargets(targets);
+
+    // 吸收状态的受力在中心附近发散，只靠贴合阈值收敛，步长比较没有意义，不参与搜索
+    struct StepCase
+    {
+        const char* name;
+        float particleState;
+        float attractor;
+    };
+    const StepCase stepCases[] = {
+        { "shape spring",   2.0f, 0.0f },
+        { "attractor well", 0.0f, 0.0002f },
+    };
+
+    // 步长以参考帧(1/60秒)为单位，都能整除检查间隔
+    const float steps[] = { 1.0f, 1.5f, 2.0f, 3.0f, 4.0f, 6.0f, 12.0f };
+    const int numSteps = sizeof(steps) / sizeof(steps[0]);
+    const int checkInterval = 12;
+    const int numChecks = 10;
+    const float bound = 4.0f;
+
+    // 返回各检查时刻位置RMS误差的最大值；有粒子飞出bound之外时返回无穷大
+    auto simulate = [&](ShaderParams params, float h, const std::vector<glm::vec4>* exact,
+                        std::vector<glm::vec4>& checks) {
+        std::vector<glm::vec4> pos(start), vel(samples, glm::vec4(0.0f));
+        params.dt = h / 60.0f;
+        int stepsPerCheck = (int)(checkInterval / h + 0.5f);
+        double worst = 0.0;
+        checks.clear();
+        for (int check = 0; check < numChecks; check++) {
+            for (int step = 0; step < stepsPerCheck; step++) {
+                reference.step(params, pos, vel);
+            }
+            double sum = 0.0;
+            for (int i = 0; i < samples; i++) {
+                glm::vec3 p(pos[i]);
+                if (!(glm::length(p) < bound)) {
+                    return (double)INFINITY;
+                }
+                if (exact) {
+                    glm::vec3 d = p - glm::vec3((*exact)[check * samples + i]);
+                    sum += glm::dot(d, d);
+                }
+            }
+            worst = std::max(worst, sqrt(sum / samples));
+            checks.insert(checks.end(), pos.begin(), pos.end());
+        }
+        return worst;
+    };
+
+    for (const StepCase& c : stepCases) {
+        ShaderParams params;
+        params.numParticles = samples;
+        params.particleState = c.particleState;
+        params.attractor = glm::vec4(0.3f, -0.2f, 0.1f, c.attractor);
+        params.noiseStrength = 0.0f;
+        params.targetOffsetA = params.targetOffsetB = 0;
+
+        std::vector<glm::vec4> exact, result;
+        params.integrator = ParticleSystem::kIntegratorRK4;
+        simulate(params, 0.125f, nullptr, exact);
+
+        params.integrator = ParticleSystem::kIntegratorLegacy;
+        double legacyError = simulate(params, 1.0f, &exact, result);
+
+        printf("  %s: worst RMS position error over %d checks in %.1f s, vs RK4 at 1/480 s\n",
+               c.name, numChecks, numChecks * checkInterval / 60.0f);
+        printf("    %-8s", "frames");
+        for (float h : steps) {
+            printf(" %8.1f", h);
+        }
+        printf("  | largest bounded step | largest step as accurate as legacy 60 Hz\n");
+
+        for (uint32_t integrator = 0; integrator < ParticleSystem::kNumIntegrators; integrator++) {
+            params.integrator = integrator;
+            printf("    %-8s", ParticleSystem::integratorName(integrator));
+            float bounded = 0.0f, accurate = 0.0f;
+            for (int k = 0; k < numSteps; k++) {
+                float h = steps[k];
+                // 按帧步进不能改变步长
+                if (integrator == ParticleSystem::kIntegratorLegacy && h != 1.0f) {
+                    printf(" %8s", "-");
+                    continue;
+                }
+                double error = simulate(params, h, &exact, result);
+                if (std::isinf(error)) {
+                    printf(" %8s", "diverged");
+                    continue;
+                }
+                printf(" %8.1e", error);
+                bounded = std::max(bounded, h);
+                if (error <= legacyError * 1.01) {
+                    accurate = std::max(accurate, h);
+                }
+            }
+            int evals = ParticleSystem::integratorEvaluations(integrator);
+            printf("  | %4.1f (%3.0f evals/s)", bounded, bounded > 0.0f ? evals * 60.0f / bounded : 0.0f);
+            if (accurate > 0.0f) {
+                printf(" | %4.1f (%3.0f evals/s)\n", accurate, evals * 60.0f / accurate);
+            } else {
+                printf(" | none\n");
+            }
+        }
+    }
+    CHECK_GL_ERROR();
+}
+
+// PBD壳体: 细分5~7次(6万~98万个约束)时每次约束投影的耗时、颜色数与每个约束的平均耗时，
+// 以及在噪声场扰动下不同迭代次数时约束的残余误差
+void benchmarkShell()
+{
+    const size_t count = 1u << 20;
+    const int runs = 5;
+
+    printf("== PBD shell constraints (graph-colored, one dispatch per color)\n");
+
+    srand(1234);
+    ParticleSystem particles(count, kShaderPrefix);
+    BenchScene scene(count);
+
+    printf("  %-6s %9s %12s %7s %12s %12s %12s\n",
+           "level", "vertices", "constraints", "colors", "ms/iter", "ns/constr", "finalize ms");
+    for (int level = 5; level <= 7; level++) {
+        ShellConstraints shell(level, 0.6f, kShaderPrefix);
+        shell.deploy(&particles);
+        shell.storePositions(&particles);
+
+        FinishTimer iterateTimer, finalizeTimer;
+        shell.iterate(&particles);
+        for (int run = 0; run < runs; run++) {
+            iterateTimer.begin();
+            shell.iterate(&particles);
+            iterateTimer.end();
+
+            finalizeTimer.begin();
+            shell.finalize(&particles, scene.params);
+            finalizeTimer.end();
+        }
+        float ms = iterateTimer.getAverageMs();
+        printf("  %-6d %9zu %12zu %7zu %12.3f %12.2f %12.3f\n", level, shell.getVertexCount(),
+               shell.getConstraintCount(), shell.getColorCount(), ms, ms * 1.0e6f / shell.getConstraintCount(),
+               finalizeTimer.getAverageMs());
+    }
+
+    // 应用中的噪声场扰动下运行60步，统计拉伸约束的相对误差 |len - rest| / rest
+    const int level = 6;
+    const int steps = 60;
+    ShellConstraints shell(level, 0.6f, kShaderPrefix);
+    scene.setCamera(0.0f);
+
+    printf("  level %d shell in the default noise field, %d steps: stretch error |len - rest| / rest\n", level, steps);
+    const int iterationCounts[] = { 1, 2, 4, 8, 16 };
+    for (int iterations : iterationCounts) {
+        shell.iterations = iterations;
+        shell.deploy(&particles);
+        FinishTimer stepTimer;
+        for (int step = 0; step < steps; step++) {
+            stepTimer.begin();
+            shell.storePositions(&particles);
+            particles.update(scene.params);
+            shell.solve(&particles, scene.params);
+            stepTimer.end();
+        }
+
+        std::vector<glm::vec4> pos(shell.getVertexCount());
+        particles.getPosBuffer()->bind();
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, pos.size() * sizeof(glm::vec4), pos.data());
+        particles.getPosBuffer()->unbind();
+
+        double sumError = 0.0, maxError = 0.0;
+        size_t numEdges = 0;
+        for (const ShellConstraints::Constraint& c : shell.getConstraints()) {
+            if (c.kind != ShellConstraints::kStretch) continue;
+            double len = glm::length(glm::vec3(pos[c.a]) - glm::vec3(pos[c.b]));
+            double error = fabs(len - c.restLength) / c.restLength;
+            sumError += error;
+            maxError = std::max(maxError, error);
+            numEdges++;
+        }
+        printf("    %2d iterations: mean %.2e  max %.2e  (%.3f ms/step incl. prediction)\n",
+               iterations, sumError / std::max<size_t>(numEdges, 1), maxError, stepTimer.getAverageMs());
+    }
+    CHECK_GL_ERROR();
+}
+
+// 片元着色器链与计算着色器Bloom: 1080p/1440p/4K下的整帧耗时(少量粒子，两者之差即Bloom之差)，
+// 以及计算路径在合成HDR场景上两个阶段各自的耗时
+void benchmarkBloom(GLFWwindow* window)
+{
+    struct Resolution { const char* name; int width; int height; };
+    const Resolution resolutions[] = { { "1080p", 1920, 1080 }, { "1440p", 2560, 1440 }, { "4K", 3840, 2160 } };
+    const int numResolutions = 3;
+    const int frames = 4;
+
+    printf("== Bloom: fragment chain vs compute mip chain\n");
+
+    // 先全部测量再输出，初始化与编译的日志不会夹在表格中
+    float frameMs[numResolutions][2] = {};
+    {
+        srand(1234);
+        ComputeParticles app;
+        app.setParticleCount(1 << 16);
+        if (!app.init(window)) {
+            std::cerr << "  could not initialise renderer" << std::endl;
+            return;
+        }
+        for (int r = 0; r < numResolutions; r++) {
+            app.reshape(resolutions[r].width, resolutions[r].height);
+            const BloomPath paths[] = { FragmentChainBloom, ComputeMipBloom };
+            for (int p = 0; p < 2; p++) {
+                app.setBloomPath(paths[p]);
+                app.draw(1.0f / 60.0f);
+                FinishTimer timer;
+                for (int f = 0; f < frames; f++) {
+                    timer.begin();
+                    app.draw(1.0f / 60.0f);
+                    timer.end();
+                }
+                frameMs[r][p] = timer.getAverageMs();
+            }
+        }
+    }
+
+    // 合成场景: 暗背景上随机分布的高亮光斑，约一成像素超过阈值
+    float stageMs[numResolutions][2] = {};
+    ComputeBloom bloom(kShaderPrefix);
+    // bloomPass.cs从绑定点27读取曝光，单独运行时固定为1.0
+    AutoExposure exposure(kShaderPrefix);
+    exposure.bind();
+    for (int r = 0; r < numResolutions; r++) {
+        const int width = resolutions[r].width;
+        const int height = resolutions[r].height;
+        std::vector<glm::vec4> pixels((size_t)width * height, glm::vec4(0.25f, 0.25f, 0.25f, 1.0f));
+        std::mt19937 rng(1234);
+        std::uniform_int_distribution<int> px(0, width - 1), py(0, height - 1);
+        const int radius = height / 40;
+        for (int spot = 0; spot < 64; spot++) {
+            int cx = px(rng), cy = py(rng);
+            for (int y = std::max(cy - radius, 0); y < std::min(cy + radius, height); y++) {
+                for (int x = std::max(cx - radius, 0); x < std::min(cx + radius, width); x++) {
+                    float d2 = float((x - cx) * (x - cx) + (y - cy) * (y - cy)) / float(radius * radius);
+                    pixels[(size_t)y * width + x] += glm::vec4(glm::vec3(4.0f * expf(-3.0f * d2)), 0.0f);
+                }
+            }
+        }
+
+        GLuint scene;
+        glGenTextures(1, &scene);
+        glBindTexture(GL_TEXTURE_2D, scene);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, pixels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        bloom.resize(width, height);
+        bloom.render(scene);
+        FinishTimer downsampleTimer, upsampleTimer;
+        for (int f = 0; f < frames; f++) {
+            downsampleTimer.begin();
+            bloom.downsample(scene);
+            downsampleTimer.end();
+
+            upsampleTimer.begin();
+            bloom.upsample();
+            upsampleTimer.end();
+        }
+        stageMs[r][0] = downsampleTimer.getAverageMs();
+        stageMs[r][1] = upsampleTimer.getAverageMs();
+        glDeleteTextures(1, &scene);
+    }
+    CHECK_GL_ERROR();
+
+    printf("  frame with 64K particles (ms):\n");
+    printf("  %-7s %14s %14s %10s\n", "res", "fragment", "compute", "saved");
+    for (int r = 0; r < numResolutions; r++) {
+        printf("  %-7s %14.2f %14.2f %10.2f\n", resolutions[r].name, frameMs[r][0], frameMs[r][1],
+               frameMs[r][0] - frameMs[r][1]);
+    }
+    printf("  compute bloom stages on a synthetic HDR scene (ms, %d levels):\n", ComputeBloom::kNumLevels);
+    printf("  %-7s %14s %14s %10s\n", "res", "downsample", "upsample", "total");
+    for (int r = 0; r < numResolutions; r++) {
+        printf("  %-7s %14.2f %14.2f %10.2f\n", resolutions[r].name, stageMs[r][0], stageMs[r][1],
+               stageMs[r][0] + stageMs[r][1]);
+    }
+}
+
+// 模拟拖动缩放窗口: 从1280x720逐步拉到1920x1080共60个缩放事件，每个事件后绘制一帧。
+// 对比每次按实际尺寸重新分配(reshape非交互)与缩放期间按分桶尺寸复用、停止后再分配(交互)的
+// 每个事件耗时与创建的渲染目标数
+void benchmarkResize(GLFWwindow* window)
+{
+    const int events = 60;
+
+    printf("== Window drag-resize: %d events 1280x720 -> 1920x1080, one frame per event\n", events);
+
+    float reshapeMs[2] = {}, frameMs[2] = {};
+    int dragAllocations[2] = {}, settleAllocations[2] = {};
+    for (int mode = 0; mode < 2; mode++) {
+        bool interactive = mode == 1;
+        srand(1234);
+        ComputeParticles app;
+        app.setParticleCount(1 << 16);
+        if (!app.init(window)) {
+            std::cerr << "  could not initialise renderer" << std::endl;
+            return;
+        }
+        app.reshape(1280, 720);
+        app.draw(1.0f / 60.0f);
+
+        int before = app.getRenderTargetAllocations();
+        FinishTimer reshapeTimer, frameTimer;
+        for (int e = 1; e <= events; e++) {
+            int width = 1280 + (1920 - 1280) * e / events;
+            int height = 720 + (1080 - 720) * e / events;
+            reshapeTimer.begin();
+            app.reshape(width, height, interactive);
+            reshapeTimer.end();
+
+            frameTimer.begin();
+            app.draw(1.0f / 60.0f);
+            frameTimer.end();
+        }
+        dragAllocations[mode] = app.getRenderTargetAllocations() - before;
+
+        // 停止拖动后的几帧内按最终尺寸分配
+        for (int f = 0; f < 30; f++) {
+            app.draw(1.0f / 60.0f);
+        }
+        settleAllocations[mode] = app.getRenderTargetAllocations() - before - dragAllocations[mode];
+        reshapeMs[mode] = reshapeTimer.getAverageMs();
+        frameMs[mode] = frameTimer.getAverageMs();
+    }
+    CHECK_GL_ERROR();
+
+    printf("  %-22s %12s %12s %14s %14s\n", "", "reshape ms", "frame ms", "allocs (drag)", "allocs (settle)");
+    const char* names[] = { "reallocate per event", "pooled + deferred" };
+    for (int mode = 0; mode < 2; mode++) {
+        printf("  %-22s %12.3f %12.2f %14d %14d\n", names[mode], reshapeMs[mode], frameMs[mode],
+               dragAllocations[mode], settleAllocations[mode]);
+    }
+}
+
+
+// 稀疏Bloom: 拉近相机使粒子云覆盖更多的屏幕块，另以阈值0(背景亦超过阈值)与无穷大给出全部/零覆盖，
+// 比较逐像素的片元链与只绘制活动块的稀疏链的整帧耗时。两者的粒子pass相同，耗时之差即Bloom链节省的部分；
+// 分类本身的开销计入稀疏链
+void benchmarkSparseBloom(GLFWwindow* window)
+{
+    struct Resolution { const char* name; int width; int height; };
+    const Resolution resolutions[] = { { "1080p", 1920, 1080 }, { "4K", 3840, 2160 } };
+    const int numResolutions = 2;
+    struct Scene { const char* name; float cameraDistance; float threshold; };
+    const Scene scenes[] = {
+        { "threshold inf", 3.0f, 1e9f },
+        { "distance 6.0", 6.0f, 1.2f },
+        { "distance 3.0", 3.0f, 1.2f },
+        { "distance 1.5", 1.5f, 1.2f },
+        { "distance 1.0", 1.0f, 1.2f },
+        { "distance 0.6", 0.6f, 1.2f },
+        { "threshold 0", 3.0f, 0.0f },
+    };
+    const int numScenes = sizeof(scenes) / sizeof(scenes[0]);
+    const int frames = 4;
+
+    printf("== Sparse bloom: fragment chain over every pixel vs active %dx%d tiles only\n",
+           BloomTiles::kTileSize, BloomTiles::kTileSize);
+
+    srand(1234);
+    ComputeParticles app;
+    app.setParticleCount(1 << 16);
+    if (!app.init(window)) {
+        std::cerr << "  could not initialise renderer" << std::endl;
+        return;
+    }
+
+    float frameMs[numResolutions][numScenes][2] = {};
+    float coverage[numResolutions][numScenes] = {};
+    float cameraDistance = 3.0f;
+    for (int r = 0; r < numResolutions; r++) {
+        app.reshape(resolutions[r].width, resolutions[r].height);
+        for (int c = 0; c < numScenes; c++) {
+            // 滚轮每格0.1
+            app.handleScroll(0.0, (cameraDistance - scenes[c].cameraDistance) / 0.1);
+            cameraDistance = scenes[c].cameraDistance;
+            app.setBloomThreshold(scenes[c].threshold);
+
+            const BloomPath paths[] = { FragmentChainBloom, SparseTileBloom };
+            for (int p = 0; p < 2; p++) {
+                app.setBloomPath(paths[p]);
+                app.draw(1.0f / 60.0f);
+                FinishTimer timer;
+                for (int f = 0; f < frames; f++) {
+                    timer.begin();
+                    app.draw(1.0f / 60.0f);
+                    timer.end();
+                }
+                frameMs[r][c][p] = timer.getAverageMs();
+            }
+            int active = 0, total = 0;
+            app.getBloomTileCoverage(active, total);
+            coverage[r][c] = total > 0 ? 100.0f * active / total : 0.0f;
+        }
+    }
+    CHECK_GL_ERROR();
+
+    printf("  frame with 64K particles (ms), coverage = active tiles incl. dilation:\n");
+    printf("  %-7s %-14s %10s %12s %12s %10s\n", "res", "scene", "coverage", "fragment", "sparse", "saved");
+    for (int r = 0; r < numResolutions; r++) {
+        for (int c = 0; c < numScenes; c++) {
+            printf("  %-7s %-14s %9.1f%% %12.2f %12.2f %10.2f\n", resolutions[r].name, scenes[c].name, coverage[r][c],
+                   frameMs[r][c][0], frameMs[r][c][1], frameMs[r][c][0] - frameMs[r][c][1]);
+        }
+    }
+}
+
+// 融合Bloom链: 提取并入第一次降采样、合成并入最后一次上采样，对比普通片元链的未裁剪pass数、
+// 帧图估算的每帧显存流量(每个pass完整读取输入、写入输出一次)与整帧耗时
+void benchmarkFusedBloom(GLFWwindow* window)
+{
+    struct Resolution { const char* name; int width; int height; };
+    const Resolution resolutions[] = { { "1080p", 1920, 1080 }, { "1440p", 2560, 1440 }, { "4K", 3840, 2160 } };
+    const int numResolutions = 3;
+    const int frames = 4;
+
+    printf("== Fused bloom: extract folded into the first downsample, combine into the last upsample\n");
+
+    srand(1234);
+    ComputeParticles app;
+    app.setParticleCount(1 << 16);
+    if (!app.init(window)) {
+        std::cerr << "  could not initialise renderer" << std::endl;
+        return;
+    }
+
+    float frameMs[numResolutions][2] = {};
+    size_t traffic[numResolutions][2] = {};
+    int passes[numResolutions][2] = {};
+    for (int r = 0; r < numResolutions; r++) {
+        app.reshape(resolutions[r].width, resolutions[r].height);
+        const BloomPath paths[] = { FragmentChainBloom, FusedChainBloom };
+        for (int p = 0; p < 2; p++) {
+            app.setBloomPath(paths[p]);
+            app.draw(1.0f / 60.0f);
+            FinishTimer timer;
+            for (int f = 0; f < frames; f++) {
+                timer.begin();
+                app.draw(1.0f / 60.0f);
+                timer.end();
+            }
+            frameMs[r][p] = timer.getAverageMs();
+
+            const FrameGraph* graph = app.getFrameGraph();
+            traffic[r][p] = graph->getTrafficBytes();
+            passes[r][p] = graph->getPassCount() - graph->getCulledPassCount();
+        }
+    }
+    CHECK_GL_ERROR();
+
+    const double mb = 1.0 / (1024.0 * 1024.0);
+    printf("  %-7s %16s %16s %12s %14s %10s %10s\n", "res", "passes", "traffic MB", "saved MB",
+           "saved GB/s@60", "frame ms", "fused ms");
+    for (int r = 0; r < numResolutions; r++) {
+        double saved = (double)traffic[r][0] - (double)traffic[r][1];
+        char passCounts[32], trafficMb[32];
+        snprintf(passCounts, sizeof(passCounts), "%d -> %d", passes[r][0], passes[r][1]);
+        snprintf(trafficMb, sizeof(trafficMb), "%.1f -> %.1f", traffic[r][0] * mb, traffic[r][1] * mb);
+        printf("  %-7s %16s %16s %12.1f %14.2f %10.2f %10.2f\n", resolutions[r].name, passCounts, trafficMb,
+               saved * mb, saved * 60.0 / 1e9, frameMs[r][0], frameMs[r][1]);
+    }
+}
+
+// 自动曝光: 直方图 + 归约在合成HDR场景上的耗时；以及爱心 -> 散开 -> 五角星的状态序列中，
+// 场景平均亮度(曝光前)、平滑后的曝光与曝光后的平均亮度随时间的变化(每0.5秒回读一次，仅统计用)
+void benchmarkExposure(GLFWwindow* window)
+{
+    struct Resolution { const char* name; int width; int height; };
+    const Resolution resolutions[] = { { "1080p", 1920, 1080 }, { "4K", 3840, 2160 } };
+    const int numResolutions = 2;
+    const int frames = 8;
+
+    printf("== Auto exposure: log-luminance histogram with shared-memory atomics, GPU-side smoothing\n");
+
+    float updateMs[numResolutions] = {};
+    {
+        AutoExposure exposure(kShaderPrefix);
+        for (int r = 0; r < numResolutions; r++) {
+            const int width = resolutions[r].width;
+            const int height = resolutions[r].height;
+            std::vector<glm::vec4> pixels((size_t)width * height);
+            std::mt19937 rng(1234);
+            std::uniform_real_distribution<float> logLuminance(-6.0f, 3.0f);
+            for (glm::vec4& pixel : pixels) {
+                pixel = glm::vec4(glm::vec3(exp2f(logLuminance(rng))), 1.0f);
+            }
+
+            GLuint scene;
+            glGenTextures(1, &scene);
+            glBindTexture(GL_TEXTURE_2D, scene);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, pixels.data());
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            exposure.update(scene, width, height, 1.0f / 60.0f);
+            FinishTimer timer;
+            for (int f = 0; f < frames; f++) {
+                timer.begin();
+                exposure.update(scene, width, height, 1.0f / 60.0f);
+                timer.end();
+            }
+            updateMs[r] = timer.getAverageMs();
+            glDeleteTextures(1, &scene);
+        }
+    }
+
+    // 状态序列: 初始爱心5秒后散开，9秒时切换到下一个形状(五角星)
+    struct Sample { float time; float averageLuminance; float exposure; };
+    std::vector<Sample> samples;
+    {
+        srand(1234);
+        ComputeParticles app;
+        app.setParticleCount(1 << 17);
+        if (!app.init(window)) {
+            std::cerr << "  could not initialise renderer" << std::endl;
+            return;
+        }
+        app.reshape(384, 384);
+        app.setAutoExposure(true);
+
+        const float dt = 1.0f / 30.0f;
+        const int steps = 14 * 30;
+        for (int step = 1; step <= steps; step++) {
+            if (step == 9 * 30) {
+                app.handleKey(GLFW_KEY_P, GLFW_PRESS);
+            }
+            app.draw(dt);
+            if (step % 15 == 0) {
+                Sample sample;
+                sample.time = step * dt;
+                sample.exposure = app.readExposure(&sample.averageLuminance);
+                samples.push_back(sample);
+            }
+        }
+    }
+    CHECK_GL_ERROR();
+
+    printf("  histogram + reduction on a synthetic HDR scene (ms):\n");
+    for (int r = 0; r < numResolutions; r++) {
+        printf("  %-7s %10.2f\n", resolutions[r].name, updateMs[r]);
+    }
+    printf("  heart (0-5 s) -> scattered -> morph to star (9 s), 128K particles at 384x384:\n");
+    printf("  %8s %-10s %14s %10s %16s\n", "time s", "state", "avg luminance", "exposure", "exposed average");
+    for (const Sample& sample : samples) {
+        const char* state = sample.time < 5.0f ? "heart" : sample.time < 9.0f ? "scattered" : "star";
+        printf("  %8.1f %-10s %14.3f %10.3f %16.3f\n", sample.time, state, sample.averageLuminance, sample.exposure,
+               sample.averageLuminance * sample.exposure);
+    }
+}
+
+// 4K下场景与后处理帧图的显存: 帧图之前常驻的全部RGBA16F目标(场景、4级Bloom、3级上采样、
+// 1/2与1/4分辨率粒子目标) 对比帧图别名与格式选择之后实际分配的字节数，以及各配置下裁剪的pass。
+// 计算着色器Bloom的mip链由ComputeBloom自行管理，两边都不计入
+void benchmarkFrameGraph(GLFWwindow* window)
+{
+    const int width = 3840, height = 2160;
+
+    printf("== Frame graph transient targets at %dx%d\n", width, height);
+
+    size_t legacyBytes = (size_t)width * height;
+    for (int i = 1; i < 4; i++) {
+        legacyBytes += (size_t)(width >> i) * (height >> i);
+    }
+    legacyBytes += (size_t)(width >> 3) * (height >> 3) + (size_t)(width >> 2) * (height >> 2) + (size_t)width * height;
+    legacyBytes += (size_t)(width / 2) * (height / 2) + (size_t)(width / 4) * (height / 4);
+    legacyBytes *= RenderTargetPool::bytesPerPixel(GL_RGBA16F);
+
+    struct Config {
+        const char* name;
+        ParticleResolution resolution;
+        BloomPath bloom;
+    };
+    const Config configs[] = {
+        { "full res, fragment bloom", FullResolution, FragmentChainBloom },
+        { "1/2 res, fragment bloom", HalfResolution, FragmentChainBloom },
+        { "full res, compute bloom", FullResolution, ComputeMipBloom },
+        { "1/2 res, compute bloom", HalfResolution, ComputeMipBloom },
+    };
+    const int numConfigs = sizeof(configs) / sizeof(configs[0]);
+
+    srand(1234);
+    ComputeParticles app;
+    app.setParticleCount(1 << 16);
+    if (!app.init(window)) {
+        std::cerr << "  could not initialise renderer" << std::endl;
+        return;
+    }
+    app.reshape(width, height);
+
+    size_t allocated[numConfigs], unaliased[numConfigs];
+    int passes[numConfigs], culled[numConfigs], targets[numConfigs];
+    float frameMs[numConfigs];
+    for (int c = 0; c < numConfigs; c++) {
+        app.setParticleResolution(configs[c].resolution);
+        app.setBloomPath(configs[c].bloom);
+        app.draw(1.0f / 60.0f);
+
+        FinishTimer timer;
+        for (int f = 0; f < 4; f++) {
+            timer.begin();
+            app.draw(1.0f / 60.0f);
+            timer.end();
+        }
+        frameMs[c] = timer.getAverageMs();
+
+        const FrameGraph* graph = app.getFrameGraph();
+        allocated[c] = graph->getAllocatedBytes();
+        unaliased[c] = graph->getUnaliasedBytes();
+        passes[c] = graph->getPassCount();
+        culled[c] = graph->getCulledPassCount();
+        targets[c] = graph->getPhysicalTargetCount();
+        if (c == 1) {
+            printf("  graph for \"%s\":\n", configs[c].name);
+            graph->dump();
+        }
+    }
+    CHECK_GL_ERROR();
+
+    const double mb = 1.0 / (1024.0 * 1024.0);
+    printf("  fixed RGBA16F targets before the frame graph: %.1f MB\n", legacyBytes * mb);
+    printf("  %-26s %8s %8s %10s %12s %10s %10s\n", "", "passes", "culled", "targets",
+           "unaliased MB", "graph MB", "saved MB");
+    for (int c = 0; c < numConfigs; c++) {
+        printf("  %-26s %8d %8d %10d %12.1f %10.1f %10.1f\n", configs[c].name, passes[c], culled[c], targets[c],
+               unaliased[c] * mb, allocated[c] * mb, (legacyBytes - allocated[c]) * mb);
+    }
+    printf("  %-26s %10s\n", "", "frame ms");
+    for (int c = 0; c < numConfigs; c++) {
+        printf("  %-26s %10.2f\n", configs[c].name, frameMs[c]);
+    }
+}
+
+// 降分辨率粒子的空间上采样与时间重建对比全分辨率，三种场景: 粒子暂停(仍有呼吸缩放)且相机静止、
+// 粒子暂停而相机匀速环绕、爱心成形途中切换到五角星。报告整帧耗时，
+// 以及每8帧以全分辨率重新绘制同一帧粒子作参考的PSNR(平均与最差)
+void benchmarkTemporal(GLFWwindow* window)
+{
+    const int width = 1280, height = 720;
+    const int warmupFrames = 16;
+    const int measuredFrames = 48;
+    const int morphFrame = 40;
+
+    struct Config {
+        const char* name;
+        ParticleResolution resolution;
+        bool temporal;
+    };
+    const Config configs[] = {
+        { "native", FullResolution, false },
+        { "1/2 spatial upsample", HalfResolution, false },
+        { "1/2 temporal", HalfResolution, true },
+        { "1/4 spatial upsample", QuarterResolution, false },
+        { "1/4 temporal", QuarterResolution, true },
+    };
+    const int numConfigs = sizeof(configs) / sizeof(configs[0]);
+
+    // dragPerFrame: 按住左键每帧水平拖动的像素数，每像素相机绕目标转0.005弧度
+    struct Scenario {
+        const char* name;
+        bool animate;
+        double dragPerFrame;
+    };
+    const Scenario scenarios[] = {
+        { "particles paused, static camera", false, 0.0 },
+        { "particles paused, camera orbiting at 0.6 rad/s", false, 4.0 },
+        { "heart forming, morph to star at frame 40, static camera", true, 0.0 },
+    };
+
+    printf("== Temporal reconstruction of the particle pass, %dx%d, 256K particles\n", width, height);
+
+    for (const Scenario& scenario : scenarios) {
+        float frameMs[numConfigs];
+        float meanPSNR[numConfigs], worstPSNR[numConfigs];
+        for (int c = 0; c < numConfigs; c++) {
+            srand(1234);
+            ComputeParticles app;
+            app.setParticleCount(1 << 18);
+            if (!app.init(window)) {
+                std::cerr << "  could not initialise renderer" << std::endl;
+                return;
+            }
+            app.reshape(width, height);
+            app.setParticleResolution(configs[c].resolution);
+            app.setTemporalUpsample(configs[c].temporal);
+
+            if (!scenario.animate) {
+                app.handleKey(GLFW_KEY_SPACE, GLFW_PRESS);
+            }
+            double mouseX = 0.0;
+            app.handleMouseMove(mouseX, 0.0);
+            app.handleMouseButton(GLFW_MOUSE_BUTTON_LEFT, GLFW_PRESS, 0);
+
+            FinishTimer timer;
+            double sumPSNR = 0.0;
+            int samples = 0;
+            worstPSNR[c] = 99.0f;
+            for (int f = 0; f < warmupFrames + measuredFrames; f++) {
+                if (scenario.animate && f == morphFrame) {
+                    app.handleKey(GLFW_KEY_P, GLFW_PRESS);
+                }
+                mouseX += scenario.dragPerFrame;
+                app.handleMouseMove(mouseX, 0.0);
+
+                bool measured = f >= warmupFrames;
+                if (measured) timer.begin();
+                app.draw(1.0f / 30.0f);
+                if (measured) timer.end();
+
+                if (measured && (f - warmupFrames) % 8 == 7) {
+                    float psnr = app.measureParticlePSNR();
+                    sumPSNR += psnr;
+                    samples++;
+                    worstPSNR[c] = std::min(worstPSNR[c], psnr);
+                }
+            }
+            frameMs[c] = timer.getAverageMs();
+            meanPSNR[c] = samples > 0 ? (float)(sumPSNR / samples) : 0.0f;
+        }
+        CHECK_GL_ERROR();
+
+        printf("  %s:\n", scenario.name);
+        printf("  %-22s %10s %8s %12s %12s\n", "", "frame ms", "speedup", "mean PSNR", "worst PSNR");
+        for (int c = 0; c < numConfigs; c++) {
+            if (c == 0) {
+                printf("  %-22s %10.2f %8s %12s %12s\n", configs[c].name, frameMs[c], "1.00x", "-", "-");
+            } else {
+                printf("  %-22s %10.2f %7.2fx %9.2f dB %9.2f dB\n", configs[c].name, frameMs[c],
+                       frameMs[c] > 0.0f ? frameMs[0] / frameMs[c] : 0.0f, meanPSNR[c], worstPSNR[c]);
+            }
+        }
+    }
+}
+
+// 八边形精灵(衰减查表、无discard)对比四边形(exp + discard): 爱心成形后冻结，分别在默认距离与拉近的相机下，
+// 剔除与未剔除路径各绘制8帧，报告整帧耗时、管线统计查询得到的顶点/片段着色器调用数，以及相对四边形的PSNR
+void benchmarkSprites(GLFWwindow* window)
+{
+    const int width = 1280, height = 720;
+    const int warmupFrames = 30;
+    const int measuredFrames = 8;
+
+    struct Config {
+        const char* name;
+        bool culling;
+        bool octagons;
+    };
+    const Config configs[] = {
+        { "culled, quad", true, false },
+        { "culled, octagon", true, true },
+        { "unculled, quad", false, false },
+        { "unculled, octagon", false, true },
+    };
+    const int numConfigs = sizeof(configs) / sizeof(configs[0]);
+
+    // 每次滚轮使相机拉近0.1，默认距离3
+    struct Camera {
+        const char* name;
+        double scroll;
+    };
+    const Camera cameras[] = {
+        { "camera at distance 3", 0.0 },
+        { "camera at distance 1.5", 15.0 },
+    };
+
+    printf("== Sprite geometry, %dx%d, 256K particles in the heart shape\n", width, height);
+
+    for (const Camera& camera : cameras) {
+        srand(1234);
+        ComputeParticles app;
+        app.setParticleCount(1 << 18);
+        if (!app.init(window)) {
+            std::cerr << "  could not initialise renderer" << std::endl;
+            return;
+        }
+        app.reshape(width, height);
+        app.handleScroll(0.0, camera.scroll);
+        app.setPipelineStatistics(true);
+        for (int f = 0; f < warmupFrames; f++) {
+            app.draw(1.0f / 30.0f);
+        }
+        // 暂停粒子，之后以零时间步绘制，呼吸缩放也不再变化，各配置绘制完全相同的一帧
+        app.handleKey(GLFW_KEY_SPACE, GLFW_PRESS);
+
+        float frameMs[numConfigs];
+        GLuint64 vertices[numConfigs] = {}, fragments[numConfigs] = {};
+        float psnr[numConfigs];
+        bool hasStats = true;
+        for (int c = 0; c < numConfigs; c++) {
+            app.setCulling(configs[c].culling);
+            app.setOctagonSprites(configs[c].octagons);
+            app.draw(0.0f);
+
+            FinishTimer timer;
+            for (int f = 0; f < measuredFrames; f++) {
+                timer.begin();
+                app.draw(0.0f);
+                timer.end();
+            }
+            frameMs[c] = timer.getAverageMs();
+
+            GLuint64 primitives = 0;
+            hasStats = app.readParticleStatistics(vertices[c], primitives, fragments[c]) && hasStats;
+            psnr[c] = app.measureParticlePSNR(true);
+        }
+        CHECK_GL_ERROR();
+
+        printf("  %s:\n", camera.name);
+        printf("  %-20s %10s %14s %16s %10s %12s\n", "", "frame ms", "VS invocations", "FS invocations",
+               "FS saved", "PSNR vs quad");
+        for (int c = 0; c < numConfigs; c++) {
+            const GLuint64 quadFragments = fragments[configs[c].octagons ? c - 1 : c];
+            char saved[16] = "-";
+            char quality[16] = "-";
+            if (configs[c].octagons) {
+                snprintf(saved, sizeof(saved), "%.1f%%",
+                         quadFragments > 0 ? 100.0 * (1.0 - (double)fragments[c] / quadFragments) : 0.0);
+                snprintf(quality, sizeof(quality), "%.2f dB", psnr[c]);
+            }
+            if (hasStats) {
+                printf("  %-20s %10.2f %14llu %16llu %10s %12s\n", configs[c].name, frameMs[c],
+                       (unsigned long long)vertices[c], (unsigned long long)fragments[c], saved, quality);
+            } else {
+                printf("  %-20s %10.2f %14s %16s %10s %12s\n", configs[c].name, frameMs[c], "n/a", "n/a", "-", quality);
+            }
+        }
+        if (!hasStats) {
+            printf("  (GL_ARB_pipeline_statistics_query not supported)\n");
+        }
+    }
+}
+
+} // namespace
+
+// 随机LOD: 1M粒子的爱心冻结后，相机分别在距离3、6、10处，剔除路径下关闭与开启随机LOD各绘制4帧，
+// 报告整帧耗时、保留的精灵/单像素点数、粒子pass的片段着色器调用数，以及相对绘制全部粒子的PSNR
+void benchmarkStochasticLod(GLFWwindow* window)
+{
+    const int width = 1280, height = 720;
+    const int warmupFrames = 20;
+    const int measuredFrames = 4;
+
+    // 每次滚轮使相机拉近0.1，默认距离3
+    struct Camera {
+        const char* name;
+        double scroll;
+    };
+    const Camera cameras[] = {
+        { "camera at distance 3", 0.0 },
+        { "camera at distance 6", -30.0 },
+        { "camera at distance 10", -70.0 },
+    };
+
+    printf("== Stochastic LOD, %dx%d, 1M particles in the heart shape, culling on\n", width, height);
+
+    for (const Camera& camera : cameras) {
+        srand(1234);
+        ComputeParticles app;
+        app.setParticleCount(1 << 20);
+        if (!app.init(window)) {
+            std::cerr << "  could not initialise renderer" << std::endl;
+            return;
+        }
+        app.reshape(width, height);
+        app.handleScroll(0.0, camera.scroll);
+        app.setPipelineStatistics(true);
+        for (int f = 0; f < warmupFrames; f++) {
+            app.draw(1.0f / 30.0f);
+        }
+        // 暂停粒子，之后以零时间步绘制，两种配置绘制完全相同的一帧
+        app.handleKey(GLFW_KEY_SPACE, GLFW_PRESS);
+
+        printf("  %s:\n", camera.name);
+        printf("  %-16s %10s %10s %10s %16s %10s %10s\n", "", "frame ms", "sprites", "points", "FS invocations",
+               "FS saved", "PSNR");
+        GLuint64 fullFragments = 0;
+        for (int c = 0; c < 2; c++) {
+            bool stochastic = c == 1;
+            app.setStochasticLod(stochastic);
+            // 第一帧只累加每块的估计
+            app.draw(0.0f);
+
+            FinishTimer timer;
+            for (int f = 0; f < measuredFrames; f++) {
+                timer.begin();
+                app.draw(0.0f);
+                timer.end();
+            }
+
+            unsigned int sprites = 0, points = 0;
+            app.readCullCounts(sprites, points);
+            GLuint64 vertices = 0, primitives = 0, fragments = 0;
+            bool hasStats = app.readParticleStatistics(vertices, primitives, fragments);
+            if (!stochastic) {
+                fullFragments = fragments;
+            }
+
+            char invocations[24] = "n/a";
+            char saved[16] = "-";
+            char quality[16] = "-";
+            if (hasStats) {
+                snprintf(invocations, sizeof(invocations), "%llu", (unsigned long long)fragments);
+            }
+            if (stochastic) {
+                if (hasStats && fullFragments > 0) {
+                    snprintf(saved, sizeof(saved), "%.1f%%", 100.0 * (1.0 - (double)fragments / fullFragments));
+                }
+                snprintf(quality, sizeof(quality), "%.2f dB", app.measureParticlePSNR());
+            }
+            printf("  %-16s %10.2f %10u %10u %16s %10s %10s\n", stochastic ? "stochastic LOD" : "all particles",
+                   timer.getAverageMs(), sprites, points, invocations, saved, quality);
+        }
+        CHECK_GL_ERROR();
+    }
+}
+
+int runBenchmark(GLFWwindow* window, const char* name)
+{
+    if (strcmp(name, "sort") == 0) {
+        benchmarkSort();
+        return 0;
+    }
+    if (strcmp(name, "reorder") == 0) {
+        benchmarkReorder();
+        return 0;
+    }
+    if (strcmp(name, "attractors") == 0) {
+        benchmarkAttractors();
+        return 0;
+    }
+
+    if (strcmp(name, "barnes-hut") == 0) {
+        benchmarkBarnesHut();
+        return 0;
+    }
+
+    if (strcmp(name, "grid") == 0) {
+        benchmarkNeighborGrid();
+        return 0;
+    }
+
+    if (strcmp(name, "fluid") == 0) {
+        benchmarkFluid();
+        return 0;
+    }
+
+    if (strcmp(name, "shapes") == 0) {
+        benchmarkShapes();
+        return 0;
+    }
+
+    if (strcmp(name, "variants") == 0) {
+        benchmarkVariants();
+        return 0;
+    }
+
+    if (strcmp(name, "orbits") == 0) {
+        benchmarkOrbits();
+        return 0;
+    }
+
+    if (strcmp(name, "integrators") == 0) {
+        benchmarkIntegrators();
+        return 0;
+    }
+
+    if (strcmp(name, "shell") == 0) {
+        benchmarkShell();
+        return 0;
+    }
+
+    if (strcmp(name, "bloom") == 0) {
+        benchmarkBloom(window);
+        return 0;
+    }
+
+    if (strcmp(name, "resize") == 0) {
+        benchmarkResize(window);
+        return 0;
+    }
+
+    if (strcmp(name, "framegraph") == 0) {
+        benchmarkFrameGraph(window);
+        return 0;
+    }
+
+    if (strcmp(name, "sparsebloom") == 0) {
+        benchmarkSparseBloom(window);
+        return 0;
+    }
+
+    if (strcmp(name, "fusedbloom") == 0) {
+        benchmarkFusedBloom(window);
+        return 0;
+    }
+
+    if (strcmp(name, "exposure") == 0) {
+        benchmarkExposure(window);
+        return 0;
+    }
+
+    if (strcmp(name, "temporal") == 0) {
+        benchmarkTemporal(window);
+        return 0;
+    }
+
+    if (strcmp(name, "sprites") == 0) {
+        benchmarkSprites(window);
+        return 0;
+    }
+
+    if (strcmp(name, "stochastic") == 0) {
+        benchmarkStochasticLod(window);
+        return 0;
+    }
+
+    std::cerr << "Unknown benchmark: " << name << " (available: sort, reorder, attractors, barnes-hut, grid, fluid, shapes, variants, orbits, integrators, shell, bloom, resize, framegraph, sparsebloom, fusedbloom, exposure, temporal, sprites, stochastic)" << std::endl;
+    return 1;
+}
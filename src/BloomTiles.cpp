@@ -0,0 +1,135 @@
+#include "BloomTiles.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <iostream>
+#include <string>
+
+// 与bloomTiles.cs一致
+static const int kCompactGroupSize = 64;
+
+BloomTiles::BloomTiles(const char* shaderPrefix) :
+    dilation(1),
+    m_width(0),
+    m_height(0),
+    m_tilesX(0),
+    m_tilesY(0),
+    m_mask(nullptr),
+    m_list(nullptr),
+    m_command(nullptr),
+    m_classifyProg(0),
+    m_compactProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    // 在第一次分类之前draw()不绘制任何块
+    m_command = new ShaderBuffer<uint32_t>(4);
+    uint32_t command[4] = { 6, 0, 0, 0 };
+    m_command->bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(command), command);
+    m_command->unbind();
+
+    loadShaders();
+}
+
+BloomTiles::~BloomTiles()
+{
+    destroyBuffers();
+    delete m_command;
+
+    if (m_classifyProg) glDeleteProgram(m_classifyProg);
+    if (m_compactProg) glDeleteProgram(m_compactProg);
+}
+
+void BloomTiles::loadShaders()
+{
+    PROFILE_SCOPE("BloomTiles::loadShaders");
+
+    GLuint* programs[] = { &m_classifyProg, &m_compactProg };
+    for (GLuint* prog : programs) {
+        if (*prog) {
+            glDeleteProgram(*prog);
+            *prog = 0;
+        }
+    }
+
+    std::string src = readShaderFile("assets/shaders/bloomTiles.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_classifyProg = createComputeProgram(injectShaderDefines(src, "#define BLOOM_TILE_CLASSIFY\n").c_str(), m_shaderPrefix);
+    m_compactProg = createComputeProgram(injectShaderDefines(src, "#define BLOOM_TILE_COMPACT\n").c_str(), m_shaderPrefix);
+    if (m_classifyProg == 0 || m_compactProg == 0) {
+        std::cerr << "Failed to create bloom tile shader programs" << std::endl;
+    }
+}
+
+void BloomTiles::destroyBuffers()
+{
+    delete m_mask;
+    delete m_list;
+    m_mask = nullptr;
+    m_list = nullptr;
+}
+
+void BloomTiles::resize(int width, int height)
+{
+    if (width == m_width && height == m_height && m_mask) return;
+
+    destroyBuffers();
+    m_width = width;
+    m_height = height;
+    m_tilesX = (width + kTileSize - 1) / kTileSize;
+    m_tilesY = (height + kTileSize - 1) / kTileSize;
+    if (width <= 0 || height <= 0) return;
+
+    m_mask = new ShaderBuffer<uint32_t>((size_t)m_tilesX * m_tilesY);
+    m_list = new ShaderBuffer<uint32_t>((size_t)m_tilesX * m_tilesY);
+}
+
+void BloomTiles::classify(GLuint sceneTexture, float threshold)
+{
+    PROFILE_GPU_SCOPE("BloomTiles::classify");
+    if (m_classifyProg == 0 || m_compactProg == 0 || !m_mask) return;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 23, m_mask->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 24, m_list->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 25, m_command->getBuffer());
+
+    glUseProgram(m_classifyProg);
+    glUniform1i(glGetUniformLocation(m_classifyProg, "sceneTexture"), 0);
+    glUniform1f(glGetUniformLocation(m_classifyProg, "threshold"), threshold);
+    glUniform2i(glGetUniformLocation(m_classifyProg, "tileCount"), m_tilesX, m_tilesY);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sceneTexture);
+    glDispatchCompute(m_tilesX, m_tilesY, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(m_compactProg);
+    glUniform2i(glGetUniformLocation(m_compactProg, "tileCount"), m_tilesX, m_tilesY);
+    glUniform1i(glGetUniformLocation(m_compactProg, "dilation"), dilation);
+    glDispatchCompute((m_tilesX * m_tilesY + kCompactGroupSize - 1) / kCompactGroupSize, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    glUseProgram(0);
+    CHECK_GL_ERROR();
+}
+
+void BloomTiles::draw()
+{
+    if (!m_list) return;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 24, m_list->getBuffer());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_command->getBuffer());
+    glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+int BloomTiles::readActiveTileCount()
+{
+    uint32_t command[4] = {};
+    m_command->bind();
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(command), command);
+    m_command->unbind();
+    return (int)command[1];
+}
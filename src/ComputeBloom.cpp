@@ -0,0 +1,159 @@
+#include "ComputeBloom.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+// 与bloomPass.cs一致: 16x16的工作组，降采样时每组覆盖64x64个场景像素
+static const int kGroupSize = 16;
+static const int kDownsampleTile = 64;
+
+ComputeBloom::ComputeBloom(const char* shaderPrefix) :
+    threshold(1.2f),
+    m_width(0),
+    m_height(0),
+    m_chain(0),
+    m_counter(nullptr),
+    m_downsampleProg(0),
+    m_upsampleProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    m_counter = new ShaderBuffer<uint32_t>(1);
+    uint32_t zero = 0;
+    m_counter->bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+    m_counter->unbind();
+
+    loadShaders();
+}
+
+ComputeBloom::~ComputeBloom()
+{
+    destroyTextures();
+    delete m_counter;
+
+    if (m_downsampleProg) glDeleteProgram(m_downsampleProg);
+    if (m_upsampleProg) glDeleteProgram(m_upsampleProg);
+}
+
+void ComputeBloom::loadShaders()
+{
+    PROFILE_SCOPE("ComputeBloom::loadShaders");
+
+    GLuint* programs[] = { &m_downsampleProg, &m_upsampleProg };
+    for (GLuint* prog : programs) {
+        if (*prog) {
+            glDeleteProgram(*prog);
+            *prog = 0;
+        }
+    }
+
+    std::string src = readShaderFile("assets/shaders/bloomPass.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_downsampleProg = createComputeProgram(injectShaderDefines(src, "#define BLOOM_DOWNSAMPLE\n").c_str(), m_shaderPrefix);
+    m_upsampleProg = createComputeProgram(injectShaderDefines(src, "#define BLOOM_UPSAMPLE\n").c_str(), m_shaderPrefix);
+    if (m_downsampleProg == 0 || m_upsampleProg == 0) {
+        std::cerr << "Failed to create compute bloom shader programs" << std::endl;
+    }
+}
+
+void ComputeBloom::destroyTextures()
+{
+    if (m_chain) {
+        glDeleteTextures(1, &m_chain);
+        m_chain = 0;
+    }
+}
+
+void ComputeBloom::resize(int width, int height)
+{
+    if (width == m_width && height == m_height && m_chain) return;
+
+    destroyTextures();
+    m_width = width;
+    m_height = height;
+    if (width <= 0 || height <= 0) return;
+
+    // 逐级分配而非glTexStorage2D: 窗口很小时级数可能超过log2(尺寸)+1，尺寸钳制到1
+    glGenTextures(1, &m_chain);
+    glBindTexture(GL_TEXTURE_2D, m_chain);
+    for (int level = 0; level < kNumLevels; level++) {
+        int w = std::max((width / 2) >> level, 1);
+        int h = std::max((height / 2) >> level, 1);
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA16F, w, h, 0, GL_RGBA, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, kNumLevels - 1);
+    // 上采样用textureLod取整数级，级内双线性；合成时放大只会用到第0级
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    CHECK_GL_ERROR();
+}
+
+void ComputeBloom::render(GLuint sceneTexture)
+{
+    PROFILE_SCOPE("ComputeBloom::render");
+
+    downsample(sceneTexture);
+    upsample();
+}
+
+void ComputeBloom::downsample(GLuint sceneTexture)
+{
+    PROFILE_GPU_SCOPE("ComputeBloom::downsample");
+    if (m_downsampleProg == 0 || m_chain == 0) return;
+
+    glUseProgram(m_downsampleProg);
+    glUniform1i(glGetUniformLocation(m_downsampleProg, "sceneTexture"), 0);
+    glUniform1f(glGetUniformLocation(m_downsampleProg, "threshold"), threshold);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sceneTexture);
+    for (int level = 0; level < kNumLevels; level++) {
+        glBindImageTexture(level, m_chain, level, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA16F);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 22, m_counter->getBuffer());
+
+    glDispatchCompute((m_width + kDownsampleTile - 1) / kDownsampleTile,
+                      (m_height + kDownsampleTile - 1) / kDownsampleTile, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    glUseProgram(0);
+    CHECK_GL_ERROR();
+}
+
+void ComputeBloom::upsample()
+{
+    PROFILE_GPU_SCOPE("ComputeBloom::upsample");
+    if (m_upsampleProg == 0 || m_chain == 0) return;
+
+    glUseProgram(m_upsampleProg);
+    glUniform1i(glGetUniformLocation(m_upsampleProg, "chainTexture"), 0);
+    GLint srcLevelLoc = glGetUniformLocation(m_upsampleProg, "srcLevel");
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_chain);
+
+    // 同一纹理: 从第srcLevel级采样，写第srcLevel-1级，两级互不重叠
+    for (int srcLevel = kNumLevels - 1; srcLevel > 0; srcLevel--) {
+        int w = std::max((m_width / 2) >> (srcLevel - 1), 1);
+        int h = std::max((m_height / 2) >> (srcLevel - 1), 1);
+
+        glUniform1i(srcLevelLoc, srcLevel);
+        glBindImageTexture(0, m_chain, srcLevel - 1, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA16F);
+        glDispatchCompute((w + kGroupSize - 1) / kGroupSize, (h + kGroupSize - 1) / kGroupSize, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    CHECK_GL_ERROR();
+}
@@ -1,26 +1,90 @@
 #include "ComputeParticles.h"
 #include "ParticleSystem.h"
 #include "GLUtils.h"
+#include "Profiler.h"
+#include "ParticleCuller.h"
+#include "GpuTimer.h"
+#include "ParticleSorter.h"
+#include "ParticleReorder.h"
+#include "AttractorCluster.h"
+#include "SwarmGravity.h"
+#include "NeighborGrid.h"
+#include "FluidSolver.h"
+#include "ShapeTargets.h"
+#include "KeplerOrbits.h"
+#include "ShellConstraints.h"
+#include "ComputeBloom.h"
+#include "BloomTiles.h"
+#include "AutoExposure.h"
+#include "TemporalUpsample.h"
+#include "OverdrawView.h"
+#include "RenderTargetPool.h"
+#include "FrameGraph.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/ext/scalar_constants.hpp>
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <cstddef>
 #include <fstream>
 #include <sstream>
+#include <vector>
+
+// 按dt积分时单个子步的上限(秒): --bench integrators 中各积分器在最硬的形状弹簧上
+// 仍不比60Hz逐帧步进更不准的最大步长；吸引子等较软的受力可以更大。Legacy不使用
+static const float kMaxStepSeconds[ParticleSystem::kNumIntegrators] = { 1.0f / 60.0f, 1.0f / 60.0f, 1.0f / 60.0f, 1.0f / 40.0f };
+// 一帧最多模拟的时间，卡顿之后不一次补太多步
+static const float kMaxFrameTime = 0.1f;
+// 最后一次缩放事件之后多久按实际窗口尺寸重新分配渲染目标
+static const float kResizeSettleSeconds = 0.25f;
 
 ComputeParticles::ComputeParticles() 
     : mEnableAttractor(false),
     mAnimate(true),
     mTime(0.0f),
+    mSubsteps(1),
     mWidth(800),
     mHeight(600),
     mCameraPos(0.0f, 0.0f, -3.0f),
     mCameraTarget(0.0f, 0.0f, 0.0f),
-    mRenderProg(nullptr),
+    mSprites(),
+    mOverdrawSprites(),
+    mFalloffTexture(0),
+    mOctagonSprites(true),
+    mParticles(nullptr),
+    mParticleCount(mNumParticles),
     mUBO(0),
     mVBO(0),
     mVAO(0),
+    mCuller(nullptr),
+    mEnableCulling(true),
+    mStochasticLod(false),
+    mParticleResolution(FullResolution),
+    mAutoDivisor(1),
+    mAutoCooldown(0),
+    mParticleBudgetMs(4.0f),
+    mReportParticleResolution(false),
+    mParticleTimer(nullptr),
+    mTemporal(nullptr),
+    mTemporalUpsample(false),
+    mBlendMode(AdditiveBlend),
+    mSorter(nullptr),
+    mReorder(nullptr),
+    mAttractors(nullptr),
+    mSwarm(nullptr),
+    mGrid(nullptr),
+    mFluid(nullptr),
+    mShapes(nullptr),
+    mHeartShape(0),
+    mStarShape(0),
+    mMorphFrom(0),
+    mMorphTo(0),
+    mMorphDuration(2.0f),
+    mOrbits(nullptr),
+    mOrbitTime(0.0f),
+    mOrbitActive(false),
+    mShell(nullptr),
     mLeftMousePressed(false),
     mRightMousePressed(false),
     mLastMouseX(0.0),
@@ -33,32 +97,119 @@ ComputeParticles::ComputeParticles()
     mStateTime(0.0f),
     mAbsorbDuration(2.0f),
     mHeartDuration(5.0f),
-    mSceneFBO(0),
-    mSceneTexture(0),
+    mTargetPool(nullptr),
+    mFrameGraph(nullptr),
+    mSceneHandle(FrameGraph::kInvalid),
+    mFrameGraphDivisor(1),
+    mFrameGraphBloomPath(FragmentChainBloom),
+    mRenderWidth(0),
+    mRenderHeight(0),
+    mResizePending(false),
+    mResizeIdleTime(0.0f),
+    mBloomPath(FragmentChainBloom),
+    mBloomThreshold(1.2f),
+    mComputeBloom(nullptr),
+    mBloomTiles(nullptr),
+    mAutoExposure(nullptr),
+    mAutoExposureEnabled(false),
+    mFrameDeltaTime(0.0f),
+    mOverdraw(nullptr),
+    mOverdrawView(false),
+    mOverdrawReportTime(0.0f),
     mBloomExtractProg(nullptr),
     mBloomDownsampleProg(nullptr),
     mBloomUpsampleProg(nullptr),
     mBloomCombineProg(nullptr),
+    mBloomFusedDownsampleProg(nullptr),
+    mBloomFusedUpsampleProg(nullptr),
+    mParticleUpsampleProg(nullptr),
     mScreenQuadVAO(0),
     mScreenQuadVBO(0)
 {
-    for (int i = 0; i < 4; i++) {
-        mBloomFBO[i] = 0;
-        mBloomTexture[i] = 0;
-    }
-    for (int i = 0; i < 3; i++) {
-        mBloomUpsampleFBO[i] = 0;
-        mBloomUpsampleTexture[i] = 0;
-    }
 }
 
 ComputeParticles::~ComputeParticles()
 {
-    destroyBloomResources();
+    if (mFrameGraph) {
+        delete mFrameGraph;
+        mFrameGraph = nullptr;
+    }
+    if (mTargetPool) {
+        delete mTargetPool;
+        mTargetPool = nullptr;
+    }
+    destroyPostProcessShaders();
+    
+    destroySpritePrograms(mSprites);
+    destroySpritePrograms(mOverdrawSprites);
+    if (mFalloffTexture) {
+        glDeleteTextures(1, &mFalloffTexture);
+        mFalloffTexture = 0;
+    }
     
-    if (mRenderProg) {
-        delete mRenderProg;
-        mRenderProg = nullptr;
+    if (mCuller) {
+        delete mCuller;
+        mCuller = nullptr;
+    }
+    if (mParticleTimer) {
+        delete mParticleTimer;
+        mParticleTimer = nullptr;
+    }
+    if (mSorter) {
+        delete mSorter;
+        mSorter = nullptr;
+    }
+    if (mReorder) {
+        delete mReorder;
+        mReorder = nullptr;
+    }
+    if (mAttractors) {
+        delete mAttractors;
+        mAttractors = nullptr;
+    }
+    if (mSwarm) {
+        delete mSwarm;
+        mSwarm = nullptr;
+    }
+    if (mGrid) {
+        delete mGrid;
+        mGrid = nullptr;
+    }
+    if (mFluid) {
+        delete mFluid;
+        mFluid = nullptr;
+    }
+    if (mShapes) {
+        delete mShapes;
+        mShapes = nullptr;
+    }
+    if (mOrbits) {
+        delete mOrbits;
+        mOrbits = nullptr;
+    }
+    if (mShell) {
+        delete mShell;
+        mShell = nullptr;
+    }
+    if (mComputeBloom) {
+        delete mComputeBloom;
+        mComputeBloom = nullptr;
+    }
+    if (mBloomTiles) {
+        delete mBloomTiles;
+        mBloomTiles = nullptr;
+    }
+    if (mAutoExposure) {
+        delete mAutoExposure;
+        mAutoExposure = nullptr;
+    }
+    if (mTemporal) {
+        delete mTemporal;
+        mTemporal = nullptr;
+    }
+    if (mOverdraw) {
+        delete mOverdraw;
+        mOverdraw = nullptr;
     }
     
     if (mParticles) {
@@ -83,6 +234,8 @@ ComputeParticles::~ComputeParticles()
 
 bool ComputeParticles::init(GLFWwindow* window)
 {
+    PROFILE_SCOPE("ComputeParticles::init");
+    
     int major, minor;
     glGetIntegerv(GL_MAJOR_VERSION, &major);
     glGetIntegerv(GL_MINOR_VERSION, &minor);
@@ -97,36 +250,10 @@ bool ComputeParticles::init(GLFWwindow* window)
     
     const char* shaderPrefix = "#version 430\n";
     
-    // 加载渲染着色器文件
-    std::ifstream vsFile("assets/shaders/basePass.verrt");
-    if (!vsFile.is_open()) {
-        std::cerr << "错误: 无法打开顶点着色器文件: assets/shaders/basePass.verrt" << std::endl;
-        return false;
-    }
-    std::stringstream vsBuffer;
-    vsBuffer << vsFile.rdbuf();
-    std::string renderVS = vsBuffer.str();
-    vsFile.close();
-    
-    // 加载渲染着色器文件
-    std::ifstream fsFile("assets/shaders/basePass.frag");
-    if (!fsFile.is_open()) {
-        std::cerr << "错误: 无法打开片段着色器文件: assets/shaders/basePass.frag" << std::endl;
-        return false;
-    }
-    std::stringstream fsBuffer;
-    fsBuffer << fsFile.rdbuf();
-    std::string renderFS = fsBuffer.str();
-    fsFile.close();
-    
-    std::string renderVSWithVersion = renderVS;
-    std::string renderFSWithVersion = renderFS;
-    
-    mRenderProg = new ShaderProgram();
-    if (!mRenderProg->loadFromStrings(renderVSWithVersion.c_str(), renderFSWithVersion.c_str())) {
-        std::cerr << "错误: 加载渲染着色器失败" << std::endl;
+    if (!loadSpritePrograms(mSprites, "")) {
         return false;
     }
+    createFalloffTexture();
     CHECK_GL_ERROR();
     
     glGenBuffers(1, &mUBO);
@@ -147,12 +274,52 @@ bool ComputeParticles::init(GLFWwindow* window)
     glBindVertexArray(0);
     CHECK_GL_ERROR();
     
-    mParticleCount = mNumParticles;
     mParticles = new ParticleSystem(mParticleCount, shaderPrefix);
     
     mParticles->resetToHeartShape(0.3f);
     CHECK_GL_ERROR();
     
+    mCuller = new ParticleCuller(mParticleCount, shaderPrefix);
+    mParticleTimer = new GpuTimer();
+    mSorter = new ParticleSorter(mParticleCount, shaderPrefix);
+    mReorder = new ParticleReorder(mParticleCount, shaderPrefix);
+    mAttractors = new AttractorCluster();
+    mSwarm = new SwarmGravity(std::min<size_t>(mParticleCount, 1 << 17));
+    mParticles->setSwarmAccelerations(mSwarm->getAccelBuffer());
+    mGrid = new NeighborGrid(mParticleCount, shaderPrefix);
+    mParticles->setNeighborGrid(mGrid->getSortedBuffer(), mGrid->getCellRangeBuffer());
+    mFluid = new FluidSolver(64, shaderPrefix);
+    
+    // 内置形状之外，默认的网格与命令行指定的网格依次加入；读取失败的跳过
+    mShapes = new ShapeTargets(mParticleCount);
+    mHeartShape = mShapes->addHeart(0.3f);
+    mStarShape = mShapes->addStar(0.3f);
+    std::vector<std::string> shapeFiles = { "assets/models/torus.obj", "assets/models/knot.ply" };
+    shapeFiles.insert(shapeFiles.end(), mShapeFiles.begin(), mShapeFiles.end());
+    for (const std::string& file : shapeFiles) {
+        mShapes->addMesh(file.c_str(), 0.3f);
+    }
+    mMorphFrom = mMorphTo = mHeartShape;
+    mParticles->setShapeTargets(mShapes->getBuffer());
+    CHECK_GL_ERROR();
+    
+    mOrbits = new KeplerOrbits(mParticleCount, shaderPrefix);
+    mOrbits->generate(64, 7);
+    
+    // 壳体顶点不超过粒子数: 细分7次为163842个顶点、983040个约束
+    int shellLevel = 7;
+    while (shellLevel > 0 && ((size_t)10 << (2 * shellLevel)) + 2 > (size_t)mParticleCount) {
+        shellLevel--;
+    }
+    mShell = new ShellConstraints(shellLevel, 0.6f, shaderPrefix);
+    
+    mComputeBloom = new ComputeBloom(shaderPrefix);
+    mComputeBloom->threshold = mBloomThreshold;
+    mBloomTiles = new BloomTiles(shaderPrefix);
+    mAutoExposure = new AutoExposure(shaderPrefix);
+    mTemporal = new TemporalUpsample(shaderPrefix);
+    mOverdraw = new OverdrawView(shaderPrefix);
+    
     //int cx, cy, cz;
     //glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &cx);
     //glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 1, &cy);
@@ -172,20 +339,107 @@ bool ComputeParticles::init(GLFWwindow* window)
     
     mViewMatrix = glm::lookAt(mCameraPos, mCameraTarget, glm::vec3(0.0f, 1.0f, 0.0f));
     
-    initBloomResources();
+    loadPostProcessShaders();
+    mTargetPool = new RenderTargetPool();
+    mFrameGraph = new FrameGraph(mTargetPool);
+    setRenderSize(mWidth, mHeight);
     
     return true;
 }
 
-void ComputeParticles::reshape(int width, int height)
+void ComputeParticles::reshape(int width, int height, bool interactive)
 {
     mWidth = width;
     mHeight = height;
     glViewport(0, 0, width, height);
     CHECK_GL_ERROR();
     
-    destroyBloomResources();
-    initBloomResources();
+    // 最小化时尺寸为0，保留原有目标
+    if (width <= 0 || height <= 0 || !mFrameGraph) return;
+    
+    if (interactive) {
+        // 拖动缩放期间每次事件都会调用: 渲染目标按分桶尺寸复用，合成时拉伸到窗口，
+        // 停止缩放kResizeSettleSeconds后再由draw()按实际尺寸分配
+        setRenderSize(RenderTargetPool::chooseSize(mRenderWidth, width),
+                      RenderTargetPool::chooseSize(mRenderHeight, height));
+        mResizePending = true;
+        mResizeIdleTime = 0.0f;
+    } else {
+        setRenderSize(width, height);
+        mResizePending = false;
+    }
+}
+
+int ComputeParticles::getRenderTargetAllocations() const
+{
+    return mTargetPool ? mTargetPool->getAllocationCount() : 0;
+}
+
+void ComputeParticles::setBloomThreshold(float threshold)
+{
+    mBloomThreshold = threshold;
+    if (mComputeBloom) {
+        mComputeBloom->threshold = threshold;
+    }
+}
+
+void ComputeParticles::getBloomTileCoverage(int& activeTiles, int& totalTiles)
+{
+    activeTiles = mBloomTiles ? mBloomTiles->readActiveTileCount() : 0;
+    totalTiles = mBloomTiles ? mBloomTiles->getTileCountX() * mBloomTiles->getTileCountY() : 0;
+}
+
+void ComputeParticles::setAutoExposure(bool enabled)
+{
+    mAutoExposureEnabled = enabled;
+    if (mAutoExposure && !enabled) {
+        mAutoExposure->reset(1.0f);
+    }
+    if (mFrameGraph) {
+        mFrameGraph->reset();
+    }
+}
+
+float ComputeParticles::readExposure(float* averageLuminance)
+{
+    return mAutoExposure ? mAutoExposure->readExposure(averageLuminance) : 1.0f;
+}
+
+void ComputeParticles::setTemporalUpsample(bool enabled)
+{
+    mTemporalUpsample = enabled;
+    if (mTemporal) {
+        mTemporal->reset();
+    }
+    if (mFrameGraph) {
+        mFrameGraph->reset();
+    }
+}
+
+void ComputeParticles::setPipelineStatistics(bool enabled)
+{
+    if (mFrameGraph) {
+        mFrameGraph->setPipelineStatistics(enabled);
+    }
+}
+
+// 计数与热力图pass只在视图打开时声明，切换时重建帧图
+void ComputeParticles::setOverdrawView(bool enabled)
+{
+    // 计数的精灵变体只在需要时编译，平时绘制的程序不含图像写入
+    if (enabled && mOverdraw && !mOverdrawSprites.quad) {
+        if (!loadSpritePrograms(mOverdrawSprites, "#define OVERDRAW_COUNT\n") ||
+            !mOverdrawSprites.octagon != !mSprites.octagon || !mOverdrawSprites.orbit != !mSprites.orbit) {
+            std::cerr << "错误: 加载overdraw计数着色器失败" << std::endl;
+            destroySpritePrograms(mOverdrawSprites);
+        }
+    }
+    mOverdrawView = enabled && mOverdraw && mOverdrawSprites.quad;
+    mOverdrawReportTime = 0.0f;
+    setPipelineStatistics(mOverdrawView);
+    if (mFrameGraph) {
+        mFrameGraph->reset();
+    }
 }
 
 void ComputeParticles::handleKey(int key, int action)
@@ -203,6 +457,224 @@ void ComputeParticles::handleKey(int key, int action)
             case GLFW_KEY_R:
                 reset();
                 break;
+            case GLFW_KEY_C:
+                mEnableCulling = !mEnableCulling;
+                std::cout << "Culling/LOD: " << (mEnableCulling ? "On" : "Off") << std::endl;
+                break;
+            case GLFW_KEY_1:
+                if (action == GLFW_PRESS) {
+                    mStochasticLod = !mStochasticLod;
+                    std::cout << "Stochastic LOD: " << (mStochasticLod ? "On" : "Off") << " (with culling)" << std::endl;
+                }
+                break;
+            case GLFW_KEY_H:
+                if (action == GLFW_PRESS) {
+                    static const char* names[] = { "Full", "Half", "Quarter", "Auto" };
+                    mParticleResolution = ParticleResolution((mParticleResolution + 1) % 4);
+                    mAutoDivisor = 1;
+                    mAutoCooldown = 0;
+                    mParticleTimer->reset();
+                    std::cout << "Particle resolution: " << names[mParticleResolution] << std::endl;
+                }
+                break;
+            case GLFW_KEY_O:
+                if (action == GLFW_PRESS) {
+                    static const char* names[] = { "Additive", "Sorted over (full sort)", "Sorted over (incremental)" };
+                    mBlendMode = ParticleBlendMode((mBlendMode + 1) % 3);
+                    mSorter->incremental = mBlendMode == IncrementalOverBlend;
+                    mSorter->invalidate();
+                    std::cout << "Blend mode: " << names[mBlendMode] << std::endl;
+                }
+                break;
+            case GLFW_KEY_G:
+                if (action == GLFW_PRESS) {
+                    static const int counts[] = { 0, 256, 1024, AttractorCluster::kMaxAttractors };
+                    int next = 0;
+                    for (int i = 0; i < 4; i++) {
+                        if (counts[i] == mAttractors->getCount()) next = (i + 1) % 4;
+                    }
+                    mAttractors->setCount(counts[next]);
+                    std::cout << "Attractor cluster: " << counts[next] << std::endl;
+                }
+                break;
+            case GLFW_KEY_W:
+                if (action == GLFW_PRESS) {
+                    if (mParticleState == Swarm) {
+                        mParticleState = Normal;
+                    } else {
+                        // 进入前槽位可能已被重排，旧的加速度不再对应
+                        mSwarm->invalidate();
+                        mParticleState = Swarm;
+                    }
+                    mStateTime = 0.0f;
+                    std::cout << "Swarm self-gravity: " << (mParticleState == Swarm ? "On" : "Off") << std::endl;
+                }
+                break;
+            case GLFW_KEY_B:
+                if (action == GLFW_PRESS) {
+                    mParticleState = mParticleState == Flock ? Normal : Flock;
+                    mStateTime = 0.0f;
+                    std::cout << "Flock: " << (mParticleState == Flock ? "On" : "Off") << std::endl;
+                }
+                break;
+            case GLFW_KEY_F:
+                if (action == GLFW_PRESS) {
+                    mParticleState = mParticleState == Fluid ? Normal : Fluid;
+                    mStateTime = 0.0f;
+                    std::cout << "Fluid: " << (mParticleState == Fluid ? "On" : "Off") << std::endl;
+                }
+                break;
+            case GLFW_KEY_P:
+                if (action == GLFW_PRESS) {
+                    int current = mHeartShape;
+                    if (mParticleState == ShapeMorph) current = mMorphTo;
+                    if (mParticleState == StarShape) current = mStarShape;
+                    mMorphFrom = current;
+                    mMorphTo = (current + 1) % mShapes->getShapeCount();
+                    mParticleState = ShapeMorph;
+                    mStateTime = 0.0f;
+                    std::cout << "Shape morph: " << mShapes->getName(mMorphFrom) << " -> "
+                              << mShapes->getName(mMorphTo) << std::endl;
+                }
+                break;
+            case GLFW_KEY_V:
+                if (action == GLFW_PRESS) {
+                    static const int sizes[] = { 64, 96, 128 };
+                    int next = 0;
+                    for (int i = 0; i < 3; i++) {
+                        if (sizes[i] == mFluid->getResolution()) next = (i + 1) % 3;
+                    }
+                    mFluid->setResolution(sizes[next]);
+                    std::cout << "Fluid grid: " << sizes[next] << "^3" << std::endl;
+                }
+                break;
+            case GLFW_KEY_J:
+                if (action == GLFW_PRESS) {
+                    static const int iterations[] = { 10, 20, 40 };
+                    int next = 0;
+                    for (int i = 0; i < 3; i++) {
+                        if (iterations[i] == mFluid->jacobiIterations) next = (i + 1) % 3;
+                    }
+                    mFluid->jacobiIterations = iterations[next];
+                    std::cout << "Fluid pressure iterations: " << iterations[next] << std::endl;
+                }
+                break;
+            case GLFW_KEY_E:
+                if (action == GLFW_PRESS) {
+                    mParticleState = mParticleState == Orbit ? Normal : Orbit;
+                    mStateTime = 0.0f;
+                    std::cout << "Kepler orbits: " << (mParticleState == Orbit ? "On" : "Off") << std::endl;
+                }
+                break;
+            case GLFW_KEY_S:
+                if (action == GLFW_PRESS) {
+                    if (mParticleState == Shell) {
+                        mParticleState = Normal;
+                    } else if (mShell->deploy(mParticles)) {
+                        // 壳体写入了前几个槽位，排序结果不再适用
+                        mParticleState = Shell;
+                        mSorter->invalidate();
+                    }
+                    mStateTime = 0.0f;
+                    std::cout << "PBD shell: " << (mParticleState == Shell ? "On" : "Off") << " ("
+                              << mShell->getVertexCount() << " vertices, " << mShell->getConstraintCount()
+                              << " constraints, " << mShell->getColorCount() << " colors)" << std::endl;
+                }
+                break;
+            case GLFW_KEY_U:
+                if (action == GLFW_PRESS) {
+                    static const int iterations[] = { 1, 2, 4, 8, 16 };
+                    int next = 0;
+                    for (int i = 0; i < 5; i++) {
+                        if (iterations[i] == mShell->iterations) next = (i + 1) % 5;
+                    }
+                    mShell->iterations = iterations[next];
+                    std::cout << "Shell constraint iterations: " << iterations[next] << std::endl;
+                }
+                break;
+            case GLFW_KEY_X:
+                if (action == GLFW_PRESS) {
+                    setAutoExposure(!mAutoExposureEnabled);
+                    std::cout << "Auto exposure: " << (mAutoExposureEnabled ? "On" : "Off") << std::endl;
+                }
+                break;
+            case GLFW_KEY_Z:
+                if (action == GLFW_PRESS) {
+                    setTemporalUpsample(!mTemporalUpsample);
+                    std::cout << "Temporal particle upsampling: " << (mTemporalUpsample ? "On" : "Off")
+                              << " (at 1/2 and 1/4 particle resolution)" << std::endl;
+                }
+                break;
+            case GLFW_KEY_Y:
+                if (action == GLFW_PRESS) {
+                    mOctagonSprites = !mOctagonSprites;
+                    std::cout << "Sprite geometry: " << (mOctagonSprites ? "octagon, falloff table" : "quad, exp + discard")
+                              << std::endl;
+                }
+                break;
+            case GLFW_KEY_D:
+                if (action == GLFW_PRESS) {
+                    setOverdrawView(!mOverdrawView);
+                    std::cout << "Overdraw view: " << (mOverdrawView ? "On (heatmap, stats printed every second)" : "Off")
+                              << std::endl;
+                }
+                break;
+            case GLFW_KEY_L:
+                if (action == GLFW_PRESS) {
+                    static const char* names[] = { "fragment chain", "compute mip chain", "sparse tiles", "fused chain" };
+                    mBloomPath = (BloomPath)((mBloomPath + 1) % 4);
+                    std::cout << "Bloom: " << names[mBloomPath] << std::endl;
+                }
+                break;
+            case GLFW_KEY_LEFT:
+            case GLFW_KEY_RIGHT:
+                // 轨道时间任意跳转，求值开销与跳转距离无关
+                if (mParticleState == Orbit) {
+                    mOrbitTime += key == GLFW_KEY_RIGHT ? 10.0f : -10.0f;
+                    std::cout << "Orbit time: " << mOrbitTime << " s" << std::endl;
+                }
+                break;
+            case GLFW_KEY_N:
+                if (action == GLFW_PRESS) {
+                    mShaderParams.noiseOctaves = mShaderParams.noiseOctaves > 1 ? mShaderParams.noiseOctaves - 1 : 4;
+                    std::cout << "Noise octaves: " << mShaderParams.noiseOctaves << std::endl;
+                }
+                break;
+            case GLFW_KEY_I:
+                if (action == GLFW_PRESS) {
+                    mShaderParams.integrator = (mShaderParams.integrator + 1) % ParticleSystem::kNumIntegrators;
+                    std::cout << "Integrator: " << ParticleSystem::integratorName(mShaderParams.integrator) << std::endl;
+                }
+                break;
+            case GLFW_KEY_K:
+                if (action == GLFW_PRESS) {
+                    mParticles->specializeShaders = !mParticles->specializeShaders;
+                    std::cout << "Particle kernel: " << (mParticles->specializeShaders ? "per-state variants" : "uber-kernel")
+                              << " (" << mParticles->getVariantCount() << " variants compiled)" << std::endl;
+                }
+                break;
+            case GLFW_KEY_M:
+                if (action == GLFW_PRESS) {
+                    mReorder->enabled = !mReorder->enabled;
+                    std::cout << "Morton reorder: " << (mReorder->enabled ? "On" : "Off") << std::endl;
+                }
+                break;
+            case GLFW_KEY_Q:
+                if (action == GLFW_PRESS) {
+                    mReportParticleResolution = true;
+                }
+                break;
+            case GLFW_KEY_T:
+                if (action == GLFW_PRESS) {
+                    if (Profiler::isEnabled()) {
+                        Profiler::setEnabled(false);
+                        Profiler::dumpChromeTrace("trace.json");
+                    } else {
+                        Profiler::setEnabled(true);
+                        std::cout << "Profiler: capturing (press T again to dump trace.json)" << std::endl;
+                    }
+                }
+                break;
         }
     }
 }
@@ -212,10 +684,20 @@ void ComputeParticles::reset()
     mTime = 0.0f;
     mParticleState = Normal;
     mStateTime = 0.0f;
+    mOrbitActive = false;
     
     if (mParticles) {
         mParticles->reset(0.5f);
     }
+    if (mSorter) {
+        mSorter->invalidate();
+    }
+    if (mReorder) {
+        mReorder->invalidate();
+    }
+    if (mSwarm) {
+        mSwarm->invalidate();
+    }
 }
 
 void ComputeParticles::handleMouseButton(int button, int action, int mods)
@@ -278,6 +760,82 @@ void ComputeParticles::handleScroll(double xoffset, double yoffset)
 
 void ComputeParticles::draw(float deltaTime)
 {
+    PROFILE_SCOPE("ComputeParticles::draw");
+    
+    if (mResizePending) {
+        mResizeIdleTime += deltaTime;
+        if (mResizeIdleTime >= kResizeSettleSeconds) {
+            mResizePending = false;
+            setRenderSize(mWidth, mHeight);
+        }
+    }
+    
+    updateShaderParams(deltaTime);
+      
+    glActiveTexture(GL_TEXTURE0);
+    
+    {
+        PROFILE_SCOPE("draw::uploadUBO");
+        glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShaderParams), &mShaderParams);
+        glBindBufferBase(GL_UNIFORM_BUFFER, 1, mUBO);
+    }
+    
+    // 离开轨道模式时写回当前位置与速度，其他状态从轨道运动继续积分
+    bool orbit = mParticleState == Orbit;
+    if (mOrbitActive && !orbit) {
+        mOrbits->evaluate(mParticles, mOrbitTime, true);
+    }
+    mOrbitActive = orbit;
+    
+    if (mAnimate) {
+        // 重排改变了槽位顺序，上一帧的视深排序结果不再适用。壳体约束按槽位索引，壳体状态下不重排
+        if (mParticleState != Shell && mReorder->update(mParticles)) {
+            mSorter->invalidate();
+            mSwarm->invalidate();
+        }
+        if (mParticleState == Swarm) {
+            mSwarm->update(mParticles);
+        }
+        if (mParticleState == Fluid) {
+            mFluid->step(mTime);
+            mParticles->setFluidVelocity(mFluid->getVelocityTexture());
+        }
+        mAttractors->update(mTime);
+        mParticles->setAttractors(mAttractors->getBuffer(), mAttractors->getOffset(), mAttractors->getRangeSize());
+        if (orbit) {
+            mOrbitTime += deltaTime;
+        } else {
+            for (int step = 0; step < mSubsteps; step++) {
+                if (mParticleState == Flock) {
+                    mGrid->build(mParticles);
+                }
+                if (mParticleState == Shell) {
+                    mShell->storePositions(mParticles);
+                }
+                mParticles->update(mShaderParams);
+                if (mParticleState == Shell) {
+                    mShell->solve(mParticles, mShaderParams);
+                }
+            }
+        }
+    }
+    
+    // 暂停时也求值，跳转的时间立即可见
+    if (orbit && !evaluateOrbitsInVertexShader()) {
+        mOrbits->evaluate(mParticles, mOrbitTime);
+    }
+
+    mFrameDeltaTime = deltaTime;
+    renderFrame();
+    
+    mTargetPool->endFrame();
+}
+
+void ComputeParticles::updateShaderParams(float deltaTime)
+{
+    PROFILE_SCOPE("draw::stateMachine");
+    
     float aspect = (float)mWidth / (float)mHeight;
     glm::mat4 projectionMatrix = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 10.0f);
     
@@ -289,6 +847,21 @@ void ComputeParticles::draw(float deltaTime)
     mViewMatrix = glm::lookAt(mCameraPos, mCameraTarget, glm::vec3(0.0f, 1.0f, 0.0f));
     
     mShaderParams.numParticles = (unsigned int)(mParticles->getSize());
+    mShaderParams.numAttractors = (unsigned int)mAttractors->getCount();
+    mShaderParams.numSwarmBodies = mParticleState == Swarm ? mSwarm->getActiveBodies() : 0;
+    mShaderParams.gridCellSize = mGrid->cellSize;
+    mShaderParams.numGridCells = NeighborGrid::kNumCells;
+    mShaderParams.fluidExtent = mFluid->domainExtent;
+    
+    // 按dt积分时每帧走真实的帧时间；超过积分器的稳定步长时拆成几个等长子步。
+    // 帧时间上限避免卡顿后一次补太多步
+    mSubsteps = 1;
+    if (mShaderParams.integrator != ParticleSystem::kIntegratorLegacy) {
+        float frameTime = std::min(deltaTime, kMaxFrameTime);
+        float maxStep = kMaxStepSeconds[std::min(mShaderParams.integrator, (unsigned int)ParticleSystem::kIntegratorRK4)];
+        mSubsteps = std::max(1, (int)ceilf(frameTime / maxStep));
+        mShaderParams.dt = frameTime / mSubsteps;
+    }
     mShaderParams.ModelView = mViewMatrix;
     mShaderParams.ModelViewProjection = projectionMatrix * mViewMatrix;
     mShaderParams.ProjectionMatrix = projectionMatrix;
@@ -330,17 +903,61 @@ void ComputeParticles::draw(float deltaTime)
         mShaderParams.stateTime = mStateTime;
         mShaderParams.attractor.w = 0.0f; 
         mShaderParams.heartScale = 0.3f; 
+        mShaderParams.targetOffsetA = mShaderParams.targetOffsetB = mShapes->getOffset(mHeartShape);
+        mShaderParams.targetMorph = 0.0f;
         
         if (mStateTime >= mHeartDuration) {
             mParticleState = ParticleState::Normal;
             mStateTime = 0.0f;
         }
     }
+    else if (mParticleState == ParticleState::ShapeMorph) {
+        mShaderParams.particleState = 2.0f;
+        mShaderParams.stateTime = mStateTime;
+        mShaderParams.attractor.w = 0.0f;
+        mShaderParams.heartScale = 0.3f;
+        
+        // 渐变结束后停留在目标形状，直到再次切换
+        float t = glm::clamp(mStateTime / mMorphDuration, 0.0f, 1.0f);
+        if (t >= 1.0f) {
+            mMorphFrom = mMorphTo;
+        }
+        mShaderParams.targetOffsetA = mShapes->getOffset(mMorphFrom);
+        mShaderParams.targetOffsetB = mShapes->getOffset(mMorphTo);
+        mShaderParams.targetMorph = mMorphFrom == mMorphTo ? 0.0f : t * t * (3.0f - 2.0f * t);
+    }
+    else if (mParticleState == ParticleState::Swarm) {
+        mShaderParams.particleState = 4.0f;
+        mShaderParams.stateTime = mStateTime;
+        mShaderParams.attractor.w = 0.0f;
+        mShaderParams.heartScale = 0.3f;
+    }
+    else if (mParticleState == ParticleState::Fluid) {
+        mShaderParams.particleState = 6.0f;
+        mShaderParams.stateTime = mStateTime;
+        mShaderParams.attractor.w = 0.0f;
+        mShaderParams.heartScale = 0.3f;
+    }
+    else if (mParticleState == ParticleState::Orbit) {
+        // 不运行particlePass.cs，只有绘制读取这些参数
+        mShaderParams.particleState = 0.0f;
+        mShaderParams.stateTime = mStateTime;
+        mShaderParams.attractor.w = 0.0f;
+        mShaderParams.heartScale = 0.3f;
+    }
+    else if (mParticleState == ParticleState::Flock) {
+        mShaderParams.particleState = 5.0f;
+        mShaderParams.stateTime = mStateTime;
+        mShaderParams.attractor.w = 0.0f;
+        mShaderParams.heartScale = 0.3f;
+    }
     else if (mParticleState == ParticleState::StarShape) {
         mShaderParams.particleState = 3.0f;
         mShaderParams.stateTime = mStateTime;
         mShaderParams.attractor.w = 0.0f; 
         mShaderParams.heartScale = 0.3f;  
+        mShaderParams.targetOffsetA = mShaderParams.targetOffsetB = mShapes->getOffset(mStarShape);
+        mShaderParams.targetMorph = 0.0f;
         
         if (mStateTime >= mHeartDuration) {
             mParticleState = ParticleState::Normal;
@@ -364,26 +981,144 @@ void ComputeParticles::draw(float deltaTime)
     }
     
     mTime += deltaTime;
-      
-    glActiveTexture(GL_TEXTURE0);
+}
+
+void ComputeParticles::renderFrame()
+{
+    PROFILE_SCOPE("draw::renderFrame");
     
-    glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShaderParams), &mShaderParams);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 1, mUBO);
+    // 粒子分辨率或Bloom实现变化时重建帧图，物理目标多半能从池中直接复用
+    int divisor = chooseParticleDivisor();
+    if (!mFrameGraph->isCompiled() || divisor != mFrameGraphDivisor || mBloomPath != mFrameGraphBloomPath) {
+        buildFrameGraph(divisor);
+    }
     
-    if (mAnimate) {
-        mParticles->update();
+    if (mReportParticleResolution) {
+        mReportParticleResolution = false;
+        reportParticleResolution();
+    }
+    
+    if (mBlendMode != AdditiveBlend) {
+        mSorter->sort(mParticles);
     }
+    
+    if (useTemporalUpsample(divisor)) {
+        jitterParticleProjection(divisor);
+    }
+    
+    mAutoExposure->bind();
+    mFrameGraph->execute();
+    
+    if (mOverdrawView) {
+        mOverdrawReportTime += mFrameDeltaTime;
+        if (mOverdrawReportTime >= 1.0f) {
+            mOverdrawReportTime = 0.0f;
+            reportOverdraw();
+        }
+    }
+}
 
-    glBindFramebuffer(GL_FRAMEBUFFER, mSceneFBO);
-    glViewport(0, 0, mWidth, mHeight);
+// 打印的是几帧之前完成的结果，不等待GPU
+void ComputeParticles::reportOverdraw()
+{
+    float covered = 0.0f, screen = 0.0f;
+    unsigned int peak = 0;
+    if (readOverdraw(covered, screen, peak)) {
+        std::cout << "Overdraw: " << covered << " per covered pixel, " << screen << " per pixel, peak " << peak
+                  << std::endl;
+    }
+    if (mFrameGraph->getPipelineStatistics()) {
+        mFrameGraph->dumpPipelineStatistics();
+    }
+}
+
+bool ComputeParticles::readOverdraw(float& coveredAverage, float& screenAverage, unsigned int& peak, bool wait)
+{
+    if (!mOverdrawView || !mOverdraw) {
+        return false;
+    }
+    if (wait) {
+        mOverdraw->finish();
+    }
+    OverdrawView::Stats stats;
+    if (!mOverdraw->getStats(stats)) {
+        return false;
+    }
+    coveredAverage = stats.coveredPixels > 0 ? (float)stats.fragments / stats.coveredPixels : 0.0f;
+    screenAverage = stats.pixels > 0 ? (float)stats.fragments / stats.pixels : 0.0f;
+    peak = stats.peak;
+    return true;
+}
+
+// 帧图之外单独绘制，用于分辨率对比报告；降分辨率目标临时从池中取用
+void ComputeParticles::renderParticlesAt(int divisor, RenderTarget* scene)
+{
+    if (divisor == 1 || !mParticleUpsampleProg) {
+        drawParticles(scene->fbo, scene->width, scene->height);
+        return;
+    }
+    
+    RenderTarget* lowRes = mTargetPool->acquire(scene->width / divisor, scene->height / divisor, GL_RGBA16F);
+    drawParticles(lowRes->fbo, lowRes->width, lowRes->height);
+    upsampleParticles(lowRes->texture, scene);
+    mTargetPool->release(lowRes);
+}
+
+bool ComputeParticles::useTemporalUpsample(int divisor) const
+{
+    return mTemporalUpsample && mTemporal && divisor > 1;
+}
+
+// 本帧的子像素抖动只加在UBO中的投影上，粒子更新已经用过未抖动的矩阵；mShaderParams保持不变，
+// 重投影与measureParticlePSNR都使用它
+void ComputeParticles::jitterParticleProjection(int divisor)
+{
+    mTemporal->beginFrame(mShaderParams.ModelViewProjection, mShaderParams.particleScale, mCameraTarget,
+                          mRenderWidth / divisor, mRenderHeight / divisor);
+    
+    glm::mat4 jitter = mTemporal->getJitterMatrix();
+    glm::mat4 matrices[2] = { jitter * mShaderParams.ModelViewProjection, jitter * mShaderParams.ProjectionMatrix };
+    glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(ShaderParams, ModelViewProjection), sizeof(matrices), matrices);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void ComputeParticles::drawParticles(GLuint fbo, int width, int height, bool countOverdraw)
+{
+    // 排序模式必须按完整的排序列表绘制，不走剔除路径
+    bool sorted = mBlendMode != AdditiveBlend;
+    bool culling = mEnableCulling && mCuller && !sorted;
+    // 八边形精灵只用于加性混合(顶点着色器求轨道位置的路径仍画四边形)；剔除时由cullPass.cs写八边形的实例数
+    bool octagons = mOctagonSprites && mSprites.octagon && !sorted && !evaluateOrbitsInVertexShader();
+    if (mCuller) {
+        mCuller->octagonSprites = octagons;
+        mCuller->stochasticLod = mStochasticLod && culling;
+    }
+    if (culling) {
+        mCuller->cull(mParticles, width, height);
+    }
+    
+    PROFILE_GPU_SCOPE("particlePass");
+    mParticleTimer->begin();
+    
+    // 计数只在帧图的粒子pass中打开(OVERDRAW_COUNT变体)，分辨率对比等额外的绘制不计入
+    countOverdraw = countOverdraw && mOverdraw && mOverdrawSprites.quad;
+    const SpritePrograms& progs = countOverdraw ? mOverdrawSprites : mSprites;
+    if (countOverdraw) {
+        mOverdraw->bindCounts();
+    }
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
     glClearColor(0.25f, 0.25f, 0.25f, 1.0f); 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    mRenderProg->enable();
-
     glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    if (sorted) {
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    }
     
     glDisable(GL_DEPTH_TEST);
     glDisable(GL_CULL_FACE);
@@ -397,9 +1132,74 @@ void ComputeParticles::draw(float deltaTime)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mParticles->getIndexBuffer()->getBuffer());
     CHECK_GL_ERROR();
     
-    glDrawElements(GL_TRIANGLES, GLsizei(mParticles->getSize() * 6), GL_UNSIGNED_INT, 0);
-    CHECK_GL_ERROR();
+    if (octagons) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_1D, mFalloffTexture);
+    }
+    
+    if (sorted) {
+        // 排序列表末尾的填充项键值最大，只画前 getSize() 个
+        progs.sorted->enable();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, mSorter->getSortListBuffer());
+        glDrawElements(GL_TRIANGLES, GLsizei(mParticles->getSize() * 6), GL_UNSIGNED_INT, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0);
+        CHECK_GL_ERROR();
+    } else if (culling) {
+        // 实际绘制数量由cullPass.cs写入间接绘制缓冲
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mCuller->getIndirectBuffer());
+        
+        // 随机LOD时每个列表项带有权重，与索引列表一起绑定
+        int weighted = mCuller->stochasticLod ? 1 : 0;
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, mCuller->getQuadListBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 29, mCuller->getQuadWeightBuffer());
+        if (octagons) {
+            progs.octagonList->enable();
+            glUniform1i(progs.octagonList->getUniformLocation("falloffTexture"), 0);
+            glUniform1i(progs.octagonList->getUniformLocation("weightedDrawList"), weighted);
+            glDrawArraysIndirect(GL_TRIANGLE_FAN, (void*)ParticleCuller::octagonCommandOffset);
+        } else {
+            progs.list->enable();
+            glUniform1i(progs.list->getUniformLocation("weightedDrawList"), weighted);
+            glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)ParticleCuller::quadCommandOffset);
+        }
+        CHECK_GL_ERROR();
+        
+        progs.point->enable();
+        glUniform2f(progs.point->getUniformLocation("viewportSize"), (float)width, (float)height);
+        glUniform1i(progs.point->getUniformLocation("weightedDrawList"), weighted);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, mCuller->getPointListBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 29, mCuller->getPointWeightBuffer());
+        glDrawArraysIndirect(GL_POINTS, (void*)ParticleCuller::pointCommandOffset);
+        CHECK_GL_ERROR();
+        
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 29, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    } else if (evaluateOrbitsInVertexShader()) {
+        // 每个顶点解一次开普勒方程，位置缓冲既不写也不读
+        progs.orbit->enable();
+        glUniform1f(progs.orbit->getUniformLocation("orbitTime"), mOrbitTime);
+        glUniform1f(progs.orbit->getUniformLocation("orbitGM"), mOrbits->gm);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, mParticles->getIdBuffer()->getBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 19, mOrbits->getElementBuffer());
+        glDrawElements(GL_TRIANGLES, GLsizei(mParticles->getSize() * 6), GL_UNSIGNED_INT, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 19, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, 0);
+        CHECK_GL_ERROR();
+    } else if (octagons) {
+        progs.octagon->enable();
+        glUniform1i(progs.octagon->getUniformLocation("falloffTexture"), 0);
+        glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 8, GLsizei(mParticles->getSize()));
+        CHECK_GL_ERROR();
+    } else {
+        progs.quad->enable();
+        glDrawElements(GL_TRIANGLES, GLsizei(mParticles->getSize() * 6), GL_UNSIGNED_INT, 0);
+        CHECK_GL_ERROR();
+    }
     
+    if (octagons) {
+        glBindTexture(GL_TEXTURE_1D, 0);
+    }
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     CHECK_GL_ERROR();
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
@@ -407,24 +1207,325 @@ void ComputeParticles::draw(float deltaTime)
 
     glDisable(GL_BLEND);
     
-    mRenderProg->disable();
-
-    renderBloom();
+    glUseProgram(0);
+    
+    mParticleTimer->end();
 }
 
-void ComputeParticles::createScreenQuad()
+// 八边形精灵的衰减表: 纹素i对应到中心距离平方(以四边形半宽为单位) x = i/(N-1) * kFalloffRange，
+// 值为basePass.frag四边形路径的exp(-9x)，低于0.01的截断直接写0，片段着色器不再需要discard
+// 粒子精灵的各个变体共用basePass.verrt/basePass.frag，defines加在每个变体自身的宏之前
+bool ComputeParticles::loadSpritePrograms(SpritePrograms& progs, const std::string& defines)
 {
-    // Create screen quad for post-processing
-    float quadVertices[] = {
-        -1.0f,  1.0f,  0.0f, 1.0f,
-        -1.0f, -1.0f,  0.0f, 0.0f,
-         1.0f, -1.0f,  1.0f, 0.0f,
-        -1.0f,  1.0f,  0.0f, 1.0f,
-         1.0f, -1.0f,  1.0f, 0.0f,
-         1.0f,  1.0f,  1.0f, 1.0f
-    };
+    PROFILE_SCOPE("ComputeParticles::loadSpritePrograms");
     
-    glGenVertexArrays(1, &mScreenQuadVAO);
+    // 加载渲染着色器文件
+    std::ifstream vsFile("assets/shaders/basePass.verrt");
+    if (!vsFile.is_open()) {
+        std::cerr << "错误: 无法打开顶点着色器文件: assets/shaders/basePass.verrt" << std::endl;
+        return false;
+    }
+    std::stringstream vsBuffer;
+    vsBuffer << vsFile.rdbuf();
+    std::string renderVS = vsBuffer.str();
+    vsFile.close();
+    
+    // 加载渲染着色器文件
+    std::ifstream fsFile("assets/shaders/basePass.frag");
+    if (!fsFile.is_open()) {
+        std::cerr << "错误: 无法打开片段着色器文件: assets/shaders/basePass.frag" << std::endl;
+        return false;
+    }
+    std::stringstream fsBuffer;
+    fsBuffer << fsFile.rdbuf();
+    std::string renderFS = fsBuffer.str();
+    fsFile.close();
+    
+    progs.quad = new ShaderProgram();
+    if (!progs.quad->loadFromStrings(injectShaderDefines(renderVS, defines).c_str(),
+                                     injectShaderDefines(renderFS, defines).c_str())) {
+        std::cerr << "错误: 加载渲染着色器失败" << std::endl;
+        return false;
+    }
+    CHECK_GL_ERROR();
+    
+    // 剔除后的绘制: 四边形从压缩索引列表取粒子，亚像素粒子画成单像素点
+    const std::string drawListDefines = defines + "#define USE_DRAW_LIST\n";
+    const std::string pointDefines = defines + "#define USE_DRAW_LIST\n#define POINT_SPRITE\n";
+    
+    progs.list = new ShaderProgram();
+    if (!progs.list->loadFromStrings(injectShaderDefines(renderVS, drawListDefines).c_str(),
+                                     injectShaderDefines(renderFS, drawListDefines).c_str())) {
+        std::cerr << "错误: 加载剔除渲染着色器失败" << std::endl;
+        return false;
+    }
+    
+    progs.point = new ShaderProgram();
+    if (!progs.point->loadFromStrings(injectShaderDefines(renderVS, pointDefines).c_str(),
+                                      injectShaderDefines(renderFS, pointDefines).c_str())) {
+        std::cerr << "错误: 加载点精灵着色器失败" << std::endl;
+        return false;
+    }
+    
+    // 排序后的"over"混合: 按sortPass.cs输出的顺序由远及近绘制
+    const std::string sortedDefines = defines + "#define SORTED_DRAW_LIST\n#define OVER_BLEND\n";
+    
+    progs.sorted = new ShaderProgram();
+    if (!progs.sorted->loadFromStrings(injectShaderDefines(renderVS, sortedDefines).c_str(),
+                                       injectShaderDefines(renderFS, sortedDefines).c_str())) {
+        std::cerr << "错误: 加载排序渲染着色器失败" << std::endl;
+        return false;
+    }
+    CHECK_GL_ERROR();
+    
+    // 八边形精灵: 每个实例一个粒子的8顶点三角扇，失败时退回四边形
+    const std::string octagonDefines = defines + "#define OCTAGON_SPRITE\n";
+    const std::string octagonListDefines = defines + "#define OCTAGON_SPRITE\n#define USE_DRAW_LIST\n";
+    progs.octagon = new ShaderProgram();
+    progs.octagonList = new ShaderProgram();
+    if (!progs.octagon->loadFromStrings(injectShaderDefines(renderVS, octagonDefines).c_str(),
+                                        injectShaderDefines(renderFS, octagonDefines).c_str()) ||
+        !progs.octagonList->loadFromStrings(injectShaderDefines(renderVS, octagonListDefines).c_str(),
+                                            injectShaderDefines(renderFS, octagonListDefines).c_str())) {
+        std::cerr << "错误: 加载八边形精灵着色器失败" << std::endl;
+        delete progs.octagon;
+        delete progs.octagonList;
+        progs.octagon = nullptr;
+        progs.octagonList = nullptr;
+    }
+    CHECK_GL_ERROR();
+    
+    // 轨道模式: 顶点着色器直接由轨道根数求位置；失败时轨道模式总是走orbitPass.cs
+    const std::string orbitDefines = defines + "#define KEPLER_ORBITS\n";
+    std::string orbitVS = KeplerOrbits::insertOrbitCode(renderVS);
+    progs.orbit = new ShaderProgram();
+    if (orbitVS.empty() || !progs.orbit->loadFromStrings(injectShaderDefines(orbitVS, orbitDefines).c_str(),
+                                                         injectShaderDefines(renderFS, orbitDefines).c_str())) {
+        std::cerr << "错误: 加载轨道渲染着色器失败" << std::endl;
+        delete progs.orbit;
+        progs.orbit = nullptr;
+    }
+    CHECK_GL_ERROR();
+    return true;
+}
+
+void ComputeParticles::destroySpritePrograms(SpritePrograms& progs)
+{
+    ShaderProgram** programs[] = { &progs.quad, &progs.list, &progs.point, &progs.sorted, &progs.orbit,
+                                   &progs.octagon, &progs.octagonList };
+    for (ShaderProgram** prog : programs) {
+        if (*prog) {
+            delete *prog;
+            *prog = nullptr;
+        }
+    }
+}
+
+void ComputeParticles::createFalloffTexture()
+{
+    // 与basePass.frag的FALLOFF_SIZE/FALLOFF_RANGE一致，范围到八边形顶点
+    const int kFalloffSize = 64;
+    const float kFalloffRange = 0.5995f;
+    
+    float table[kFalloffSize];
+    for (int i = 0; i < kFalloffSize; i++) {
+        float x = (float)i / (kFalloffSize - 1) * kFalloffRange;
+        float falloff = expf(-9.0f * x);
+        table[i] = falloff < 0.01f ? 0.0f : falloff;
+    }
+    
+    glGenTextures(1, &mFalloffTexture);
+    glBindTexture(GL_TEXTURE_1D, mFalloffTexture);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_R32F, kFalloffSize, 0, GL_RED, GL_FLOAT, table);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_1D, 0);
+}
+
+bool ComputeParticles::readParticleStatistics(GLuint64& vertices, GLuint64& primitives, GLuint64& fragments)
+{
+    PipelineStatistics::Counts counts;
+    if (!mFrameGraph || !mFrameGraph->getPassStatistics("particlePass", counts, true)) {
+        return false;
+    }
+    vertices = counts.vertices;
+    primitives = counts.primitives;
+    fragments = counts.fragments;
+    return true;
+}
+
+bool ComputeParticles::readCullCounts(unsigned int& sprites, unsigned int& points)
+{
+    if (!mCuller || !mEnableCulling || mBlendMode != AdditiveBlend) {
+        return false;
+    }
+    CullDrawCommands commands = mCuller->readCommands();
+    sprites = mCuller->octagonSprites ? commands.octagons.instanceCount : commands.quads.count / 6;
+    points = commands.points.count;
+    return true;
+}
+
+bool ComputeParticles::evaluateOrbitsInVertexShader() const
+{
+    bool culling = mEnableCulling && mCuller;
+    return mParticleState == Orbit && mSprites.orbit && !culling && mBlendMode == AdditiveBlend;
+}
+
+void ComputeParticles::upsampleParticles(GLuint lowResTexture, RenderTarget* scene)
+{
+    PROFILE_GPU_SCOPE("particleUpsample");
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, scene->fbo);
+    glViewport(0, 0, scene->width, scene->height);
+    
+    mParticleUpsampleProg->enable();
+    glUniform1i(mParticleUpsampleProg->getUniformLocation("lowResTexture"), 0);
+    
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, lowResTexture);
+    
+    glBindVertexArray(mScreenQuadVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+    
+    mParticleUpsampleProg->disable();
+    CHECK_GL_ERROR();
+}
+
+int ComputeParticles::chooseParticleDivisor()
+{
+    switch (mParticleResolution) {
+        case FullResolution:    return 1;
+        case HalfResolution:    return 2;
+        case QuarterResolution: return 4;
+        default: break;
+    }
+    
+    // 填充耗时近似与像素数成正比: 超出预算则降一档，
+    // 升一档后(像素数x4)仍明显低于预算才升档，两侧阈值留出迟滞避免来回切换
+    if (mAutoCooldown > 0) {
+        mAutoCooldown--;
+    } else if (mParticleTimer->getSampleCount() >= 8) {
+        float ms = mParticleTimer->getAverageMs();
+        int divisor = mAutoDivisor;
+        if (ms > mParticleBudgetMs && divisor < 4) {
+            divisor *= 2;
+        } else if (divisor > 1 && ms * 4.0f < mParticleBudgetMs * 0.7f) {
+            divisor /= 2;
+        }
+        
+        if (divisor != mAutoDivisor) {
+            std::cout << "Auto particle resolution: 1/" << divisor
+                      << " (fill " << ms << " ms, budget " << mParticleBudgetMs << " ms)" << std::endl;
+            mAutoDivisor = divisor;
+            mAutoCooldown = 30;
+            mParticleTimer->reset();
+        }
+    }
+    return mAutoDivisor;
+}
+
+static void readTextureRGBA(GLuint texture, int width, int height, std::vector<float>& out)
+{
+    out.resize((size_t)width * height * 4);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, out.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// 按显示时的[0,1]截断计算RGB的PSNR
+static double computePSNR(const std::vector<float>& a, const std::vector<float>& b)
+{
+    double mse = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < a.size(); i += 4) {
+        for (int c = 0; c < 3; c++) {
+            double d = glm::clamp(a[i + c], 0.0f, 1.0f) - glm::clamp(b[i + c], 0.0f, 1.0f);
+            mse += d * d;
+            count++;
+        }
+    }
+    mse /= std::max<size_t>(count, 1);
+    return mse > 0.0 ? 10.0 * log10(1.0 / mse) : 99.0;
+}
+
+void ComputeParticles::reportParticleResolution()
+{
+    if (!mParticleUpsampleProg) return;
+    
+    // 同一帧粒子分别以全分辨率、1/2、1/4绘制，比较GPU耗时(含上采样)和相对全分辨率的PSNR
+    const int runs = 8;
+    RenderTarget* scene = mFrameGraph->getTarget(mSceneHandle);
+    std::vector<float> reference, image;
+    GpuTimer timer;
+    float fullMs = 0.0f;
+    
+    std::cout << "Particle resolution report (" << mRenderWidth << "x" << mRenderHeight << "):" << std::endl;
+    for (int divisor = 1; divisor <= 4; divisor *= 2) {
+        timer.reset();
+        for (int run = 0; run < runs; run++) {
+            timer.begin();
+            renderParticlesAt(divisor, scene);
+            timer.end();
+        }
+        timer.finish();
+        
+        float ms = timer.getAverageMs();
+        if (divisor == 1) {
+            fullMs = ms;
+            readTextureRGBA(scene->texture, scene->width, scene->height, reference);
+            std::cout << "  1/1  " << ms << " ms" << std::endl;
+        } else {
+            readTextureRGBA(scene->texture, scene->width, scene->height, image);
+            std::cout << "  1/" << divisor << "  " << ms << " ms  (" << (ms > 0.0f ? fullMs / ms : 0.0f)
+                      << "x)  PSNR " << computePSNR(reference, image) << " dB" << std::endl;
+        }
+    }
+    mParticleTimer->reset();
+}
+
+float ComputeParticles::measureParticlePSNR(bool quadReference)
+{
+    RenderTarget* scene = mFrameGraph->getTarget(mSceneHandle);
+    if (!scene) return 0.0f;
+    
+    std::vector<float> reference, image;
+    readTextureRGBA(scene->texture, scene->width, scene->height, image);
+    
+    glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShaderParams), &mShaderParams);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    
+    // 参考帧绘制全部粒子，不做随机LOD
+    bool octagonSprites = mOctagonSprites;
+    bool stochasticLod = mStochasticLod;
+    mOctagonSprites = mOctagonSprites && !quadReference;
+    mStochasticLod = false;
+    RenderTarget* native = mTargetPool->acquire(scene->width, scene->height, GL_RGBA16F);
+    drawParticles(native->fbo, native->width, native->height);
+    mOctagonSprites = octagonSprites;
+    mStochasticLod = stochasticLod;
+    readTextureRGBA(native->texture, native->width, native->height, reference);
+    mTargetPool->release(native);
+    mParticleTimer->reset();
+    
+    return (float)computePSNR(reference, image);
+}
+
+void ComputeParticles::createScreenQuad()
+{
+    // Create screen quad for post-processing
+    float quadVertices[] = {
+        -1.0f,  1.0f,  0.0f, 1.0f,
+        -1.0f, -1.0f,  0.0f, 0.0f,
+         1.0f, -1.0f,  1.0f, 0.0f,
+        -1.0f,  1.0f,  0.0f, 1.0f,
+         1.0f, -1.0f,  1.0f, 0.0f,
+         1.0f,  1.0f,  1.0f, 1.0f
+    };
+    
+    glGenVertexArrays(1, &mScreenQuadVAO);
     glGenBuffers(1, &mScreenQuadVBO);
     
     glBindVertexArray(mScreenQuadVAO);
@@ -440,9 +1541,10 @@ void ComputeParticles::createScreenQuad()
     CHECK_GL_ERROR();
 }
 
-void ComputeParticles::initBloomResources()
+// 程序与屏幕四边形只在init中创建一次，与渲染目标的生命周期无关
+void ComputeParticles::loadPostProcessShaders()
 {
-    if (mWidth <= 0 || mHeight <= 0) return;
+    PROFILE_SCOPE("ComputeParticles::loadPostProcessShaders");
     
     createScreenQuad();
     
@@ -509,122 +1611,34 @@ void ComputeParticles::initBloomResources()
         return;
     }
     
-    CHECK_GL_ERROR();
-    
-    glGenFramebuffers(1, &mSceneFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, mSceneFBO);
-    
-    glGenTextures(1, &mSceneTexture);
-    glBindTexture(GL_TEXTURE_2D, mSceneTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mWidth, mHeight, 0, GL_RGBA, GL_FLOAT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mSceneTexture, 0);
-    
-    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-    if (status != GL_FRAMEBUFFER_COMPLETE) {
-        std::cerr << "错误: 场景FBO创建不完整: " << status << std::endl;
+    // 融合链: 同一着色器的变体，缺失时该路径退回普通片元链
+    std::string fusedDownsampleFS = injectShaderDefines(downsampleFS, "#define BLOOM_FUSED_EXTRACT\n");
+    std::string fusedUpsampleFS = injectShaderDefines(upsampleFS, "#define BLOOM_FUSED_COMBINE\n");
+    mBloomFusedDownsampleProg = new ShaderProgram();
+    mBloomFusedUpsampleProg = new ShaderProgram();
+    if (!mBloomFusedDownsampleProg->loadFromStrings(extractVS.c_str(), fusedDownsampleFS.c_str()) ||
+        !mBloomFusedUpsampleProg->loadFromStrings(extractVS.c_str(), fusedUpsampleFS.c_str())) {
+        std::cerr << "错误: 加载融合Bloom着色器失败" << std::endl;
+        delete mBloomFusedDownsampleProg;
+        delete mBloomFusedUpsampleProg;
+        mBloomFusedDownsampleProg = nullptr;
+        mBloomFusedUpsampleProg = nullptr;
     }
     
-    CHECK_GL_ERROR();
-    
-    int bloomWidth = mWidth;
-    int bloomHeight = mHeight;
-    for (int i = 0; i < 4; i++) {
-        if (i > 0) {
-            bloomWidth /= 2;
-            bloomHeight /= 2;
-        }
-        
-        glGenFramebuffers(1, &mBloomFBO[i]);
-        glBindFramebuffer(GL_FRAMEBUFFER, mBloomFBO[i]);
-        
-        glGenTextures(1, &mBloomTexture[i]);
-        glBindTexture(GL_TEXTURE_2D, mBloomTexture[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, bloomWidth, bloomHeight, 0, GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mBloomTexture[i], 0);
-        
-        status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE) {
-            std::cerr << "错误: Bloom降采样FBO " << i << " 创建不完整: " << status << std::endl;
-        }
+    std::string particleUpsampleFS = readShaderFile("assets/shaders/particleUpsampleFS.glsl");
+    mParticleUpsampleProg = new ShaderProgram();
+    if (particleUpsampleFS.empty() ||
+        !mParticleUpsampleProg->loadFromStrings(extractVS.c_str(), particleUpsampleFS.c_str())) {
+        std::cerr << "错误: 加载粒子上采样着色器失败" << std::endl;
+        delete mParticleUpsampleProg;
+        mParticleUpsampleProg = nullptr;
     }
     
-    // 创建Bloom上采样FBO和纹理
-    // upsample[0]: 1/4分辨率
-    // upsample[1]: 1/2分辨率
-    // upsample[2]: 全分辨率
-    for (int i = 0; i < 3; i++) {
-        int level = 2 - i;
-        int width = mWidth >> (level + 1);
-        int height = mHeight >> (level + 1);
-        
-        if (level == 0) {
-            width = mWidth;
-            height = mHeight;
-        }
-        
-        glGenFramebuffers(1, &mBloomUpsampleFBO[i]);
-        glBindFramebuffer(GL_FRAMEBUFFER, mBloomUpsampleFBO[i]);
-        
-        glGenTextures(1, &mBloomUpsampleTexture[i]);
-        glBindTexture(GL_TEXTURE_2D, mBloomUpsampleTexture[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mBloomUpsampleTexture[i], 0);
-
-        status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE) {
-            std::cerr << "错误: Bloom上采样FBO " << i << " 创建不完整: " << status << std::endl;
-        }
-    }
-    
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
     CHECK_GL_ERROR();
 }
 
-void ComputeParticles::destroyBloomResources()
+void ComputeParticles::destroyPostProcessShaders()
 {
-    if (mSceneFBO) {
-        glDeleteFramebuffers(1, &mSceneFBO);
-        mSceneFBO = 0;
-    }
-    if (mSceneTexture) {
-        glDeleteTextures(1, &mSceneTexture);
-        mSceneTexture = 0;
-    }
-    
-    for (int i = 0; i < 4; i++) {
-        if (mBloomFBO[i]) {
-            glDeleteFramebuffers(1, &mBloomFBO[i]);
-            mBloomFBO[i] = 0;
-        }
-        if (mBloomTexture[i]) {
-            glDeleteTextures(1, &mBloomTexture[i]);
-            mBloomTexture[i] = 0;
-        }
-    }
-    
-    for (int i = 0; i < 3; i++) {
-        if (mBloomUpsampleFBO[i]) {
-            glDeleteFramebuffers(1, &mBloomUpsampleFBO[i]);
-            mBloomUpsampleFBO[i] = 0;
-        }
-        if (mBloomUpsampleTexture[i]) {
-            glDeleteTextures(1, &mBloomUpsampleTexture[i]);
-            mBloomUpsampleTexture[i] = 0;
-        }
-    }
-
     if (mBloomExtractProg) {
         delete mBloomExtractProg;
         mBloomExtractProg = nullptr;
@@ -641,6 +1655,18 @@ void ComputeParticles::destroyBloomResources()
         delete mBloomCombineProg;
         mBloomCombineProg = nullptr;
     }
+    if (mBloomFusedDownsampleProg) {
+        delete mBloomFusedDownsampleProg;
+        mBloomFusedDownsampleProg = nullptr;
+    }
+    if (mBloomFusedUpsampleProg) {
+        delete mBloomFusedUpsampleProg;
+        mBloomFusedUpsampleProg = nullptr;
+    }
+    if (mParticleUpsampleProg) {
+        delete mParticleUpsampleProg;
+        mParticleUpsampleProg = nullptr;
+    }
     
     if (mScreenQuadVAO) {
         glDeleteVertexArrays(1, &mScreenQuadVAO);
@@ -652,94 +1678,274 @@ void ComputeParticles::destroyBloomResources()
     }
 }
 
-void ComputeParticles::renderBloom()
+// 渲染目标尺寸变化时帧图在下一帧重建，目标由帧图从池中取用
+void ComputeParticles::setRenderSize(int width, int height)
 {
-    if (!mBloomExtractProg || !mBloomDownsampleProg || !mBloomUpsampleProg || !mBloomCombineProg) {
+    if (width <= 0 || height <= 0) return;
+    if (width == mRenderWidth && height == mRenderHeight) return;
+    
+    mRenderWidth = width;
+    mRenderHeight = height;
+    mFrameGraph->reset();
+    if (mComputeBloom) {
+        mComputeBloom->resize(width, height);
+    }
+    if (mBloomTiles) {
+        mBloomTiles->resize(width, height);
+    }
+    if (mTemporal) {
+        mTemporal->resize(width, height);
+    }
+}
+
+// 场景与后处理的全部pass。两种Bloom都声明，合成只读取当前选择的一种，另一种由帧图整条裁剪
+void ComputeParticles::buildFrameGraph(int divisor)
+{
+    PROFILE_SCOPE("ComputeParticles::buildFrameGraph");
+    
+    FrameGraph& graph = *mFrameGraph;
+    graph.reset();
+    mFrameGraphDivisor = divisor;
+    mFrameGraphBloomPath = mBloomPath;
+    
+    const int w = mRenderWidth;
+    const int h = mRenderHeight;
+    typedef FrameGraph::TextureDesc Desc;
+    
+    // 粒子以混合方式累加，保留RGBA16F；Bloom各级只整体写一次，不需要alpha
+    FrameGraph::Handle scene = graph.createTexture("scene", Desc(w, h, false, true));
+    FrameGraph::Handle backbuffer = graph.importResource("backbuffer", true);
+    FrameGraph::Handle computeChain = graph.importResource("computeBloomChain", false);
+    FrameGraph::Handle tiles = graph.importResource("bloomTiles", false);
+    FrameGraph::Handle exposure = graph.importResource("exposure", false);
+    mSceneHandle = scene;
+    
+    // overdraw视图: 粒子pass同时写计数图像，最后由热力图覆盖合成结果
+    bool overdraw = mOverdrawView && mOverdraw;
+    FrameGraph::Handle overdrawCounts = overdraw ? graph.importResource("overdrawCounts", false) : FrameGraph::kInvalid;
+    
+    if (divisor == 1 || !mParticleUpsampleProg) {
+        if (overdraw) {
+            mOverdraw->resize(w, h);
+        }
+        graph.addPass("particlePass", {}, { scene, overdrawCounts }, [this, scene, overdraw]() {
+            RenderTarget* target = mFrameGraph->getTarget(scene);
+            drawParticles(target->fbo, target->width, target->height, overdraw);
+        });
+    } else {
+        FrameGraph::Handle lowRes = graph.createTexture("particlesLowRes", Desc(w / divisor, h / divisor, false, true));
+        if (overdraw) {
+            mOverdraw->resize(std::max(w / divisor, 1), std::max(h / divisor, 1));
+        }
+        graph.addPass("particlePass", {}, { lowRes, overdrawCounts }, [this, lowRes, overdraw]() {
+            RenderTarget* target = mFrameGraph->getTarget(lowRes);
+            drawParticles(target->fbo, target->width, target->height, overdraw);
+        });
+        if (useTemporalUpsample(divisor)) {
+            // 历史缓冲由TemporalUpsample持有，跨帧保留
+            FrameGraph::Handle history = graph.importResource("particleHistory", false);
+            graph.addPass("particleTemporal", { lowRes }, { scene, history }, [this, lowRes, scene]() {
+                mTemporal->resolve(mFrameGraph->getTarget(lowRes)->texture, mFrameGraph->getTarget(scene)->texture);
+            });
+        } else {
+            graph.addPass("particleUpsample", { lowRes }, { scene }, [this, lowRes, scene]() {
+                upsampleParticles(mFrameGraph->getTarget(lowRes)->texture, mFrameGraph->getTarget(scene));
+            });
+        }
+    }
+    // 有几帧没有做时间重建(例如自动分辨率回到全分辨率)，历史已经过时
+    if (!useTemporalUpsample(divisor) && mTemporal) {
+        mTemporal->reset();
+    }
+    
+    // 自动曝光: 由场景更新曝光缓冲，之后提取与合成的pass读取它；关闭时缓冲固定为1.0，此pass不声明
+    FrameGraph::Handle exposureRead = FrameGraph::kInvalid;
+    if (mAutoExposureEnabled) {
+        exposureRead = exposure;
+        graph.addPass("autoExposure", { scene }, { exposure }, [this, scene]() {
+            RenderTarget* target = mFrameGraph->getTarget(scene);
+            mAutoExposure->update(target->texture, target->width, target->height, mFrameDeltaTime);
+        });
+    }
+    
+    // 片元着色器链: 提取 -> 3次降采样 -> 3次双边上采样
+    // bloom[i]为1/2^i分辨率；upsample[0] 1/8、upsample[1] 1/4、upsample[2] 全分辨率
+    static const char* bloomNames[4] = { "bloom0", "bloom1", "bloom2", "bloom3" };
+    static const char* upsampleNames[3] = { "bloomUpsample0", "bloomUpsample1", "bloomUpsample2" };
+    FrameGraph::Handle bloom[4];
+    FrameGraph::Handle upsample[3];
+    for (int i = 0; i < 4; i++) {
+        bloom[i] = graph.createTexture(bloomNames[i], Desc(w >> i, h >> i));
+    }
+    for (int i = 0; i < 3; i++) {
+        int level = 2 - i;
+        int shift = level == 0 ? 0 : level + 1;
+        upsample[i] = graph.createTexture(upsampleNames[i], Desc(w >> shift, h >> shift));
+    }
+    
+    // 稀疏路径: 先分类出活动块，片元链各pass只绘制这些块
+    bool sparse = mBloomPath == SparseTileBloom;
+    FrameGraph::Handle tileList = FrameGraph::kInvalid;
+    if (sparse) {
+        tileList = tiles;
+        graph.addPass("bloomClassify", { scene, exposureRead }, { tiles }, [this, scene]() {
+            mBloomTiles->classify(mFrameGraph->getTarget(scene)->texture, mBloomThreshold);
+        });
+    }
+    
+    // 融合路径: 第一次降采样直接读取场景并逐纹素提取，最后一次上采样读取场景作细节并直接合成到默认帧缓冲，
+    // bloom0与bloomUpsample2两张全分辨率纹理以及提取、合成两个全屏pass随之消失
+    bool fused = mBloomPath == FusedChainBloom && mBloomFusedDownsampleProg && mBloomFusedUpsampleProg;
+    if (fused) {
+        graph.addPass("bloomFusedDownsample", { scene, exposureRead }, { bloom[1] }, [this, scene, bloom]() {
+            bloomFusedDownsamplePass(mFrameGraph->getTarget(scene)->texture, mFrameGraph->getTarget(bloom[1]));
+        });
+    } else {
+        graph.addPass("bloomExtract", { scene, tileList, exposureRead }, { bloom[0] }, [this, scene, bloom, sparse]() {
+            bloomExtractPass(mFrameGraph->getTarget(scene)->texture, mFrameGraph->getTarget(bloom[0]), sparse);
+        });
+    }
+    for (int i = fused ? 1 : 0; i < 3; i++) {
+        FrameGraph::Handle src = bloom[i], dst = bloom[i + 1];
+        graph.addPass("bloomDownsample", { src, tileList }, { dst }, [this, src, dst, sparse]() {
+            bloomDownsamplePass(mFrameGraph->getTarget(src)->texture, mFrameGraph->getTarget(dst), sparse);
+        });
+    }
+    for (int i = 0; i < 3; i++) {
+        // 第一次从最低分辨率开始，之后从上一次的结果；细节来自同级的bloom
+        FrameGraph::Handle low = i == 0 ? bloom[3] : upsample[i - 1];
+        FrameGraph::Handle high = bloom[2 - i];
+        FrameGraph::Handle dst = upsample[i];
+        if (fused && i == 2) {
+            graph.addPass("bloomFusedUpsample", { low, scene, exposureRead }, { backbuffer }, [this, low, scene]() {
+                bloomFusedUpsamplePass(mFrameGraph->getTarget(low)->texture, mFrameGraph->getTarget(scene)->texture);
+            });
+            break;
+        }
+        graph.addPass("bloomUpsample", { low, high, tileList }, { dst }, [this, low, high, dst, sparse]() {
+            bloomUpsamplePass(mFrameGraph->getTarget(low)->texture, mFrameGraph->getTarget(high)->texture,
+                              mFrameGraph->getTarget(dst), sparse);
+        });
+    }
+    
+    graph.addPass("computeBloom", { scene, exposureRead }, { computeChain }, [this, scene]() {
+        mComputeBloom->render(mFrameGraph->getTarget(scene)->texture);
+    });
+    
+    if (!fused) {
+        bool computeBloom = mBloomPath == ComputeMipBloom;
+        FrameGraph::Handle bloomResult = computeBloom ? computeChain : upsample[2];
+        graph.addPass("bloomCombine", { scene, bloomResult, exposureRead }, { backbuffer }, [this, scene, bloomResult, computeBloom]() {
+            GLuint bloomTexture = computeBloom ? mComputeBloom->getBloomTexture() : mFrameGraph->getTarget(bloomResult)->texture;
+            bloomCombinePass(mFrameGraph->getTarget(scene)->texture, bloomTexture);
+        });
+    }
+    
+    if (overdraw) {
+        graph.addPass("overdrawView", { overdrawCounts }, { backbuffer }, [this]() {
+            mOverdraw->resolve(mWidth, mHeight);
+        });
+    }
+    
+    graph.compile();
+    CHECK_GL_ERROR();
+}
+
+void ComputeParticles::drawScreenQuad()
+{
+    glBindVertexArray(mScreenQuadVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+}
+
+// Bloom各级清零而非清为背景色: 稀疏路径下活动块之外的像素保持清屏值
+static const GLfloat kBloomClearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+// 全屏四边形，或稀疏路径下每个活动块一个四边形(块之外由清屏置零)
+void ComputeParticles::drawBloomGeometry(ShaderProgram* prog, bool sparse)
+{
+    glUniform1i(prog->getUniformLocation("tiled"), sparse ? 1 : 0);
+    if (!sparse) {
+        drawScreenQuad();
         return;
     }
     
+    glUniform2f(prog->getUniformLocation("tileSize"), mBloomTiles->getTileSizeU(), mBloomTiles->getTileSizeV());
+    glBindVertexArray(mScreenQuadVAO);
+    mBloomTiles->draw();
+    glBindVertexArray(0);
+}
+
+void ComputeParticles::bloomExtractPass(GLuint sceneTexture, RenderTarget* dst, bool sparse)
+{
+    if (!mBloomExtractProg) return;
+    
     glDisable(GL_DEPTH_TEST);
     glDisable(GL_BLEND);
-    
-    glBindFramebuffer(GL_FRAMEBUFFER, mBloomFBO[0]);
-    glViewport(0, 0, mWidth, mHeight);
-    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, dst->fbo);
+    glViewport(0, 0, dst->width, dst->height);
+    glClearBufferfv(GL_COLOR, 0, kBloomClearColor);
     
     mBloomExtractProg->enable();
     glUniform1i(mBloomExtractProg->getUniformLocation("sceneTexture"), 0);
-    glUniform1f(mBloomExtractProg->getUniformLocation("threshold"), 1.2f);
+    glUniform1f(mBloomExtractProg->getUniformLocation("threshold"), mBloomThreshold);
     
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, mSceneTexture);
-    
-    glBindVertexArray(mScreenQuadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, sceneTexture);
+    drawBloomGeometry(mBloomExtractProg, sparse);
     
     mBloomExtractProg->disable();
+}
+
+void ComputeParticles::bloomDownsamplePass(GLuint srcTexture, RenderTarget* dst, bool sparse)
+{
+    if (!mBloomDownsampleProg) return;
     
-    for (int i = 0; i < 3; i++) {
-        int width = mWidth >> (i + 1);
-        int height = mHeight >> (i + 1);
-        
-        glBindFramebuffer(GL_FRAMEBUFFER, mBloomFBO[i + 1]);
-        glViewport(0, 0, width, height);
-        glClear(GL_COLOR_BUFFER_BIT);
-        
-        mBloomDownsampleProg->enable();
-        glUniform1i(mBloomDownsampleProg->getUniformLocation("inputTexture"), 0);
-        
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, mBloomTexture[i]);
-        
-        glBindVertexArray(mScreenQuadVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
-        
-        mBloomDownsampleProg->disable();
-    }
+    glBindFramebuffer(GL_FRAMEBUFFER, dst->fbo);
+    glViewport(0, 0, dst->width, dst->height);
+    glClearBufferfv(GL_COLOR, 0, kBloomClearColor);
+    
+    mBloomDownsampleProg->enable();
+    glUniform1i(mBloomDownsampleProg->getUniformLocation("inputTexture"), 0);
+    
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, srcTexture);
+    drawBloomGeometry(mBloomDownsampleProg, sparse);
+    
+    mBloomDownsampleProg->disable();
+}
 
-    for (int i = 0; i < 3; i++) {
-        int level = 2 - i;  // Levels: 2, 1, 0
-        int width, height;
-        if (level == 0) {
-            width = mWidth;
-            height = mHeight;
-        } else {
-            width = mWidth >> (level + 1);
-            height = mHeight >> (level + 1);
-        }
-        
-        glBindFramebuffer(GL_FRAMEBUFFER, mBloomUpsampleFBO[i]);
-        glViewport(0, 0, width, height);
-        glClear(GL_COLOR_BUFFER_BIT);
-        
-        mBloomUpsampleProg->enable();
-        glUniform1i(mBloomUpsampleProg->getUniformLocation("lowResTexture"), 0);
-        glUniform1i(mBloomUpsampleProg->getUniformLocation("highResTexture"), 1);
-        glm::vec2 texelSize(1.0f / width, 1.0f / height);
-        glUniform2fv(mBloomUpsampleProg->getUniformLocation("texelSize"), 1, &texelSize[0]);
-        
-        glActiveTexture(GL_TEXTURE0);
-        if (i == 0) {
-            // First upsampling: start from lowest resolution
-            glBindTexture(GL_TEXTURE_2D, mBloomTexture[3]);
-        } else {
-            // Subsequent upsampling
-            glBindTexture(GL_TEXTURE_2D, mBloomUpsampleTexture[i - 1]);
-        }
-        
-        glActiveTexture(GL_TEXTURE1);
-        // High-res detail from bloom level
-        glBindTexture(GL_TEXTURE_2D, mBloomTexture[level]);
-        
-        glBindVertexArray(mScreenQuadVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
-        
-        mBloomUpsampleProg->disable();
-    }
+void ComputeParticles::bloomUpsamplePass(GLuint lowResTexture, GLuint highResTexture, RenderTarget* dst, bool sparse)
+{
+    if (!mBloomUpsampleProg) return;
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, dst->fbo);
+    glViewport(0, 0, dst->width, dst->height);
+    glClearBufferfv(GL_COLOR, 0, kBloomClearColor);
     
+    mBloomUpsampleProg->enable();
+    glUniform1i(mBloomUpsampleProg->getUniformLocation("lowResTexture"), 0);
+    glUniform1i(mBloomUpsampleProg->getUniformLocation("highResTexture"), 1);
+    glm::vec2 texelSize(1.0f / dst->width, 1.0f / dst->height);
+    glUniform2fv(mBloomUpsampleProg->getUniformLocation("texelSize"), 1, &texelSize[0]);
+    
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, lowResTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, highResTexture);
+    drawBloomGeometry(mBloomUpsampleProg, sparse);
+    
+    mBloomUpsampleProg->disable();
+}
+
+void ComputeParticles::bloomCombinePass(GLuint sceneTexture, GLuint bloomTexture)
+{
+    PROFILE_SCOPE("ComputeParticles::bloomCombinePass");
+    
+    if (!mBloomCombineProg) return;
+    
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(0, 0, mWidth, mHeight);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -750,15 +1956,54 @@ void ComputeParticles::renderBloom()
     glUniform1f(mBloomCombineProg->getUniformLocation("bloomIntensity"), 0.3f);
     
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, mSceneTexture);
+    glBindTexture(GL_TEXTURE_2D, sceneTexture);
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, mBloomUpsampleTexture[2]);
-    
-    glBindVertexArray(mScreenQuadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, bloomTexture);
+    drawScreenQuad();
     
     mBloomCombineProg->disable();
+    glActiveTexture(GL_TEXTURE0);
+    CHECK_GL_ERROR();
+}
+
+// 融合链的第一次降采样: 由场景直接生成1/2分辨率的bloom1，着色器内逐纹素提取
+void ComputeParticles::bloomFusedDownsamplePass(GLuint sceneTexture, RenderTarget* dst)
+{
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glBindFramebuffer(GL_FRAMEBUFFER, dst->fbo);
+    glViewport(0, 0, dst->width, dst->height);
+    
+    mBloomFusedDownsampleProg->enable();
+    glUniform1i(mBloomFusedDownsampleProg->getUniformLocation("inputTexture"), 0);
+    glUniform1f(mBloomFusedDownsampleProg->getUniformLocation("threshold"), mBloomThreshold);
+    
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sceneTexture);
+    drawBloomGeometry(mBloomFusedDownsampleProg, false);
+    
+    mBloomFusedDownsampleProg->disable();
+}
+
+// 融合链的最后一次上采样: 细节取自场景的提取结果，与场景合成后直接写默认帧缓冲
+void ComputeParticles::bloomFusedUpsamplePass(GLuint lowResTexture, GLuint sceneTexture)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, mWidth, mHeight);
+    
+    mBloomFusedUpsampleProg->enable();
+    glUniform1i(mBloomFusedUpsampleProg->getUniformLocation("lowResTexture"), 0);
+    glUniform1i(mBloomFusedUpsampleProg->getUniformLocation("highResTexture"), 1);
+    glUniform1f(mBloomFusedUpsampleProg->getUniformLocation("threshold"), mBloomThreshold);
+    glUniform1f(mBloomFusedUpsampleProg->getUniformLocation("bloomIntensity"), 0.3f);
     
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, lowResTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, sceneTexture);
+    drawBloomGeometry(mBloomFusedUpsampleProg, false);
+    
+    mBloomFusedUpsampleProg->disable();
+    glActiveTexture(GL_TEXTURE0);
     CHECK_GL_ERROR();
 }
@@ -0,0 +1,240 @@
+#include "FluidSolver.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 与fluidPass.cs的工作组大小一致
+static const int kGroupX = 8;
+static const int kGroupY = 8;
+static const int kGroupZ = 4;
+
+static GLuint createVolume(int size, GLenum internalFormat)
+{
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_3D, tex);
+    glTexStorage3D(GL_TEXTURE_3D, 1, internalFormat, size, size, size);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    // glClearTexImage需要GL 4.4，这里直接上传零
+    std::vector<float> zeros((size_t)size * size * size * 4, 0.0f);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, size, size, size, GL_RGBA, GL_FLOAT, zeros.data());
+    glBindTexture(GL_TEXTURE_3D, 0);
+    return tex;
+}
+
+FluidSolver::FluidSolver(int gridSize, const char* shaderPrefix) :
+    domainExtent(1.5f),
+    jacobiIterations(20),
+    dissipation(0.995f),
+    vorticity(0.3f),
+    jetStrength(0.0004f),
+    m_gridSize(gridSize),
+    m_current(0),
+    m_pressureCurrent(0),
+    m_vorticity(0),
+    m_divergence(0),
+    m_advectProg(0),
+    m_curlProg(0),
+    m_confineProg(0),
+    m_divergenceProg(0),
+    m_jacobiProg(0),
+    m_projectProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    m_velocity[0] = m_velocity[1] = 0;
+    m_pressure[0] = m_pressure[1] = 0;
+
+    createTextures();
+    loadShaders();
+}
+
+FluidSolver::~FluidSolver()
+{
+    destroyTextures();
+
+    GLuint programs[] = { m_advectProg, m_curlProg, m_confineProg, m_divergenceProg, m_jacobiProg, m_projectProg };
+    for (GLuint prog : programs) {
+        if (prog) glDeleteProgram(prog);
+    }
+}
+
+void FluidSolver::createTextures()
+{
+    m_velocity[0] = createVolume(m_gridSize, GL_RGBA16F);
+    m_velocity[1] = createVolume(m_gridSize, GL_RGBA16F);
+    m_vorticity = createVolume(m_gridSize, GL_RGBA16F);
+    m_pressure[0] = createVolume(m_gridSize, GL_R32F);
+    m_pressure[1] = createVolume(m_gridSize, GL_R32F);
+    m_divergence = createVolume(m_gridSize, GL_R32F);
+    m_current = 0;
+    m_pressureCurrent = 0;
+    CHECK_GL_ERROR();
+}
+
+void FluidSolver::destroyTextures()
+{
+    GLuint textures[] = { m_velocity[0], m_velocity[1], m_vorticity, m_pressure[0], m_pressure[1], m_divergence };
+    glDeleteTextures(6, textures);
+    m_velocity[0] = m_velocity[1] = 0;
+    m_pressure[0] = m_pressure[1] = 0;
+    m_vorticity = m_divergence = 0;
+}
+
+void FluidSolver::setResolution(int gridSize)
+{
+    if (gridSize == m_gridSize) return;
+
+    destroyTextures();
+    m_gridSize = gridSize;
+    createTextures();
+}
+
+void FluidSolver::loadShaders()
+{
+    PROFILE_SCOPE("FluidSolver::loadShaders");
+
+    GLuint* programs[] = { &m_advectProg, &m_curlProg, &m_confineProg, &m_divergenceProg, &m_jacobiProg, &m_projectProg };
+    for (GLuint* prog : programs) {
+        if (*prog) {
+            glDeleteProgram(*prog);
+            *prog = 0;
+        }
+    }
+
+    std::string src = readShaderFile("assets/shaders/fluidPass.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_advectProg = createComputeProgram(injectShaderDefines(src, "#define FLUID_ADVECT\n").c_str(), m_shaderPrefix);
+    m_curlProg = createComputeProgram(injectShaderDefines(src, "#define FLUID_CURL\n").c_str(), m_shaderPrefix);
+    m_confineProg = createComputeProgram(injectShaderDefines(src, "#define FLUID_CONFINE\n").c_str(), m_shaderPrefix);
+    m_divergenceProg = createComputeProgram(injectShaderDefines(src, "#define FLUID_DIVERGENCE\n").c_str(), m_shaderPrefix);
+    m_jacobiProg = createComputeProgram(injectShaderDefines(src, "#define FLUID_JACOBI\n").c_str(), m_shaderPrefix);
+    m_projectProg = createComputeProgram(injectShaderDefines(src, "#define FLUID_PROJECT\n").c_str(), m_shaderPrefix);
+    if (m_advectProg == 0 || m_curlProg == 0 || m_confineProg == 0 ||
+        m_divergenceProg == 0 || m_jacobiProg == 0 || m_projectProg == 0) {
+        std::cerr << "Failed to create fluid solver shader programs" << std::endl;
+    }
+}
+
+void FluidSolver::dispatch(GLuint prog)
+{
+    glUseProgram(prog);
+    glUniform1i(glGetUniformLocation(prog, "gridSize"), m_gridSize);
+    glUniform1f(glGetUniformLocation(prog, "cellSize"), getCellSize());
+    glDispatchCompute((m_gridSize + kGroupX - 1) / kGroupX,
+                      (m_gridSize + kGroupY - 1) / kGroupY,
+                      (m_gridSize + kGroupZ - 1) / kGroupZ);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void FluidSolver::step(float time)
+{
+    PROFILE_SCOPE("FluidSolver::step");
+
+    advect(time);
+    confineVorticity();
+    computeDivergence();
+    solvePressure();
+    project();
+}
+
+void FluidSolver::advect(float time)
+{
+    PROFILE_GPU_SCOPE("FluidSolver::advect");
+    if (m_advectProg == 0) return;
+
+    // 喷流沿水平圆周绕行，方向为切向并略微向上，带动整个区域旋转翻滚
+    glm::vec4 jetPos[kNumJets];
+    glm::vec4 jetVel[kNumJets];
+    for (int j = 0; j < kNumJets; j++) {
+        float angle = time * 0.3f + j * 2.0943951f;
+        glm::vec3 p(0.5f * cosf(angle), 0.3f * sinf(time * 0.7f + j), 0.5f * sinf(angle));
+        glm::vec3 tangent(-sinf(angle), 0.4f, cosf(angle));
+        jetPos[j] = glm::vec4(p, 0.35f);
+        jetVel[j] = glm::vec4(glm::normalize(tangent) * jetStrength, 0.0f);
+    }
+
+    int dst = m_current ^ 1;
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_3D, m_velocity[m_current]);
+    glBindImageTexture(0, m_velocity[dst], 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    glUseProgram(m_advectProg);
+    glUniform1i(glGetUniformLocation(m_advectProg, "velocitySrc"), 0);
+    glUniform1f(glGetUniformLocation(m_advectProg, "dissipation"), dissipation);
+    glUniform4fv(glGetUniformLocation(m_advectProg, "jetPos"), kNumJets, &jetPos[0].x);
+    glUniform4fv(glGetUniformLocation(m_advectProg, "jetVel"), kNumJets, &jetVel[0].x);
+    dispatch(m_advectProg);
+
+    glBindTexture(GL_TEXTURE_3D, 0);
+    m_current = dst;
+    CHECK_GL_ERROR();
+}
+
+void FluidSolver::confineVorticity()
+{
+    PROFILE_GPU_SCOPE("FluidSolver::vorticity");
+    if (m_curlProg == 0 || m_confineProg == 0) return;
+
+    glBindImageTexture(0, m_velocity[m_current], 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA16F);
+    glBindImageTexture(1, m_vorticity, 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA16F);
+    dispatch(m_curlProg);
+
+    glUseProgram(m_confineProg);
+    glUniform1f(glGetUniformLocation(m_confineProg, "vorticityStrength"), vorticity);
+    dispatch(m_confineProg);
+    CHECK_GL_ERROR();
+}
+
+void FluidSolver::computeDivergence()
+{
+    PROFILE_GPU_SCOPE("FluidSolver::divergence");
+    if (m_divergenceProg == 0) return;
+
+    glBindImageTexture(0, m_velocity[m_current], 0, GL_TRUE, 0, GL_READ_ONLY, GL_RGBA16F);
+    glBindImageTexture(4, m_divergence, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32F);
+    dispatch(m_divergenceProg);
+    CHECK_GL_ERROR();
+}
+
+void FluidSolver::solvePressure()
+{
+    PROFILE_GPU_SCOPE("FluidSolver::pressure");
+    if (m_jacobiProg == 0) return;
+
+    // 上一步的压力作为初值，流场变化缓慢时收敛所需的迭代更少
+    glBindImageTexture(4, m_divergence, 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32F);
+    for (int i = 0; i < jacobiIterations; i++) {
+        glBindImageTexture(2, m_pressure[m_pressureCurrent], 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(3, m_pressure[m_pressureCurrent ^ 1], 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32F);
+        dispatch(m_jacobiProg);
+        m_pressureCurrent ^= 1;
+    }
+    CHECK_GL_ERROR();
+}
+
+void FluidSolver::project()
+{
+    PROFILE_GPU_SCOPE("FluidSolver::project");
+    if (m_projectProg == 0) return;
+
+    glBindImageTexture(0, m_velocity[m_current], 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA16F);
+    glBindImageTexture(2, m_pressure[m_pressureCurrent], 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32F);
+    dispatch(m_projectProg);
+
+    for (GLuint unit = 0; unit < 5; unit++) {
+        glBindImageTexture(unit, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+    }
+    glUseProgram(0);
+    CHECK_GL_ERROR();
+}
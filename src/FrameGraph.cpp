@@ -0,0 +1,282 @@
+#include "FrameGraph.h"
+#include "RenderTargetPool.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+FrameGraph::FrameGraph(RenderTargetPool* pool) :
+    m_pool(pool),
+    m_compiled(false),
+    m_statisticsEnabled(false)
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+    reset();
+}
+
+void FrameGraph::reset()
+{
+    destroyStatistics();
+    for (RenderTarget* target : m_physical) {
+        m_pool->release(target);
+    }
+    m_physical.clear();
+    m_resources.clear();
+    m_passes.clear();
+    m_compiled = false;
+}
+
+GLenum FrameGraph::chooseFormat(const TextureDesc& desc)
+{
+    return desc.alpha || desc.blended ? GL_RGBA16F : GL_R11F_G11F_B10F;
+}
+
+FrameGraph::Handle FrameGraph::createTexture(const char* name, const TextureDesc& desc)
+{
+    Resource resource = { name, desc, false, false, chooseFormat(desc), -1, -1, -1 };
+    resource.desc.width = std::max(desc.width, 1);
+    resource.desc.height = std::max(desc.height, 1);
+    m_resources.push_back(resource);
+    m_compiled = false;
+    return (Handle)m_resources.size() - 1;
+}
+
+FrameGraph::Handle FrameGraph::importResource(const char* name, bool output)
+{
+    Resource resource = { name, TextureDesc(0, 0), true, output, GL_NONE, -1, -1, -1 };
+    m_resources.push_back(resource);
+    m_compiled = false;
+    return (Handle)m_resources.size() - 1;
+}
+
+void FrameGraph::addPass(const char* name, const std::vector<Handle>& reads, const std::vector<Handle>& writes,
+                         const std::function<void()>& execute)
+{
+    Pass pass = { name, {}, {}, execute, false, nullptr };
+    for (Handle h : reads) {
+        if (h != kInvalid) pass.reads.push_back(h);
+    }
+    for (Handle h : writes) {
+        if (h != kInvalid) pass.writes.push_back(h);
+    }
+    m_passes.push_back(pass);
+    m_compiled = false;
+}
+
+void FrameGraph::compile()
+{
+    PROFILE_SCOPE("FrameGraph::compile");
+
+    for (RenderTarget* target : m_physical) {
+        m_pool->release(target);
+    }
+    m_physical.clear();
+
+    // 1. 反向追溯: 写入了被需要的资源的pass保留，它读取的资源随之被需要
+    std::vector<bool> needed(m_resources.size(), false);
+    for (size_t r = 0; r < m_resources.size(); r++) {
+        needed[r] = m_resources[r].output;
+    }
+    for (size_t p = m_passes.size(); p-- > 0;) {
+        Pass& pass = m_passes[p];
+        pass.culled = true;
+        for (Handle h : pass.writes) {
+            if (needed[h]) pass.culled = false;
+        }
+        if (!pass.culled) {
+            for (Handle h : pass.reads) {
+                needed[h] = true;
+            }
+        }
+    }
+
+    // 2. 生存期
+    for (Resource& resource : m_resources) {
+        resource.firstPass = resource.lastPass = -1;
+        resource.physical = -1;
+    }
+    for (size_t p = 0; p < m_passes.size(); p++) {
+        if (m_passes[p].culled) continue;
+        for (int k = 0; k < 2; k++) {
+            for (Handle h : k == 0 ? m_passes[p].reads : m_passes[p].writes) {
+                Resource& resource = m_resources[h];
+                if (resource.firstPass < 0) resource.firstPass = (int)p;
+                resource.lastPass = (int)p;
+            }
+        }
+    }
+
+    // 3. 按pass顺序分配，物理目标在上一个占用者的最后一个pass之后空出
+    std::vector<int> busyUntil;
+    for (size_t p = 0; p < m_passes.size(); p++) {
+        for (Resource& resource : m_resources) {
+            if (resource.imported || resource.firstPass != (int)p) continue;
+
+            int slot = -1;
+            for (size_t s = 0; s < m_physical.size(); s++) {
+                const RenderTarget* target = m_physical[s];
+                if (busyUntil[s] < (int)p && target->width == resource.desc.width &&
+                    target->height == resource.desc.height && target->format == resource.format) {
+                    slot = (int)s;
+                    break;
+                }
+            }
+            if (slot < 0) {
+                m_physical.push_back(m_pool->acquire(resource.desc.width, resource.desc.height, resource.format));
+                busyUntil.push_back(-1);
+                slot = (int)m_physical.size() - 1;
+            }
+            resource.physical = slot;
+            busyUntil[slot] = resource.lastPass;
+        }
+    }
+
+    m_compiled = true;
+}
+
+void FrameGraph::execute()
+{
+    if (!m_compiled) {
+        compile();
+    }
+    for (Pass& pass : m_passes) {
+        if (pass.culled) continue;
+        PROFILE_GPU_SCOPE(pass.name);
+        if (!m_statisticsEnabled) {
+            pass.execute();
+            continue;
+        }
+        if (!pass.statistics) {
+            pass.statistics = new PipelineStatistics();
+        }
+        pass.statistics->begin();
+        pass.execute();
+        pass.statistics->end();
+    }
+}
+
+RenderTarget* FrameGraph::getTarget(Handle handle) const
+{
+    if (handle < 0 || handle >= (Handle)m_resources.size() || m_resources[handle].physical < 0) {
+        return nullptr;
+    }
+    return m_physical[m_resources[handle].physical];
+}
+
+size_t FrameGraph::getAllocatedBytes() const
+{
+    size_t bytes = 0;
+    for (const RenderTarget* target : m_physical) {
+        bytes += (size_t)target->width * target->height * RenderTargetPool::bytesPerPixel(target->format);
+    }
+    return bytes;
+}
+
+size_t FrameGraph::getUnaliasedBytes() const
+{
+    size_t bytes = 0;
+    for (const Resource& resource : m_resources) {
+        if (resource.imported) continue;
+        bytes += (size_t)resource.desc.width * resource.desc.height * RenderTargetPool::bytesPerPixel(GL_RGBA16F);
+    }
+    return bytes;
+}
+
+size_t FrameGraph::getTrafficBytes() const
+{
+    size_t bytes = 0;
+    for (const Pass& pass : m_passes) {
+        if (pass.culled) continue;
+        for (int k = 0; k < 2; k++) {
+            for (Handle h : k == 0 ? pass.reads : pass.writes) {
+                const Resource& resource = m_resources[h];
+                if (resource.imported) continue;
+                bytes += (size_t)resource.desc.width * resource.desc.height * RenderTargetPool::bytesPerPixel(resource.format);
+            }
+        }
+    }
+    return bytes;
+}
+
+int FrameGraph::getCulledPassCount() const
+{
+    int culled = 0;
+    for (const Pass& pass : m_passes) {
+        if (pass.culled) culled++;
+    }
+    return culled;
+}
+
+void FrameGraph::dump() const
+{
+    for (size_t p = 0; p < m_passes.size(); p++) {
+        printf("  pass %2zu %-20s %s\n", p, m_passes[p].name, m_passes[p].culled ? "culled" : "");
+    }
+    for (const Resource& resource : m_resources) {
+        if (resource.imported) {
+            printf("  %-20s imported%s\n", resource.name, resource.output ? " (output)" : "");
+        } else if (resource.physical < 0) {
+            printf("  %-20s unused\n", resource.name);
+        } else {
+            printf("  %-20s %4dx%-4d %-14s passes %2d..%-2d -> target %d\n", resource.name,
+                   resource.desc.width, resource.desc.height,
+                   resource.format == GL_RGBA16F ? "RGBA16F" : "R11F_G11F_B10F",
+                   resource.firstPass, resource.lastPass, resource.physical);
+        }
+    }
+}
+
+void FrameGraph::destroyStatistics()
+{
+    for (Pass& pass : m_passes) {
+        delete pass.statistics;
+        pass.statistics = nullptr;
+    }
+}
+
+void FrameGraph::setPipelineStatistics(bool enabled)
+{
+    if (!enabled) {
+        destroyStatistics();
+    }
+    m_statisticsEnabled = enabled;
+}
+
+bool FrameGraph::getPassStatistics(const char* name, PipelineStatistics::Counts& counts, bool wait)
+{
+    counts = PipelineStatistics::Counts();
+    bool found = false;
+    for (Pass& pass : m_passes) {
+        if (!pass.statistics || std::strcmp(pass.name, name) != 0) continue;
+        if (wait) {
+            pass.statistics->finish();
+        }
+        if (!pass.statistics->hasResult()) continue;
+
+        const PipelineStatistics::Counts& last = pass.statistics->getLast();
+        counts.vertices += last.vertices;
+        counts.primitives += last.primitives;
+        counts.fragments += last.fragments;
+        found = true;
+    }
+    return found;
+}
+
+void FrameGraph::dumpPipelineStatistics()
+{
+    printf("  %-22s %12s %12s %14s\n", "pass", "VS invoc.", "primitives", "FS invoc.");
+    for (Pass& pass : m_passes) {
+        if (pass.culled) continue;
+        if (!pass.statistics || !pass.statistics->isSupported() || !pass.statistics->hasResult()) {
+            printf("  %-22s %12s %12s %14s\n", pass.name, "-", "-", "-");
+            continue;
+        }
+        const PipelineStatistics::Counts& last = pass.statistics->getLast();
+        printf("  %-22s %12llu %12llu %14llu\n", pass.name, (unsigned long long)last.vertices,
+               (unsigned long long)last.primitives, (unsigned long long)last.fragments);
+    }
+}
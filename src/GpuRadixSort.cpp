@@ -0,0 +1,114 @@
+#include "GpuRadixSort.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <iostream>
+#include <string>
+
+// 与radixSort.cs一致
+static const GLuint kRadixTile = 1024;
+static const GLuint kRadixDigits = 16;
+static const int kRadixBits = 4;
+
+GpuRadixSort::GpuRadixSort(size_t capacity, const char* shaderPrefix) :
+    m_capacity(capacity),
+    m_countProg(0),
+    m_scanProg(0),
+    m_scatterProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    m_pairs[0] = new ShaderBuffer<glm::uvec2>(capacity);
+    m_pairs[1] = new ShaderBuffer<glm::uvec2>(capacity);
+
+    size_t numTiles = (capacity + kRadixTile - 1) / kRadixTile;
+    m_histogram = new ShaderBuffer<uint32_t>(numTiles * kRadixDigits);
+    CHECK_GL_ERROR();
+
+    loadShaders();
+}
+
+GpuRadixSort::~GpuRadixSort()
+{
+    delete m_pairs[0];
+    delete m_pairs[1];
+    delete m_histogram;
+
+    if (m_countProg) glDeleteProgram(m_countProg);
+    if (m_scanProg) glDeleteProgram(m_scanProg);
+    if (m_scatterProg) glDeleteProgram(m_scatterProg);
+}
+
+void GpuRadixSort::loadShaders()
+{
+    PROFILE_SCOPE("GpuRadixSort::loadShaders");
+
+    GLuint* programs[] = { &m_countProg, &m_scanProg, &m_scatterProg };
+    for (GLuint* prog : programs) {
+        if (*prog) {
+            glDeleteProgram(*prog);
+            *prog = 0;
+        }
+    }
+
+    std::string src = readShaderFile("assets/shaders/radixSort.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_countProg = createComputeProgram(injectShaderDefines(src, "#define RADIX_COUNT\n").c_str(), m_shaderPrefix);
+    m_scanProg = createComputeProgram(injectShaderDefines(src, "#define RADIX_SCAN\n").c_str(), m_shaderPrefix);
+    m_scatterProg = createComputeProgram(injectShaderDefines(src, "#define RADIX_SCATTER\n").c_str(), m_shaderPrefix);
+    if (m_countProg == 0 || m_scanProg == 0 || m_scatterProg == 0) {
+        std::cerr << "Failed to create radix sort shader programs" << std::endl;
+    }
+}
+
+void GpuRadixSort::sort(size_t count, int numBits)
+{
+    PROFILE_SCOPE("GpuRadixSort::sort");
+
+    if (m_countProg == 0 || m_scanProg == 0 || m_scatterProg == 0) {
+        return;
+    }
+    if (count > m_capacity) {
+        count = m_capacity;
+    }
+
+    GLuint numTiles = (GLuint)((count + kRadixTile - 1) / kRadixTile);
+    if (numTiles == 0) return;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, m_histogram->getBuffer());
+
+    int src = 0;
+    for (int shift = 0; shift < numBits; shift += kRadixBits) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_pairs[src]->getBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_pairs[src ^ 1]->getBuffer());
+
+        GLuint programs[] = { m_countProg, m_scanProg, m_scatterProg };
+        for (GLuint prog : programs) {
+            glUseProgram(prog);
+            glUniform1ui(glGetUniformLocation(prog, "count"), (GLuint)count);
+            glUniform1ui(glGetUniformLocation(prog, "shift"), (GLuint)shift);
+            glUniform1ui(glGetUniformLocation(prog, "numTiles"), numTiles);
+            glDispatchCompute(prog == m_scanProg ? 1 : numTiles, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+        src ^= 1;
+    }
+
+    // 轮数为奇数时结果在副缓冲，拷回主缓冲
+    if (src != 0) {
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_COPY_READ_BUFFER, m_pairs[1]->getBuffer());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_pairs[0]->getBuffer());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, count * sizeof(glm::uvec2));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    glUseProgram(0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, 0);
+    CHECK_GL_ERROR();
+}
@@ -0,0 +1,214 @@
+#include "KeplerOrbits.h"
+#include "ParticleSystem.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include "uniforms.h"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+// orbitPass.cs 每个调用处理4个粒子
+static const GLuint kParticlesPerInvocation = 4;
+
+KeplerOrbits::KeplerOrbits(size_t count, const char* shaderPrefix) :
+    gm(0.0247f),
+    stepSeconds(1.0f / 60.0f),
+    m_count(count),
+    m_packed(count * kWordsPerParticle, 0),
+    m_evaluateProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    m_buffer = new ShaderBuffer<uint32_t>(count * kWordsPerParticle);
+    CHECK_GL_ERROR();
+
+    loadShaders();
+}
+
+KeplerOrbits::~KeplerOrbits()
+{
+    delete m_buffer;
+    if (m_evaluateProg) glDeleteProgram(m_evaluateProg);
+}
+
+std::string KeplerOrbits::insertOrbitCode(const std::string& src)
+{
+    static const char* marker = "// @KEPLER_ORBIT";
+    std::string orbitCode = readShaderFile("assets/shaders/keplerOrbit.glsl");
+    size_t pos = src.find(marker);
+    if (orbitCode.empty() || pos == std::string::npos) {
+        std::cerr << "Failed to insert keplerOrbit.glsl" << std::endl;
+        return "";
+    }
+    return src.substr(0, pos) + orbitCode + src.substr(pos + strlen(marker));
+}
+
+void KeplerOrbits::loadShaders()
+{
+    PROFILE_SCOPE("KeplerOrbits::loadShaders");
+
+    if (m_evaluateProg) {
+        glDeleteProgram(m_evaluateProg);
+        m_evaluateProg = 0;
+    }
+
+    std::string src = readShaderFile("assets/shaders/orbitPass.cs");
+    if (src.empty()) {
+        return;
+    }
+    src = insertOrbitCode(src);
+    if (src.empty()) {
+        return;
+    }
+
+    m_evaluateProg = createComputeProgram(src.c_str(), m_shaderPrefix);
+    if (m_evaluateProg == 0) {
+        std::cerr << "Failed to create orbit shader program" << std::endl;
+    }
+}
+
+void KeplerOrbits::generate(int numRings, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    const float twoPi = 6.28318530718f;
+
+    // 每个环: 轨道面法线在球面上均匀分布，大多数环接近圆轨道
+    numRings = std::max(numRings, 1);
+    std::vector<Elements> rings(numRings);
+    for (Elements& ring : rings) {
+        ring.a = 0.55f + 0.4f * uniform(rng);
+        float u = uniform(rng);
+        ring.e = 0.25f * u * u;
+        ring.inclination = acosf(1.0f - 2.0f * uniform(rng));
+        ring.node = twoPi * uniform(rng);
+        ring.periapsis = twoPi * uniform(rng);
+        ring.meanAnomaly = 0.0f;
+    }
+
+    // 环内粒子的根数略有散布，使环有一定厚度
+    std::normal_distribution<float> jitter(0.0f, 1.0f);
+    std::vector<Elements> elements(m_count);
+    for (size_t i = 0; i < m_count; i++) {
+        Elements el = rings[i % numRings];
+        el.a *= 1.0f + 0.01f * jitter(rng);
+        el.e = std::min(std::max(el.e + 0.005f * jitter(rng), 0.0f), 0.3f);
+        el.inclination += 0.01f * jitter(rng);
+        el.node += 0.01f * jitter(rng);
+        el.meanAnomaly = uniform(rng);
+        elements[i] = el;
+    }
+    setElements(elements);
+}
+
+void KeplerOrbits::setElements(const std::vector<Elements>& elements)
+{
+    size_t count = std::min(elements.size(), m_count);
+    for (size_t i = 0; i < count; i++) {
+        packElements(elements[i], &m_packed[i * kWordsPerParticle]);
+    }
+
+    m_buffer->bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_packed.size() * sizeof(uint32_t), m_packed.data());
+    m_buffer->unbind();
+    CHECK_GL_ERROR();
+}
+
+void KeplerOrbits::evaluate(ParticleSystem* particles, float time, bool writeVelocity)
+{
+    PROFILE_SCOPE("KeplerOrbits::evaluate");
+    PROFILE_GPU_SCOPE("orbitPass");
+
+    if (m_evaluateProg == 0) {
+        return;
+    }
+
+    GLuint count = (GLuint)std::min(particles->getSize(), m_count);
+    GLuint perGroup = WORK_GROUP_SIZE * kParticlesPerInvocation;
+    GLuint numGroups = (count + perGroup - 1) / perGroup;
+    if (numGroups == 0) return;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, particles->getPosBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, particles->getVelBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, particles->getIdBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 19, m_buffer->getBuffer());
+
+    glUseProgram(m_evaluateProg);
+    glUniform1ui(glGetUniformLocation(m_evaluateProg, "numParticles"), count);
+    glUniform1f(glGetUniformLocation(m_evaluateProg, "orbitTime"), time);
+    glUniform1f(glGetUniformLocation(m_evaluateProg, "orbitGM"), gm);
+    glUniform1i(glGetUniformLocation(m_evaluateProg, "writeVelocity"), writeVelocity ? 1 : 0);
+    glUniform1f(glGetUniformLocation(m_evaluateProg, "velocityScale"), stepSeconds);
+    glDispatchCompute(numGroups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 19, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+    glUseProgram(0);
+    CHECK_GL_ERROR();
+}
+
+void KeplerOrbits::packElements(const Elements& el, uint32_t* words)
+{
+    const float pi = 3.14159265359f;
+    const float twoPi = 6.28318530718f;
+    auto wrap = [](float turns) { return turns - floorf(turns); };
+
+    words[0] = glm::packUnorm2x16(glm::vec2(el.a / kMaxAxis, el.e));
+    words[1] = glm::packUnorm2x16(glm::vec2(el.inclination / pi, wrap(el.node / twoPi)));
+    words[2] = glm::packUnorm2x16(glm::vec2(wrap(el.periapsis / twoPi), wrap(el.meanAnomaly)));
+}
+
+KeplerOrbits::Elements KeplerOrbits::unpackElements(const uint32_t* words)
+{
+    const float pi = 3.14159265359f;
+    const float twoPi = 6.28318530718f;
+    glm::vec2 w0 = glm::unpackUnorm2x16(words[0]);
+    glm::vec2 w1 = glm::unpackUnorm2x16(words[1]);
+    glm::vec2 w2 = glm::unpackUnorm2x16(words[2]);
+
+    Elements el;
+    el.a = w0.x * kMaxAxis;
+    el.e = w0.y;
+    el.inclination = w1.x * pi;
+    el.node = w1.y * twoPi;
+    el.periapsis = w2.x * twoPi;
+    el.meanAnomaly = w2.y;
+    return el;
+}
+
+glm::vec3 KeplerOrbits::position(const Elements& el, float time, float gm, glm::vec3* velocity)
+{
+    const float twoPi = 6.28318530718f;
+    float a = el.a, e = el.e;
+
+    float n = sqrtf(gm / (a * a * a));
+    float turns = el.meanAnomaly + n * (time / twoPi);
+    float M = twoPi * (turns - floorf(turns));
+    float E = M + e * sinf(M);
+    for (int k = 0; k < kIterations; k++) {
+        E -= (E - e * sinf(E) - M) / (1.0f - e * cosf(E));
+    }
+
+    float cosE = cosf(E), sinE = sinf(E);
+    float b = a * sqrtf(1.0f - e * e);
+    float x = a * (cosE - e), y = b * sinE;
+
+    // 轨道平面到世界坐标: 近心点方向P与其正交方向Q
+    float cosO = cosf(el.node), sinO = sinf(el.node);
+    float cosW = cosf(el.periapsis), sinW = sinf(el.periapsis);
+    float cosI = cosf(el.inclination), sinI = sinf(el.inclination);
+    glm::vec3 P(cosO * cosW - sinO * sinW * cosI, sinW * sinI, sinO * cosW + cosO * sinW * cosI);
+    glm::vec3 Q(-cosO * sinW - sinO * cosW * cosI, cosW * sinI, -sinO * sinW + cosO * cosW * cosI);
+
+    if (velocity) {
+        float dE = n / (1.0f - e * cosE);
+        *velocity = (-a * sinE * dE) * P + (b * cosE * dE) * Q;
+    }
+    return x * P + y * Q;
+}
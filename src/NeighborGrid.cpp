@@ -0,0 +1,155 @@
+#include "NeighborGrid.h"
+#include "ParticleSystem.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <iostream>
+#include <string>
+
+// 与gridPass.cs一致
+static const GLuint kGridGroupSize = 512;
+static const GLuint kGridBlock = 1024;
+
+NeighborGrid::NeighborGrid(size_t capacity, const char* shaderPrefix) :
+    cellSize(0.03f),
+    m_capacity(capacity),
+    m_count(0),
+    m_countProg(0),
+    m_scanBlocksProg(0),
+    m_scanTotalsProg(0),
+    m_addTotalsProg(0),
+    m_scatterProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    m_sorted = new ShaderBuffer<glm::vec4>(capacity * 2);
+    m_cellRanges = new ShaderBuffer<glm::uvec2>(kNumCells);
+    m_cellCounts = new ShaderBuffer<uint32_t>(kNumCells);
+    m_particleCells = new ShaderBuffer<glm::uvec2>(capacity);
+    m_blockTotals = new ShaderBuffer<uint32_t>(kNumCells / kGridBlock);
+    CHECK_GL_ERROR();
+
+    loadShaders();
+}
+
+NeighborGrid::~NeighborGrid()
+{
+    delete m_sorted;
+    delete m_cellRanges;
+    delete m_cellCounts;
+    delete m_particleCells;
+    delete m_blockTotals;
+
+    if (m_countProg) glDeleteProgram(m_countProg);
+    if (m_scanBlocksProg) glDeleteProgram(m_scanBlocksProg);
+    if (m_scanTotalsProg) glDeleteProgram(m_scanTotalsProg);
+    if (m_addTotalsProg) glDeleteProgram(m_addTotalsProg);
+    if (m_scatterProg) glDeleteProgram(m_scatterProg);
+}
+
+void NeighborGrid::loadShaders()
+{
+    PROFILE_SCOPE("NeighborGrid::loadShaders");
+
+    GLuint* programs[] = { &m_countProg, &m_scanBlocksProg, &m_scanTotalsProg, &m_addTotalsProg, &m_scatterProg };
+    for (GLuint* prog : programs) {
+        if (*prog) {
+            glDeleteProgram(*prog);
+            *prog = 0;
+        }
+    }
+
+    std::string src = readShaderFile("assets/shaders/gridPass.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_countProg = createComputeProgram(injectShaderDefines(src, "#define GRID_COUNT\n").c_str(), m_shaderPrefix);
+    m_scanBlocksProg = createComputeProgram(injectShaderDefines(src, "#define GRID_SCAN_BLOCKS\n").c_str(), m_shaderPrefix);
+    m_scanTotalsProg = createComputeProgram(injectShaderDefines(src, "#define GRID_SCAN_TOTALS\n").c_str(), m_shaderPrefix);
+    m_addTotalsProg = createComputeProgram(injectShaderDefines(src, "#define GRID_ADD_TOTALS\n").c_str(), m_shaderPrefix);
+    m_scatterProg = createComputeProgram(injectShaderDefines(src, "#define GRID_SCATTER\n").c_str(), m_shaderPrefix);
+    if (m_countProg == 0 || m_scanBlocksProg == 0 || m_scanTotalsProg == 0 || m_addTotalsProg == 0 || m_scatterProg == 0) {
+        std::cerr << "Failed to create neighbor grid shader programs" << std::endl;
+    }
+}
+
+void NeighborGrid::build(ParticleSystem* particles)
+{
+    PROFILE_SCOPE("NeighborGrid::build");
+    PROFILE_GPU_SCOPE("NeighborGrid::build");
+
+    countCells(particles);
+    scanCells();
+    scatter(particles);
+}
+
+void NeighborGrid::bindBuffers(ParticleSystem* particles)
+{
+    m_count = particles->getSize() < m_capacity ? particles->getSize() : m_capacity;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, particles->getPosBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, particles->getVelBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 13, m_sorted->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, m_cellRanges->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, m_cellCounts->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 16, m_particleCells->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 17, m_blockTotals->getBuffer());
+}
+
+void NeighborGrid::unbindBuffers()
+{
+    for (GLuint binding : { 2u, 3u, 13u, 14u, 15u, 16u, 17u }) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+    }
+    glUseProgram(0);
+    CHECK_GL_ERROR();
+}
+
+void NeighborGrid::dispatch(GLuint prog, GLuint numGroups)
+{
+    glUseProgram(prog);
+    glUniform1ui(glGetUniformLocation(prog, "count"), (GLuint)m_count);
+    glUniform1ui(glGetUniformLocation(prog, "numCells"), kNumCells);
+    glUniform1f(glGetUniformLocation(prog, "cellSize"), cellSize);
+    glDispatchCompute(numGroups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void NeighborGrid::countCells(ParticleSystem* particles)
+{
+    if (m_countProg == 0) return;
+
+    bindBuffers(particles);
+
+    const GLuint zero = 0;
+    m_cellCounts->bind();
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    m_cellCounts->unbind();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    dispatch(m_countProg, (GLuint)((m_count + kGridGroupSize - 1) / kGridGroupSize));
+    unbindBuffers();
+}
+
+void NeighborGrid::scanCells()
+{
+    if (m_scanBlocksProg == 0 || m_scanTotalsProg == 0 || m_addTotalsProg == 0) return;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, m_cellRanges->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, m_cellCounts->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 17, m_blockTotals->getBuffer());
+
+    dispatch(m_scanBlocksProg, kNumCells / kGridBlock);
+    dispatch(m_scanTotalsProg, 1);
+    dispatch(m_addTotalsProg, kNumCells / kGridGroupSize);
+    unbindBuffers();
+}
+
+void NeighborGrid::scatter(ParticleSystem* particles)
+{
+    if (m_scatterProg == 0) return;
+
+    bindBuffers(particles);
+    dispatch(m_scatterProg, (GLuint)((m_count + kGridGroupSize - 1) / kGridGroupSize));
+    unbindBuffers();
+}
@@ -0,0 +1,196 @@
+#include "OverdrawView.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 与overdrawPass.cs一致
+static const int kGroupSize = 16;
+static const int kNumStats = 3;
+
+OverdrawView::OverdrawView(const char* shaderPrefix) :
+    rampMax(1024.0f),
+    m_width(0),
+    m_height(0),
+    m_counts(0),
+    m_heatmap(0),
+    m_heatmapFBO(0),
+    m_index(0),
+    m_last(),
+    m_hasResult(false),
+    m_resolveProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    for (int i = 0; i < kLatency; i++) {
+        m_stats[i] = new ShaderBuffer<uint32_t>(kNumStats);
+        m_fences[i] = 0;
+    }
+
+    loadShaders();
+}
+
+OverdrawView::~OverdrawView()
+{
+    destroyTargets();
+    for (int i = 0; i < kLatency; i++) {
+        delete m_stats[i];
+        if (m_fences[i]) glDeleteSync(m_fences[i]);
+    }
+
+    if (m_resolveProg) glDeleteProgram(m_resolveProg);
+}
+
+void OverdrawView::loadShaders()
+{
+    PROFILE_SCOPE("OverdrawView::loadShaders");
+
+    if (m_resolveProg) {
+        glDeleteProgram(m_resolveProg);
+        m_resolveProg = 0;
+    }
+
+    std::string src = readShaderFile("assets/shaders/overdrawPass.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_resolveProg = createComputeProgram(src.c_str(), m_shaderPrefix);
+    if (m_resolveProg == 0) {
+        std::cerr << "Failed to create overdraw view shader program" << std::endl;
+    }
+}
+
+void OverdrawView::destroyTargets()
+{
+    if (m_heatmapFBO) glDeleteFramebuffers(1, &m_heatmapFBO);
+    if (m_counts) glDeleteTextures(1, &m_counts);
+    if (m_heatmap) glDeleteTextures(1, &m_heatmap);
+    m_heatmapFBO = 0;
+    m_counts = 0;
+    m_heatmap = 0;
+}
+
+void OverdrawView::resize(int width, int height)
+{
+    if (width == m_width && height == m_height && m_counts) return;
+
+    destroyTargets();
+    m_width = width;
+    m_height = height;
+    if (width <= 0 || height <= 0) return;
+
+    // 之后由overdrawPass.cs在读取后清零
+    std::vector<uint32_t> zeros((size_t)width * height, 0);
+    glGenTextures(1, &m_counts);
+    glBindTexture(GL_TEXTURE_2D, m_counts);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width, height);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED_INTEGER, GL_UNSIGNED_INT, zeros.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenTextures(1, &m_heatmap);
+    glBindTexture(GL_TEXTURE_2D, m_heatmap);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &m_heatmapFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_heatmapFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_heatmap, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Overdraw heatmap framebuffer incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    CHECK_GL_ERROR();
+}
+
+void OverdrawView::bindCounts()
+{
+    if (!m_counts) return;
+    glBindImageTexture(2, m_counts, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+}
+
+void OverdrawView::resolve(int width, int height)
+{
+    PROFILE_GPU_SCOPE("OverdrawView::resolve");
+    if (m_resolveProg == 0 || !m_counts) return;
+
+    collect(false);
+    if (m_fences[m_index]) {
+        // 环形缓冲已满: 等待最旧的一份统计，保证不覆盖未读的结果
+        collect(true);
+    }
+
+    uint32_t zeros[kNumStats] = {};
+    ShaderBuffer<uint32_t>* stats = m_stats[m_index];
+    stats->bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zeros), zeros);
+    stats->unbind();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 28, stats->getBuffer());
+
+    // 粒子绘制的原子计数对计算着色器可见
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    glUseProgram(m_resolveProg);
+    glUniform1f(glGetUniformLocation(m_resolveProg, "rampMax"), rampMax);
+    glBindImageTexture(0, m_counts, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+    glBindImageTexture(1, m_heatmap, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    glDispatchCompute((m_width + kGroupSize - 1) / kGroupSize, (m_height + kGroupSize - 1) / kGroupSize, 1);
+    // 下一帧的计数、热力图的blit与统计的回读
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    glUseProgram(0);
+
+    m_fences[m_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_index = (m_index + 1) % kLatency;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_heatmapFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    CHECK_GL_ERROR();
+}
+
+void OverdrawView::collect(bool wait)
+{
+    // 从最旧的一份开始，保证m_last是最新完成的结果
+    for (int i = 0; i < kLatency; i++) {
+        int slot = (m_index + i) % kLatency;
+        if (!m_fences[slot]) continue;
+
+        GLenum status = glClientWaitSync(m_fences[slot], wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                         wait ? GL_TIMEOUT_IGNORED : 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            if (status == GL_WAIT_FAILED) {
+                std::cerr << "Overdraw statistics fence wait failed" << std::endl;
+            }
+            break;
+        }
+        glDeleteSync(m_fences[slot]);
+        m_fences[slot] = 0;
+
+        uint32_t values[kNumStats] = {};
+        m_stats[slot]->bind();
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(values), values);
+        m_stats[slot]->unbind();
+        m_last.fragments = values[0];
+        m_last.peak = values[1];
+        m_last.coveredPixels = values[2];
+        m_last.pixels = (uint32_t)(m_width * m_height);
+        m_hasResult = true;
+    }
+}
+
+bool OverdrawView::getStats(Stats& stats) const
+{
+    if (!m_hasResult) return false;
+    stats = m_last;
+    return true;
+}
+
+void OverdrawView::finish()
+{
+    collect(true);
+}
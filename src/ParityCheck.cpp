@@ -0,0 +1,477 @@
+#include "ParityCheck.h"
+#include "ComputeParticles.h"
+#include "ParticleReference.h"
+#include "ParticleSystem.h"
+#include "AttractorCluster.h"
+#include "BarnesHut.h"
+#include "NeighborGrid.h"
+#include "FluidSolver.h"
+#include "ShapeTargets.h"
+#include "KeplerOrbits.h"
+#include "ShellConstraints.h"
+#include "GLUtils.h"
+#include "uniforms.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+struct ErrorStats
+{
+    double maxAbs = 0.0;
+    double sumAbs = 0.0;
+    double sumSq = 0.0;
+    size_t count = 0;
+    size_t outliers = 0;
+    size_t worst = 0;
+
+    void add(size_t index, const glm::vec4& gpu, const glm::vec4& cpu, float absTol, float relTol) {
+        double err = glm::length(glm::vec3(gpu) - glm::vec3(cpu));
+        if (!std::isfinite(err)) err = 1e30;
+        if (err > maxAbs) {
+            maxAbs = err;
+            worst = index;
+        }
+        sumAbs += err;
+        sumSq += err * err;
+        count++;
+        if (err > absTol + relTol * glm::length(glm::vec3(cpu))) {
+            outliers++;
+        }
+    }
+
+    void print(const char* label) const {
+        printf("    %-4s max %.3e  mean %.3e  rms %.3e  outliers %zu/%zu (worst #%zu)\n",
+               label, maxAbs, sumAbs / std::max<size_t>(count, 1),
+               sqrt(sumSq / std::max<size_t>(count, 1)), outliers, count, worst);
+    }
+};
+
+struct SimPhase
+{
+    const char* name;
+    float particleState;
+    bool attractor;
+    int numAttractors;
+    int numSwarmBodies;
+    // 形状状态: 目标为 mix(形状A, 形状B, morph)
+    int shapeA = 0;
+    int shapeB = 0;
+    float morph = 0.0f;
+    // fBm八度数，0为默认值
+    int noiseOctaves = 0;
+    // 积分器(ParticleSystem::Integrator)与步长(秒)，0为按帧步进
+    int integrator = ParticleSystem::kIntegratorLegacy;
+    float dt = 0.0f;
+};
+
+template <class T>
+void readBuffer(ShaderBuffer<T>* buffer, std::vector<T>& out)
+{
+    out.resize(buffer->getSize());
+    T* data = buffer->map(GL_MAP_READ_BIT);
+    std::copy(data, data + buffer->getSize(), out.begin());
+    buffer->unmap();
+}
+
+bool runSimulationParity(const ParityOptions& options)
+{
+    std::cout << "== Simulation parity (" << options.numParticles << " particles, "
+              << options.stepsPerPhase << " steps/phase, seed " << options.seed << ")" << std::endl;
+
+    srand(options.seed);
+    ParticleSystem particles(options.numParticles, "#version 430\n");
+    particles.specializeShaders = options.specializeShaders;
+    std::cout << "  kernel: " << (options.specializeShaders ? "per-state variants" : "uber-kernel") << std::endl;
+
+    int noiseSize = particles.getNoiseSize();
+    std::vector<int8_t> noise(noiseSize * noiseSize * noiseSize * 4);
+    glBindTexture(GL_TEXTURE_3D, particles.getNoiseTexture());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_BYTE, noise.data());
+    glBindTexture(GL_TEXTURE_3D, 0);
+    CHECK_GL_ERROR();
+
+    ParticleReference reference(noise, noiseSize);
+
+    GLuint ubo;
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ShaderParams), nullptr, GL_STREAM_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 1, ubo);
+
+    // 引力源数量不是分块大小的整数倍，覆盖最后一个不满的块
+    AttractorCluster cluster;
+    cluster.setCount(300);
+    cluster.totalStrength = 0.002f;
+    cluster.update(1.0f);
+    particles.setAttractors(cluster.getBuffer(), cluster.getOffset(), cluster.getRangeSize());
+    reference.setAttractors(cluster.getAttractors());
+
+    // 粒子群: 只有前一半粒子受自引力，另一半走普通分支
+    int numSwarmBodies = options.numParticles / 2;
+    std::vector<glm::vec4> swarmPos, swarmAccel(numSwarmBodies);
+    readBuffer(particles.getPosBuffer(), swarmPos);
+    BarnesHut solver;
+    solver.gravity = 0.01f;
+    solver.solve(swarmPos.data(), numSwarmBodies, swarmAccel.data());
+    reference.setSwarmAccelerations(swarmAccel);
+
+    GLuint swarmBuffer;
+    glGenBuffers(1, &swarmBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, swarmBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, numSwarmBodies * sizeof(glm::vec4), swarmAccel.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    particles.setSwarmAccelerations(swarmBuffer);
+
+    NeighborGrid grid(options.numParticles, "#version 430\n");
+    particles.setNeighborGrid(grid.getSortedBuffer(), grid.getCellRangeBuffer());
+
+    // 流体: 先让速度场发展一段时间，再固定下来供两边采样
+    FluidSolver fluid(32, "#version 430\n");
+    fluid.jetStrength = 0.002f;
+    for (int step = 0; step < 30; step++) {
+        fluid.step(step / 60.0f);
+    }
+    std::vector<glm::vec4> fluidTexels(32 * 32 * 32);
+    glBindTexture(GL_TEXTURE_3D, fluid.getVelocityTexture());
+    glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_FLOAT, fluidTexels.data());
+    glBindTexture(GL_TEXTURE_3D, 0);
+    particles.setFluidVelocity(fluid.getVelocityTexture());
+    reference.setFluidVelocity(fluidTexels, 32);
+    CHECK_GL_ERROR();
+
+    // 形状目标: 内置爱心/五角星，外加一个采样得到的立方体表面，两边读同一份数据
+    ShapeTargets shapes(options.numParticles);
+    int heartShape = shapes.addHeart(0.3f);
+    int starShape = shapes.addStar(0.3f);
+    TriangleMesh cube;
+    for (int v = 0; v < 8; v++) {
+        cube.vertices.push_back(glm::vec3(v & 1 ? 1.0f : -1.0f, v & 2 ? 1.0f : -1.0f, v & 4 ? 1.0f : -1.0f));
+    }
+    const int cubeFaces[6][4] = { {0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5} };
+    for (const int* f : cubeFaces) {
+        cube.triangles.push_back(glm::uvec3(f[0], f[1], f[2]));
+        cube.triangles.push_back(glm::uvec3(f[0], f[2], f[3]));
+    }
+    int cubeShape = shapes.addMesh(cube, "cube", 0.25f);
+    std::vector<glm::vec4> shapeTargets(shapes.getShapeCount() * shapes.getPointsPerShape());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, shapes.getBuffer());
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, shapeTargets.size() * sizeof(glm::vec4), shapeTargets.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    particles.setShapeTargets(shapes.getBuffer());
+    reference.setShapeTargets(shapeTargets);
+    CHECK_GL_ERROR();
+
+    const SimPhase phases[] = {
+        { "normal",           0.0f, false, 0,   0 },
+        { "normal+attractor", 0.0f, true,  0,   0 },
+        { "normal+cluster",   0.0f, false, 300, 0 },
+        { "normal 2 octaves", 0.0f, false, 0,   0, 0, 0, 0.0f, 2 },
+        { "swarm",            4.0f, false, 0,   numSwarmBodies },
+        { "flock",            5.0f, false, 0,   0 },
+        { "fluid",            6.0f, false, 0,   0 },
+        { "absorbing",        1.0f, false, 0,   0 },
+        { "heart",            2.0f, false, 0,   0, heartShape, heartShape, 0.0f },
+        { "star",             3.0f, false, 0,   0, starShape,  starShape,  0.0f },
+        { "morph heart->cube", 2.0f, false, 0,  0, heartShape, cubeShape,  0.35f },
+        // 按dt积分，步长不是参考帧的整数倍
+        { "normal+cluster euler 1/24s",   0.0f, false, 300, 0, 0, 0, 0.0f, 0, ParticleSystem::kIntegratorEuler,  1.0f / 24.0f },
+        { "normal+attractor verlet 1/45s", 0.0f, true, 0,   0, 0, 0, 0.0f, 0, ParticleSystem::kIntegratorVerlet, 1.0f / 45.0f },
+        { "normal+cluster rk4 1/20s",     0.0f, false, 300, 0, 0, 0, 0.0f, 0, ParticleSystem::kIntegratorRK4,    1.0f / 20.0f },
+        { "swarm verlet 1/30s",           4.0f, false, 0, numSwarmBodies, 0, 0, 0.0f, 0, ParticleSystem::kIntegratorVerlet, 1.0f / 30.0f },
+        { "flock euler 1/30s",            5.0f, false, 0,   0, 0, 0, 0.0f, 0, ParticleSystem::kIntegratorEuler,  1.0f / 30.0f },
+        { "fluid rk4 1/40s",              6.0f, false, 0,   0, 0, 0, 0.0f, 0, ParticleSystem::kIntegratorRK4,    1.0f / 40.0f },
+        { "absorbing rk4 1/90s",          1.0f, false, 0,   0, 0, 0, 0.0f, 0, ParticleSystem::kIntegratorRK4,    1.0f / 90.0f },
+        { "morph heart->cube verlet 1/15s", 2.0f, false, 0, 0, heartShape, cubeShape, 0.35f, 0, ParticleSystem::kIntegratorVerlet, 1.0f / 15.0f },
+        { "star rk4 1/10s",               3.0f, false, 0,   0, starShape, starShape, 0.0f, 0, ParticleSystem::kIntegratorRK4, 1.0f / 10.0f },
+    };
+
+    bool passed = true;
+    std::vector<glm::vec4> cpuPos, cpuVel, gpuPos, gpuVel;
+
+    for (const SimPhase& phase : phases) {
+        ShaderParams params;
+        params.numParticles = (unsigned int)particles.getSize();
+        params.particleState = phase.particleState;
+        if (phase.attractor) {
+            params.attractor = glm::vec4(0.3f, -0.2f, 0.1f, 0.0002f);
+        }
+        params.numAttractors = (unsigned int)phase.numAttractors;
+        params.numSwarmBodies = (unsigned int)phase.numSwarmBodies;
+        params.numGridCells = NeighborGrid::kNumCells;
+        // 不截断邻居，结果与格子内的顺序无关
+        params.maxNeighbors = 4096;
+        params.targetOffsetA = shapes.getOffset(phase.shapeA);
+        params.targetOffsetB = shapes.getOffset(phase.shapeB);
+        params.targetMorph = phase.morph;
+        if (phase.noiseOctaves > 0) {
+            params.noiseOctaves = (unsigned int)phase.noiseOctaves;
+        }
+        params.integrator = (unsigned int)phase.integrator;
+        if (phase.dt > 0.0f) {
+            params.dt = phase.dt;
+        }
+
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShaderParams), &params);
+
+        ErrorStats posStats, velStats;
+        for (int step = 0; step < options.stepsPerPhase; step++) {
+            // 每一步都从GPU当前状态出发，避免误差随步数累积
+            readBuffer(particles.getPosBuffer(), cpuPos);
+            readBuffer(particles.getVelBuffer(), cpuVel);
+            reference.step(params, cpuPos, cpuVel);
+
+            if (phase.particleState > 4.5f) {
+                grid.build(&particles);
+            }
+            particles.update(params);
+            readBuffer(particles.getPosBuffer(), gpuPos);
+            readBuffer(particles.getVelBuffer(), gpuVel);
+
+            for (size_t i = 0; i < gpuPos.size(); i++) {
+                posStats.add(i, gpuPos[i], cpuPos[i], options.absTolerance, options.relTolerance);
+                velStats.add(i, gpuVel[i], cpuVel[i], options.absTolerance, options.relTolerance);
+            }
+        }
+
+        size_t allowed = (size_t)(options.maxOutlierFraction * posStats.count);
+        bool ok = posStats.outliers <= allowed && velStats.outliers <= allowed;
+        printf("  [%s] %s\n", ok ? "PASS" : "FAIL", phase.name);
+        posStats.print("pos");
+        velStats.print("vel");
+        passed = passed && ok;
+    }
+
+    // PBD壳体: 从GPU预测后的位置出发，比较shellPass.cs按颜色并行的投影与CPU按颜色顺序的投影
+    int shellLevel = 7;
+    while (shellLevel > 0 && (10 << (2 * shellLevel)) + 2 > options.numParticles) {
+        shellLevel--;
+    }
+    ShellConstraints shell(shellLevel, 0.6f, "#version 430\n");
+    // 按帧步进与按dt积分(h != 1，速度由位移除以步长得到)各一遍
+    const SimPhase shellPhases[] = {
+        { "pbd shell",                0.0f, false, 0, 0 },
+        { "pbd shell verlet 1/144s",  0.0f, false, 0, 0, 0, 0, 0.0f, 0, ParticleSystem::kIntegratorVerlet, 1.0f / 144.0f },
+    };
+    for (const SimPhase& phase : shellPhases) {
+        if (!shell.deploy(&particles)) break;
+
+        ShaderParams params;
+        params.numParticles = (unsigned int)particles.getSize();
+        params.noiseStrength = 0.004f;
+        params.integrator = (unsigned int)phase.integrator;
+        if (phase.dt > 0.0f) {
+            params.dt = phase.dt;
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShaderParams), &params);
+
+        std::vector<glm::vec4> prevPos;
+        ErrorStats posStats, velStats;
+        for (int step = 0; step < options.stepsPerPhase; step++) {
+            readBuffer(particles.getPosBuffer(), prevPos);
+            shell.storePositions(&particles);
+            particles.update(params);
+            readBuffer(particles.getPosBuffer(), cpuPos);
+            readBuffer(particles.getVelBuffer(), cpuVel);
+            shell.solveReference(cpuPos, cpuVel, prevPos, params);
+
+            shell.solve(&particles, params);
+            readBuffer(particles.getPosBuffer(), gpuPos);
+            readBuffer(particles.getVelBuffer(), gpuVel);
+            for (size_t i = 0; i < shell.getVertexCount(); i++) {
+                posStats.add(i, gpuPos[i], cpuPos[i], options.absTolerance, options.relTolerance);
+                velStats.add(i, gpuVel[i], cpuVel[i], options.absTolerance, options.relTolerance);
+            }
+        }
+
+        size_t allowed = (size_t)(options.maxOutlierFraction * posStats.count);
+        bool ok = posStats.outliers <= allowed && velStats.outliers <= allowed;
+        printf("  [%s] %s (%zu constraints, %zu colors, %d iterations)\n", ok ? "PASS" : "FAIL",
+               phase.name, shell.getConstraintCount(), shell.getColorCount(), shell.iterations);
+        posStats.print("pos");
+        velStats.print("vel");
+        passed = passed && ok;
+    }
+
+    // 开普勒轨道: orbitPass.cs(4个粒子一组的vec4求解)与CPU解析解在若干时刻的位置/速度，含跳转到很远的时刻
+    KeplerOrbits orbits(options.numParticles, "#version 430\n");
+    orbits.generate(64, options.seed);
+    const std::vector<uint32_t>& packed = orbits.getPackedElements();
+    const float orbitTimes[] = { 0.0f, 37.5f, 3600.0f };
+    std::vector<uint32_t> ids;
+    readBuffer(particles.getIdBuffer(), ids);
+    for (float time : orbitTimes) {
+        orbits.evaluate(&particles, time, true);
+        readBuffer(particles.getPosBuffer(), gpuPos);
+        readBuffer(particles.getVelBuffer(), gpuVel);
+
+        ErrorStats posStats, velStats;
+        for (size_t i = 0; i < gpuPos.size(); i++) {
+            KeplerOrbits::Elements el = KeplerOrbits::unpackElements(&packed[ids[i] * KeplerOrbits::kWordsPerParticle]);
+            glm::vec3 v;
+            glm::vec3 p = KeplerOrbits::position(el, time, orbits.gm, &v);
+            posStats.add(i, gpuPos[i], glm::vec4(p, 1.0f), options.absTolerance, options.relTolerance);
+            velStats.add(i, gpuVel[i], glm::vec4(v * orbits.stepSeconds, 0.0f), options.absTolerance, options.relTolerance);
+        }
+
+        size_t allowed = (size_t)(options.maxOutlierFraction * posStats.count);
+        bool ok = posStats.outliers <= allowed && velStats.outliers <= allowed;
+        printf("  [%s] kepler orbits t=%.1fs\n", ok ? "PASS" : "FAIL", time);
+        posStats.print("pos");
+        velStats.print("vel");
+        passed = passed && ok;
+    }
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, 1, 0);
+    glDeleteBuffers(1, &ubo);
+    glDeleteBuffers(1, &swarmBuffer);
+    CHECK_GL_ERROR();
+    return passed;
+}
+
+bool readPPM(const char* path, int& width, int& height, std::vector<uint8_t>& rgb)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    std::string magic;
+    int maxValue;
+    file >> magic >> width >> height >> maxValue;
+    file.get();
+    if (magic != "P6" || maxValue != 255) return false;
+
+    rgb.resize((size_t)width * height * 3);
+    file.read((char*)rgb.data(), rgb.size());
+    return (bool)file;
+}
+
+bool writePPM(const char* path, int width, int height, const std::vector<uint8_t>& rgb)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write((const char*)rgb.data(), rgb.size());
+    return (bool)file;
+}
+
+glm::vec3 srgbToLab(const uint8_t* c)
+{
+    glm::vec3 rgb;
+    for (int i = 0; i < 3; i++) {
+        float v = c[i] / 255.0f;
+        rgb[i] = v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+    }
+
+    // D65
+    glm::vec3 xyz(0.4124f * rgb.r + 0.3576f * rgb.g + 0.1805f * rgb.b,
+                  0.2126f * rgb.r + 0.7152f * rgb.g + 0.0722f * rgb.b,
+                  0.0193f * rgb.r + 0.1192f * rgb.g + 0.9505f * rgb.b);
+    xyz /= glm::vec3(0.95047f, 1.0f, 1.08883f);
+
+    for (int i = 0; i < 3; i++) {
+        xyz[i] = xyz[i] > 0.008856f ? cbrtf(xyz[i]) : 7.787f * xyz[i] + 16.0f / 116.0f;
+    }
+    return glm::vec3(116.0f * xyz.y - 16.0f, 500.0f * (xyz.x - xyz.y), 200.0f * (xyz.y - xyz.z));
+}
+
+bool runImageParity(GLFWwindow* window, const ParityOptions& options)
+{
+    std::cout << "== Image parity (" << options.imageWidth << "x" << options.imageHeight << ", "
+              << options.imageFrames << " frames)" << std::endl;
+
+    const int width = options.imageWidth;
+    const int height = options.imageHeight;
+    std::vector<uint8_t> frame((size_t)width * height * 3);
+
+    {
+        srand(options.seed);
+        ComputeParticles app;
+        app.setParticleCount(options.numParticles);
+        if (!app.init(window)) {
+            std::cerr << "  [FAIL] could not initialise renderer" << std::endl;
+            return false;
+        }
+        app.reshape(width, height);
+
+        for (int f = 0; f < options.imageFrames; f++) {
+            app.draw(1.0f / 60.0f);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        std::vector<uint8_t> bottomUp(frame.size());
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, bottomUp.data());
+        CHECK_GL_ERROR();
+
+        for (int y = 0; y < height; y++) {
+            std::copy(bottomUp.begin() + (size_t)(height - 1 - y) * width * 3,
+                      bottomUp.begin() + (size_t)(height - y) * width * 3,
+                      frame.begin() + (size_t)y * width * 3);
+        }
+    }
+
+    if (options.updateGolden) {
+        if (!writePPM(options.goldenPath, width, height, frame)) {
+            std::cerr << "  [FAIL] could not write golden image " << options.goldenPath << std::endl;
+            return false;
+        }
+        std::cout << "  golden image updated: " << options.goldenPath << std::endl;
+        return true;
+    }
+
+    int goldenWidth = 0, goldenHeight = 0;
+    std::vector<uint8_t> golden;
+    if (!readPPM(options.goldenPath, goldenWidth, goldenHeight, golden)) {
+        std::cerr << "  [FAIL] missing golden image " << options.goldenPath
+                  << " (run with --update-golden to create it)" << std::endl;
+        return false;
+    }
+    if (goldenWidth != width || goldenHeight != height) {
+        std::cerr << "  [FAIL] golden image is " << goldenWidth << "x" << goldenHeight << std::endl;
+        return false;
+    }
+
+    double sumDeltaE = 0.0, maxDeltaE = 0.0;
+    size_t badPixels = 0;
+    size_t numPixels = (size_t)width * height;
+    for (size_t i = 0; i < numPixels; i++) {
+        float deltaE = glm::length(srgbToLab(&frame[i * 3]) - srgbToLab(&golden[i * 3]));
+        sumDeltaE += deltaE;
+        maxDeltaE = std::max(maxDeltaE, (double)deltaE);
+        if (deltaE > options.pixelDeltaE) {
+            badPixels++;
+        }
+    }
+
+    double meanDeltaE = sumDeltaE / numPixels;
+    double badFraction = (double)badPixels / numPixels;
+    bool ok = meanDeltaE <= options.maxMeanDeltaE && badFraction <= options.maxBadPixelFraction;
+    printf("  [%s] mean dE %.3f  max dE %.2f  pixels over dE %.1f: %.3f%%\n",
+           ok ? "PASS" : "FAIL", meanDeltaE, maxDeltaE, options.pixelDeltaE, badFraction * 100.0);
+
+    if (!ok) {
+        writePPM("parity_frame.ppm", width, height, frame);
+        std::cout << "  rendered frame written to parity_frame.ppm" << std::endl;
+    }
+    return ok;
+}
+
+} // namespace
+
+int runParityCheck(GLFWwindow* window, const ParityOptions& options)
+{
+    bool simOk = runSimulationParity(options);
+    bool imageOk = runImageParity(window, options);
+
+    std::cout << "Parity check " << (simOk && imageOk ? "PASSED" : "FAILED") << std::endl;
+    return simOk && imageOk ? 0 : 1;
+}
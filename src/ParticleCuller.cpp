@@ -0,0 +1,181 @@
+#include "ParticleCuller.h"
+#include "ParticleSystem.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include "uniforms.h"
+#include <iostream>
+#include <string>
+
+// 与cullPass.cs的LOD_TILE_SIZE一致
+static const int kLodTileSize = 16;
+
+ParticleCuller::ParticleCuller(size_t capacity, const char* shaderPrefix) :
+    lodPointRadius(1.0f),
+    lodMinEnergy(0.002f),
+    octagonSprites(false),
+    stochasticLod(false),
+    lodTargetOverdraw(24.0f),
+    lodMinFraction(1.0f / 16.0f),
+    lodMaxRadius(8.0f),
+    m_capacity(capacity),
+    m_indirectBuffer(0),
+    m_densityCurrent(0),
+    m_tilesX(0),
+    m_tilesY(0),
+    m_cullProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    m_quadList = new ShaderBuffer<uint32_t>(capacity);
+    m_pointList = new ShaderBuffer<uint32_t>(capacity);
+    m_quadWeights = new ShaderBuffer<float>(capacity);
+    m_pointWeights = new ShaderBuffer<float>(capacity);
+    m_density[0] = m_density[1] = nullptr;
+
+    CullDrawCommands commands = {};
+    glGenBuffers(1, &m_indirectBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(CullDrawCommands), &commands, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    CHECK_GL_ERROR();
+
+    loadShaders();
+}
+
+ParticleCuller::~ParticleCuller()
+{
+    delete m_quadList;
+    delete m_pointList;
+    delete m_quadWeights;
+    delete m_pointWeights;
+    delete m_density[0];
+    delete m_density[1];
+
+    if (m_indirectBuffer) {
+        glDeleteBuffers(1, &m_indirectBuffer);
+    }
+    if (m_cullProg) {
+        glDeleteProgram(m_cullProg);
+    }
+}
+
+void ParticleCuller::loadShaders()
+{
+    PROFILE_SCOPE("ParticleCuller::loadShaders");
+
+    if (m_cullProg) {
+        glDeleteProgram(m_cullProg);
+        m_cullProg = 0;
+    }
+
+    std::string src = readShaderFile("assets/shaders/cullPass.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_cullProg = createComputeProgram(src.c_str(), m_shaderPrefix);
+    if (m_cullProg == 0) {
+        std::cerr << "Failed to create cull shader program" << std::endl;
+    }
+}
+
+void ParticleCuller::cull(ParticleSystem* particles, int viewportWidth, int viewportHeight)
+{
+    PROFILE_SCOPE("ParticleCuller::cull");
+    PROFILE_GPU_SCOPE("cullPass");
+
+    if (m_cullProg == 0) {
+        return;
+    }
+
+    // 计数从零开始，instanceCount等固定字段一并写入
+    CullDrawCommands commands = {};
+    commands.quads.instanceCount = 1;
+    commands.points.instanceCount = 1;
+    commands.octagons.count = 8;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(CullDrawCommands), &commands);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glUseProgram(m_cullProg);
+    glUniform2f(glGetUniformLocation(m_cullProg, "viewportSize"), (float)viewportWidth, (float)viewportHeight);
+    glUniform1f(glGetUniformLocation(m_cullProg, "lodPointRadius"), lodPointRadius);
+    glUniform1f(glGetUniformLocation(m_cullProg, "lodMinEnergy"), lodMinEnergy);
+    glUniform1i(glGetUniformLocation(m_cullProg, "octagonSprites"), octagonSprites ? 1 : 0);
+    glUniform1i(glGetUniformLocation(m_cullProg, "stochasticLod"), stochasticLod ? 1 : 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, particles->getPosBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_quadList->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_pointList->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, m_indirectBuffer);
+
+    if (stochasticLod) {
+        int tilesX = (viewportWidth + kLodTileSize - 1) / kLodTileSize;
+        int tilesY = (viewportHeight + kLodTileSize - 1) / kLodTileSize;
+        resizeDensity(tilesX, tilesY);
+
+        // 上一帧累加的缓冲变为读取的估计，另一个清零后累加本帧
+        m_densityCurrent = 1 - m_densityCurrent;
+        ShaderBuffer<uint32_t>* next = m_density[m_densityCurrent];
+        ShaderBuffer<uint32_t>* previous = m_density[1 - m_densityCurrent];
+        GLuint zero = 0;
+        next->bind();
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+        next->unbind();
+
+        glUniform1f(glGetUniformLocation(m_cullProg, "lodTargetOverdraw"), lodTargetOverdraw);
+        glUniform1f(glGetUniformLocation(m_cullProg, "lodMinFraction"), lodMinFraction);
+        glUniform1f(glGetUniformLocation(m_cullProg, "lodMaxRadius"), lodMaxRadius);
+        glUniform2i(glGetUniformLocation(m_cullProg, "lodTiles"), tilesX, tilesY);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, particles->getIdBuffer()->getBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 29, m_quadWeights->getBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 30, m_pointWeights->getBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 31, previous->getBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 32, next->getBuffer());
+    }
+
+    size_t count = particles->getSize() < m_capacity ? particles->getSize() : m_capacity;
+    GLuint numGroups = (GLuint)((count + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE);
+    if (numGroups == 0) numGroups = 1;
+    glDispatchCompute(numGroups, 1, 1);
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    if (stochasticLod) {
+        for (GLuint binding : { 7u, 29u, 30u, 31u, 32u }) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+        }
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+    glUseProgram(0);
+    CHECK_GL_ERROR();
+}
+
+// 分块数变化(视口或粒子分辨率变化)时重新分配并清零，下一帧的估计为零，全部保留
+void ParticleCuller::resizeDensity(int tilesX, int tilesY)
+{
+    if (tilesX == m_tilesX && tilesY == m_tilesY && m_density[0]) return;
+
+    m_tilesX = tilesX;
+    m_tilesY = tilesY;
+    GLuint zero = 0;
+    for (int i = 0; i < 2; i++) {
+        delete m_density[i];
+        m_density[i] = new ShaderBuffer<uint32_t>((size_t)tilesX * tilesY);
+        m_density[i]->bind();
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+        m_density[i]->unbind();
+    }
+}
+
+CullDrawCommands ParticleCuller::readCommands()
+{
+    CullDrawCommands commands = {};
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+    glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(CullDrawCommands), &commands);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    return commands;
+}
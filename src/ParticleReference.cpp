@@ -0,0 +1,342 @@
+#include "ParticleReference.h"
+#include <algorithm>
+#include <cmath>
+
+ParticleReference::ParticleReference(const std::vector<int8_t>& noiseTexels, int noiseSize) :
+    m_noise(noiseTexels),
+    m_noiseSize(noiseSize)
+{
+}
+
+glm::vec4 ParticleReference::texel(int x, int y, int z) const
+{
+    // GL_REPEAT
+    x = ((x % m_noiseSize) + m_noiseSize) % m_noiseSize;
+    y = ((y % m_noiseSize) + m_noiseSize) % m_noiseSize;
+    z = ((z % m_noiseSize) + m_noiseSize) % m_noiseSize;
+
+    const int8_t* t = &m_noise[((z * m_noiseSize + y) * m_noiseSize + x) * 4];
+    // SNORM8 -> float
+    return glm::vec4(std::max(t[0] / 127.0f, -1.0f),
+                     std::max(t[1] / 127.0f, -1.0f),
+                     std::max(t[2] / 127.0f, -1.0f),
+                     std::max(t[3] / 127.0f, -1.0f));
+}
+
+glm::vec3 ParticleReference::noise3f(glm::vec3 p) const
+{
+    // texture(noiseTex3D, p * invNoiseSize) with GL_LINEAR filtering
+    glm::vec3 u = p * (1.0f / m_noiseSize) * float(m_noiseSize) - 0.5f;
+    glm::vec3 f = glm::floor(u);
+    glm::vec3 a = u - f;
+    int x0 = (int)f.x, y0 = (int)f.y, z0 = (int)f.z;
+
+    glm::vec4 c000 = texel(x0, y0, z0), c100 = texel(x0 + 1, y0, z0);
+    glm::vec4 c010 = texel(x0, y0 + 1, z0), c110 = texel(x0 + 1, y0 + 1, z0);
+    glm::vec4 c001 = texel(x0, y0, z0 + 1), c101 = texel(x0 + 1, y0, z0 + 1);
+    glm::vec4 c011 = texel(x0, y0 + 1, z0 + 1), c111 = texel(x0 + 1, y0 + 1, z0 + 1);
+
+    glm::vec4 c00 = glm::mix(c000, c100, a.x), c10 = glm::mix(c010, c110, a.x);
+    glm::vec4 c01 = glm::mix(c001, c101, a.x), c11 = glm::mix(c011, c111, a.x);
+    glm::vec4 c0 = glm::mix(c00, c10, a.y), c1 = glm::mix(c01, c11, a.y);
+    return glm::vec3(glm::mix(c0, c1, a.z));
+}
+
+glm::vec3 ParticleReference::fBm3f(glm::vec3 p, int octaves, float lacunarity, float gain) const
+{
+    float freq = 1.0f, amp = 0.5f;
+    glm::vec3 sum(0.0f);
+    for(int i=0; i<octaves; i++) {
+        sum += noise3f(p*freq)*amp;
+        freq *= lacunarity;
+        amp *= gain;
+    }
+    return sum;
+}
+
+glm::vec3 ParticleReference::attract(glm::vec3 p, glm::vec3 p2) const
+{
+    const float softeningSquared = 0.01f;
+    glm::vec3 v = p2 - p;
+    float r2 = glm::dot(v, v);
+    r2 += softeningSquared;
+    float invDist = 1.0f / sqrtf(r2);
+    float invDistCubed = invDist*invDist*invDist;
+    return v * invDistCubed;
+}
+
+glm::vec3 ParticleReference::getTargetPosition(uint32_t particleId, const ShaderParams& params) const
+{
+    size_t a = (size_t)params.targetOffsetA + particleId;
+    size_t b = (size_t)params.targetOffsetB + particleId;
+    glm::vec3 target = a < m_shapeTargets.size() ? glm::vec3(m_shapeTargets[a]) : glm::vec3(0.0f);
+    if (params.targetMorph > 0.0f) {
+        glm::vec3 targetB = b < m_shapeTargets.size() ? glm::vec3(m_shapeTargets[b]) : glm::vec3(0.0f);
+        target = glm::mix(target, targetB, params.targetMorph);
+    }
+    return target;
+}
+
+glm::vec3 ParticleReference::sampleFluid(glm::vec3 uvw) const
+{
+    if (m_fluidSize == 0) {
+        return glm::vec3(0.0f);
+    }
+
+    glm::vec3 u = uvw * float(m_fluidSize) - 0.5f;
+    glm::vec3 f = glm::floor(u);
+    glm::vec3 a = u - f;
+    int n = m_fluidSize;
+    auto texel = [&](int x, int y, int z) {
+        x = std::min(std::max(x, 0), n - 1);
+        y = std::min(std::max(y, 0), n - 1);
+        z = std::min(std::max(z, 0), n - 1);
+        return glm::vec3(m_fluid[((size_t)z * n + y) * n + x]);
+    };
+    int x0 = (int)f.x, y0 = (int)f.y, z0 = (int)f.z;
+
+    glm::vec3 c00 = glm::mix(texel(x0, y0, z0), texel(x0 + 1, y0, z0), a.x);
+    glm::vec3 c10 = glm::mix(texel(x0, y0 + 1, z0), texel(x0 + 1, y0 + 1, z0), a.x);
+    glm::vec3 c01 = glm::mix(texel(x0, y0, z0 + 1), texel(x0 + 1, y0, z0 + 1), a.x);
+    glm::vec3 c11 = glm::mix(texel(x0, y0 + 1, z0 + 1), texel(x0 + 1, y0 + 1, z0 + 1), a.x);
+    return glm::mix(glm::mix(c00, c10, a.y), glm::mix(c01, c11, a.y), a.z);
+}
+
+uint32_t ParticleReference::cellHash(glm::ivec3 c, const ShaderParams& params) const
+{
+    uint32_t h = ((uint32_t)c.x * 73856093u) ^ ((uint32_t)c.y * 19349663u) ^ ((uint32_t)c.z * 83492791u);
+    return h & (params.numGridCells - 1u);
+}
+
+void ParticleReference::buildGrid(const ShaderParams& params, const std::vector<glm::vec4>& pos,
+                                  const std::vector<glm::vec4>& vel, NeighborGrid& grid) const
+{
+    size_t count = std::min<size_t>(params.numParticles, pos.size());
+    std::vector<uint32_t> cells(count);
+    grid.cellStart.assign(params.numGridCells + 1, 0);
+    for (size_t i = 0; i < count; i++) {
+        cells[i] = cellHash(glm::ivec3(glm::floor(glm::vec3(pos[i]) / params.gridCellSize)), params);
+        grid.cellStart[cells[i] + 1]++;
+    }
+    for (uint32_t c = 0; c < params.numGridCells; c++) {
+        grid.cellStart[c + 1] += grid.cellStart[c];
+    }
+
+    // 格子内按粒子下标排列；着色器中为原子计数的先后，只影响求和的舍入
+    std::vector<uint32_t> cursor(grid.cellStart.begin(), grid.cellStart.end() - 1);
+    grid.pos.resize(count);
+    grid.vel.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t dst = cursor[cells[i]]++;
+        grid.pos[dst] = pos[i];
+        grid.vel[dst] = vel[i];
+    }
+}
+
+glm::vec3 ParticleReference::flockSteer(glm::vec3 p, glm::vec3 v, const ShaderParams& params,
+                                        const NeighborGrid& grid) const
+{
+    float radius2 = params.gridCellSize * params.gridCellSize;
+    float separation2 = radius2 * 0.4f * 0.4f;
+    glm::ivec3 c = glm::ivec3(glm::floor(p / params.gridCellSize));
+
+    glm::vec3 sumPos(0.0f), sumVel(0.0f), separation(0.0f);
+    uint32_t n = 0;
+
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                uint32_t cell = cellHash(c + glm::ivec3(dx, dy, dz), params);
+                for (uint32_t k = grid.cellStart[cell]; k < grid.cellStart[cell + 1] && n < params.maxNeighbors; k++) {
+                    glm::vec3 q(grid.pos[k]);
+                    glm::vec3 d = q - p;
+                    float r2 = glm::dot(d, d);
+                    if (r2 < radius2 && r2 > 1e-12f) {
+                        sumPos += q;
+                        sumVel += glm::vec3(grid.vel[k]);
+                        if (r2 < separation2) {
+                            separation -= d / r2;
+                        }
+                        n++;
+                    }
+                }
+            }
+        }
+    }
+
+    glm::vec3 steer(0.0f);
+    if (n > 0) {
+        float invN = 1.0f / float(n);
+        steer += (sumVel * invN - v) * 0.05f;
+        steer += (sumPos * invN - p) * 0.02f;
+        steer += separation * 0.00002f;
+    }
+    steer -= p * std::max(glm::length(p) - 1.0f, 0.0f) * 0.002f;
+    return steer;
+}
+
+// 与particlePass.cs中FORCE_*的取值一致
+enum { kForceField, kForceAbsorb, kForceSpring, kForceConstant };
+
+glm::vec3 ParticleReference::accelAt(const Dynamics& d, glm::vec3 p, const ShaderParams& params) const
+{
+    glm::vec3 cluster(0.0f);
+    const uint32_t numAttractors = std::min<uint32_t>(params.numAttractors, (uint32_t)m_attractors.size());
+    for (uint32_t j = 0; params.particleState < 0.5f && j < numAttractors; j++) {
+        cluster += attract(p, glm::vec3(m_attractors[j]))*m_attractors[j].w;
+    }
+
+    if (d.force == kForceField) {
+        glm::vec3 a = fBm3f(p*params.noiseFreq, (int)params.noiseOctaves, 2.0f, 0.5f)*params.noiseStrength;
+        a += attract(p, glm::vec3(params.attractor))*params.attractor.w;
+        return a + cluster;
+    }
+    if (d.force == kForceAbsorb) {
+        float dist = glm::length(p);
+        return dist > 0.0f ? -p / dist * (5.0f / (dist + 0.01f)) : glm::vec3(0.0f);
+    }
+    if (d.force == kForceSpring) {
+        return (d.anchor - p) * 2.0f;
+    }
+    return d.anchor;
+}
+
+void ParticleReference::integrate(const Dynamics& d, glm::vec3& p, glm::vec3& v, float h,
+                                  const ShaderParams& params) const
+{
+    if (params.integrator == 1) {
+        v += accelAt(d, p, params) * h;
+        p += v * (d.gain * h);
+        v *= expf(-d.drag * h);
+    } else if (params.integrator == 2) {
+        float halfDecay = expf(-d.drag * h * 0.5f);
+        v = v * halfDecay + accelAt(d, p, params) * (0.5f * h);
+        p += v * (d.gain * h);
+        v = (v + accelAt(d, p, params) * (0.5f * h)) * halfDecay;
+    } else {
+        glm::vec3 k1p = v * d.gain;
+        glm::vec3 k1v = accelAt(d, p, params) - v * d.drag;
+        glm::vec3 v2 = v + k1v * (0.5f * h);
+        glm::vec3 k2p = v2 * d.gain;
+        glm::vec3 k2v = accelAt(d, p + k1p * (0.5f * h), params) - v2 * d.drag;
+        glm::vec3 v3 = v + k2v * (0.5f * h);
+        glm::vec3 k3p = v3 * d.gain;
+        glm::vec3 k3v = accelAt(d, p + k2p * (0.5f * h), params) - v3 * d.drag;
+        glm::vec3 v4 = v + k3v * h;
+        glm::vec3 k4p = v4 * d.gain;
+        glm::vec3 k4v = accelAt(d, p + k3p * h, params) - v4 * d.drag;
+        p += (k1p + 2.0f * (k2p + k3p) + k4p) * (h / 6.0f);
+        v += (k1v + 2.0f * (k2v + k3v) + k4v) * (h / 6.0f);
+    }
+}
+
+void ParticleReference::step(const ShaderParams& params, std::vector<glm::vec4>& pos, std::vector<glm::vec4>& vel) const
+{
+    const glm::vec3 attractor(params.attractor);
+    const uint32_t numAttractors = std::min<uint32_t>(params.numAttractors, (uint32_t)m_attractors.size());
+    const uint32_t numSwarmBodies = std::min<uint32_t>(params.numSwarmBodies, (uint32_t)m_swarmAccel.size());
+
+    NeighborGrid grid;
+    if (params.particleState > 4.5f) {
+        buildGrid(params, pos, vel, grid);
+    }
+
+    // 按dt积分时以参考帧(1/60秒)为时间单位，按帧步进相当于h为1
+    const bool legacy = params.integrator == 0;
+    const float h = legacy ? 1.0f : params.dt * 60.0f;
+
+    for (uint32_t i = 0; i < params.numParticles && i < pos.size(); i++) {
+        glm::vec3 p(pos[i]);
+        glm::vec3 v(vel[i]);
+
+        if (params.particleState > 5.5f) {
+            glm::vec3 flow = sampleFluid(p / (2.0f * params.fluidExtent) + 0.5f);
+            v = glm::mix(v, flow, 1.0f - powf(1.0f - 0.5f, h));
+            v -= p * std::max(glm::length(p) - params.fluidExtent * 0.9f, 0.0f) * 0.01f * h;
+
+            p += v * h;
+        } else if (params.particleState > 4.5f) {
+            v += flockSteer(p, v, params, grid) * h;
+
+            float speed = glm::length(v);
+            if (speed < 1e-7f) {
+                float a = float(i) * 2.39996323f;
+                v = glm::vec3(cosf(a), sinf(a * 0.5f), sinf(a)) * 0.002f;
+            } else {
+                v *= glm::clamp(speed, 0.002f, 0.006f) / speed;
+            }
+
+            p += v * h;
+        } else if (!legacy) {
+            Dynamics d = { kForceField, 1.0f, -logf(params.dampingPerSecond) / 60.0f, glm::vec3(0.0f) };
+            bool settled = false;
+            if (params.particleState > 3.5f && i < numSwarmBodies) {
+                d = { kForceConstant, 1.0f, -logf(0.998f), glm::vec3(m_swarmAccel[i]) };
+            } else if (params.particleState >= 0.5f && params.particleState < 1.5f) {
+                d = { kForceAbsorb, 0.5f, -logf(0.8f), glm::vec3(0.0f) };
+                settled = !(glm::length(p) > 0.001f);
+            } else if (params.particleState >= 1.5f && params.particleState <= 3.5f) {
+                d = { kForceSpring, 0.3f, -logf(0.85f), getTargetPosition(i, params) };
+                settled = !(glm::length(d.anchor - p) > 0.001f);
+            }
+
+            integrate(d, p, v, h, params);
+            if (settled) {
+                p = d.anchor;
+                v = glm::vec3(0.0f);
+            }
+        } else if (params.particleState > 3.5f && i < numSwarmBodies) {
+            v += glm::vec3(m_swarmAccel[i]);
+
+            p += v;
+            v *= 0.998f;
+        } else if (params.particleState < 0.5f || params.particleState > 3.5f) {
+            // 与着色器分块求和的顺序一致: 按引力源下标依次累加；星团只在普通状态下生效
+            glm::vec3 cluster(0.0f);
+            for (uint32_t j = 0; params.particleState < 0.5f && j < numAttractors; j++) {
+                cluster += attract(p, glm::vec3(m_attractors[j]))*m_attractors[j].w;
+            }
+
+            v += fBm3f(p*params.noiseFreq, (int)params.noiseOctaves, 2.0f, 0.5f)*params.noiseStrength;
+            v += attract(p, attractor)*params.attractor.w;
+            v += cluster;
+
+            p += v;
+            v *= params.damping;
+        } else if (params.particleState < 1.5f) {
+            glm::vec3 center(0.0f);
+            glm::vec3 toCenter = center - p;
+            float dist = glm::length(toCenter);
+
+            float absorbStrength = 5.0f;
+            if (dist > 0.001f) {
+                v += glm::normalize(toCenter) * absorbStrength * (1.0f / (dist + 0.01f));
+            } else {
+                v = glm::vec3(0.0f);
+                p = center;
+            }
+
+            p += v * 0.5f;
+            v *= 0.8f;
+        } else {
+            glm::vec3 targetPos = getTargetPosition(i, params);
+
+            glm::vec3 toTarget = targetPos - p;
+            float dist = glm::length(toTarget);
+
+            if (dist > 0.001f) {
+                float springStrength = 2.0f;
+                v += glm::normalize(toTarget) * springStrength * dist;
+
+                p += v * 0.3f;
+                v *= 0.85f;
+            } else {
+                p = targetPos;
+                v = glm::vec3(0.0f);
+            }
+        }
+
+        pos[i] = glm::vec4(p, 1.0f);
+        vel[i] = glm::vec4(v, 0.0f);
+    }
+}
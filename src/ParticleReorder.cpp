@@ -0,0 +1,137 @@
+#include "ParticleReorder.h"
+#include "ParticleSystem.h"
+#include "GpuRadixSort.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include "uniforms.h"
+#include <iostream>
+#include <string>
+
+ParticleReorder::ParticleReorder(size_t capacity, const char* shaderPrefix) :
+    enabled(true),
+    interval(300),
+    boundsExtent(1.5f),
+    m_capacity(capacity),
+    m_framesSinceReorder(0),
+    m_codesProg(0),
+    m_permuteProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    m_sort = new GpuRadixSort(capacity, shaderPrefix);
+    m_sortedPos = new ShaderBuffer<glm::vec4>(capacity);
+    m_sortedVel = new ShaderBuffer<glm::vec4>(capacity);
+    m_sortedIds = new ShaderBuffer<uint32_t>(capacity);
+    CHECK_GL_ERROR();
+
+    loadShaders();
+}
+
+ParticleReorder::~ParticleReorder()
+{
+    delete m_sort;
+    delete m_sortedPos;
+    delete m_sortedVel;
+    delete m_sortedIds;
+
+    if (m_codesProg) glDeleteProgram(m_codesProg);
+    if (m_permuteProg) glDeleteProgram(m_permuteProg);
+}
+
+void ParticleReorder::loadShaders()
+{
+    PROFILE_SCOPE("ParticleReorder::loadShaders");
+
+    if (m_codesProg) {
+        glDeleteProgram(m_codesProg);
+        m_codesProg = 0;
+    }
+    if (m_permuteProg) {
+        glDeleteProgram(m_permuteProg);
+        m_permuteProg = 0;
+    }
+
+    std::string src = readShaderFile("assets/shaders/mortonPass.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_codesProg = createComputeProgram(injectShaderDefines(src, "#define MORTON_CODES\n").c_str(), m_shaderPrefix);
+    m_permuteProg = createComputeProgram(injectShaderDefines(src, "#define MORTON_PERMUTE\n").c_str(), m_shaderPrefix);
+    if (m_codesProg == 0 || m_permuteProg == 0) {
+        std::cerr << "Failed to create Morton reorder shader programs" << std::endl;
+    }
+}
+
+bool ParticleReorder::update(ParticleSystem* particles)
+{
+    if (!enabled) {
+        return false;
+    }
+
+    if (++m_framesSinceReorder < interval) {
+        return false;
+    }
+
+    reorder(particles);
+    return true;
+}
+
+void ParticleReorder::reorder(ParticleSystem* particles)
+{
+    PROFILE_SCOPE("ParticleReorder::reorder");
+    PROFILE_GPU_SCOPE("mortonReorder");
+
+    m_framesSinceReorder = 0;
+    if (m_codesProg == 0 || m_permuteProg == 0) {
+        return;
+    }
+
+    GLuint count = (GLuint)(particles->getSize() < m_capacity ? particles->getSize() : m_capacity);
+    GLuint numGroups = (count + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE;
+    if (numGroups == 0) return;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, particles->getPosBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_sort->getPairBuffer());
+
+    glUseProgram(m_codesProg);
+    glUniform1ui(glGetUniformLocation(m_codesProg, "count"), count);
+    glUniform1f(glGetUniformLocation(m_codesProg, "boundsExtent"), boundsExtent);
+    glDispatchCompute(numGroups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    m_sort->sort(count, 30);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, particles->getPosBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, particles->getVelBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_sort->getPairBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, particles->getIdBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, m_sortedPos->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, m_sortedVel->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, m_sortedIds->getBuffer());
+
+    glUseProgram(m_permuteProg);
+    glUniform1ui(glGetUniformLocation(m_permuteProg, "count"), count);
+    glDispatchCompute(numGroups, 1, 1);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    for (int binding = 2; binding <= 10; binding++) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+    }
+    glUseProgram(0);
+
+    // 拷回粒子缓冲，外部持有的缓冲对象保持不变
+    struct { GLuint src; GLuint dst; size_t bytes; } copies[] = {
+        { m_sortedPos->getBuffer(), particles->getPosBuffer()->getBuffer(), count * sizeof(glm::vec4) },
+        { m_sortedVel->getBuffer(), particles->getVelBuffer()->getBuffer(), count * sizeof(glm::vec4) },
+        { m_sortedIds->getBuffer(), particles->getIdBuffer()->getBuffer(), count * sizeof(uint32_t) },
+    };
+    for (const auto& copy : copies) {
+        glBindBuffer(GL_COPY_READ_BUFFER, copy.src);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, copy.dst);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, copy.bytes);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    CHECK_GL_ERROR();
+}
@@ -0,0 +1,192 @@
+#include "ParticleSorter.h"
+#include "ParticleSystem.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <iostream>
+#include <string>
+
+// 与sortPass.cs一致
+static const GLuint kSortGroupSize = 512;
+static const GLuint kSortBlockSize = 1024;
+
+ParticleSorter::ParticleSorter(size_t capacity, const char* shaderPrefix) :
+    incremental(true),
+    incrementalPasses(2),
+    fullSortInterval(60),
+    m_capacity(capacity),
+    m_entryCount(kSortBlockSize),
+    m_framesSinceFullSort(-1),
+    m_passParity(0),
+    m_keysProg(0),
+    m_localProg(0),
+    m_globalProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    // 双调排序要求2的幂，多出的位置用最大键值填充，排序后落在末尾
+    while (m_entryCount < capacity) {
+        m_entryCount <<= 1;
+    }
+
+    m_entries = new ShaderBuffer<glm::uvec2>(m_entryCount);
+    glm::uvec2* entries = m_entries->map();
+    for (size_t i = 0; i < m_entryCount; i++) {
+        entries[i] = glm::uvec2(0xffffffffu, i < capacity ? (GLuint)i : 0xffffffffu);
+    }
+    m_entries->unmap();
+    CHECK_GL_ERROR();
+
+    loadShaders();
+}
+
+ParticleSorter::~ParticleSorter()
+{
+    delete m_entries;
+
+    if (m_keysProg) glDeleteProgram(m_keysProg);
+    if (m_localProg) glDeleteProgram(m_localProg);
+    if (m_globalProg) glDeleteProgram(m_globalProg);
+}
+
+void ParticleSorter::loadShaders()
+{
+    PROFILE_SCOPE("ParticleSorter::loadShaders");
+
+    GLuint* programs[] = { &m_keysProg, &m_localProg, &m_globalProg };
+    for (GLuint* prog : programs) {
+        if (*prog) {
+            glDeleteProgram(*prog);
+            *prog = 0;
+        }
+    }
+
+    std::string src = readShaderFile("assets/shaders/sortPass.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_keysProg = createComputeProgram(injectShaderDefines(src, "#define SORT_KEYS\n").c_str(), m_shaderPrefix);
+    m_localProg = createComputeProgram(injectShaderDefines(src, "#define SORT_LOCAL\n").c_str(), m_shaderPrefix);
+    m_globalProg = createComputeProgram(injectShaderDefines(src, "#define SORT_GLOBAL\n").c_str(), m_shaderPrefix);
+    if (m_keysProg == 0 || m_localProg == 0 || m_globalProg == 0) {
+        std::cerr << "Failed to create sort shader programs" << std::endl;
+    }
+}
+
+void ParticleSorter::bindBuffers(ParticleSystem* particles)
+{
+    if (particles) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, particles->getPosBuffer()->getBuffer());
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_entries->getBuffer());
+}
+
+void ParticleSorter::sort(ParticleSystem* particles)
+{
+    PROFILE_SCOPE("ParticleSorter::sort");
+    PROFILE_GPU_SCOPE("sortPass");
+
+    updateKeys(particles);
+
+    bool needFull = !incremental || m_framesSinceFullSort < 0 ||
+                    (fullSortInterval > 0 && m_framesSinceFullSort >= fullSortInterval);
+    if (needFull) {
+        sortFull();
+        m_framesSinceFullSort = 0;
+    } else {
+        sortIncremental(incrementalPasses);
+        m_framesSinceFullSort++;
+    }
+}
+
+void ParticleSorter::updateKeys(ParticleSystem* particles)
+{
+    if (m_keysProg == 0) {
+        return;
+    }
+
+    bindBuffers(particles);
+    glUseProgram(m_keysProg);
+    glUniform1ui(glGetUniformLocation(m_keysProg, "entryCount"), (GLuint)m_entryCount);
+    glDispatchCompute((GLuint)(m_entryCount / kSortGroupSize), 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0);
+}
+
+void ParticleSorter::dispatchLocal(GLuint blockOffset, GLuint mergeStage, bool alternateBlocks)
+{
+    GLuint numBlocks = (GLuint)(m_entryCount / kSortBlockSize);
+    // 错开半个块时最后半块不参与本轮
+    if (blockOffset > 0) numBlocks--;
+    if (numBlocks == 0) return;
+
+    glUseProgram(m_localProg);
+    glUniform1ui(glGetUniformLocation(m_localProg, "entryCount"), (GLuint)m_entryCount);
+    glUniform1ui(glGetUniformLocation(m_localProg, "blockOffset"), blockOffset);
+    glUniform1ui(glGetUniformLocation(m_localProg, "mergeStage"), mergeStage);
+    glUniform1i(glGetUniformLocation(m_localProg, "alternateBlocks"), alternateBlocks ? 1 : 0);
+    glDispatchCompute(numBlocks, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ParticleSorter::sortFull()
+{
+    if (m_localProg == 0 || m_globalProg == 0) {
+        return;
+    }
+
+    bindBuffers(nullptr);
+
+    // 块内排序，相邻块方向相反，构成下一级的双调序列
+    dispatchLocal(0, 0, true);
+
+    GLuint n = (GLuint)m_entryCount;
+    for (GLuint k = kSortBlockSize * 2; k <= n; k <<= 1) {
+        glUseProgram(m_globalProg);
+        glUniform1ui(glGetUniformLocation(m_globalProg, "entryCount"), n);
+        glUniform1ui(glGetUniformLocation(m_globalProg, "stage"), k);
+        for (GLuint j = k >> 1; j >= kSortBlockSize; j >>= 1) {
+            glUniform1ui(glGetUniformLocation(m_globalProg, "stepSize"), j);
+            glDispatchCompute(n / 2 / kSortGroupSize, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+        // 比较距离小于一个块的步骤在共享内存中完成
+        dispatchLocal(0, k, false);
+    }
+
+    glUseProgram(0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0);
+}
+
+void ParticleSorter::sortIncremental(int passes)
+{
+    if (m_localProg == 0) {
+        return;
+    }
+
+    bindBuffers(nullptr);
+    for (int pass = 0; pass < passes; pass++) {
+        dispatchLocal(m_passParity ? kSortBlockSize / 2 : 0, 0, false);
+        m_passParity ^= 1;
+    }
+
+    glUseProgram(0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0);
+}
+
+size_t ParticleSorter::countInversions()
+{
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glm::uvec2* entries = m_entries->map(GL_MAP_READ_BIT);
+    size_t inversions = 0;
+    for (size_t i = 0; i + 1 < m_capacity; i++) {
+        if (entries[i].x > entries[i + 1].x) {
+            inversions++;
+        }
+    }
+    m_entries->unmap();
+    return inversions;
+}
@@ -1,13 +1,17 @@
 #include "ParticleSystem.h"
 #include <GL/gl3w.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include "GLUtils.h"
+#include "Profiler.h"
 #include "noise.h"
 #include "uniforms.h"
+#include "ShaderUtils.h"
+#include "ShapeTargets.h"
 
 static float frand()
 {
@@ -20,15 +24,25 @@ static float sfrand()
 }
 
 ParticleSystem::ParticleSystem(size_t size, const char* shaderPrefix) :
+    specializeShaders(true),
     m_size(size),
     m_noiseTex(0),
     m_noiseSize(16),
     m_updateProg(0),
+    m_attractorBuffer(0),
+    m_attractorOffset(0),
+    m_attractorSize(0),
+    m_swarmAccelBuffer(0),
+    m_gridSortedBuffer(0),
+    m_fluidVelocityTex(0),
+    m_gridCellRangeBuffer(0),
+    m_shapeTargetBuffer(0),
     m_shaderPrefix(shaderPrefix)
 {
     m_pos = new ShaderBuffer<glm::vec4>(size);
     m_vel = new ShaderBuffer<glm::vec4>(size);
     m_indices = new ShaderBuffer<uint32_t>(size*6);
+    m_ids = new ShaderBuffer<uint32_t>(size);
 
     uint32_t *indices = m_indices->map();
     for(size_t i=0; i<m_size; i++) {
@@ -67,125 +81,24 @@ static inline const char *GetShaderStageName(GLenum target)
 
 GLuint ParticleSystem::createComputeProgram(const char* src)
 {
-    GLuint computeShader = glCreateShader(GL_COMPUTE_SHADER);
-    if (computeShader == 0) {
-        std::cerr << "Failed to create compute shader" << std::endl;
-        CHECK_GL_ERROR();
-        return 0;
-    }
-
-    std::string srcStr(src);
-    bool hasVersion = srcStr.find("#version") != std::string::npos;
-    
-    const GLchar* fullSrc[2];
-    int srcCount = 2;
-    if (hasVersion) {
-        fullSrc[0] = src;
-        srcCount = 1;
-    } else {
-        fullSrc[0] = m_shaderPrefix;
-        fullSrc[1] = src;
-    }
-
-    glShaderSource(computeShader, srcCount, fullSrc, nullptr);
-    glCompileShader(computeShader);
-    
-    GLint compileStatus;
-    glGetShaderiv(computeShader, GL_COMPILE_STATUS, &compileStatus);
-    if (compileStatus != GL_TRUE) {
-        GLint logLength;
-        glGetShaderiv(computeShader, GL_INFO_LOG_LENGTH, &logLength);
-        if (logLength > 0) {
-            char *log = new char [logLength];
-            glGetShaderInfoLog(computeShader, logLength, 0, log);
-            std::cerr << "=== Compute shader compilation failed ===" << std::endl;
-            std::cerr << log << std::endl;
-            std::cerr << "=========================================" << std::endl;
-            delete [] log;
-        } else {
-            std::cerr << "Compute shader compilation failed (no log available)" << std::endl;
-        }
-        glDeleteShader(computeShader);
-        CHECK_GL_ERROR();
-        return 0;
-    }
-
-    GLuint program = glCreateProgram();
-    if (program == 0) {
-        std::cerr << "Failed to create program" << std::endl;
-        glDeleteShader(computeShader);
-        CHECK_GL_ERROR();
-        return 0;
-    }
-
-    glAttachShader(program, computeShader);
-    glLinkProgram(program);
-
-    GLint linkStatus;
-    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
-    if (linkStatus != GL_TRUE) {
-        GLint logLength;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
-        if (logLength > 0) {
-            char *log = new char [logLength];
-            glGetProgramInfoLog(program, logLength, 0, log);
-            std::cerr << "=== Compute shader program link failed ===" << std::endl;
-            std::cerr << log << std::endl;
-            std::cerr << "==========================================" << std::endl;
-            delete [] log;
-        } else {
-            std::cerr << "Compute shader program link failed (no log available)" << std::endl;
-        }
-        glDeleteProgram(program);
-        glDeleteShader(computeShader);
-        CHECK_GL_ERROR();
-        return 0;
-    }
-
-    glDeleteShader(computeShader);
-
-    GLboolean isProgram = glIsProgram(program);
-    if (isProgram == GL_FALSE) {
-        std::cerr << "Error: Created program is not a valid program object" << std::endl;
-        glDeleteProgram(program);
-        CHECK_GL_ERROR();
-        return 0;
-    }
-
-    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
-    if (linkStatus != GL_TRUE) {
-        std::cerr << "Error: Program link status check failed after creation" << std::endl;
-        glDeleteProgram(program);
-        CHECK_GL_ERROR();
-        return 0;
-    }
-
-    {
-        GLint logLength;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
-        if (logLength > 1) { 
-            char *log = new char [logLength];
-            glGetProgramInfoLog(program, logLength, 0, log);
-            std::cout << "Compute shader program info:\n" << log << std::endl;
-            delete [] log;
-        }
-    }
-
-    CHECK_GL_ERROR();
-    std::cout << "Compute program created successfully, ID: " << program << std::endl;
-    return program;
+    return ::createComputeProgram(src, m_shaderPrefix);
 }
 
 void ParticleSystem::loadShaders()
 {
+    PROFILE_SCOPE("ParticleSystem::loadShaders");
+
     if (m_updateProg) {
         glDeleteProgram(m_updateProg);
         m_updateProg = 0;
     }
+    // 变体在下次使用时按新的源码重新编译
+    destroyVariants();
 
     std::ifstream shaderFile("assets/shaders/particlePass.cs");
     if (!shaderFile.is_open()) {
         std::cerr << "Failed to open compute shader file: assets/shaders/particlePass.cs" << std::endl;
+        m_shaderSource.clear();
         return;
     }
     std::stringstream shaderBuffer;
@@ -195,12 +108,15 @@ void ParticleSystem::loadShaders()
     
     if (src.empty()) {
         std::cerr << "Failed to load compute shader source (file is empty)" << std::endl;
+        m_shaderSource.clear();
         return;
     }
     
     std::cout << "Compute shader source loaded, length: " << src.length() << " bytes" << std::endl;
+
+    m_shaderSource = injectShaderDefines(src, m_shaderDefines);
     
-    m_updateProg = createComputeProgram(src.c_str());
+    m_updateProg = createComputeProgram(m_shaderSource.c_str());
     if (m_updateProg == 0) {
         std::cerr << "Failed to create compute shader program - check error messages above" << std::endl;
         std::cerr << "Shader source preview (first 500 chars):" << std::endl;
@@ -210,35 +126,140 @@ void ParticleSystem::loadShaders()
     
     std::cout << "Compute shader program created successfully, ID: " << m_updateProg << std::endl;
 
-    glUseProgram(m_updateProg);
+    setupProgram(m_updateProg, true);
+}
+
+void ParticleSystem::setupProgram(GLuint prog, bool warnMissing)
+{
+    glUseProgram(prog);
 
-    GLint loc = glGetUniformLocation(m_updateProg, "invNoiseSize");
+    // 特化的变体可能把用不到的uniform优化掉，只对uber-kernel报告缺失
+    GLint loc = glGetUniformLocation(prog, "invNoiseSize");
     if (loc >= 0) {
         glUniform1f(loc, 1.0f / m_noiseSize);
-    } else {
+    } else if (warnMissing) {
         std::cerr << "Warning: uniform 'invNoiseSize' not found in compute shader" << std::endl;
     }
 
-    loc = glGetUniformLocation(m_updateProg, "noiseTex3D");
+    loc = glGetUniformLocation(prog, "noiseTex3D");
     if (loc >= 0) {
         glUniform1i(loc, 0);
-    } else {
+    } else if (warnMissing) {
         std::cerr << "Warning: uniform 'noiseTex3D' not found in compute shader" << std::endl;
     }
 
+    loc = glGetUniformLocation(prog, "fluidVelocity");
+    if (loc >= 0) {
+        glUniform1i(loc, 1);
+    } else if (warnMissing) {
+        std::cerr << "Warning: uniform 'fluidVelocity' not found in compute shader" << std::endl;
+    }
+
     glUseProgram(0);
     CHECK_GL_ERROR();
 }
 
+void ParticleSystem::destroyVariants()
+{
+    for (auto& variant : m_variants) {
+        if (variant.second) {
+            glDeleteProgram(variant.second);
+        }
+    }
+    m_variants.clear();
+}
+
+uint32_t ParticleSystem::variantKey(const ShaderParams& params)
+{
+    // 与particlePass.cs中uber-kernel的分支顺序一致；粒子群状态中未参与自引力的粒子走普通分支
+    uint32_t state;
+    if (params.particleState > 5.5f) state = kStateFluid;
+    else if (params.particleState > 4.5f) state = kStateFlock;
+    else if (params.particleState > 3.5f) state = kStateSwarm;
+    else if (params.particleState < 0.5f) state = kStateNormal;
+    else if (params.particleState < 1.5f) state = kStateAbsorb;
+    else state = kStateShape;
+
+    uint32_t key = state + 1;
+    // 特性开关只影响普通分支，其他状态不必区分，避免产生重复的变体
+    if (state == kStateNormal || state == kStateSwarm) {
+        if (params.attractor.w != 0.0f) key |= 1u << 3;
+        if (state == kStateNormal && params.numAttractors > 0) key |= 1u << 4;
+        key |= std::min(params.noiseOctaves, 7u) << 5;
+    }
+    // 鸟群与流体只区分是否按dt步进
+    uint32_t integrator = std::min(params.integrator, (uint32_t)kIntegratorRK4);
+    if (state == kStateFlock || state == kStateFluid) {
+        integrator = std::min(integrator, 1u);
+    }
+    key |= integrator << 8;
+    return key;
+}
+
+const char* ParticleSystem::integratorName(uint32_t integrator)
+{
+    static const char* names[kNumIntegrators] = { "legacy", "euler", "verlet", "rk4" };
+    return integrator < kNumIntegrators ? names[integrator] : "unknown";
+}
+
+int ParticleSystem::integratorEvaluations(uint32_t integrator)
+{
+    static const int evaluations[kNumIntegrators] = { 1, 1, 2, 4 };
+    return integrator < kNumIntegrators ? evaluations[integrator] : 0;
+}
+
+std::string ParticleSystem::variantDefines(uint32_t key)
+{
+    if (key == kUberKernel) {
+        return "";
+    }
+
+    std::ostringstream defines;
+    defines << "#define PARTICLE_STATE " << ((key & 7u) - 1) << "\n";
+    defines << "#define USE_ATTRACTOR " << ((key >> 3) & 1u) << "\n";
+    defines << "#define USE_CLUSTER " << ((key >> 4) & 1u) << "\n";
+    defines << "#define NOISE_OCTAVES " << ((key >> 5) & 7u) << "\n";
+    defines << "#define INTEGRATOR " << ((key >> 8) & 3u) << "\n";
+    return defines.str();
+}
+
+GLuint ParticleSystem::getProgram(uint32_t key)
+{
+    if (key == kUberKernel) {
+        return m_updateProg;
+    }
+
+    auto it = m_variants.find(key);
+    if (it == m_variants.end()) {
+        PROFILE_SCOPE("ParticleSystem::compileVariant");
+
+        GLuint prog = 0;
+        if (!m_shaderSource.empty()) {
+            prog = createComputeProgram(injectShaderDefines(m_shaderSource, variantDefines(key)).c_str());
+        }
+        if (prog) {
+            setupProgram(prog, false);
+        } else {
+            std::cerr << "Failed to create particle shader variant 0x" << std::hex << key << std::dec
+                      << ", using the uber-kernel" << std::endl;
+        }
+        // 编译失败也记入缓存，避免每帧重试
+        it = m_variants.emplace(key, prog).first;
+    }
+    return it->second ? it->second : m_updateProg;
+}
+
 ParticleSystem::~ParticleSystem()
 {
     delete m_pos;
     delete m_vel;
     delete m_indices;
+    delete m_ids;
 
     if (m_updateProg) {
         glDeleteProgram(m_updateProg);
     }
+    destroyVariants();
     if (m_noiseTex) {
         glDeleteTextures(1, &m_noiseTex);
     }
@@ -257,28 +278,24 @@ void ParticleSystem::reset(float size)
         vel[i] = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
     }
     m_vel->unmap();
+
+    resetIds();
+}
+
+void ParticleSystem::resetIds()
+{
+    uint32_t *ids = m_ids->map();
+    for(size_t i=0; i<m_size; i++) {
+        ids[i] = uint32_t(i);
+    }
+    m_ids->unmap();
 }
 
 void ParticleSystem::resetToHeartShape(float scale)
 {
     glm::vec4 *pos = m_pos->map();
-    const float pi = 3.14159265359f;
-    
     for(size_t i=0; i<m_size; i++) {
-        float t = float(i) / float(m_size);
-        
-        float u = t * 2.0f * pi;
-        
-        float x = 16.0f * sinf(u) * sinf(u) * sinf(u);
-        float y = 13.0f * cosf(u) - 5.0f * cosf(2.0f * u) - 2.0f * cosf(3.0f * u) - cosf(4.0f * u);
-        
-        float heartScale = scale / 20.0f;
-        x *= heartScale;
-        y *= heartScale;
-        
-        float z = sinf(u * 2.0f) * heartScale * 0.5f;
-        
-        pos[i] = glm::vec4(x, y, z, 1.0f);
+        pos[i] = glm::vec4(ShapeTargets::heartPosition(i, m_size, scale), 1.0f);
     }
     m_pos->unmap();
     
@@ -287,24 +304,53 @@ void ParticleSystem::resetToHeartShape(float scale)
         vel[i] = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
     }
     m_vel->unmap();
+
+    resetIds();
 }
 
-void ParticleSystem::update()
+void ParticleSystem::setAttractors(GLuint buffer, GLintptr offset, GLsizeiptr size)
 {
-    if (m_updateProg == 0) {
+    m_attractorBuffer = buffer;
+    m_attractorOffset = offset;
+    m_attractorSize = size;
+}
+
+void ParticleSystem::update(const ShaderParams& params)
+{
+    PROFILE_SCOPE("ParticleSystem::update");
+    PROFILE_GPU_SCOPE("ParticleSystem::update");
+
+    GLuint prog = getProgram(specializeShaders ? variantKey(params) : kUberKernel);
+    if (prog == 0) {
         std::cerr << "Error: Invalid compute shader program (m_updateProg is 0)" << std::endl;
         return;
     }
 
-    glUseProgram(m_updateProg);
+    glUseProgram(prog);
     CHECK_GL_ERROR();
 
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_3D, m_fluidVelocityTex);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_3D, m_noiseTex);
     CHECK_GL_ERROR();
 
     glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2,  m_pos->getBuffer() );
     glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 3,  m_vel->getBuffer() );
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 7,  m_ids->getBuffer() );
+    if (m_attractorBuffer) {
+        glBindBufferRange( GL_SHADER_STORAGE_BUFFER, 11, m_attractorBuffer, m_attractorOffset, m_attractorSize );
+    }
+    if (m_swarmAccelBuffer) {
+        glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 12, m_swarmAccelBuffer );
+    }
+    if (m_gridSortedBuffer && m_gridCellRangeBuffer) {
+        glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 13, m_gridSortedBuffer );
+        glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 14, m_gridCellRangeBuffer );
+    }
+    if (m_shapeTargetBuffer) {
+        glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 18, m_shapeTargetBuffer );
+    }
     CHECK_GL_ERROR();
 
     GLuint numGroups = (GLuint)((m_size + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE);
@@ -315,9 +361,18 @@ void ParticleSystem::update()
     glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
     CHECK_GL_ERROR();
 
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 18, 0 );
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 14, 0 );
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 13, 0 );
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 12, 0 );
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 11, 0 );
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 7,  0 );
     glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 3,  0 );
     glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2,  0 );
     glBindTexture(GL_TEXTURE_3D, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glActiveTexture(GL_TEXTURE0);
     glUseProgram(0);
     CHECK_GL_ERROR();
 }
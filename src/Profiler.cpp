@@ -0,0 +1,283 @@
+#include "Profiler.h"
+#include "GLUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct ProfileEvent
+{
+    const char* name;
+    uint64_t beginNs;
+    uint64_t endNs;
+};
+
+// 每个线程一个固定容量的环形缓冲区，写满后覆盖最旧的事件
+const size_t kThreadRingSize = 1 << 16;
+
+struct ThreadBuffer
+{
+    std::string name;
+    int tid;
+    std::vector<ProfileEvent> events;
+    std::atomic<uint64_t> head;
+
+    ThreadBuffer(int id) : tid(id), events(kThreadRingSize), head(0) {}
+};
+
+std::mutex sRegistryMutex;
+std::vector<ThreadBuffer*> sThreadBuffers;
+thread_local ThreadBuffer* tlsBuffer = nullptr;
+
+ThreadBuffer* getThreadBuffer()
+{
+    if (!tlsBuffer) {
+        std::lock_guard<std::mutex> lock(sRegistryMutex);
+        // 线程退出后缓冲区保留，保证导出时仍能看到其事件
+        tlsBuffer = new ThreadBuffer((int)sThreadBuffers.size());
+        tlsBuffer->name = tlsBuffer->tid == 0 ? "Main" : "Worker " + std::to_string(tlsBuffer->tid);
+        sThreadBuffers.push_back(tlsBuffer);
+    }
+    return tlsBuffer;
+}
+
+// GPU区间: 每帧最多kMaxGpuZones个，结果在kGpuFrameLatency帧之后回读，避免等待GPU
+const int kMaxGpuZones = 64;
+const int kGpuFrameLatency = 4;
+const size_t kGpuRingSize = 1 << 14;
+const int kGpuTid = 1000;
+
+struct GpuZone
+{
+    const char* name;
+    GLuint queries[2];
+    bool closed;
+};
+
+struct GpuFrame
+{
+    GpuZone zones[kMaxGpuZones];
+    int count;
+    int64_t cpuMinusGpuNs;
+};
+
+GpuFrame sGpuFrames[kGpuFrameLatency];
+int sGpuFrameIndex = 0;
+bool sGpuQueriesCreated = false;
+
+std::vector<ProfileEvent> sGpuEvents(kGpuRingSize);
+uint64_t sGpuHead = 0;
+
+const uint64_t sEpochNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+
+void createGpuQueries()
+{
+    for (int f = 0; f < kGpuFrameLatency; f++) {
+        sGpuFrames[f].count = 0;
+        sGpuFrames[f].cpuMinusGpuNs = 0;
+        for (int z = 0; z < kMaxGpuZones; z++) {
+            glGenQueries(2, sGpuFrames[f].zones[z].queries);
+        }
+    }
+    sGpuQueriesCreated = true;
+    CHECK_GL_ERROR();
+}
+
+void calibrate(GpuFrame& frame)
+{
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    frame.cpuMinusGpuNs = (int64_t)Profiler::nowNs() - (int64_t)gpuNow;
+}
+
+void resolveGpuFrame(GpuFrame& frame)
+{
+    for (int z = 0; z < frame.count; z++) {
+        GpuZone& zone = frame.zones[z];
+        if (!zone.closed) continue;
+
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(zone.queries[0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(zone.queries[1], GL_QUERY_RESULT, &end);
+
+        ProfileEvent& e = sGpuEvents[sGpuHead % kGpuRingSize];
+        e.name = zone.name;
+        e.beginNs = (uint64_t)((int64_t)begin + frame.cpuMinusGpuNs);
+        e.endNs = (uint64_t)((int64_t)end + frame.cpuMinusGpuNs);
+        sGpuHead++;
+    }
+    frame.count = 0;
+}
+
+struct ZoneStats
+{
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+    int count = 0;
+};
+
+void writeEvent(std::ofstream& out, const ProfileEvent& e, int tid, const char* cat,
+                std::map<std::string, ZoneStats>& stats, bool& first)
+{
+    double ts = (double)((int64_t)e.beginNs - (int64_t)sEpochNs) / 1000.0;
+    double dur = (double)(e.endNs - e.beginNs) / 1000.0;
+    char line[512];
+    snprintf(line, sizeof(line),
+             "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+             first ? "" : ",\n", e.name, cat, ts, dur, tid);
+    out << line;
+    first = false;
+
+    ZoneStats& s = stats[std::string(cat) + ":" + e.name];
+    s.totalMs += dur / 1000.0;
+    s.maxMs = std::max(s.maxMs, dur / 1000.0);
+    s.count++;
+}
+
+} // namespace
+
+std::atomic<bool> Profiler::sEnabled(false);
+
+uint64_t Profiler::nowNs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    if (enabled && !isEnabled()) {
+        clear();
+        if (!sGpuQueriesCreated) {
+            createGpuQueries();
+        }
+        calibrate(sGpuFrames[sGpuFrameIndex]);
+    }
+    sEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const char* name)
+{
+    getThreadBuffer()->name = name;
+}
+
+void Profiler::clear()
+{
+    std::lock_guard<std::mutex> lock(sRegistryMutex);
+    for (ThreadBuffer* buffer : sThreadBuffers) {
+        buffer->head.store(0, std::memory_order_relaxed);
+    }
+    sGpuHead = 0;
+}
+
+void Profiler::beginFrame()
+{
+    if (!sGpuQueriesCreated) return;
+
+    sGpuFrameIndex = (sGpuFrameIndex + 1) % kGpuFrameLatency;
+    GpuFrame& frame = sGpuFrames[sGpuFrameIndex];
+    resolveGpuFrame(frame);
+
+    if (isEnabled()) {
+        calibrate(frame);
+    }
+}
+
+void Profiler::recordCpu(const char* name, uint64_t beginNs, uint64_t endNs)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    ProfileEvent& e = buffer->events[head % kThreadRingSize];
+    e.name = name;
+    e.beginNs = beginNs;
+    e.endNs = endNs;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+int Profiler::beginGpuZone(const char* name)
+{
+    if (!sGpuQueriesCreated) return -1;
+
+    GpuFrame& frame = sGpuFrames[sGpuFrameIndex];
+    if (frame.count >= kMaxGpuZones) return -1;
+
+    int zone = frame.count++;
+    frame.zones[zone].name = name;
+    frame.zones[zone].closed = false;
+    glQueryCounter(frame.zones[zone].queries[0], GL_TIMESTAMP);
+    return zone;
+}
+
+void Profiler::endGpuZone(int zone)
+{
+    GpuFrame& frame = sGpuFrames[sGpuFrameIndex];
+    if (zone >= frame.count) return;
+
+    glQueryCounter(frame.zones[zone].queries[1], GL_TIMESTAMP);
+    frame.zones[zone].closed = true;
+}
+
+bool Profiler::dumpChromeTrace(const char* path)
+{
+    // 先回读所有未完成的GPU查询，保证最后几帧也出现在时间线上
+    if (sGpuQueriesCreated) {
+        for (int f = 1; f <= kGpuFrameLatency; f++) {
+            resolveGpuFrame(sGpuFrames[(sGpuFrameIndex + f) % kGpuFrameLatency]);
+        }
+    }
+
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open trace file: " << path << std::endl;
+        return false;
+    }
+
+    std::map<std::string, ZoneStats> stats;
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    {
+        std::lock_guard<std::mutex> lock(sRegistryMutex);
+        for (ThreadBuffer* buffer : sThreadBuffers) {
+            out << (first ? "" : ",\n")
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"args\":{\"name\":\"CPU " << buffer->name << "\"}}";
+            first = false;
+
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            uint64_t begin = head > kThreadRingSize ? head - kThreadRingSize : 0;
+            for (uint64_t i = begin; i < head; i++) {
+                writeEvent(out, buffer->events[i % kThreadRingSize], buffer->tid, "cpu", stats, first);
+            }
+        }
+    }
+
+    out << (first ? "" : ",\n")
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << kGpuTid
+        << ",\"args\":{\"name\":\"GPU\"}}";
+    first = false;
+
+    uint64_t gpuBegin = sGpuHead > kGpuRingSize ? sGpuHead - kGpuRingSize : 0;
+    for (uint64_t i = gpuBegin; i < sGpuHead; i++) {
+        writeEvent(out, sGpuEvents[i % kGpuRingSize], kGpuTid, "gpu", stats, first);
+    }
+
+    out << "\n]}\n";
+    out.close();
+
+    std::cout << "Trace written to " << path << std::endl;
+    for (const auto& it : stats) {
+        const ZoneStats& s = it.second;
+        printf("  %-40s avg %8.3f ms  max %8.3f ms  (%d)\n",
+               it.first.c_str(), s.totalMs / s.count, s.maxMs, s.count);
+    }
+    return true;
+}
@@ -0,0 +1,169 @@
+#include "RenderTargetPool.h"
+#include "GLUtils.h"
+#include <algorithm>
+#include <iostream>
+
+RenderTargetPool::RenderTargetPool() :
+    m_frame(0),
+    m_allocations(0)
+{
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+    for (RenderTarget* target : m_idle) {
+        destroy(target);
+    }
+    for (RenderTarget* target : m_live) {
+        destroy(target);
+    }
+}
+
+size_t RenderTargetPool::bytesPerPixel(GLenum format)
+{
+    switch (format) {
+        case GL_RGBA32F: return 16;
+        case GL_RGBA16F: return 8;
+        case GL_RG16F: return 4;
+        case GL_R11F_G11F_B10F: return 4;
+        case GL_RGBA8: return 4;
+        case GL_R32F: return 4;
+        case GL_R16F: return 2;
+        default: return 4;
+    }
+}
+
+RenderTarget* RenderTargetPool::create(int width, int height, GLenum format)
+{
+    RenderTarget* target = new RenderTarget();
+    target->width = width;
+    target->height = height;
+    target->format = format;
+    target->lastUsedFrame = m_frame;
+
+    glGenTextures(1, &target->texture);
+    glBindTexture(GL_TEXTURE_2D, target->texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &target->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->texture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "错误: 渲染目标FBO " << width << "x" << height << " 创建不完整: " << status << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    CHECK_GL_ERROR();
+
+    m_allocations++;
+    return target;
+}
+
+void RenderTargetPool::destroy(RenderTarget* target)
+{
+    glDeleteFramebuffers(1, &target->fbo);
+    glDeleteTextures(1, &target->texture);
+    delete target;
+}
+
+RenderTarget* RenderTargetPool::acquire(int width, int height, GLenum format)
+{
+    width = std::max(width, 1);
+    height = std::max(height, 1);
+
+    // 从最近归还的开始找，刚释放的目标最可能仍在显存中
+    for (size_t i = m_idle.size(); i-- > 0;) {
+        RenderTarget* target = m_idle[i];
+        if (target->width == width && target->height == height && target->format == format) {
+            m_idle.erase(m_idle.begin() + i);
+            m_live.push_back(target);
+            return target;
+        }
+    }
+
+    RenderTarget* target = create(width, height, format);
+    m_live.push_back(target);
+    return target;
+}
+
+void RenderTargetPool::release(RenderTarget* target)
+{
+    if (!target) return;
+
+    std::vector<RenderTarget*>::iterator it = std::find(m_live.begin(), m_live.end(), target);
+    if (it == m_live.end()) {
+        std::cerr << "错误: 归还的渲染目标不属于此池" << std::endl;
+        return;
+    }
+    m_live.erase(it);
+    target->lastUsedFrame = m_frame;
+    m_idle.push_back(target);
+}
+
+void RenderTargetPool::endFrame()
+{
+    m_frame++;
+
+    // m_idle按归还顺序排列，最久未用的在前
+    size_t idleBytes = getIdleBytes();
+    while (!m_idle.empty()) {
+        RenderTarget* oldest = m_idle.front();
+        if (m_frame - oldest->lastUsedFrame <= kMaxIdleFrames && idleBytes <= kMaxIdleBytes) {
+            break;
+        }
+        idleBytes -= (size_t)oldest->width * oldest->height * bytesPerPixel(oldest->format);
+        destroy(oldest);
+        m_idle.erase(m_idle.begin());
+    }
+}
+
+void RenderTargetPool::trim()
+{
+    for (RenderTarget* target : m_idle) {
+        destroy(target);
+    }
+    m_idle.clear();
+}
+
+int RenderTargetPool::bucketSize(int size)
+{
+    int powerOfTwo = 1;
+    while (powerOfTwo < size) {
+        if (powerOfTwo >= 2 && powerOfTwo + powerOfTwo / 2 >= size) {
+            return powerOfTwo + powerOfTwo / 2;
+        }
+        powerOfTwo *= 2;
+    }
+    return powerOfTwo;
+}
+
+int RenderTargetPool::chooseSize(int current, int requested)
+{
+    if (current > 0 && requested <= current && requested * 2 > current) {
+        return current;
+    }
+    return bucketSize(requested);
+}
+
+size_t RenderTargetPool::getIdleBytes() const
+{
+    size_t bytes = 0;
+    for (const RenderTarget* target : m_idle) {
+        bytes += (size_t)target->width * target->height * bytesPerPixel(target->format);
+    }
+    return bytes;
+}
+
+size_t RenderTargetPool::getLiveBytes() const
+{
+    size_t bytes = 0;
+    for (const RenderTarget* target : m_live) {
+        bytes += (size_t)target->width * target->height * bytesPerPixel(target->format);
+    }
+    return bytes;
+}
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <sstream>
 #include <cstring>
+#include "GLUtils.h"
 
 std::string loadShaderSourceWithUniformTag(const char* uniformsFile, const char* srcFile) {
     std::ifstream uniformsStream(uniformsFile);
@@ -39,3 +40,141 @@ std::string loadShaderSourceWithUniformTag(const char* uniformsFile, const char*
     return srcStr;
 }
 
+std::string readShaderFile(const char* path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open shader file: " << path << std::endl;
+        return "";
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+std::string injectShaderDefines(const std::string& src, const std::string& defines) {
+    if (defines.empty()) {
+        return src;
+    }
+    
+    // #define 必须放在 #version 之后
+    size_t versionPos = src.find("#version");
+    if (versionPos == std::string::npos) {
+        return defines + src;
+    }
+    size_t lineEnd = src.find('\n', versionPos);
+    if (lineEnd == std::string::npos) {
+        return src + "\n" + defines;
+    }
+    return src.substr(0, lineEnd + 1) + defines + src.substr(lineEnd + 1);
+}
+
+GLuint createComputeProgram(const char* src, const char* shaderPrefix)
+{
+    GLuint computeShader = glCreateShader(GL_COMPUTE_SHADER);
+    if (computeShader == 0) {
+        std::cerr << "Failed to create compute shader" << std::endl;
+        CHECK_GL_ERROR();
+        return 0;
+    }
+
+    std::string srcStr(src);
+    bool hasVersion = srcStr.find("#version") != std::string::npos;
+    
+    const GLchar* fullSrc[2];
+    int srcCount = 2;
+    if (hasVersion) {
+        fullSrc[0] = src;
+        srcCount = 1;
+    } else {
+        fullSrc[0] = shaderPrefix;
+        fullSrc[1] = src;
+    }
+
+    glShaderSource(computeShader, srcCount, fullSrc, nullptr);
+    glCompileShader(computeShader);
+    
+    GLint compileStatus;
+    glGetShaderiv(computeShader, GL_COMPILE_STATUS, &compileStatus);
+    if (compileStatus != GL_TRUE) {
+        GLint logLength;
+        glGetShaderiv(computeShader, GL_INFO_LOG_LENGTH, &logLength);
+        if (logLength > 0) {
+            char *log = new char [logLength];
+            glGetShaderInfoLog(computeShader, logLength, 0, log);
+            std::cerr << "=== Compute shader compilation failed ===" << std::endl;
+            std::cerr << log << std::endl;
+            std::cerr << "=========================================" << std::endl;
+            delete [] log;
+        } else {
+            std::cerr << "Compute shader compilation failed (no log available)" << std::endl;
+        }
+        glDeleteShader(computeShader);
+        CHECK_GL_ERROR();
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    if (program == 0) {
+        std::cerr << "Failed to create program" << std::endl;
+        glDeleteShader(computeShader);
+        CHECK_GL_ERROR();
+        return 0;
+    }
+
+    glAttachShader(program, computeShader);
+    glLinkProgram(program);
+
+    GLint linkStatus;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE) {
+        GLint logLength;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+        if (logLength > 0) {
+            char *log = new char [logLength];
+            glGetProgramInfoLog(program, logLength, 0, log);
+            std::cerr << "=== Compute shader program link failed ===" << std::endl;
+            std::cerr << log << std::endl;
+            std::cerr << "==========================================" << std::endl;
+            delete [] log;
+        } else {
+            std::cerr << "Compute shader program link failed (no log available)" << std::endl;
+        }
+        glDeleteProgram(program);
+        glDeleteShader(computeShader);
+        CHECK_GL_ERROR();
+        return 0;
+    }
+
+    glDeleteShader(computeShader);
+
+    GLboolean isProgram = glIsProgram(program);
+    if (isProgram == GL_FALSE) {
+        std::cerr << "Error: Created program is not a valid program object" << std::endl;
+        glDeleteProgram(program);
+        CHECK_GL_ERROR();
+        return 0;
+    }
+
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE) {
+        std::cerr << "Error: Program link status check failed after creation" << std::endl;
+        glDeleteProgram(program);
+        CHECK_GL_ERROR();
+        return 0;
+    }
+
+    {
+        GLint logLength;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+        if (logLength > 1) { 
+            char *log = new char [logLength];
+            glGetProgramInfoLog(program, logLength, 0, log);
+            std::cout << "Compute shader program info:\n" << log << std::endl;
+            delete [] log;
+        }
+    }
+
+    CHECK_GL_ERROR();
+    std::cout << "Compute program created successfully, ID: " << program << std::endl;
+    return program;
+}
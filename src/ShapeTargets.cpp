@@ -0,0 +1,584 @@
+#include "ShapeTargets.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+// 采样按固定大小分块，每块用由seed与块号导出的独立随机数流，结果与线程数无关
+const size_t kSampleChunk = 16384;
+
+uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// PCG32
+struct Pcg32
+{
+    uint64_t state;
+
+    explicit Pcg32(uint64_t seed) : state(splitmix64(seed)) {}
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = (uint32_t)(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+
+    // [0, 1)
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+};
+
+// Vose alias表: O(1)按权重抽取下标
+struct AliasTable
+{
+    std::vector<float> prob;
+    std::vector<uint32_t> alias;
+
+    bool build(const std::vector<double>& weights) {
+        size_t n = weights.size();
+        double total = 0.0;
+        for (double w : weights) total += w;
+        if (n == 0 || !(total > 0.0)) return false;
+
+        prob.assign(n, 1.0f);
+        alias.resize(n);
+        std::vector<double> scaled(n);
+        std::vector<uint32_t> small, large;
+        for (size_t i = 0; i < n; i++) {
+            alias[i] = (uint32_t)i;
+            scaled[i] = weights[i] * n / total;
+            (scaled[i] < 1.0 ? small : large).push_back((uint32_t)i);
+        }
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back();
+            small.pop_back();
+            uint32_t l = large.back();
+            prob[s] = (float)scaled[s];
+            alias[s] = l;
+            scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // 剩余项只差舍入误差，概率取1
+        return true;
+    }
+
+    uint32_t sample(Pcg32& rng) const {
+        uint32_t column = std::min((uint32_t)(rng.uniform() * prob.size()), (uint32_t)prob.size() - 1);
+        return rng.uniform() < prob[column] ? column : alias[column];
+    }
+};
+
+bool hasExtension(const char* path, const char* ext)
+{
+    size_t len = strlen(path), extLen = strlen(ext);
+    if (len < extLen) return false;
+    for (size_t i = 0; i < extLen; i++) {
+        if (tolower(path[len - extLen + i]) != ext[i]) return false;
+    }
+    return true;
+}
+
+bool readFile(const char* path, std::string& data)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open mesh file: " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    data = buffer.str();
+    return true;
+}
+
+// PLY属性类型的字节数，未知类型返回0
+int plyTypeSize(const std::string& type)
+{
+    if (type == "char" || type == "uchar" || type == "int8" || type == "uint8") return 1;
+    if (type == "short" || type == "ushort" || type == "int16" || type == "uint16") return 2;
+    if (type == "int" || type == "uint" || type == "int32" || type == "uint32") return 4;
+    if (type == "float" || type == "float32") return 4;
+    if (type == "double" || type == "float64") return 8;
+    return 0;
+}
+
+double plyReadBinary(const char* p, const std::string& type)
+{
+    // 按小端读取，与x86/ARM主机字节序一致
+    if (type == "char" || type == "int8") { int8_t v; memcpy(&v, p, 1); return v; }
+    if (type == "uchar" || type == "uint8") { uint8_t v; memcpy(&v, p, 1); return v; }
+    if (type == "short" || type == "int16") { int16_t v; memcpy(&v, p, 2); return v; }
+    if (type == "ushort" || type == "uint16") { uint16_t v; memcpy(&v, p, 2); return v; }
+    if (type == "int" || type == "int32") { int32_t v; memcpy(&v, p, 4); return v; }
+    if (type == "uint" || type == "uint32") { uint32_t v; memcpy(&v, p, 4); return v; }
+    if (type == "float" || type == "float32") { float v; memcpy(&v, p, 4); return v; }
+    double v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+struct PlyProperty
+{
+    std::string name;
+    std::string type;
+    std::string countType;  // 非空表示list
+};
+
+struct PlyElement
+{
+    std::string name;
+    size_t count;
+    std::vector<PlyProperty> properties;
+};
+
+// 扇形三角化，丢弃越界索引的多边形
+void addPolygon(TriangleMesh& mesh, const std::vector<int64_t>& polygon, size_t numVertices)
+{
+    for (int64_t index : polygon) {
+        if (index < 0 || (size_t)index >= numVertices) return;
+    }
+    for (size_t k = 2; k < polygon.size(); k++) {
+        mesh.triangles.push_back(glm::uvec3((uint32_t)polygon[0], (uint32_t)polygon[k - 1], (uint32_t)polygon[k]));
+    }
+}
+
+} // namespace
+
+ShapeTargets::ShapeTargets(size_t pointsPerShape, int numThreads) :
+    numThreads(numThreads),
+    m_pointsPerShape(pointsPerShape),
+    m_buffer(0)
+{
+    if (this->numThreads <= 0) {
+        this->numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+ShapeTargets::~ShapeTargets()
+{
+    if (m_buffer) {
+        glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+glm::vec3 ShapeTargets::heartPosition(size_t i, size_t count, float scale)
+{
+    float t = float(i) / float(count);
+    float u = t * 6.28318530718f;
+
+    float x = 16.0f * sinf(u) * sinf(u) * sinf(u);
+    float y = 13.0f * cosf(u) - 5.0f * cosf(2.0f * u) - 2.0f * cosf(3.0f * u) - cosf(4.0f * u);
+
+    float heartScale = scale / 20.0f;
+    x *= heartScale;
+    y *= heartScale;
+
+    float z = sinf(u * 2.0f) * heartScale * 0.5f;
+
+    return glm::vec3(x, y, z);
+}
+
+glm::vec3 ShapeTargets::starPosition(size_t i, size_t count, float scale)
+{
+    float t = float(i) / float(count);
+    float angle = t * 6.28318530718f;
+
+    // 五角星: 外半径在0°、72°...，内半径在36°、108°...，之间线性插值
+    float outerRadius = 1.0f;
+    float innerRadius = 0.382f;
+
+    // GLSL mod(x, y) = x - y * floor(x / y)
+    float segmentAngle = angle - 1.25663706144f * floorf(angle / 1.25663706144f);
+
+    float radius;
+    if (segmentAngle < 0.62831853072f) {
+        float localAngle = segmentAngle / 0.62831853072f;
+        radius = glm::mix(outerRadius, innerRadius, localAngle);
+    } else {
+        float localAngle = (segmentAngle - 0.62831853072f) / 0.62831853072f;
+        radius = glm::mix(innerRadius, outerRadius, localAngle);
+    }
+
+    float starScale = scale * 0.5f;
+    float x = cosf(angle) * radius * starScale;
+    float y = sinf(angle) * radius * starScale;
+
+    float z = sinf(angle * 3.0f) * starScale * 0.3f;
+
+    return glm::vec3(x, y, z);
+}
+
+int ShapeTargets::addHeart(float scale)
+{
+    std::vector<glm::vec4> points(m_pointsPerShape);
+    for (size_t i = 0; i < m_pointsPerShape; i++) {
+        points[i] = glm::vec4(heartPosition(i, m_pointsPerShape, scale), 1.0f);
+    }
+    return addPoints(points.data(), "heart");
+}
+
+int ShapeTargets::addStar(float scale)
+{
+    std::vector<glm::vec4> points(m_pointsPerShape);
+    for (size_t i = 0; i < m_pointsPerShape; i++) {
+        points[i] = glm::vec4(starPosition(i, m_pointsPerShape, scale), 1.0f);
+    }
+    return addPoints(points.data(), "star");
+}
+
+int ShapeTargets::addMesh(const char* path, float radius)
+{
+    PROFILE_SCOPE("ShapeTargets::addMesh");
+
+    TriangleMesh mesh;
+    if (!loadMesh(path, mesh)) {
+        return -1;
+    }
+
+    std::string name(path);
+    size_t slash = name.find_last_of("/\\");
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+    return addMesh(mesh, name, radius);
+}
+
+int ShapeTargets::addMesh(const TriangleMesh& mesh, const std::string& name, float radius)
+{
+    TriangleMesh normalized = mesh;
+    normalize(normalized, radius);
+
+    std::vector<glm::vec4> points(m_pointsPerShape);
+    if (!samplePoints(normalized, m_pointsPerShape, points.data(), (uint32_t)m_names.size() + 1)) {
+        std::cerr << "Failed to sample mesh " << name << " (no triangles with non-zero area)" << std::endl;
+        return -1;
+    }
+    return addPoints(points.data(), name);
+}
+
+int ShapeTargets::addPoints(const glm::vec4* points, const std::string& name)
+{
+    // 缓冲按形状数增长: 新建更大的缓冲，旧内容在GPU上复制过去
+    GLsizeiptr shapeBytes = (GLsizeiptr)(m_pointsPerShape * sizeof(glm::vec4));
+    GLsizeiptr oldBytes = shapeBytes * (GLsizeiptr)m_names.size();
+
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, oldBytes + shapeBytes, nullptr, GL_STATIC_DRAW);
+    if (m_buffer) {
+        glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &m_buffer);
+    }
+    glBufferSubData(GL_COPY_WRITE_BUFFER, oldBytes, shapeBytes, points);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    CHECK_GL_ERROR();
+
+    m_buffer = buffer;
+    m_names.push_back(name);
+    return (int)m_names.size() - 1;
+}
+
+bool ShapeTargets::samplePoints(const TriangleMesh& mesh, size_t count, glm::vec4* out, uint32_t seed) const
+{
+    PROFILE_SCOPE("ShapeTargets::samplePoints");
+
+    std::vector<double> areas(mesh.triangles.size());
+    for (size_t t = 0; t < mesh.triangles.size(); t++) {
+        const glm::uvec3& tri = mesh.triangles[t];
+        glm::dvec3 a(mesh.vertices[tri.x]), b(mesh.vertices[tri.y]), c(mesh.vertices[tri.z]);
+        areas[t] = 0.5 * glm::length(glm::cross(b - a, c - a));
+    }
+
+    AliasTable table;
+    if (!table.build(areas)) {
+        return false;
+    }
+
+    size_t numChunks = (count + kSampleChunk - 1) / kSampleChunk;
+    std::atomic<size_t> nextChunk(0);
+    auto worker = [&]() {
+        for (size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++) {
+            Pcg32 rng(((uint64_t)seed << 32) ^ chunk);
+            size_t end = std::min(count, (chunk + 1) * kSampleChunk);
+            for (size_t i = chunk * kSampleChunk; i < end; i++) {
+                const glm::uvec3& tri = mesh.triangles[table.sample(rng)];
+                // 三角形内均匀分布: sqrt使靠近顶点a的区域不过密
+                float r1 = sqrtf(rng.uniform());
+                float r2 = rng.uniform();
+                glm::vec3 p = mesh.vertices[tri.x] * (1.0f - r1) +
+                              mesh.vertices[tri.y] * (r1 * (1.0f - r2)) +
+                              mesh.vertices[tri.z] * (r1 * r2);
+                out[i] = glm::vec4(p, 1.0f);
+            }
+        }
+    };
+
+    int threads = (int)std::min<size_t>((size_t)numThreads, numChunks);
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+    return true;
+}
+
+bool ShapeTargets::loadMesh(const char* path, TriangleMesh& mesh)
+{
+    if (hasExtension(path, ".obj")) {
+        return loadOBJ(path, mesh);
+    }
+    if (hasExtension(path, ".ply")) {
+        return loadPLY(path, mesh);
+    }
+    std::cerr << "Unsupported mesh format (expected .obj or .ply): " << path << std::endl;
+    return false;
+}
+
+bool ShapeTargets::loadOBJ(const char* path, TriangleMesh& mesh)
+{
+    std::string data;
+    if (!readFile(path, data)) {
+        return false;
+    }
+
+    mesh.vertices.clear();
+    mesh.triangles.clear();
+
+    // 面可能引用文件后部的顶点，先收集所有多边形，最后统一校验索引
+    std::vector<int64_t> indices;
+    std::vector<uint32_t> polygonSizes;
+
+    const char* p = data.c_str();
+    const char* end = p + data.size();
+    while (p < end) {
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        if (!lineEnd) lineEnd = end;
+
+        while (p < lineEnd && (*p == ' ' || *p == '\t')) p++;
+        if (p + 1 < lineEnd && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+            char* next;
+            glm::vec3 v;
+            v.x = strtof(p + 1, &next);
+            v.y = strtof(next, &next);
+            v.z = strtof(next, &next);
+            mesh.vertices.push_back(v);
+        } else if (p + 1 < lineEnd && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+            const char* q = p + 1;
+            uint32_t n = 0;
+            while (q < lineEnd) {
+                while (q < lineEnd && (*q == ' ' || *q == '\t' || *q == '\r')) q++;
+                if (q >= lineEnd) break;
+                char* next;
+                long index = strtol(q, &next, 10);
+                if (next == q) break;
+                // 1起始，负数相对于当前已读的顶点
+                indices.push_back(index > 0 ? index - 1 : (int64_t)mesh.vertices.size() + index);
+                n++;
+                // 跳过 /vt/vn
+                q = next;
+                while (q < lineEnd && *q != ' ' && *q != '\t') q++;
+            }
+            polygonSizes.push_back(n);
+        }
+        p = lineEnd + 1;
+    }
+
+    std::vector<int64_t> polygon;
+    size_t offset = 0;
+    for (uint32_t n : polygonSizes) {
+        polygon.assign(indices.begin() + offset, indices.begin() + offset + n);
+        addPolygon(mesh, polygon, mesh.vertices.size());
+        offset += n;
+    }
+
+    if (mesh.triangles.empty()) {
+        std::cerr << "No triangles found in OBJ file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ShapeTargets::loadPLY(const char* path, TriangleMesh& mesh)
+{
+    std::string data;
+    if (!readFile(path, data)) {
+        return false;
+    }
+
+    mesh.vertices.clear();
+    mesh.triangles.clear();
+
+    size_t headerEnd = data.find("end_header");
+    if (data.compare(0, 3, "ply") != 0 || headerEnd == std::string::npos) {
+        std::cerr << "Invalid PLY header: " << path << std::endl;
+        return false;
+    }
+
+    std::istringstream header(data.substr(0, headerEnd));
+    std::vector<PlyElement> elements;
+    bool binary = false;
+    std::string line;
+    while (std::getline(header, line)) {
+        std::istringstream tokens(line);
+        std::string keyword;
+        tokens >> keyword;
+        if (keyword == "format") {
+            std::string format;
+            tokens >> format;
+            if (format == "binary_little_endian") {
+                binary = true;
+            } else if (format != "ascii") {
+                std::cerr << "Unsupported PLY format " << format << ": " << path << std::endl;
+                return false;
+            }
+        } else if (keyword == "element") {
+            PlyElement element;
+            tokens >> element.name >> element.count;
+            elements.push_back(element);
+        } else if (keyword == "property" && !elements.empty()) {
+            PlyProperty property;
+            tokens >> property.type;
+            if (property.type == "list") {
+                tokens >> property.countType >> property.type;
+            }
+            tokens >> property.name;
+            if (plyTypeSize(property.type) == 0 ||
+                (!property.countType.empty() && plyTypeSize(property.countType) == 0)) {
+                std::cerr << "Unsupported PLY property type " << property.type << ": " << path << std::endl;
+                return false;
+            }
+            elements.back().properties.push_back(property);
+        }
+    }
+
+    size_t bodyStart = data.find('\n', headerEnd);
+    if (bodyStart == std::string::npos) {
+        std::cerr << "Truncated PLY file: " << path << std::endl;
+        return false;
+    }
+    bodyStart++;
+
+    const char* p = data.c_str() + bodyStart;
+    const char* end = data.c_str() + data.size();
+
+    // 读取一个标量，ascii时按空白分隔
+    auto readValue = [&](const std::string& type, double& value) -> bool {
+        if (binary) {
+            int size = plyTypeSize(type);
+            if (p + size > end) return false;
+            value = plyReadBinary(p, type);
+            p += size;
+            return true;
+        }
+        while (p < end && isspace((unsigned char)*p)) p++;
+        if (p >= end) return false;
+        char* next;
+        value = strtod(p, &next);
+        if (next == p) return false;
+        p = next;
+        return true;
+    };
+
+    std::vector<int64_t> polygon;
+    for (const PlyElement& element : elements) {
+        bool isVertex = element.name == "vertex";
+        bool isFace = element.name == "face";
+        int axis[3] = { -1, -1, -1 };
+        for (size_t k = 0; k < element.properties.size(); k++) {
+            const std::string& name = element.properties[k].name;
+            if (name == "x") axis[0] = (int)k;
+            if (name == "y") axis[1] = (int)k;
+            if (name == "z") axis[2] = (int)k;
+        }
+        if (isVertex && (axis[0] < 0 || axis[1] < 0 || axis[2] < 0)) {
+            std::cerr << "PLY vertex element has no x/y/z: " << path << std::endl;
+            return false;
+        }
+
+        for (size_t e = 0; e < element.count; e++) {
+            glm::vec3 v(0.0f);
+            for (size_t k = 0; k < element.properties.size(); k++) {
+                const PlyProperty& property = element.properties[k];
+                double value;
+                if (property.countType.empty()) {
+                    if (!readValue(property.type, value)) {
+                        std::cerr << "Truncated PLY file: " << path << std::endl;
+                        return false;
+                    }
+                    for (int a = 0; a < 3; a++) {
+                        if (axis[a] == (int)k) v[a] = (float)value;
+                    }
+                    continue;
+                }
+
+                double n;
+                if (!readValue(property.countType, n)) {
+                    std::cerr << "Truncated PLY file: " << path << std::endl;
+                    return false;
+                }
+                bool indices = isFace && (property.name == "vertex_indices" || property.name == "vertex_index");
+                polygon.clear();
+                for (int j = 0; j < (int)n; j++) {
+                    if (!readValue(property.type, value)) {
+                        std::cerr << "Truncated PLY file: " << path << std::endl;
+                        return false;
+                    }
+                    polygon.push_back((int64_t)value);
+                }
+                if (indices) {
+                    addPolygon(mesh, polygon, mesh.vertices.size());
+                }
+            }
+            if (isVertex) {
+                mesh.vertices.push_back(v);
+            }
+        }
+    }
+
+    if (mesh.triangles.empty()) {
+        std::cerr << "No triangles found in PLY file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ShapeTargets::normalize(TriangleMesh& mesh, float radius)
+{
+    if (mesh.vertices.empty()) return;
+
+    glm::vec3 lo(mesh.vertices[0]), hi(mesh.vertices[0]);
+    for (const glm::vec3& v : mesh.vertices) {
+        lo = glm::min(lo, v);
+        hi = glm::max(hi, v);
+    }
+    glm::vec3 center = (lo + hi) * 0.5f;
+    glm::vec3 half = (hi - lo) * 0.5f;
+    float extent = std::max(half.x, std::max(half.y, half.z));
+    float s = extent > 0.0f ? radius / extent : 1.0f;
+    for (glm::vec3& v : mesh.vertices) {
+        v = (v - center) * s;
+    }
+}
@@ -0,0 +1,333 @@
+#include "ShellConstraints.h"
+#include "ParticleSystem.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include "uniforms.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+// 与shellPass.cs一致
+static const GLuint kShellGroupSize = 256;
+
+ShellConstraints::ShellConstraints(int level, float radius, const char* shaderPrefix) :
+    iterations(4),
+    stretchStiffness(1.0f),
+    bendStiffness(0.5f),
+    damping(0.95f),
+    m_constraintBuffer(nullptr),
+    m_prevPos(nullptr),
+    m_solveProg(0),
+    m_finalizeProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    generate(level, radius);
+    colorConstraints();
+
+    m_constraintBuffer = new ShaderBuffer<Constraint>(m_constraints.size());
+    m_constraintBuffer->bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_constraints.size() * sizeof(Constraint), m_constraints.data());
+    m_constraintBuffer->unbind();
+    m_prevPos = new ShaderBuffer<glm::vec4>(m_vertices.size());
+    CHECK_GL_ERROR();
+
+    loadShaders();
+}
+
+ShellConstraints::~ShellConstraints()
+{
+    delete m_constraintBuffer;
+    delete m_prevPos;
+
+    if (m_solveProg) glDeleteProgram(m_solveProg);
+    if (m_finalizeProg) glDeleteProgram(m_finalizeProg);
+}
+
+void ShellConstraints::loadShaders()
+{
+    PROFILE_SCOPE("ShellConstraints::loadShaders");
+
+    GLuint* programs[] = { &m_solveProg, &m_finalizeProg };
+    for (GLuint* prog : programs) {
+        if (*prog) {
+            glDeleteProgram(*prog);
+            *prog = 0;
+        }
+    }
+
+    std::string src = readShaderFile("assets/shaders/shellPass.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_solveProg = createComputeProgram(injectShaderDefines(src, "#define SHELL_SOLVE\n").c_str(), m_shaderPrefix);
+    m_finalizeProg = createComputeProgram(injectShaderDefines(src, "#define SHELL_FINALIZE\n").c_str(), m_shaderPrefix);
+    if (m_solveProg == 0 || m_finalizeProg == 0) {
+        std::cerr << "Failed to create shell constraint shader programs" << std::endl;
+    }
+}
+
+void ShellConstraints::generate(int level, float radius)
+{
+    // 二十面体
+    const float t = (1.0f + sqrtf(5.0f)) * 0.5f;
+    m_vertices = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+    };
+    std::vector<glm::uvec3> triangles = {
+        {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+        {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+        {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+        {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1},
+    };
+    for (glm::vec3& v : m_vertices) {
+        v = glm::normalize(v);
+    }
+
+    auto edgeKey = [](uint32_t a, uint32_t b) {
+        return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    };
+
+    // 每次细分把三角形分成4个，边中点投影回球面，相邻三角形共用中点
+    level = std::max(0, std::min(level, 9));
+    for (int l = 0; l < level; l++) {
+        std::unordered_map<uint64_t, uint32_t> midpoints;
+        midpoints.reserve(triangles.size() * 2);
+        auto midpoint = [&](uint32_t a, uint32_t b) {
+            auto it = midpoints.find(edgeKey(a, b));
+            if (it != midpoints.end()) return it->second;
+            uint32_t index = (uint32_t)m_vertices.size();
+            m_vertices.push_back(glm::normalize(m_vertices[a] + m_vertices[b]));
+            midpoints.emplace(edgeKey(a, b), index);
+            return index;
+        };
+
+        std::vector<glm::uvec3> subdivided;
+        subdivided.reserve(triangles.size() * 4);
+        for (const glm::uvec3& tri : triangles) {
+            uint32_t ab = midpoint(tri.x, tri.y), bc = midpoint(tri.y, tri.z), ca = midpoint(tri.z, tri.x);
+            subdivided.push_back(glm::uvec3(tri.x, ab, ca));
+            subdivided.push_back(glm::uvec3(tri.y, bc, ab));
+            subdivided.push_back(glm::uvec3(tri.z, ca, bc));
+            subdivided.push_back(glm::uvec3(ab, bc, ca));
+        }
+        triangles.swap(subdivided);
+    }
+    for (glm::vec3& v : m_vertices) {
+        v *= radius;
+    }
+
+    // 每条边记下两侧三角形的对顶点；边生成拉伸约束，对顶点之间生成弯曲约束
+    struct EdgeInfo
+    {
+        uint32_t a, b;
+        uint32_t opposite[2];
+        int numOpposite;
+    };
+    std::unordered_map<uint64_t, uint32_t> edgeIndex;
+    std::vector<EdgeInfo> edges;
+    edgeIndex.reserve(triangles.size() * 2);
+    edges.reserve(triangles.size() * 3 / 2);
+    for (const glm::uvec3& tri : triangles) {
+        for (int e = 0; e < 3; e++) {
+            uint32_t a = tri[e], b = tri[(e + 1) % 3], c = tri[(e + 2) % 3];
+            auto inserted = edgeIndex.emplace(edgeKey(a, b), (uint32_t)edges.size());
+            if (inserted.second) {
+                edges.push_back({ a, b, { c, c }, 0 });
+            }
+            EdgeInfo& edge = edges[inserted.first->second];
+            if (edge.numOpposite < 2) {
+                edge.opposite[edge.numOpposite++] = c;
+            }
+        }
+    }
+
+    m_constraints.clear();
+    m_constraints.reserve(edges.size() * 2);
+    for (const EdgeInfo& edge : edges) {
+        m_constraints.push_back({ edge.a, edge.b, glm::length(m_vertices[edge.a] - m_vertices[edge.b]), kStretch });
+    }
+    for (const EdgeInfo& edge : edges) {
+        if (edge.numOpposite == 2) {
+            uint32_t c = edge.opposite[0], d = edge.opposite[1];
+            m_constraints.push_back({ c, d, glm::length(m_vertices[c] - m_vertices[d]), kBend });
+        }
+    }
+}
+
+void ShellConstraints::colorConstraints()
+{
+    // 贪心边着色: 每个约束取两端粒子都未用过的最小颜色。
+    // 每个顶点最多约12个约束(6条边 + 约6个弯曲)，颜色数不超过23，用64位掩码足够
+    std::vector<uint64_t> used(m_vertices.size(), 0);
+    std::vector<uint32_t> colors(m_constraints.size());
+    uint32_t numColors = 0;
+    for (size_t i = 0; i < m_constraints.size(); i++) {
+        const Constraint& c = m_constraints[i];
+        uint64_t taken = used[c.a] | used[c.b];
+        uint32_t color = 0;
+        while (color < 64 && (taken >> color) & 1) {
+            color++;
+        }
+        if (color == 64) {
+            std::cerr << "ShellConstraints: more than 64 colors needed" << std::endl;
+            color = 63;
+        }
+        used[c.a] |= 1ull << color;
+        used[c.b] |= 1ull << color;
+        colors[i] = color;
+        numColors = std::max(numColors, color + 1);
+    }
+
+    // 按颜色计数排序，同色约束连续存放
+    m_colorOffsets.assign(numColors + 1, 0);
+    for (uint32_t color : colors) {
+        m_colorOffsets[color + 1]++;
+    }
+    for (uint32_t c = 0; c < numColors; c++) {
+        m_colorOffsets[c + 1] += m_colorOffsets[c];
+    }
+    std::vector<uint32_t> cursor(m_colorOffsets.begin(), m_colorOffsets.end() - 1);
+    std::vector<Constraint> sorted(m_constraints.size());
+    for (size_t i = 0; i < m_constraints.size(); i++) {
+        sorted[cursor[colors[i]]++] = m_constraints[i];
+    }
+    m_constraints.swap(sorted);
+}
+
+glm::vec2 ShellConstraints::passStiffness() const
+{
+    float n = (float)std::max(iterations, 1);
+    return glm::vec2(1.0f - powf(1.0f - glm::clamp(stretchStiffness, 0.0f, 1.0f), 1.0f / n),
+                     1.0f - powf(1.0f - glm::clamp(bendStiffness, 0.0f, 1.0f), 1.0f / n));
+}
+
+float ShellConstraints::stepFrames(const ShaderParams& params)
+{
+    return params.integrator == ParticleSystem::kIntegratorLegacy ? 1.0f : params.dt * 60.0f;
+}
+
+bool ShellConstraints::deploy(ParticleSystem* particles)
+{
+    if (particles->getSize() < m_vertices.size()) {
+        std::cerr << "ShellConstraints: " << m_vertices.size() << " shell vertices need as many particles, have "
+                  << particles->getSize() << std::endl;
+        return false;
+    }
+
+    std::vector<glm::vec4> pos(m_vertices.size()), vel(m_vertices.size(), glm::vec4(0.0f));
+    for (size_t i = 0; i < m_vertices.size(); i++) {
+        pos[i] = glm::vec4(m_vertices[i], 1.0f);
+    }
+    particles->getPosBuffer()->bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, pos.size() * sizeof(glm::vec4), pos.data());
+    particles->getVelBuffer()->bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, vel.size() * sizeof(glm::vec4), vel.data());
+    particles->getVelBuffer()->unbind();
+    CHECK_GL_ERROR();
+    return true;
+}
+
+void ShellConstraints::storePositions(ParticleSystem* particles)
+{
+    PROFILE_SCOPE("ShellConstraints::storePositions");
+
+    glBindBuffer(GL_COPY_READ_BUFFER, particles->getPosBuffer()->getBuffer());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_prevPos->getBuffer());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_vertices.size() * sizeof(glm::vec4));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    CHECK_GL_ERROR();
+}
+
+void ShellConstraints::dispatch(GLuint prog, GLuint first, GLuint count)
+{
+    GLuint numGroups = (count + kShellGroupSize - 1) / kShellGroupSize;
+    if (numGroups == 0) return;
+
+    glUniform1ui(glGetUniformLocation(prog, "first"), first);
+    glUniform1ui(glGetUniformLocation(prog, "count"), count);
+    glDispatchCompute(numGroups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ShellConstraints::solve(ParticleSystem* particles, const ShaderParams& params)
+{
+    PROFILE_SCOPE("ShellConstraints::solve");
+    PROFILE_GPU_SCOPE("shellPass");
+
+    for (int i = 0; i < iterations; i++) {
+        iterate(particles);
+    }
+    finalize(particles, params);
+}
+
+void ShellConstraints::iterate(ParticleSystem* particles)
+{
+    if (m_solveProg == 0 || particles->getSize() < m_vertices.size()) return;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, particles->getPosBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 20, m_constraintBuffer->getBuffer());
+    glUseProgram(m_solveProg);
+    glm::vec2 stiffness = passStiffness();
+    glUniform2f(glGetUniformLocation(m_solveProg, "stiffness"), stiffness.x, stiffness.y);
+
+    // 每种颜色一次调度，之间的内存屏障保证下一种颜色看到更新后的位置
+    for (size_t c = 0; c + 1 < m_colorOffsets.size(); c++) {
+        dispatch(m_solveProg, m_colorOffsets[c], m_colorOffsets[c + 1] - m_colorOffsets[c]);
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 20, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+    glUseProgram(0);
+    CHECK_GL_ERROR();
+}
+
+void ShellConstraints::finalize(ParticleSystem* particles, const ShaderParams& params)
+{
+    if (m_finalizeProg == 0 || particles->getSize() < m_vertices.size()) return;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, particles->getPosBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, particles->getVelBuffer()->getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 21, m_prevPos->getBuffer());
+    glUseProgram(m_finalizeProg);
+    glUniform1f(glGetUniformLocation(m_finalizeProg, "damping"), damping);
+    glUniform1f(glGetUniformLocation(m_finalizeProg, "h"), stepFrames(params));
+    dispatch(m_finalizeProg, 0, (GLuint)m_vertices.size());
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 21, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+    glUseProgram(0);
+    CHECK_GL_ERROR();
+}
+
+void ShellConstraints::solveReference(std::vector<glm::vec4>& pos, std::vector<glm::vec4>& vel,
+                                      const std::vector<glm::vec4>& prevPos, const ShaderParams& params) const
+{
+    glm::vec2 stiffness = passStiffness();
+    for (int i = 0; i < iterations; i++) {
+        // 同色约束互不相交，颜色内的顺序不影响结果
+        for (const Constraint& c : m_constraints) {
+            glm::vec3 pa(pos[c.a]), pb(pos[c.b]);
+            glm::vec3 d = pb - pa;
+            float len = glm::length(d);
+            if (len < 1e-9f) continue;
+
+            glm::vec3 correction = d * ((len - c.restLength) / len * 0.5f * stiffness[c.kind]);
+            pos[c.a] = glm::vec4(pa + correction, 1.0f);
+            pos[c.b] = glm::vec4(pb - correction, 1.0f);
+        }
+    }
+    // 位移除以步长得到每参考帧的速度，阻尼按步长换算，与预测步的dampingPerSecond一致
+    const float h = stepFrames(params);
+    const float scale = powf(damping, h) / h;
+    for (size_t k = 0; k < m_vertices.size(); k++) {
+        vel[k] = glm::vec4((glm::vec3(pos[k]) - glm::vec3(prevPos[k])) * scale, 0.0f);
+    }
+}
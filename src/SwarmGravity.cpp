@@ -0,0 +1,125 @@
+#include "SwarmGravity.h"
+#include "GLUtils.h"
+#include "ParticleSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+SwarmGravity::SwarmGravity(size_t maxBodies) :
+    m_maxBodies(maxBodies),
+    m_numBodies(0),
+    m_jobBodies(0),
+    m_activeBodies(0),
+    m_readbackBuffer(0),
+    m_accelBuffer(0),
+    m_readbackFence(0),
+    m_discardJob(false)
+{
+    // 交互式使用: 力误差约0.4%，遍历耗时约为theta=0.5时的一半
+    m_solver.theta = 0.7f;
+
+    glGenBuffers(1, &m_readbackBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_readbackBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, maxBodies * sizeof(glm::vec4), nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glGenBuffers(1, &m_accelBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_accelBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, maxBodies * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    CHECK_GL_ERROR();
+
+    m_positions.resize(maxBodies);
+    m_accel.resize(maxBodies);
+}
+
+SwarmGravity::~SwarmGravity()
+{
+    waitForJob();
+    if (m_readbackFence) {
+        glDeleteSync(m_readbackFence);
+    }
+    if (m_readbackBuffer) {
+        glDeleteBuffers(1, &m_readbackBuffer);
+    }
+    if (m_accelBuffer) {
+        glDeleteBuffers(1, &m_accelBuffer);
+    }
+}
+
+void SwarmGravity::waitForJob()
+{
+    if (m_job.valid()) {
+        m_job.get();
+    }
+}
+
+void SwarmGravity::invalidate()
+{
+    if (m_readbackFence) {
+        glDeleteSync(m_readbackFence);
+        m_readbackFence = 0;
+    }
+    m_discardJob = m_job.valid();
+    m_activeBodies = 0;
+}
+
+void SwarmGravity::update(ParticleSystem* particles)
+{
+    PROFILE_SCOPE("SwarmGravity::update");
+
+    // 3. 后台求解完成 -> 上传加速度
+    if (m_job.valid() && m_job.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        m_job.get();
+        if (!m_discardJob) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_accelBuffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_jobBodies * sizeof(glm::vec4), m_accel.data());
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            CHECK_GL_ERROR();
+            m_activeBodies = (unsigned int)m_jobBodies;
+        }
+        m_discardJob = false;
+    }
+
+    // 2. 回读完成且后台空闲 -> 读出位置并开始求解
+    if (m_readbackFence && !m_job.valid()) {
+        GLenum status = glClientWaitSync(m_readbackFence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            glDeleteSync(m_readbackFence);
+            m_readbackFence = 0;
+
+            glBindBuffer(GL_COPY_READ_BUFFER, m_readbackBuffer);
+            const void* src = glMapBufferRange(GL_COPY_READ_BUFFER, 0, m_numBodies * sizeof(glm::vec4), GL_MAP_READ_BIT);
+            if (src) {
+                memcpy(m_positions.data(), src, m_numBodies * sizeof(glm::vec4));
+                glUnmapBuffer(GL_COPY_READ_BUFFER);
+                m_jobBodies = m_numBodies;
+                m_job = std::async(std::launch::async, [this]() {
+                    m_solver.solve(m_positions.data(), m_jobBodies, m_accel.data());
+                });
+            } else {
+                std::cerr << "Error: Failed to map swarm readback buffer" << std::endl;
+            }
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            CHECK_GL_ERROR();
+        } else if (status == GL_WAIT_FAILED) {
+            std::cerr << "Error: Swarm readback fence wait failed" << std::endl;
+            glDeleteSync(m_readbackFence);
+            m_readbackFence = 0;
+        }
+    }
+
+    // 1. 没有进行中的回读 -> 拷贝当前位置，读出的快照留给下一次求解
+    if (!m_readbackFence) {
+        m_numBodies = std::min(m_maxBodies, particles->getSize());
+        glBindBuffer(GL_COPY_READ_BUFFER, particles->getPosBuffer()->getBuffer());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_readbackBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_numBodies * sizeof(glm::vec4));
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        m_readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        CHECK_GL_ERROR();
+    }
+}
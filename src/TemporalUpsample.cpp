@@ -0,0 +1,185 @@
+#include "TemporalUpsample.h"
+#include "ShaderUtils.h"
+#include "GLUtils.h"
+#include "Profiler.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <string>
+
+// 与temporalPass.cs一致
+static const int kGroupSize = 16;
+
+// 以base为底的Halton序列第index项，(0, 1)
+static float halton(int index, int base)
+{
+    float result = 0.0f;
+    float f = 1.0f;
+    for (int i = index; i > 0; i /= base) {
+        f /= base;
+        result += f * (i % base);
+    }
+    return result;
+}
+
+// 世界坐标点的NDC深度，相机后方或超出远平面时钳制
+static float ndcDepth(const glm::mat4& viewProjection, const glm::vec3& point)
+{
+    glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+    return clip.w > 0.0f ? glm::clamp(clip.z / clip.w, -1.0f, 1.0f) : -1.0f;
+}
+
+TemporalUpsample::TemporalUpsample(const char* shaderPrefix) :
+    sampleBlend(0.3f),
+    depthRange(0.5f),
+    parallaxRejection(0.1f),
+    m_width(0),
+    m_height(0),
+    m_history{ 0, 0 },
+    m_current(0),
+    m_historyValid(false),
+    m_frame(0),
+    m_jitter(0.0f),
+    m_lowResSize(1.0f),
+    m_viewProjection(1.0f),
+    m_particleScale(1.0f),
+    m_reprojection(1.0f),
+    m_focusDepth(0.0f),
+    m_parallaxDepths(0.0f),
+    m_hasPreviousFrame(false),
+    m_resolveProg(0),
+    m_shaderPrefix(shaderPrefix)
+{
+    loadShaders();
+}
+
+TemporalUpsample::~TemporalUpsample()
+{
+    destroyTextures();
+
+    if (m_resolveProg) glDeleteProgram(m_resolveProg);
+}
+
+void TemporalUpsample::loadShaders()
+{
+    PROFILE_SCOPE("TemporalUpsample::loadShaders");
+
+    if (m_resolveProg) {
+        glDeleteProgram(m_resolveProg);
+        m_resolveProg = 0;
+    }
+
+    std::string src = readShaderFile("assets/shaders/temporalPass.cs");
+    if (src.empty()) {
+        return;
+    }
+
+    m_resolveProg = createComputeProgram(src.c_str(), m_shaderPrefix);
+    if (m_resolveProg == 0) {
+        std::cerr << "Failed to create temporal upsample shader program" << std::endl;
+    }
+}
+
+void TemporalUpsample::destroyTextures()
+{
+    if (m_history[0]) {
+        glDeleteTextures(2, m_history);
+        m_history[0] = m_history[1] = 0;
+    }
+}
+
+void TemporalUpsample::resize(int width, int height)
+{
+    if (width == m_width && height == m_height && m_history[0]) return;
+
+    destroyTextures();
+    m_width = width;
+    m_height = height;
+    m_historyValid = false;
+    if (width <= 0 || height <= 0) return;
+
+    glGenTextures(2, m_history);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, m_history[i]);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, width, height);
+        // 重投影的位置不在像素中心，双线性读取
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    CHECK_GL_ERROR();
+}
+
+void TemporalUpsample::beginFrame(const glm::mat4& viewProjection, float particleScale, const glm::vec3& focusPoint,
+                                  int lowResWidth, int lowResHeight)
+{
+    // Halton从第1项开始，第0项全为0
+    int index = m_frame % kJitterCount + 1;
+    m_frame++;
+    m_jitter = glm::vec2(halton(index, 2), halton(index, 3)) - 0.5f;
+    m_lowResSize = glm::vec2((float)lowResWidth, (float)lowResHeight);
+
+    // 视线方向由近、远平面中心反投影得到
+    glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+    glm::vec4 nearCenter = inverseViewProjection * glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+    glm::vec4 farCenter = inverseViewProjection * glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    glm::vec3 forward = glm::normalize(glm::vec3(farCenter) / farCenter.w - glm::vec3(nearCenter) / nearCenter.w);
+    m_focusDepth = ndcDepth(viewProjection, focusPoint);
+    m_parallaxDepths = glm::vec2(ndcDepth(viewProjection, focusPoint - forward * depthRange),
+                                 ndcDepth(viewProjection, focusPoint + forward * depthRange));
+    // 粒子位置整体乘particleScale(以原点为中心): 本帧的世界坐标按两帧缩放之比换算到上一帧
+    if (m_hasPreviousFrame && particleScale > 0.0f) {
+        glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(m_particleScale / particleScale));
+        m_reprojection = m_viewProjection * scale * inverseViewProjection;
+    } else {
+        m_reprojection = glm::mat4(1.0f);
+    }
+    m_viewProjection = viewProjection;
+    m_particleScale = particleScale;
+    m_hasPreviousFrame = true;
+}
+
+glm::mat4 TemporalUpsample::getJitterMatrix() const
+{
+    glm::vec2 ndc = m_jitter * 2.0f / m_lowResSize;
+    return glm::translate(glm::mat4(1.0f), glm::vec3(ndc, 0.0f));
+}
+
+void TemporalUpsample::resolve(GLuint lowResTexture, GLuint sceneTexture)
+{
+    PROFILE_GPU_SCOPE("TemporalUpsample::resolve");
+    if (m_resolveProg == 0 || m_history[0] == 0) return;
+
+    int previous = m_current;
+    m_current = 1 - m_current;
+
+    glUseProgram(m_resolveProg);
+    glUniform1i(glGetUniformLocation(m_resolveProg, "lowResTexture"), 0);
+    glUniform1i(glGetUniformLocation(m_resolveProg, "historyTexture"), 1);
+    glUniform2fv(glGetUniformLocation(m_resolveProg, "jitter"), 1, glm::value_ptr(m_jitter));
+    glUniformMatrix4fv(glGetUniformLocation(m_resolveProg, "reprojection"), 1, GL_FALSE, glm::value_ptr(m_reprojection));
+    glUniform1f(glGetUniformLocation(m_resolveProg, "focusDepth"), m_focusDepth);
+    glUniform2fv(glGetUniformLocation(m_resolveProg, "parallaxDepths"), 1, glm::value_ptr(m_parallaxDepths));
+    glUniform1i(glGetUniformLocation(m_resolveProg, "historyValid"), m_historyValid ? 1 : 0);
+    glUniform1f(glGetUniformLocation(m_resolveProg, "sampleBlend"), sampleBlend);
+    glUniform1f(glGetUniformLocation(m_resolveProg, "parallaxRejection"), parallaxRejection);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, lowResTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_history[previous]);
+    glBindImageTexture(0, m_history[m_current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    glBindImageTexture(1, sceneTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    glDispatchCompute((m_width + kGroupSize - 1) / kGroupSize, (m_height + kGroupSize - 1) / kGroupSize, 1);
+    // 之后的Bloom与合成以纹理或图像读取场景
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glUseProgram(0);
+    m_historyValid = true;
+    CHECK_GL_ERROR();
+}
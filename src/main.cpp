@@ -1,8 +1,13 @@
 ﻿#include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
 #include "ComputeParticles.h"
+#include "Profiler.h"
+#include "ParityCheck.h"
+#include "Benchmarks.h"
 #include <iostream>
 #include <chrono>
+#include <cstring>
+#include <vector>
 
 void errorCallback(int error, const char* description) {
     std::cerr << "GLFW Error " << error << ": " << description << std::endl;
@@ -22,7 +27,7 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 void framebufferSizeCallback(GLFWwindow* window, int width, int height) {
     ComputeParticles* app = static_cast<ComputeParticles*>(glfwGetWindowUserPointer(window));
     if (app) {
-        app->reshape(width, height);
+        app->reshape(width, height, true);
     }
 }
 
@@ -47,7 +52,30 @@ void scrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    bool traceFromStart = false;
+    bool parityMode = false;
+    ParityOptions parityOptions;
+    const char* benchmarkName = nullptr;
+    std::vector<const char*> shapeFiles;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0) {
+            traceFromStart = true;
+        } else if (strcmp(argv[i], "--parity") == 0) {
+            parityMode = true;
+        } else if (strcmp(argv[i], "--update-golden") == 0) {
+            parityOptions.updateGolden = true;
+        } else if (strcmp(argv[i], "--no-variants") == 0) {
+            parityOptions.specializeShaders = false;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            parityOptions.seed = (unsigned int)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            benchmarkName = argv[++i];
+        } else if (strcmp(argv[i], "--shape") == 0 && i + 1 < argc) {
+            shapeFiles.push_back(argv[++i]);
+        }
+    }
+
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -61,9 +89,14 @@ int main() {
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+    if (parityMode || benchmarkName) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
     
     // Create window
-    GLFWwindow* window = glfwCreateWindow(800, 600, "ParticleSystem", nullptr, nullptr);
+    GLFWwindow* window = parityMode
+        ? glfwCreateWindow(parityOptions.imageWidth, parityOptions.imageHeight, "ParticleSystem Parity", nullptr, nullptr)
+        : glfwCreateWindow(800, 600, "ParticleSystem", nullptr, nullptr);
     if (!window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -80,9 +113,30 @@ int main() {
         return -1;
     }
     
+    if (parityMode) {
+        int result = runParityCheck(window, parityOptions);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return result;
+    }
+    
+    if (benchmarkName) {
+        int result = runBenchmark(window, benchmarkName);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return result;
+    }
+    
+    if (traceFromStart) {
+        Profiler::setThreadName("Main");
+        Profiler::setEnabled(true);
+    }
   
     // Create application
     ComputeParticles app;
+    for (const char* file : shapeFiles) {
+        app.addShapeFile(file);
+    }
     if (!app.init(window)) {
         std::cerr << "Failed to initialize application" << std::endl;
         glfwDestroyWindow(window);
@@ -111,6 +165,31 @@ int main() {
         std::cout << "  SPACE - 切换动画开关" << std::endl;
         std::cout << "  A - 切换吸引子开关" << std::endl;
         std::cout << "  R - 重置粒子" << std::endl;
+        std::cout << "  C - 切换视锥剔除/LOD" << std::endl;
+        std::cout << "  1 - 开启/关闭随机LOD (剔除开启时)" << std::endl;
+        std::cout << "  H - 切换粒子绘制分辨率 (全/半/四分之一/自动)" << std::endl;
+        std::cout << "  Q - 输出各分辨率耗时与画质对比" << std::endl;
+        std::cout << "  O - 切换混合方式 (加性/排序over/增量排序over)" << std::endl;
+        std::cout << "  M - 切换Morton序周期重排" << std::endl;
+        std::cout << "  G - 切换引力源星团数量 (0/256/1024/4096)" << std::endl;
+        std::cout << "  W - 进入/退出粒子群自引力状态" << std::endl;
+        std::cout << "  B - 进入/退出鸟群状态" << std::endl;
+        std::cout << "  F - 进入/退出流体状态" << std::endl;
+        std::cout << "  V - 切换流体网格分辨率 (64/96/128)" << std::endl;
+        std::cout << "  J - 切换流体压力迭代次数 (10/20/40)" << std::endl;
+        std::cout << "  P - 渐变到下一个形状 (爱心/五角星/网格)" << std::endl;
+        std::cout << "  E - 进入/退出开普勒轨道模式 (左右方向键跳转轨道时间)" << std::endl;
+        std::cout << "  N - 切换噪声八度数 (4/3/2/1)" << std::endl;
+        std::cout << "  K - 切换特化着色器变体/uber-kernel" << std::endl;
+        std::cout << "  I - 切换积分器 (逐帧/半隐式欧拉/Verlet/RK4)" << std::endl;
+        std::cout << "  S - 进入/退出PBD戴森壳状态" << std::endl;
+        std::cout << "  U - 切换壳体约束迭代次数 (1/2/4/8/16)" << std::endl;
+        std::cout << "  L - 切换Bloom实现 (片元着色器链/计算着色器mip链/稀疏分块链/融合片元链)" << std::endl;
+        std::cout << "  X - 开启/关闭GPU自动曝光" << std::endl;
+        std::cout << "  Z - 开启/关闭降分辨率粒子的时间重建" << std::endl;
+        std::cout << "  Y - 切换精灵几何：八边形+衰减查表 / 四边形+exp与discard" << std::endl;
+        std::cout << "  D - 开启/关闭overdraw热力图与各pass的管线统计" << std::endl;
+        std::cout << "  T - 开始/停止性能采样 (输出trace.json)" << std::endl;
         std::cout << "  左键拖动 - 旋转相机" << std::endl;
         std::cout << "  右键拖动 - 平移相机" << std::endl;
         std::cout << "  鼠标滚轮 - 缩放" << std::endl;
@@ -121,10 +200,24 @@ int main() {
         float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
         lastTime = currentTime;
 
+        Profiler::beginFrame();
+        PROFILE_SCOPE("Frame");
+        
         app.draw(deltaTime);
         
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        {
+            PROFILE_SCOPE("glfwPollEvents");
+            glfwPollEvents();
+        }
+    }
+    
+    if (Profiler::isEnabled()) {
+        Profiler::setEnabled(false);
+        Profiler::dumpChromeTrace("trace.json");
     }
     
     glfwDestroyWindow(window);